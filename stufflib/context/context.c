@@ -23,3 +23,12 @@ bool sl_context_unwind_errors(struct sl_context ctx[static 1], FILE stream[stati
   sl_error_clear(&ctx->errors);
   return ok;
 }
+
+// pushes errors of src on top of dst, oldest first, and clears src
+void sl_context_move_errors(struct sl_context dst[static 1], struct sl_context src[static 1]) {
+  for (size_t i = 0; i < sl_error_depth(&src->errors); ++i) {
+    const struct sl_error_msg* e = src->errors.entries + i;
+    sl_error_push(&dst->errors, e->file, e->line, e->msg);
+  }
+  sl_error_clear(&src->errors);
+}
@@ -33,6 +33,7 @@ __attribute__((__format__(__printf__, 4, 5))) static inline void sl_context_erro
   sl_context_error_pushf((ctx), __FILE__, __LINE__, (fmt)__VA_OPT__(, __VA_ARGS__))
 
 bool sl_context_unwind_errors(struct sl_context ctx[static 1], FILE stream[static 1]);
+void sl_context_move_errors(struct sl_context dst[static 1], struct sl_context src[static 1]);
 
 static inline bool sl_context_error_occurred(struct sl_context ctx[static 1]) {
   return sl_error_occurred(&ctx->errors);
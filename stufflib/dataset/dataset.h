@@ -7,4 +7,7 @@
 #define SL_DATASET_RCV1_SAMPLES  804'414
 #define SL_DATASET_RCV1_FEATURES 47'236
 
+// suffix of the records with the value ranges of each RCV1 samples record
+#define SL_DATASET_RCV1_MINMAX_SUFFIX "_minmax"
+
 #endif  // STUFFLIB_DATASET_H_INCLUDED
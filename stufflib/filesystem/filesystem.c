@@ -1,8 +1,14 @@
+#include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <stufflib/context/context.h>
 #include <stufflib/filesystem/filesystem.h>
 #include <stufflib/io/io.h>
@@ -79,3 +85,47 @@ done:
   sl_file_close(&f);
   return ok;
 }
+
+bool sl_fs_map_file(
+    struct sl_context ctx[static 1],
+    const char path[const static 1],
+    struct sl_span data[const static 1]
+) {
+  *data   = (struct sl_span){0};
+  bool ok = false;
+
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    SL_ERROR(ctx, "cannot open '%s' (%s)", path, strerror(errno));
+    return false;
+  }
+  struct stat st = {0};
+  if (fstat(fd, &st) != 0) {
+    SL_ERROR(ctx, "cannot stat '%s' (%s)", path, strerror(errno));
+    goto done;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    SL_ERROR(ctx, "cannot map '%s', it is not a regular file", path);
+    goto done;
+  }
+  if (st.st_size > 0) {
+    void* mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      SL_ERROR(ctx, "cannot map '%s' (%s)", path, strerror(errno));
+      goto done;
+    }
+    *data = sl_span_view((size_t)st.st_size, mapped);
+  }
+  ok = true;
+done:
+  // the mapping stays valid after closing the file
+  close(fd);
+  return ok;
+}
+
+void sl_fs_unmap_file(struct sl_span data[const static 1]) {
+  if (data->data) {
+    munmap(data->data, data->size);
+  }
+  *data = (struct sl_span){0};
+}
@@ -25,5 +25,12 @@ bool sl_fs_read_int64(
     size_t count,
     int64_t values[const count]
 );
+// maps a regular file read-only, data is a view into the mapping until sl_fs_unmap_file
+bool sl_fs_map_file(
+    struct sl_context ctx[static 1],
+    const char path[const static 1],
+    struct sl_span data[const static 1]
+);
+void sl_fs_unmap_file(struct sl_span data[const static 1]);
 
 #endif  // SL_FILESYSTEM_H_INCLUDED
@@ -1,11 +1,14 @@
 #include <stddef.h>
 #include <stdint.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include <assert.h>
 
+#include <stufflib/context/context.h>
 #include <stufflib/json/json.h>
+#include <stufflib/macros/macros.h>
+#include <stufflib/memory/memory.h>
+#include <stufflib/number/number.h>
 
 static inline bool sl_json_is_ws(char ch) {
   return ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t';
@@ -19,6 +22,198 @@ static inline bool sl_json_is_path_key(char ch) {
   return '!' <= ch && ch <= '~' && ch != '"' && ch != '.' && ch != '[' && ch != ']';
 }
 
+// input is classified in blocks of 64 bytes, one bit per byte
+#define SL_JSON_BLOCK_SIZE 64
+
+static inline uint64_t sl_json_load_word(const unsigned char src[static sizeof(uint64_t)]) {
+  uint64_t word = 0;
+  memcpy(&word, src, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64(word);
+#endif
+  return word;
+}
+
+// moves the high bit of each byte into bits 0 to 7, first byte to bit 0
+static inline uint64_t sl_json_gather_bytes(uint64_t high_bits) {
+  return ((high_bits >> 7) * 0x0102040810204080ULL) >> 56;
+}
+
+// sets the high bit of each byte equal to ch
+static inline uint64_t sl_json_bytes_eq(uint64_t word, unsigned char ch) {
+  const uint64_t low_bits = 0x7f7f7f7f7f7f7f7fULL;
+  const uint64_t x        = word ^ (0x0101010101010101ULL * ch);
+  return ~(((x & low_bits) + low_bits) | x | low_bits);
+}
+
+// sets the high bit of each byte less than 0x20
+static inline uint64_t sl_json_bytes_control(uint64_t word) {
+  const uint64_t low_bits = 0x7f7f7f7f7f7f7f7fULL;
+  return ~(((word & low_bits) + 0x6060606060606060ULL) | word | low_bits);
+}
+
+// classifies the block at begin into whitespace and string stop bitmasks
+// bytes past the end of input are classified as zeros
+static void sl_json_classify_block(
+    struct sl_json_parser p[restrict static 1],
+    size_t len,
+    const char json[restrict static len],
+    size_t begin
+) {
+  const unsigned char* src = (const unsigned char*)json + begin;
+  unsigned char tail[SL_JSON_BLOCK_SIZE];
+  if (len - begin < SL_JSON_BLOCK_SIZE) {
+    memset(tail, 0, sizeof(tail));
+    memcpy(tail, src, len - begin);
+    src = tail;
+  }
+
+  uint64_t ws          = 0;
+  uint64_t string_stop = 0;
+  for (size_t i = 0; i < SL_JSON_BLOCK_SIZE / sizeof(uint64_t); ++i) {
+    const uint64_t word = sl_json_load_word(src + (i * sizeof(uint64_t)));
+    const uint64_t is_ws
+        = sl_json_bytes_eq(word, ' ') | sl_json_bytes_eq(word, '\n') | sl_json_bytes_eq(word, '\r')
+          | sl_json_bytes_eq(word, '\t');
+    const uint64_t is_string_stop
+        = sl_json_bytes_eq(word, '"') | sl_json_bytes_eq(word, '\\') | sl_json_bytes_control(word);
+    ws |= sl_json_gather_bytes(is_ws) << (i * 8);
+    string_stop |= sl_json_gather_bytes(is_string_stop) << (i * 8);
+  }
+
+  p->block_begin       = begin;
+  p->block_end         = begin + SL_JSON_BLOCK_SIZE;
+  p->block_non_ws      = ~ws;
+  p->block_string_stop = string_stop;
+}
+
+// returns the offset of the first byte at or after pos that is a string stop (in_string)
+// or not whitespace (!in_string), or len if there is no such byte
+static inline size_t sl_json_skip(
+    struct sl_json_parser p[restrict static 1],
+    size_t len,
+    const char json[restrict static len],
+    size_t pos,
+    bool in_string
+) {
+  while (pos < len) {
+    if (pos < p->block_begin || pos >= p->block_end) {
+      sl_json_classify_block(p, len, json, pos);
+    }
+    const uint64_t stops = in_string ? p->block_string_stop : p->block_non_ws;
+    const uint64_t mask  = stops >> (pos - p->block_begin);
+    if (mask) {
+      return SL_MIN(len, pos + (size_t)__builtin_ctzll(mask));
+    }
+    pos = p->block_end;
+  }
+  return len;
+}
+
+// jumps over bytes that would not change the current state
+static inline void sl_json_parse_skip(
+    struct sl_json_parser p[restrict static 1],
+    size_t len,
+    const char json[restrict static len]
+) {
+  switch (p->state) {
+    case sl_json_string_value:
+    case sl_json_string_key: {
+      p->pos = sl_json_skip(p, len, json, p->pos, true);
+    } break;
+    case sl_json_element:
+    case sl_json_object:
+    case sl_json_array:
+    case sl_json_colon:
+    case sl_json_member:
+    case sl_json_array_element:
+    case sl_json_after_value: {
+      if (p->pos < len && sl_json_is_ws(json[p->pos])) {
+        p->pos = sl_json_skip(p, len, json, p->pos, false);
+      }
+    } break;
+    case sl_json_string_escape_value:
+    case sl_json_string_escape_key:
+    case sl_json_number_minus:
+    case sl_json_number_zero:
+    case sl_json_number_one_nine:
+    case sl_json_number_frac_first:
+    case sl_json_number_frac_digits:
+    case sl_json_number_exp_sign:
+    case sl_json_number_exp_first:
+    case sl_json_number_exp_digits:
+    case sl_json_done:
+    case sl_json_error:
+    case sl_json_error_end_of_input: {
+    } break;
+  }
+}
+
+static struct sl_json_parse_stack
+sl_json_parse_storage_stack(struct sl_json_parse_storage storage[static 1]) {
+  return (struct sl_json_parse_stack){
+      .capacity  = SL_JSON_PARSE_MAX_DEPTH,
+      .is_array  = storage->is_array,
+      .array_pos = storage->array_pos,
+  };
+}
+
+static inline bool
+sl_json_parse_is_array(const struct sl_json_parser p[static 1], const size_t depth) {
+  return (p->stack.is_array[depth / 64] >> (depth % 64)) & 1;
+}
+
+// opens a container at the current depth, fails if the stack is full
+static inline bool sl_json_parse_push(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_parser p[restrict static 1],
+    const bool is_array
+) {
+  if (p->depth == p->stack.capacity) {
+    SL_ERROR(ctx, "JSON is nested deeper than %zu at offset %zu", p->stack.capacity, p->pos);
+    return false;
+  }
+  uint64_t* word     = p->stack.is_array + p->depth / 64;
+  const uint64_t bit = 1ULL << (p->depth % 64);
+  *word              = is_array ? (*word | bit) : (*word & ~bit);
+  if (is_array) {
+    if (p->n_arrays) {
+      p->stack.array_pos[p->n_arrays - 1] = p->array_pos;
+    }
+    ++(p->n_arrays);
+    p->array_pos = SIZE_MAX;
+  }
+  p->in_array = is_array;
+  ++(p->depth);
+  return true;
+}
+
+// closes the innermost container and restores the position in the enclosing array
+static inline void sl_json_parse_pop(struct sl_json_parser p[static 1]) {
+  assert(p->depth);
+  if (p->in_array) {
+    --(p->n_arrays);
+    if (p->n_arrays) {
+      p->array_pos = p->stack.array_pos[p->n_arrays - 1];
+    }
+  }
+  --(p->depth);
+  p->in_array = p->depth && sl_json_parse_is_array(p, p->depth - 1);
+}
+
+// index of the current event node in its parent array, SIZE_MAX if the parent is not an array
+static inline size_t sl_json_parse_event_index(const struct sl_json_parser p[static 1]) {
+  if (p->event.type != sl_json_begin_node) {
+    return p->in_array ? p->array_pos : SIZE_MAX;
+  }
+  // the container of the event was already opened
+  const size_t depth = p->event.node_depth;
+  if (depth == 0 || !sl_json_parse_is_array(p, depth - 1)) {
+    return SIZE_MAX;
+  }
+  return p->in_array ? p->stack.array_pos[p->n_arrays - 2] : p->array_pos;
+}
+
 static inline void sl_json_parse_unget(struct sl_json_parser p[static 1]) {
   assert(p->pos);
   --(p->pos);
@@ -80,8 +275,7 @@ static inline void sl_json_parse_emit_end_container(
     struct sl_json_parser p[static 1],
     enum sl_json_type container_type
 ) {
-  assert(p->depth);
-  --(p->depth);
+  sl_json_parse_pop(p);
   p->state = sl_json_after_value;
   p->event = (struct sl_json_event){
       .emitted    = true,
@@ -97,6 +291,7 @@ static inline bool sl_json_parse_advance(
     size_t len,
     const char json[restrict static len]
 ) {
+  sl_json_parse_skip(p, len, json);
   enum sl_json_parse_state current_state = p->state;
 
   char ch  = (char)(p->pos < len ? json[p->pos] : 0);
@@ -113,30 +308,31 @@ static inline bool sl_json_parse_advance(
 
       switch (ch) {
         case '{': {
+          if (!sl_json_parse_push(ctx, p, false)) {
+            break;
+          }
           p->state = sl_json_object;
           p->event = (struct sl_json_event){
               .emitted    = true,
               .type       = sl_json_begin_node,
-              .node_depth = p->depth,
+              .node_depth = p->depth - 1,
               .node_type  = sl_json_type_object,
           };
-          p->value_begin     = p->pos;
-          p->stack[p->depth] = sl_json_container_object;
-          ++(p->depth);
+          p->value_begin = p->pos;
         } break;
 
         case '[': {
+          if (!sl_json_parse_push(ctx, p, true)) {
+            break;
+          }
           p->state = sl_json_array;
           p->event = (struct sl_json_event){
               .emitted    = true,
               .type       = sl_json_begin_node,
-              .node_depth = p->depth,
+              .node_depth = p->depth - 1,
               .node_type  = sl_json_type_array,
           };
-          p->value_begin         = p->pos;
-          p->stack[p->depth]     = sl_json_container_array;
-          p->array_pos[p->depth] = SIZE_MAX;
-          ++(p->depth);
+          p->value_begin = p->pos;
         } break;
 
         case '"': {
@@ -207,15 +403,7 @@ static inline bool sl_json_parse_advance(
       if (sl_json_is_ws(ch)) {
         p->state = sl_json_object;
       } else if (ch == '}') {
-        assert(p->depth);
-        --(p->depth);
-        p->state = sl_json_after_value;
-        p->event = (struct sl_json_event){
-            .emitted    = true,
-            .type       = sl_json_end_node,
-            .node_depth = p->depth,
-            .node_type  = sl_json_type_object,
-        };
+        sl_json_parse_emit_end_container(p, sl_json_type_object);
       } else if (ch == '"') {
         sl_json_parse_unget(p);
         p->state = sl_json_member;
@@ -265,15 +453,7 @@ static inline bool sl_json_parse_advance(
       if (sl_json_is_ws(ch)) {
         p->state = sl_json_array;
       } else if (ch == ']') {
-        assert(p->depth);
-        --(p->depth);
-        p->state = sl_json_after_value;
-        p->event = (struct sl_json_event){
-            .emitted    = true,
-            .type       = sl_json_end_node,
-            .node_depth = p->depth,
-            .node_type  = sl_json_type_array,
-        };
+        sl_json_parse_emit_end_container(p, sl_json_type_array);
       } else if (ch == 0) {
         p->state = sl_json_error_end_of_input;
       } else {
@@ -288,10 +468,10 @@ static inline bool sl_json_parse_advance(
       } else if (ch == 0) {
         p->state = sl_json_error_end_of_input;
       } else {
-        assert(p->depth);
+        assert(p->in_array);
         sl_json_parse_unget(p);
         p->state = sl_json_element;
-        ++(p->array_pos[p->depth - 1]);
+        ++(p->array_pos);
       }
     } break;
 
@@ -483,7 +663,7 @@ static inline bool sl_json_parse_advance(
         p->state = sl_json_after_value;
       } else if (p->depth == 0 && p->pos == len) {
         p->state = sl_json_done;
-      } else if (p->depth && p->stack[p->depth - 1] == sl_json_container_object) {
+      } else if (p->depth && !p->in_array) {
         if (ch == ',') {
           p->state = sl_json_member;
         } else if (ch == '}') {
@@ -498,7 +678,7 @@ static inline bool sl_json_parse_advance(
               (unsigned char)ch
           );
         }
-      } else if (p->depth && p->stack[p->depth - 1] == sl_json_container_array) {
+      } else if (p->in_array) {
         if (ch == ',') {
           p->state = sl_json_array_element;
         } else if (ch == ']') {
@@ -533,7 +713,7 @@ static inline bool sl_json_parse_advance(
     SL_ERROR(ctx, "unexpected end of input at offset %zu", p->pos);
     return false;
   }
-  return p->state != sl_json_error && ++(p->pos) <= len && p->depth < SL_JSON_PARSE_MAX_DEPTH;
+  return p->state != sl_json_error && ++(p->pos) <= len;
 }
 
 size_t sl_json_count_nodes(
@@ -545,8 +725,12 @@ size_t sl_json_count_nodes(
     SL_ERROR(ctx, "JSON content is empty");
     return 0;
   }
-  struct sl_json_parser p = {.state = sl_json_element};
-  size_t count            = 0;
+  struct sl_json_parse_storage storage;
+  struct sl_json_parser p = {
+      .state = sl_json_element,
+      .stack = sl_json_parse_storage_stack(&storage),
+  };
+  size_t count = 0;
   while (sl_json_parse_advance(ctx, &p, len, json)) {
     count += (int)(p.event.emitted
                    && (p.event.type == sl_json_end_node || p.event.type == sl_json_value));
@@ -707,8 +891,12 @@ bool sl_json_find_path(
     const struct sl_json_path_step steps[restrict static n_steps],
     struct sl_json_node node[restrict static 1]
 ) {
-  struct sl_json_parser p = {0};
-  size_t step_idx         = 0;
+  struct sl_json_parse_storage storage;
+  struct sl_json_parser p = {
+      .state = sl_json_element,
+      .stack = sl_json_parse_storage_stack(&storage),
+  };
+  size_t step_idx = 0;
 
   // PHASE 1: navigate to the target node
 
@@ -739,9 +927,7 @@ bool sl_json_find_path(
            && memcmp(json + p.key_begin, step.key, step.key_len) == 0);
 
     bool array_index_matches
-        = (step.is_index && p.event.node_depth
-           && p.stack[p.event.node_depth - 1] == sl_json_container_array
-           && p.array_pos[p.event.node_depth - 1] == step.index);
+        = (step.is_index && sl_json_parse_event_index(&p) == step.index);
 
     if (object_key_matches || array_index_matches) {
       ++step_idx;
@@ -796,6 +982,194 @@ not_found:
   return false;
 }
 
+static bool sl_json_path_step_eq(
+    const struct sl_json_path_step a[restrict static 1],
+    const struct sl_json_path_step b[restrict static 1]
+) {
+  if (a->is_index || b->is_index) {
+    return a->is_index == b->is_index && a->index == b->index;
+  }
+  return a->key_len == b->key_len && memcmp(a->key, b->key, a->key_len) == 0;
+}
+
+bool sl_json_path_trie_compile(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_path_trie trie[restrict static 1],
+    size_t n_paths,
+    const struct sl_json_path paths[restrict static n_paths]
+) {
+  if (n_paths == 0 || n_paths > SL_JSON_PATH_TRIE_MAX_PATHS) {
+    SL_ERROR(
+        ctx,
+        "cannot search %zu JSON paths, at least 1 and at most %d supported",
+        n_paths,
+        SL_JSON_PATH_TRIE_MAX_PATHS
+    );
+    return false;
+  }
+  trie->size     = 1;
+  trie->nodes[0] = (struct sl_json_path_trie_node){0};
+  trie->n_paths  = n_paths;
+
+  for (size_t i = 0; i < n_paths; ++i) {
+    size_t node = 0;
+    for (size_t s = 0; s < paths[i].n_steps; ++s) {
+      const struct sl_json_path_step* step = paths[i].steps + s;
+
+      size_t child = trie->nodes[node].first_child;
+      while (child && !sl_json_path_step_eq(&(trie->nodes[child].step), step)) {
+        child = trie->nodes[child].next_sibling;
+      }
+      if (!child) {
+        if (trie->size == SL_JSON_PATH_TRIE_MAX_SIZE) {
+          SL_ERROR(
+              ctx,
+              "JSON paths have more than %d distinct prefixes",
+              SL_JSON_PATH_TRIE_MAX_SIZE - 1
+          );
+          return false;
+        }
+        child              = trie->size++;
+        trie->nodes[child] = (struct sl_json_path_trie_node){
+            .step         = *step,
+            .next_sibling = trie->nodes[node].first_child,
+        };
+        trie->nodes[node].first_child = child;
+      }
+      node = child;
+    }
+    trie->path_ends[i] = node;
+    trie->nodes[node].n_path_ends += 1;
+  }
+  return true;
+}
+
+// returns the child of node that matches the key or array index, or SIZE_MAX if there is none
+static size_t sl_json_path_trie_child(
+    const struct sl_json_path_trie trie[restrict static 1],
+    size_t node,
+    const struct sl_json_path_step step[restrict static 1]
+) {
+  if (node == SIZE_MAX) {
+    return SIZE_MAX;
+  }
+  for (size_t child = trie->nodes[node].first_child; child;
+       child        = trie->nodes[child].next_sibling) {
+    if (sl_json_path_step_eq(&(trie->nodes[child].step), step)) {
+      return child;
+    }
+  }
+  return SIZE_MAX;
+}
+
+// fills nodes[i] for each path i of the trie, nodes of paths that were not found are zeroed
+// returns the amount of paths found and stops parsing when all paths are found
+size_t sl_json_find_paths(
+    struct sl_context ctx[restrict static 1],
+    const struct sl_json_path_trie trie[restrict static 1],
+    size_t json_len,
+    const char json[restrict static json_len],
+    struct sl_json_node nodes[restrict static 1]
+) {
+  for (size_t i = 0; i < trie->n_paths; ++i) {
+    nodes[i] = (struct sl_json_node){0};
+  }
+  if (json_len == 0) {
+    SL_ERROR(ctx, "JSON content is empty");
+    return 0;
+  }
+
+  size_t n_unresolved = 0;
+  for (size_t t = 0; t < trie->size; ++t) {
+    n_unresolved += (size_t)(trie->nodes[t].n_path_ends > 0);
+  }
+  bool resolved[SL_JSON_PATH_TRIE_MAX_SIZE] = {0};
+  // trie node matched by the current value at each depth, SIZE_MAX if none
+  size_t matches[SL_JSON_PARSE_MAX_DEPTH + 1];
+  matches[0] = 0;
+
+  struct sl_json_parse_storage storage;
+  struct sl_json_parser p = {
+      .state = sl_json_element,
+      .stack = sl_json_parse_storage_stack(&storage),
+  };
+  while (n_unresolved > 0 && sl_json_parse_advance(ctx, &p, json_len, json)) {
+    if (!p.event.emitted) {
+      continue;
+    }
+    const size_t depth = p.event.node_depth;
+
+    switch (p.event.type) {
+      case sl_json_key: {
+        const struct sl_json_path_step key = {
+            .key     = json + p.key_begin,
+            .key_len = p.key_len,
+        };
+        matches[depth] = sl_json_path_trie_child(trie, matches[depth - 1], &key);
+      } break;
+
+      case sl_json_begin_node:
+      case sl_json_value: {
+        const size_t array_idx = sl_json_parse_event_index(&p);
+        if (array_idx != SIZE_MAX) {
+          const struct sl_json_path_step index = {
+              .is_index = true,
+              .index    = array_idx,
+          };
+          matches[depth] = sl_json_path_trie_child(trie, matches[depth - 1], &index);
+        }
+        const size_t t = matches[depth];
+        if (t == SIZE_MAX || trie->nodes[t].n_path_ends == 0 || resolved[t]) {
+          break;
+        }
+        const bool is_value = p.event.type == sl_json_value;
+        for (size_t i = 0; i < trie->n_paths; ++i) {
+          if (trie->path_ends[i] == t) {
+            nodes[i] = (struct sl_json_node){
+                .type        = p.event.node_type,
+                .value_begin = p.value_begin,
+                .value_len   = is_value ? p.pos - p.value_begin : 0,
+            };
+          }
+        }
+        if (is_value) {
+          resolved[t] = true;
+          --n_unresolved;
+        }
+      } break;
+
+      case sl_json_end_node: {
+        // container values are complete at their closing ] or }
+        const size_t t = matches[depth];
+        if (t == SIZE_MAX || trie->nodes[t].n_path_ends == 0 || resolved[t]) {
+          break;
+        }
+        for (size_t i = 0; i < trie->n_paths; ++i) {
+          if (trie->path_ends[i] == t) {
+            nodes[i].value_len = p.pos - nodes[i].value_begin;
+          }
+        }
+        resolved[t] = true;
+        --n_unresolved;
+      } break;
+    }
+  }
+
+  if (n_unresolved > 0 && p.state == sl_json_error && !sl_context_error_occurred(ctx)) {
+    SL_ERROR(ctx, "unknown JSON parse error");
+  }
+
+  size_t n_found = 0;
+  for (size_t i = 0; i < trie->n_paths; ++i) {
+    if (resolved[trie->path_ends[i]]) {
+      ++n_found;
+    } else {
+      nodes[i] = (struct sl_json_node){0};
+    }
+  }
+  return n_found;
+}
+
 bool sl_json_find(
     struct sl_context ctx[static 1],
     size_t json_len,
@@ -816,79 +1190,378 @@ bool sl_json_find(
   return sl_json_find_path(ctx, json_len, json, n_steps, steps, node);
 }
 
-bool sl_json_get_str(
-    struct sl_context ctx[static 1],
-    const struct sl_json_node node[static 1],
-    const char json[static 1],
-    size_t out_len,
-    char out[static out_len]
+static bool sl_json_tape_push(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_tape tape[restrict static 1],
+    struct sl_json_tape_node node
 ) {
-  if (node->type != sl_json_type_string) {
-    SL_ERROR(ctx, "node is not a string");
+  if (tape->size == tape->capacity) {
+    const size_t capacity           = tape->capacity ? 2 * tape->capacity : 64;
+    struct sl_json_tape_node* nodes = sl_realloc(
+        ctx,
+        tape->nodes,
+        tape->capacity,
+        capacity,
+        sizeof(struct sl_json_tape_node)
+    );
+    if (!nodes) {
+      SL_ERROR(ctx, "failed growing JSON tape to %zu nodes", capacity);
+      return false;
+    }
+    tape->nodes    = nodes;
+    tape->capacity = capacity;
+  }
+  tape->nodes[tape->size++] = node;
+  return true;
+}
+
+bool sl_json_tape_parse(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_tape tape[restrict static 1],
+    size_t len,
+    const char json[restrict static len]
+) {
+  tape->size = 0;
+  if (len == 0) {
+    SL_ERROR(ctx, "JSON content is empty");
     return false;
   }
 
-  // value_begin points at the opening '"', value_len covers both quotes
-  const char* src     = json + node->value_begin + 1;
-  const char* src_end = json + node->value_begin + node->value_len - 1;
-  size_t i_out        = 0;
-
-  while (src < src_end && i_out < out_len) {
-    char ch = *src++;
-    if (ch != '\\') {
-      // not escaped, copy and go to next char
-      out[i_out++] = ch;
+  struct sl_json_parse_storage storage;
+  struct sl_json_parser p = {
+      .state = sl_json_element,
+      .stack = sl_json_parse_storage_stack(&storage),
+  };
+  // tape index of the open container at each depth
+  size_t containers[SL_JSON_PARSE_MAX_DEPTH];
+  size_t key_begin = 0;
+  size_t key_len   = 0;
+
+  while (sl_json_parse_advance(ctx, &p, len, json)) {
+    if (!p.event.emitted) {
       continue;
     }
-    // ch is \ so it escapes something
-    // go to next char and handle each escape sequence separately
-    assert(src < src_end);
-    switch ((ch = *src++)) {
-      case '"': {
-        out[i_out++] = '"';
-      } break;
-      case '\\': {
-        out[i_out++] = '\\';
-      } break;
-      case 'n': {
-        out[i_out++] = '\n';
-      } break;
-      case 'r': {
-        out[i_out++] = '\r';
-      } break;
-      case 't': {
-        out[i_out++] = '\t';
-      } break;
-      case 'b': {
-        out[i_out++] = '\b';
+    switch (p.event.type) {
+      case sl_json_key: {
+        key_begin = p.key_begin;
+        key_len   = p.key_len;
       } break;
-      case 'f': {
-        out[i_out++] = '\f';
+      case sl_json_begin_node:
+      case sl_json_value: {
+        const bool is_value = p.event.type == sl_json_value;
+        if (!is_value) {
+          containers[p.event.node_depth] = tape->size;
+        }
+        const struct sl_json_tape_node node = {
+            .type        = p.event.node_type,
+            .key_begin   = key_begin,
+            .key_len     = key_len,
+            .value_begin = p.value_begin,
+            .value_len   = is_value ? p.pos - p.value_begin : 0,
+            .next        = is_value ? tape->size + 1 : 0,
+        };
+        if (!sl_json_tape_push(ctx, tape, node)) {
+          return false;
+        }
+        key_begin = 0;
+        key_len   = 0;
       } break;
-      case 'u': {
-        // 4 byte unicode escape
-        assert(src + 4 <= src_end);
-        char hex_buf[5] = {src[0], src[1], src[2], src[3], 0};
-        out[i_out++]    = (char)strtoul(hex_buf, nullptr, 16);
-        src += 4;
+      case sl_json_end_node: {
+        struct sl_json_tape_node* node = tape->nodes + containers[p.event.node_depth];
+        node->value_len                = p.pos - node->value_begin;
+        node->next                     = tape->size;
       } break;
-      default: {
-        assert(false);
-        __builtin_unreachable();
+    }
+  }
+
+  if (p.state != sl_json_done) {
+    if (!sl_context_error_occurred(ctx)) {
+      SL_ERROR(ctx, "unknown JSON parse error at offset %zu", p.pos);
+    }
+    tape->size = 0;
+    return false;
+  }
+  return true;
+}
+
+void sl_json_tape_destroy(struct sl_json_tape tape[static 1]) {
+  sl_free(tape->nodes);
+  *tape = (struct sl_json_tape){0};
+}
+
+// returns the index of the first node in document order at the end of steps from node idx
+// or tape->size if there is no such node
+static size_t sl_json_tape_walk(
+    const struct sl_json_tape tape[restrict static 1],
+    const char json[restrict static 1],
+    size_t idx,
+    size_t n_steps,
+    const struct sl_json_path_step steps[restrict static 1]
+) {
+  if (n_steps == 0) {
+    return idx;
+  }
+  const struct sl_json_tape_node* parent = tape->nodes + idx;
+  const struct sl_json_path_step step    = steps[0];
+
+  if (step.is_index) {
+    if (parent->type != sl_json_type_array) {
+      return tape->size;
+    }
+    size_t child = idx + 1;
+    for (size_t i = 0; i < step.index && child < parent->next; ++i) {
+      child = tape->nodes[child].next;
+    }
+    if (child >= parent->next) {
+      return tape->size;
+    }
+    return sl_json_tape_walk(tape, json, child, n_steps - 1, steps + 1);
+  }
+
+  if (parent->type != sl_json_type_object) {
+    return tape->size;
+  }
+  // duplicate keys are searched in order, like sl_json_find_path does
+  for (size_t child = idx + 1; child < parent->next; child = tape->nodes[child].next) {
+    const struct sl_json_tape_node* node = tape->nodes + child;
+    if (node->key_len == step.key_len
+        && memcmp(json + node->key_begin, step.key, step.key_len) == 0) {
+      const size_t found = sl_json_tape_walk(tape, json, child, n_steps - 1, steps + 1);
+      if (found < tape->size) {
+        return found;
+      }
+    }
+  }
+  return tape->size;
+}
+
+bool sl_json_tape_find_path(
+    const struct sl_json_tape tape[restrict static 1],
+    const char json[restrict static 1],
+    size_t n_steps,
+    const struct sl_json_path_step steps[restrict static n_steps],
+    struct sl_json_node node[restrict static 1]
+) {
+  *node = (struct sl_json_node){0};
+  if (tape->size == 0) {
+    return false;
+  }
+  const size_t idx = sl_json_tape_walk(tape, json, 0, n_steps, steps);
+  if (idx >= tape->size) {
+    return false;
+  }
+  *node = (struct sl_json_node){
+      .type        = tape->nodes[idx].type,
+      .value_begin = tape->nodes[idx].value_begin,
+      .value_len   = tape->nodes[idx].value_len,
+  };
+  return true;
+}
+
+bool sl_json_tape_find(
+    struct sl_context ctx[static 1],
+    const struct sl_json_tape tape[restrict static 1],
+    const char json[restrict static 1],
+    size_t path_len,
+    const char path[restrict static path_len],
+    struct sl_json_node node[static 1]
+) {
+  struct sl_json_path_step steps[SL_JSON_PARSE_MAX_DEPTH];
+  size_t n_steps = sl_json_parse_path(ctx, path_len, path, SL_ARRAY_LEN(steps), steps);
+  if (n_steps == 0) {
+    return false;
+  }
+  return sl_json_tape_find_path(tape, json, n_steps, steps, node);
+}
+
+// returns the offset of the first backslash in str, or len if there is none
+static inline size_t sl_json_find_escape(size_t len, const char str[static len]) {
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+    const uint64_t word = sl_json_load_word((const unsigned char*)str + i);
+    const uint64_t mask = sl_json_bytes_eq(word, '\\');
+    if (mask) {
+      return i + (size_t)__builtin_ctzll(mask) / 8;
+    }
+  }
+  while (i < len && str[i] != '\\') {
+    ++i;
+  }
+  return i;
+}
+
+static inline uint32_t sl_json_hex_value(const char hex[static 4]) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    const char ch = hex[i];
+    const uint32_t digit = (uint32_t)(ch <= '9' ? ch - '0' : (ch | 0x20) - 'a' + 10);
+    value                = (value << 4) | digit;
+  }
+  return value;
+}
+
+// writes codepoint as UTF-8 into out and returns the amount of bytes written
+static size_t sl_json_encode_utf8(uint32_t codepoint, unsigned char out[static 4]) {
+  if (codepoint < 0x80) {
+    out[0] = (unsigned char)codepoint;
+    return 1;
+  }
+  if (codepoint < 0x800) {
+    out[0] = (unsigned char)(0xc0 | (codepoint >> 6));
+    out[1] = (unsigned char)(0x80 | (codepoint & 0x3f));
+    return 2;
+  }
+  if (codepoint < 0x1'0000) {
+    out[0] = (unsigned char)(0xe0 | (codepoint >> 12));
+    out[1] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3f));
+    out[2] = (unsigned char)(0x80 | (codepoint & 0x3f));
+    return 3;
+  }
+  out[0] = (unsigned char)(0xf0 | (codepoint >> 18));
+  out[1] = (unsigned char)(0x80 | ((codepoint >> 12) & 0x3f));
+  out[2] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3f));
+  out[3] = (unsigned char)(0x80 | (codepoint & 0x3f));
+  return 4;
+}
+
+// decodes the escape sequence at src[0] == '\\' into at most 4 bytes of UTF-8 in out
+// returns the length of the escape sequence and sets out_size to the length of its output
+static size_t sl_json_decode_escape(
+    size_t len,
+    const char src[static len],
+    unsigned char out[static 4],
+    size_t out_size[static 1]
+) {
+  assert(len >= 2 && src[0] == '\\');
+  *out_size = 1;
+  switch (src[1]) {
+    case 'b': {
+      out[0] = '\b';
+    } break;
+    case 'f': {
+      out[0] = '\f';
+    } break;
+    case 'n': {
+      out[0] = '\n';
+    } break;
+    case 'r': {
+      out[0] = '\r';
+    } break;
+    case 't': {
+      out[0] = '\t';
+    } break;
+    case 'u': {
+      assert(len >= 6);
+      uint32_t codepoint = sl_json_hex_value(src + 2);
+      size_t escape_len  = 6;
+      if (0xd800 <= codepoint && codepoint <= 0xdbff && len >= 12 && src[6] == '\\'
+          && src[7] == 'u') {
+        const uint32_t low = sl_json_hex_value(src + 8);
+        if (0xdc00 <= low && low <= 0xdfff) {
+          codepoint  = 0x1'0000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+          escape_len = 12;
+        }
+      }
+      if (0xd800 <= codepoint && codepoint <= 0xdfff) {
+        // unpaired surrogates have no UTF-8 encoding
+        codepoint = 0xfffd;
       }
+      *out_size = sl_json_encode_utf8(codepoint, out);
+      return escape_len;
     }
+    default: {
+      // ", \ and /
+      out[0] = (unsigned char)src[1];
+    } break;
+  }
+  return 2;
+}
+
+// unescapes len bytes of string contents from src into out, out may be equal to src
+// unescaped output is never longer than the input
+// returns the length of the output, or SIZE_MAX if it does not fit in out_len bytes
+static size_t sl_json_unescape_into(
+    size_t len,
+    const char src[static len],
+    size_t out_len,
+    char out[static out_len]
+) {
+  size_t n_out = 0;
+  for (size_t i = 0; i < len;) {
+    // copy everything up to the next escape at once
+    const size_t run = sl_json_find_escape(len - i, src + i);
+    if (run > out_len - n_out) {
+      return SIZE_MAX;
+    }
+    memmove(out + n_out, src + i, run);
+    i += run;
+    n_out += run;
+    if (i == len) {
+      break;
+    }
+    unsigned char decoded[4];
+    size_t decoded_size = 0;
+    i += sl_json_decode_escape(len - i, src + i, decoded, &decoded_size);
+    if (decoded_size > out_len - n_out) {
+      return SIZE_MAX;
+    }
+    memcpy(out + n_out, decoded, decoded_size);
+    n_out += decoded_size;
   }
+  return n_out;
+}
 
-  if (i_out >= out_len) {
+bool sl_json_get_str(
+    struct sl_context ctx[static 1],
+    const struct sl_json_node node[static 1],
+    const char json[static 1],
+    size_t out_len,
+    char out[static out_len]
+) {
+  if (node->type != sl_json_type_string) {
+    SL_ERROR(ctx, "node is not a string");
+    return false;
+  }
+  // value_begin points at the opening '"', value_len covers both quotes
+  assert(node->value_len >= 2);
+  const char* src  = json + node->value_begin + 1;
+  const size_t len = node->value_len - 2;
+  // one byte is left for the null terminator
+  const size_t n = out_len ? sl_json_unescape_into(len, src, out_len - 1, out) : SIZE_MAX;
+  if (n == SIZE_MAX) {
     SL_ERROR(ctx, "output buffer too small");
     return false;
   }
-  out[i_out] = 0;
+  out[n] = 0;
+  return true;
+}
 
-  assert(src == src_end);
+bool sl_json_get_str_view(
+    const struct sl_json_node node[static 1],
+    const char json[static 1],
+    size_t len[static 1],
+    const char* str[static 1]
+) {
+  if (node->type != sl_json_type_string) {
+    return false;
+  }
+  assert(node->value_len >= 2);
+  const char* begin = json + node->value_begin + 1;
+  const size_t size = node->value_len - 2;
+  if (sl_json_find_escape(size, begin) < size) {
+    return false;
+  }
+  *len = size;
+  *str = begin;
   return true;
 }
 
+size_t sl_json_unescape(size_t len, char str[static len]) {
+  const size_t n = sl_json_unescape_into(len, str, len, str);
+  assert(n <= len);
+  return n;
+}
+
 bool sl_json_get_int(
     const struct sl_json_node node[static 1],
     const char json[static 1],
@@ -897,7 +1570,232 @@ bool sl_json_get_int(
   if (node->type != sl_json_type_number) {
     return false;
   }
-  char* end = nullptr;
-  *out      = strtoll(json + node->value_begin, &end, 10);
-  return end != json + node->value_begin;
+  int64_t value = 0;
+  if (sl_number_parse_i64(node->value_len, json + node->value_begin, &value) == 0) {
+    return false;
+  }
+  *out = value;
+  return true;
+}
+
+bool sl_json_get_double(
+    struct sl_context ctx[static 1],
+    const struct sl_json_node node[static 1],
+    const char json[static 1],
+    double out[static 1]
+) {
+  if (node->type != sl_json_type_number) {
+    return false;
+  }
+  return sl_number_parse_f64(ctx, node->value_len, json + node->value_begin, out)
+         == node->value_len;
+}
+
+bool sl_json_stream_create(
+    struct sl_context ctx[static 1],
+    struct sl_json_stream stream[static 1],
+    size_t capacity
+) {
+  if (capacity <= SL_JSON_PARSE_LOOKAHEAD) {
+    SL_ERROR(ctx, "JSON stream capacity must be larger than %d", SL_JSON_PARSE_LOOKAHEAD);
+    return false;
+  }
+  char* data = sl_alloc(ctx, capacity, 1);
+  if (!data) {
+    SL_ERROR(ctx, "failed allocating %zu byte JSON stream buffer", capacity);
+    return false;
+  }
+  struct sl_json_parse_storage* storage = sl_alloc(ctx, 1, sizeof(*storage));
+  if (!storage) {
+    SL_ERROR(ctx, "failed allocating JSON stream parser stack");
+    sl_free(data);
+    return false;
+  }
+  *stream = (struct sl_json_stream){
+      .parser =
+          {
+              .state = sl_json_element,
+              .stack = sl_json_parse_storage_stack(storage),
+          },
+      .capacity = capacity,
+      .data     = data,
+      .storage  = storage,
+  };
+  return true;
+}
+
+void sl_json_stream_destroy(struct sl_json_stream stream[static 1]) {
+  sl_free(stream->data);
+  sl_free(stream->storage);
+  *stream = (struct sl_json_stream){0};
+}
+
+void sl_json_stream_set_stack(
+    struct sl_json_stream stream[static 1],
+    struct sl_json_parse_stack stack
+) {
+  assert(stream->parser.depth == 0);
+  sl_free(stream->storage);
+  stream->storage      = nullptr;
+  stream->parser.stack = stack;
+}
+
+// amount of bytes from the current byte ch that the parser may read when parsing ch
+static size_t sl_json_parse_lookahead(const struct sl_json_parser p[static 1], char ch) {
+  switch (p->state) {
+    case sl_json_element:
+    case sl_json_array:
+    case sl_json_array_element: {
+      return (ch == 't' || ch == 'f' || ch == 'n') ? SL_JSON_PARSE_LOOKAHEAD : 1;
+    }
+    case sl_json_string_escape_value:
+    case sl_json_string_escape_key: {
+      return ch == 'u' ? SL_JSON_PARSE_LOOKAHEAD : 1;
+    }
+    case sl_json_object:
+    case sl_json_string_value:
+    case sl_json_string_key:
+    case sl_json_number_minus:
+    case sl_json_number_zero:
+    case sl_json_number_one_nine:
+    case sl_json_number_frac_first:
+    case sl_json_number_frac_digits:
+    case sl_json_number_exp_sign:
+    case sl_json_number_exp_first:
+    case sl_json_number_exp_digits:
+    case sl_json_colon:
+    case sl_json_member:
+    case sl_json_after_value:
+    case sl_json_done:
+    case sl_json_error:
+    case sl_json_error_end_of_input: {
+      return 1;
+    }
+  }
+  return 1;
+}
+
+// offset of the first byte still needed by the parser
+static size_t sl_json_stream_keep_begin(const struct sl_json_parser p[static 1]) {
+  switch (p->state) {
+    case sl_json_string_value:
+    case sl_json_string_key:
+    case sl_json_string_escape_value:
+    case sl_json_string_escape_key:
+    case sl_json_number_minus:
+    case sl_json_number_zero:
+    case sl_json_number_one_nine:
+    case sl_json_number_frac_first:
+    case sl_json_number_frac_digits:
+    case sl_json_number_exp_sign:
+    case sl_json_number_exp_first:
+    case sl_json_number_exp_digits: {
+      return p->value_begin;
+    }
+    case sl_json_element:
+    case sl_json_object:
+    case sl_json_array:
+    case sl_json_colon:
+    case sl_json_member:
+    case sl_json_array_element:
+    case sl_json_after_value:
+    case sl_json_done:
+    case sl_json_error:
+    case sl_json_error_end_of_input: {
+      // the parser may unget the previous byte
+      return p->pos ? p->pos - 1 : 0;
+    }
+  }
+  return 0;
+}
+
+// drops parsed input from the beginning of the buffer
+static void sl_json_stream_compact(struct sl_json_stream stream[static 1]) {
+  struct sl_json_parser* p = &(stream->parser);
+  const size_t shift       = sl_json_stream_keep_begin(p);
+  if (shift == 0) {
+    return;
+  }
+  memmove(stream->data, stream->data + shift, stream->size - shift);
+  stream->offset += shift;
+  stream->size -= shift;
+  p->pos -= shift;
+  // offsets of tokens that were already emitted are no longer valid
+  p->value_begin = p->value_begin >= shift ? p->value_begin - shift : 0;
+  p->key_begin   = p->key_begin >= shift ? p->key_begin - shift : 0;
+}
+
+size_t sl_json_stream_feed(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_stream stream[restrict static 1],
+    size_t size,
+    const char chunk[restrict static size]
+) {
+  if (stream->is_final) {
+    SL_ERROR(ctx, "cannot feed a finished JSON stream");
+    return 0;
+  }
+  if (stream->capacity - stream->size < size) {
+    sl_json_stream_compact(stream);
+  }
+  const size_t n = SL_MIN(size, stream->capacity - stream->size);
+  if (n == 0 && size > 0) {
+    SL_ERROR(
+        ctx,
+        "JSON token at offset %zu does not fit in %zu byte stream buffer",
+        stream->offset + sl_json_stream_keep_begin(&(stream->parser)),
+        stream->capacity
+    );
+    return 0;
+  }
+  memcpy(stream->data + stream->size, chunk, n);
+  stream->size += n;
+  // the last block was classified with zeros in place of the new input
+  stream->parser.block_end = 0;
+  return n;
+}
+
+void sl_json_stream_finish(struct sl_json_stream stream[static 1]) {
+  stream->is_final         = true;
+  stream->parser.block_end = 0;
+}
+
+bool sl_json_stream_next(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_stream stream[restrict static 1]
+) {
+  struct sl_json_parser* p = &(stream->parser);
+  if (stream->size == 0) {
+    if (stream->is_final && p->state == sl_json_element) {
+      SL_ERROR(ctx, "JSON content is empty");
+      p->state = sl_json_error;
+    }
+    return false;
+  }
+  for (;;) {
+    if (!stream->is_final) {
+      // the next byte is parsed only when all bytes it could look ahead at have arrived
+      sl_json_parse_skip(p, stream->size, stream->data);
+      if (p->pos == stream->size
+          || stream->size - p->pos < sl_json_parse_lookahead(p, stream->data[p->pos])) {
+        return false;
+      }
+    }
+    if (!sl_json_parse_advance(ctx, p, stream->size, stream->data)) {
+      break;
+    }
+    if (p->event.emitted) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool sl_json_stream_needs_input(const struct sl_json_stream stream[static 1]) {
+  const enum sl_json_parse_state state = stream->parser.state;
+  return !stream->is_final && state != sl_json_error && state != sl_json_error_end_of_input;
+}
+
+bool sl_json_stream_is_done(const struct sl_json_stream stream[static 1]) {
+  return stream->parser.state == sl_json_done;
 }
@@ -5,18 +5,38 @@
  * can read invalid JSON as long as it is valid up to and including the searched key-value pair
  * duplicate keys are not considered invalid
  * sl_json_find will continue searching until a match is found or input is exhausted
+ * sl_json_tape parses a complete document once into a flat node array for repeated lookups
+ * sl_json_stream parses input that arrives in chunks, e.g. from a socket or a pipe
  *
  */
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <stufflib/context/context.h>
 
 #ifndef SL_JSON_PARSE_MAX_DEPTH
-  // maximum level of object nesting
+  // maximum level of nesting, unless a stream is given a deeper stack
   #define SL_JSON_PARSE_MAX_DEPTH 512
 #endif
 
+// amount of 64-bit words in the container bitstack for depth levels of nesting
+#define SL_JSON_PARSE_STACK_WORDS(depth) (((depth) + 63) / 64)
+
+// maximum amount of input bytes the parser reads when parsing one byte
+// (the literal "false" or a \u escape with 4 hex digits)
+#define SL_JSON_PARSE_LOOKAHEAD 5
+
+#ifndef SL_JSON_PATH_TRIE_MAX_PATHS
+  // maximum amount of paths searched in one pass
+  #define SL_JSON_PATH_TRIE_MAX_PATHS 64
+#endif
+
+#ifndef SL_JSON_PATH_TRIE_MAX_SIZE
+  // maximum amount of distinct path prefixes searched in one pass
+  #define SL_JSON_PATH_TRIE_MAX_SIZE 512
+#endif
+
 enum sl_json_type : signed char {
   sl_json_type_NONE = 0,
   sl_json_type_object,
@@ -66,12 +86,6 @@ enum sl_json_parse_state : signed char {
   sl_json_error_end_of_input,
 };
 
-enum sl_json_container : signed char {
-  sl_json_container_NONE = 0,
-  sl_json_container_object,
-  sl_json_container_array,
-};
-
 enum sl_json_event_type : signed char {
   sl_json_key = 0,
   sl_json_begin_node,
@@ -86,6 +100,24 @@ struct sl_json_event {
   size_t node_depth;
 };
 
+// open containers of a parser, entries are written before they are read and need no initialization
+struct sl_json_parse_stack {
+  // maximum depth
+  size_t capacity;
+  // bit d % 64 of is_array[d / 64] is set if the container at depth d + 1 is an array
+  // SL_JSON_PARSE_STACK_WORDS(capacity) words
+  uint64_t* is_array;
+  // positions in the open arrays enclosing the innermost open array, outermost first
+  // capacity items
+  size_t* array_pos;
+};
+
+// a stack of SL_JSON_PARSE_MAX_DEPTH levels
+struct sl_json_parse_storage {
+  uint64_t is_array[SL_JSON_PARSE_STACK_WORDS(SL_JSON_PARSE_MAX_DEPTH)];
+  size_t array_pos[SL_JSON_PARSE_MAX_DEPTH];
+};
+
 struct sl_json_parser {
   // current byte offset in the json string
   size_t pos;
@@ -106,10 +138,22 @@ struct sl_json_parser {
 
   // current depth, increases on { and [, decreases on } and ]
   size_t depth;
-  // container type at depth-1
-  enum sl_json_container stack[SL_JSON_PARSE_MAX_DEPTH];
-  // index of current array element at depth-1 (only valid if stack[depth-1] is an array)
-  size_t array_pos[SL_JSON_PARSE_MAX_DEPTH];
+  // the container at depth-1 is an array
+  bool in_array;
+  // amount of open arrays
+  size_t n_arrays;
+  // index of the current element in the innermost open array
+  size_t array_pos;
+  struct sl_json_parse_stack stack;
+
+  // classified block of 64 input bytes [block_begin, block_end), none if block_end is 0
+  // used for skipping whitespace and string contents without stepping over every byte
+  size_t block_begin;
+  size_t block_end;
+  // bit i is set if byte block_begin + i is not whitespace
+  uint64_t block_non_ws;
+  // bit i is set if byte block_begin + i is ", \ or a control character
+  uint64_t block_string_stop;
 };
 
 bool sl_json_is_valid(
@@ -161,6 +205,44 @@ bool sl_json_find_path(
     struct sl_json_node node[restrict static 1]
 );
 
+struct sl_json_path {
+  size_t n_steps;
+  const struct sl_json_path_step* steps;
+};
+
+// paths sharing a prefix share the trie nodes of the prefix, node 0 is the empty path
+struct sl_json_path_trie_node {
+  struct sl_json_path_step step;
+  // 0 if there are no children or siblings
+  size_t first_child;
+  size_t next_sibling;
+  // amount of paths ending at this node
+  size_t n_path_ends;
+};
+
+struct sl_json_path_trie {
+  size_t size;
+  struct sl_json_path_trie_node nodes[SL_JSON_PATH_TRIE_MAX_SIZE];
+  size_t n_paths;
+  // trie node at the end of each path
+  size_t path_ends[SL_JSON_PATH_TRIE_MAX_PATHS];
+};
+
+bool sl_json_path_trie_compile(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_path_trie trie[restrict static 1],
+    size_t n_paths,
+    const struct sl_json_path paths[restrict static n_paths]
+);
+
+size_t sl_json_find_paths(
+    struct sl_context ctx[restrict static 1],
+    const struct sl_json_path_trie trie[restrict static 1],
+    size_t json_len,
+    const char json[restrict static json_len],
+    struct sl_json_node nodes[restrict static 1]
+);
+
 bool sl_json_find(
     struct sl_context ctx[static 1],
     size_t json_len,
@@ -170,6 +252,53 @@ bool sl_json_find(
     struct sl_json_node node[static 1]
 );
 
+// one node per JSON value in document order
+struct sl_json_tape_node {
+  enum sl_json_type type;
+  // byte offset and length of the key without quotes, only for object members
+  size_t key_begin;
+  size_t key_len;
+  // byte offset and length of the value in the JSON string
+  size_t value_begin;
+  size_t value_len;
+  // index of the next sibling, the descendants of a container are between it and next
+  size_t next;
+};
+
+// nodes refer to the JSON string by byte offsets and are valid as long as the string is
+struct sl_json_tape {
+  size_t size;
+  size_t capacity;
+  struct sl_json_tape_node* nodes;
+};
+
+bool sl_json_tape_parse(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_tape tape[restrict static 1],
+    size_t len,
+    const char json[restrict static len]
+);
+void sl_json_tape_destroy(struct sl_json_tape tape[static 1]);
+
+bool sl_json_tape_find_path(
+    const struct sl_json_tape tape[restrict static 1],
+    const char json[restrict static 1],
+    size_t n_steps,
+    const struct sl_json_path_step steps[restrict static n_steps],
+    struct sl_json_node node[restrict static 1]
+);
+
+bool sl_json_tape_find(
+    struct sl_context ctx[static 1],
+    const struct sl_json_tape tape[restrict static 1],
+    const char json[restrict static 1],
+    size_t path_len,
+    const char path[restrict static path_len],
+    struct sl_json_node node[static 1]
+);
+
+// unescapes the contents of a string node into out and null-terminates them
+// \u escapes are decoded into UTF-8, unpaired surrogates into U+FFFD
 bool sl_json_get_str(
     struct sl_context ctx[static 1],
     const struct sl_json_node node[static 1],
@@ -177,6 +306,17 @@ bool sl_json_get_str(
     size_t out_len,
     char out[static out_len]
 );
+// points str at the contents of a string node in json without copying them
+// returns false if the node is not a string or has escapes, those need sl_json_get_str
+bool sl_json_get_str_view(
+    const struct sl_json_node node[static 1],
+    const char json[static 1],
+    size_t len[static 1],
+    const char* str[static 1]
+);
+// unescapes string contents in place, str must be valid as the contents of a JSON string
+// returns the unescaped length, which is never longer than len
+size_t sl_json_unescape(size_t len, char str[static len]);
 
 bool sl_json_get_int(
     const struct sl_json_node node[static 1],
@@ -184,4 +324,57 @@ bool sl_json_get_int(
     long long out[static 1]
 );
 
+bool sl_json_get_double(
+    struct sl_context ctx[static 1],
+    const struct sl_json_node node[static 1],
+    const char json[static 1],
+    double out[static 1]
+);
+
+// input of a JSON document pushed in chunks of any size and parsed as it arrives
+// the buffer holds unparsed input and the token being parsed, which must fit in capacity bytes
+// offsets in the parser and its events are relative to data and valid until the next feed
+struct sl_json_stream {
+  struct sl_json_parser parser;
+  // input offset of data[0] from the beginning of the document
+  size_t offset;
+  size_t size;
+  size_t capacity;
+  char* data;
+  // the document ends at data[size]
+  bool is_final;
+  // parser stack allocated by create, freed when a stack is set with sl_json_stream_set_stack
+  struct sl_json_parse_storage* storage;
+};
+
+bool sl_json_stream_create(
+    struct sl_context ctx[static 1],
+    struct sl_json_stream stream[static 1],
+    size_t capacity
+);
+void sl_json_stream_destroy(struct sl_json_stream stream[static 1]);
+// parses nesting up to stack.capacity levels using caller-provided memory
+// must be called before the first feed, stack must outlive the stream
+void sl_json_stream_set_stack(
+    struct sl_json_stream stream[static 1],
+    struct sl_json_parse_stack stack
+);
+// appends as much of the chunk as there is room for, returns the amount of bytes appended
+size_t sl_json_stream_feed(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_stream stream[restrict static 1],
+    size_t size,
+    const char chunk[restrict static size]
+);
+// marks the end of the document
+void sl_json_stream_finish(struct sl_json_stream stream[static 1]);
+// parses until the next event in stream->parser.event
+// returns false if more input is needed, the document is done or on error
+bool sl_json_stream_next(
+    struct sl_context ctx[restrict static 1],
+    struct sl_json_stream stream[restrict static 1]
+);
+bool sl_json_stream_needs_input(const struct sl_json_stream stream[static 1]);
+bool sl_json_stream_is_done(const struct sl_json_stream stream[static 1]);
+
 #endif  // SL_JSON_H_INCLUDED
@@ -0,0 +1,466 @@
+#include <locale.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/error/error.h>
+#include <stufflib/json/json.h>
+#include <stufflib/json/writer.h>
+#include <stufflib/memory/memory.h>
+#include <stufflib/number/number.h>
+#include <stufflib/span/span.h>
+
+// longest formatted number, 20 digits and a sign or a %.17g double
+#define SL_JSON_WRITER_NUMBER_SIZE 32
+
+static const char sl_json_writer_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+bool sl_json_writer_create(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    FILE* stream,
+    size_t capacity
+) {
+  *writer = (struct sl_json_writer){.stream = stream};
+  if (!sl_span_create(ctx, capacity, &(writer->buffer))) {
+    SL_ERROR(ctx, "failed allocating %zu byte JSON writer buffer", capacity);
+    return false;
+  }
+  return true;
+}
+
+void sl_json_writer_init(
+    struct sl_json_writer writer[static 1],
+    FILE* stream,
+    size_t capacity,
+    unsigned char buffer[static capacity]
+) {
+  *writer = (struct sl_json_writer){
+      .stream = stream,
+      .buffer = sl_span_view(capacity, buffer),
+  };
+}
+
+void sl_json_writer_destroy(struct sl_json_writer writer[static 1]) {
+  sl_span_destroy(&(writer->buffer));
+  *writer = (struct sl_json_writer){0};
+}
+
+bool sl_json_writer_flush(struct sl_context ctx[static 1], struct sl_json_writer writer[static 1]) {
+  if (!writer->stream || writer->size == 0) {
+    return true;
+  }
+  if (fwrite(writer->buffer.data, 1, writer->size, writer->stream) != writer->size) {
+    SL_ERROR(ctx, "failed writing %zu bytes of JSON", writer->size);
+    return false;
+  }
+  writer->size = 0;
+  return true;
+}
+
+// makes room for n more bytes by flushing or growing the buffer
+static bool sl_json_writer_reserve(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    size_t n
+) {
+  if (writer->buffer.size - writer->size >= n) {
+    return true;
+  }
+  if (writer->stream) {
+    if (!sl_json_writer_flush(ctx, writer)) {
+      return false;
+    }
+    if (writer->buffer.size >= n) {
+      return true;
+    }
+  }
+  if (!writer->buffer.owned) {
+    SL_ERROR(ctx, "JSON writer buffer of %zu bytes is full", writer->buffer.size);
+    return false;
+  }
+  size_t capacity = 2 * writer->buffer.size;
+  if (capacity < writer->size + n) {
+    capacity = writer->size + n;
+  }
+  unsigned char* data = sl_realloc(ctx, writer->buffer.data, writer->buffer.size, capacity, 1);
+  if (!data) {
+    SL_ERROR(ctx, "failed growing JSON writer buffer to %zu bytes", capacity);
+    return false;
+  }
+  writer->buffer.data = data;
+  writer->buffer.size = capacity;
+  return true;
+}
+
+static bool sl_json_writer_append(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    size_t len,
+    const char data[static len]
+) {
+  if (writer->stream && len > writer->buffer.size) {
+    // larger than the whole buffer, skip the copy
+    if (!sl_json_writer_flush(ctx, writer)) {
+      return false;
+    }
+    if (fwrite(data, 1, len, writer->stream) != len) {
+      SL_ERROR(ctx, "failed writing %zu bytes of JSON", len);
+      return false;
+    }
+    return true;
+  }
+  if (!sl_json_writer_reserve(ctx, writer, len)) {
+    return false;
+  }
+  memcpy(writer->buffer.data + writer->size, data, len);
+  writer->size += len;
+  return true;
+}
+
+static bool sl_json_writer_append_escaped(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const char str[const static 1]
+) {
+  if (!sl_json_writer_append(ctx, writer, 1, "\"")) {
+    return false;
+  }
+  const unsigned char* const s = (const unsigned char*)str;
+  for (size_t begin = 0, end = 0;; begin = ++end) {
+    // runs of bytes that need no escaping are copied as is, the terminating 0 is a control byte
+    while (s[end] >= 0x20 && s[end] != '"' && s[end] != '\\') {
+      ++end;
+    }
+    if (!sl_json_writer_append(ctx, writer, end - begin, str + begin)) {
+      return false;
+    }
+    if (!s[end]) {
+      break;
+    }
+    char escape[8] = {'\\'};
+    size_t n       = 2;
+    switch (s[end]) {
+      case '"':
+        escape[1] = '"';
+        break;
+      case '\\':
+        escape[1] = '\\';
+        break;
+      case '\b':
+        escape[1] = 'b';
+        break;
+      case '\f':
+        escape[1] = 'f';
+        break;
+      case '\n':
+        escape[1] = 'n';
+        break;
+      case '\r':
+        escape[1] = 'r';
+        break;
+      case '\t':
+        escape[1] = 't';
+        break;
+      default:
+        n = (size_t)snprintf(escape, sizeof(escape), "\\u%04x", (unsigned)s[end]);
+        break;
+    }
+    if (!sl_json_writer_append(ctx, writer, n, escape)) {
+      return false;
+    }
+  }
+  return sl_json_writer_append(ctx, writer, 1, "\"");
+}
+
+// checks that a value may be written next and writes the separator before it
+static bool sl_json_writer_begin_value(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+) {
+  if (writer->depth == 0 || writer->has_key) {
+    return true;
+  }
+  if (writer->containers[writer->depth - 1] == sl_json_type_object) {
+    SL_ERROR(ctx, "JSON writer expected an object key before the value");
+    return false;
+  }
+  return !writer->has_items || sl_json_writer_append(ctx, writer, 1, ",");
+}
+
+static bool sl_json_writer_end_value(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+) {
+  writer->has_key   = false;
+  writer->has_items = writer->depth > 0;
+  return writer->depth > 0 || sl_json_writer_append(ctx, writer, 1, "\n");
+}
+
+static bool sl_json_writer_write_value(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    size_t len,
+    const char value[static len]
+) {
+  return sl_json_writer_begin_value(ctx, writer)
+         && sl_json_writer_append(ctx, writer, len, value)
+         && sl_json_writer_end_value(ctx, writer);
+}
+
+static bool sl_json_writer_begin(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    enum sl_json_type type
+) {
+  if (writer->depth == SL_JSON_WRITER_MAX_DEPTH) {
+    SL_ERROR(ctx, "JSON writer supports at most %d nested containers", SL_JSON_WRITER_MAX_DEPTH);
+    return false;
+  }
+  if (!sl_json_writer_begin_value(ctx, writer)
+      || !sl_json_writer_append(ctx, writer, 1, type == sl_json_type_object ? "{" : "[")) {
+    return false;
+  }
+  writer->containers[writer->depth++] = type;
+  writer->has_items                   = false;
+  writer->has_key                     = false;
+  return true;
+}
+
+static bool sl_json_writer_end(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    enum sl_json_type type
+) {
+  const char* const name = type == sl_json_type_object ? "object" : "array";
+  if (writer->depth == 0 || writer->containers[writer->depth - 1] != type) {
+    SL_ERROR(ctx, "JSON writer has no open %s to end", name);
+    return false;
+  }
+  if (writer->has_key) {
+    SL_ERROR(ctx, "JSON writer expected a value for the last key before ending the %s", name);
+    return false;
+  }
+  if (!sl_json_writer_append(ctx, writer, 1, type == sl_json_type_object ? "}" : "]")) {
+    return false;
+  }
+  --writer->depth;
+  return sl_json_writer_end_value(ctx, writer);
+}
+
+bool sl_json_writer_object_begin(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+) {
+  return sl_json_writer_begin(ctx, writer, sl_json_type_object);
+}
+
+bool sl_json_writer_object_end(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+) {
+  return sl_json_writer_end(ctx, writer, sl_json_type_object);
+}
+
+bool sl_json_writer_array_begin(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+) {
+  return sl_json_writer_begin(ctx, writer, sl_json_type_array);
+}
+
+bool sl_json_writer_array_end(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+) {
+  return sl_json_writer_end(ctx, writer, sl_json_type_array);
+}
+
+bool sl_json_writer_key(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const char key[const static 1]
+) {
+  if (writer->depth == 0 || writer->containers[writer->depth - 1] != sl_json_type_object) {
+    SL_ERROR(ctx, "JSON writer cannot write key '%s' outside of an object", key);
+    return false;
+  }
+  if (writer->has_key) {
+    SL_ERROR(ctx, "JSON writer expected a value before key '%s'", key);
+    return false;
+  }
+  if (writer->has_items && !sl_json_writer_append(ctx, writer, 1, ",")) {
+    return false;
+  }
+  if (!sl_json_writer_append_escaped(ctx, writer, key)
+      || !sl_json_writer_append(ctx, writer, 1, ":")) {
+    return false;
+  }
+  writer->has_key = true;
+  return true;
+}
+
+bool sl_json_writer_end_to_depth(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const size_t depth
+) {
+  if (writer->has_key && !sl_json_writer_null(ctx, writer)) {
+    return false;
+  }
+  while (writer->depth > depth) {
+    if (!sl_json_writer_end(ctx, writer, writer->containers[writer->depth - 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool sl_json_writer_string(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const char str[const static 1]
+) {
+  return sl_json_writer_begin_value(ctx, writer)
+         && sl_json_writer_append_escaped(ctx, writer, str)
+         && sl_json_writer_end_value(ctx, writer);
+}
+
+// formats value into the end of out two digits at a time, returns the offset of the first digit
+static size_t sl_json_writer_format_u64(
+    uint64_t value,
+    char out[static SL_JSON_WRITER_NUMBER_SIZE]
+) {
+  size_t pos = SL_JSON_WRITER_NUMBER_SIZE;
+  while (value >= 100) {
+    const size_t pair = 2 * (value % 100);
+    value /= 100;
+    pos -= 2;
+    memcpy(out + pos, sl_json_writer_digit_pairs + pair, 2);
+  }
+  if (value >= 10) {
+    pos -= 2;
+    memcpy(out + pos, sl_json_writer_digit_pairs + (2 * value), 2);
+  } else {
+    out[--pos] = (char)('0' + value);
+  }
+  return pos;
+}
+
+bool sl_json_writer_int(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    int64_t value
+) {
+  char out[SL_JSON_WRITER_NUMBER_SIZE] = {0};
+  // negation of the magnitude as unsigned is also correct for INT64_MIN
+  const uint64_t magnitude = value < 0 ? ~(uint64_t)value + 1 : (uint64_t)value;
+  size_t begin             = sl_json_writer_format_u64(magnitude, out);
+  if (value < 0) {
+    out[--begin] = '-';
+  }
+  return sl_json_writer_write_value(ctx, writer, SL_JSON_WRITER_NUMBER_SIZE - begin, out + begin);
+}
+
+bool sl_json_writer_uint(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    uint64_t value
+) {
+  char out[SL_JSON_WRITER_NUMBER_SIZE] = {0};
+  const size_t begin                   = sl_json_writer_format_u64(value, out);
+  return sl_json_writer_write_value(ctx, writer, SL_JSON_WRITER_NUMBER_SIZE - begin, out + begin);
+}
+
+static uint64_t sl_json_writer_double_bits(double value) {
+  uint64_t bits = 0;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// formats value with precision significant digits, returns true if out parses back into value
+static bool sl_json_writer_format_double(
+    struct sl_context ctx[static 1],
+    const double value,
+    const int precision,
+    char out[static SL_JSON_WRITER_NUMBER_SIZE],
+    size_t len[static 1]
+) {
+  *len          = (size_t)snprintf(out, SL_JSON_WRITER_NUMBER_SIZE, "%.*g", precision, value);
+  double parsed = 0;
+  return sl_number_parse_f64(ctx, *len, out, &parsed) == *len
+         && sl_json_writer_double_bits(parsed) == sl_json_writer_double_bits(value);
+}
+
+bool sl_json_writer_double(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    double value
+) {
+  if (!isfinite(value)) {
+    return sl_json_writer_null(ctx, writer);
+  }
+  // integers are exact in the integer formatter
+  if (fabs(value) < 0x1p53
+      && sl_json_writer_double_bits(value) == sl_json_writer_double_bits((double)(int64_t)value)) {
+    return sl_json_writer_int(ctx, writer, (int64_t)value);
+  }
+
+  // snprintf writes the decimal point of the current locale, which would not be valid JSON
+  const locale_t c_locale = sl_number_c_locale();
+  const locale_t previous = c_locale ? uselocale(c_locale) : (locale_t)0;
+  if (!previous) {
+    SL_ERROR(ctx, "JSON writer cannot switch to the C locale for formatting %g", value);
+    return false;
+  }
+  // fewest significant digits that parse back exactly, 17 always do
+  // most values, e.g. metrics and floats widened to double, need 16 or 17 and are tried first
+  // decimals of up to 15 digits are more than an ulp apart, so if a precision parses back,
+  // so does every longer precision up to 15, and the shortest one can be bisected
+  char out[SL_JSON_WRITER_NUMBER_SIZE]      = {0};
+  char shortest[SL_JSON_WRITER_NUMBER_SIZE] = {0};
+  size_t len                                = 0;
+  size_t shortest_len                       = 0;
+  const size_t n_errors                     = sl_error_depth(&(ctx->errors));
+  if (!sl_json_writer_format_double(ctx, value, 15, shortest, &shortest_len)) {
+    if (!sl_json_writer_format_double(ctx, value, 16, shortest, &shortest_len)) {
+      sl_json_writer_format_double(ctx, value, 17, shortest, &shortest_len);
+    }
+  } else {
+    int lo = 1;
+    int hi = 15;
+    while (lo < hi) {
+      const int mid = lo + ((hi - lo) / 2);
+      if (sl_json_writer_format_double(ctx, value, mid, out, &len)) {
+        memcpy(shortest, out, len);
+        shortest_len = len;
+        hi           = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+  }
+  uselocale(previous);
+  return sl_error_depth(&(ctx->errors)) == n_errors
+         && sl_json_writer_write_value(ctx, writer, shortest_len, shortest);
+}
+
+bool sl_json_writer_bool(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    bool value
+) {
+  return value ? sl_json_writer_write_value(ctx, writer, 4, "true")
+               : sl_json_writer_write_value(ctx, writer, 5, "false");
+}
+
+bool sl_json_writer_null(struct sl_context ctx[static 1], struct sl_json_writer writer[static 1]) {
+  return sl_json_writer_write_value(ctx, writer, 4, "null");
+}
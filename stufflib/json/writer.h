@@ -0,0 +1,112 @@
+#ifndef SL_JSON_WRITER_H_INCLUDED
+#define SL_JSON_WRITER_H_INCLUDED
+/*
+ * JSON writer that appends compact JSON text into a buffer
+ * with a stream, the buffer is written to it whenever it fills up and on flush,
+ * without a stream, an owned buffer grows as needed and holds all output
+ * each top-level value is ended with a newline, consecutive values form NDJSON
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/json/json.h>
+#include <stufflib/span/span.h>
+
+#define SL_JSON_WRITER_MAX_DEPTH 64
+
+// default buffer size for writers that flush into a stream
+#define SL_JSON_WRITER_BUFFER_SIZE 65'536
+
+struct sl_json_writer {
+  FILE* stream;
+  struct sl_span buffer;
+  // length of the output in buffer
+  size_t size;
+  // open containers from outermost to innermost
+  size_t depth;
+  enum sl_json_type containers[SL_JSON_WRITER_MAX_DEPTH];
+  // the innermost container has items, next item needs a comma
+  bool has_items;
+  // an object key was written, next item must be its value
+  bool has_key;
+};
+
+// allocates a capacity byte buffer, stream may be null
+bool sl_json_writer_create(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    FILE* stream,
+    size_t capacity
+);
+// writes into a caller-provided buffer, which is never reallocated
+void sl_json_writer_init(
+    struct sl_json_writer writer[static 1],
+    FILE* stream,
+    size_t capacity,
+    unsigned char buffer[static capacity]
+);
+void sl_json_writer_destroy(struct sl_json_writer writer[static 1]);
+// writes buffered output into the stream, if there is one
+bool sl_json_writer_flush(struct sl_context ctx[static 1], struct sl_json_writer writer[static 1]);
+
+bool sl_json_writer_object_begin(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+);
+bool sl_json_writer_object_end(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+);
+bool sl_json_writer_array_begin(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+);
+bool sl_json_writer_array_end(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+);
+bool sl_json_writer_key(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const char key[const static 1]
+);
+// ends the innermost containers until depth are open, e.g. to finish a value that failed part-way
+// a key without a value gets null
+bool sl_json_writer_end_to_depth(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    size_t depth
+);
+
+bool sl_json_writer_string(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const char str[const static 1]
+);
+bool sl_json_writer_int(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    int64_t value
+);
+bool sl_json_writer_uint(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    uint64_t value
+);
+// shortest decimal that parses back into value, NaN and infinities are written as null
+bool sl_json_writer_double(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    double value
+);
+bool sl_json_writer_bool(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    bool value
+);
+bool sl_json_writer_null(struct sl_context ctx[static 1], struct sl_json_writer writer[static 1]);
+
+#endif  // SL_JSON_WRITER_H_INCLUDED
@@ -7,8 +7,10 @@
 
 #include <stufflib/context/context.h>
 #include <stufflib/linalg/linalg.h>
+#include <stufflib/linalg/simd.h>
 #include <stufflib/macros/macros.h>
 #include <stufflib/math/math.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
 #include <stufflib/memory/memory.h>
 #include <stufflib/vector/sl_vector_f32.h>
@@ -86,32 +88,186 @@ sl_la_matrix_row_view(struct sl_matrix_f32 a[const static 1], const size_t row)
   };
 }
 
+bool sl_la_csr_create(
+    struct sl_context ctx[static 1],
+    const size_t rows,
+    const size_t cols,
+    const size_t nnz_capacity,
+    struct sl_csr_f32 out[static 1]
+) {
+  assert(rows > 0 && cols > 0 && nnz_capacity > 0);
+  assert(cols <= (size_t)UINT32_MAX);
+  size_t* row_ptr   = sl_alloc(ctx, rows + 1, sizeof(size_t));
+  uint32_t* col_idx = sl_alloc(ctx, nnz_capacity, sizeof(uint32_t));
+  float* values     = sl_alloc(ctx, nnz_capacity, sizeof(float));
+  if (!row_ptr || !col_idx || !values) {
+    sl_free(row_ptr);
+    sl_free(col_idx);
+    sl_free(values);
+    return false;
+  }
+  *out = (struct sl_csr_f32){
+      .num_cols     = cols,
+      .row_capacity = rows,
+      .nnz_capacity = nnz_capacity,
+      .row_ptr      = row_ptr,
+      .col_idx      = col_idx,
+      .values       = values,
+  };
+  return true;
+}
+
+void sl_la_csr_destroy(struct sl_csr_f32 a[const static 1]) {
+  sl_free(a->row_ptr);
+  sl_free(a->col_idx);
+  sl_free(a->values);
+  *a = (struct sl_csr_f32){0};
+}
+
+bool sl_la_csr_reserve(
+    struct sl_context ctx[static 1],
+    struct sl_csr_f32 a[const static 1],
+    const size_t nnz_capacity
+) {
+  if (nnz_capacity <= a->nnz_capacity) {
+    return true;
+  }
+  uint32_t* col_idx
+      = sl_realloc(ctx, a->col_idx, a->nnz_capacity, nnz_capacity, sizeof(uint32_t));
+  if (!col_idx) {
+    return false;
+  }
+  a->col_idx    = col_idx;
+  float* values = sl_realloc(ctx, a->values, a->nnz_capacity, nnz_capacity, sizeof(float));
+  if (!values) {
+    return false;
+  }
+  a->values       = values;
+  a->nnz_capacity = nnz_capacity;
+  return true;
+}
+
+void sl_la_csr_clear(struct sl_csr_f32 a[const static 1]) {
+  a->num_rows   = 0;
+  a->row_ptr[0] = 0;
+}
+
+void sl_la_csr_to_dense(
+    struct sl_matrix_f32 dst[const static 1],
+    const struct sl_csr_f32 src[const static 1]
+) {
+  assert(sl_matrix_f32_num_rows(dst) >= sl_csr_f32_num_rows(src));
+  assert(sl_matrix_f32_num_cols(dst) == sl_csr_f32_num_cols(src));
+  memset(dst->data, 0, sizeof(float) * sl_matrix_f32_size(dst));
+  for (size_t row = 0; row < sl_csr_f32_num_rows(src); ++row) {
+    for (size_t i = src->row_ptr[row]; i < src->row_ptr[row + 1]; ++i) {
+      *sl_matrix_f32_get(dst, row, src->col_idx[i]) = src->values[i];
+    }
+  }
+}
+
+float sl_la_csr_row_dot(
+    const struct sl_csr_f32 a[const static 1],
+    const size_t row,
+    const struct sl_vector_f32 v[const static 1]
+) {
+  assert(row < sl_csr_f32_num_rows(a));
+  assert(sl_vector_f32_size(v) == sl_csr_f32_num_cols(a));
+  float dot = 0;
+  for (size_t i = a->row_ptr[row]; i < a->row_ptr[row + 1]; ++i) {
+    dot += a->values[i] * v->data[a->col_idx[i]];
+  }
+  return dot;
+}
+
+void sl_la_csr_row_axpy(
+    const struct sl_csr_f32 a[const static 1],
+    const size_t row,
+    const float alpha,
+    struct sl_vector_f32 v[const static 1]
+) {
+  assert(row < sl_csr_f32_num_rows(a));
+  assert(sl_vector_f32_size(v) == sl_csr_f32_num_cols(a));
+  for (size_t i = a->row_ptr[row]; i < a->row_ptr[row + 1]; ++i) {
+    v->data[a->col_idx[i]] += alpha * a->values[i];
+  }
+}
+
+void sl_la_csr_row_matrix_multiply(
+    const struct sl_csr_f32 a[const static 1],
+    const size_t row,
+    const struct sl_matrix_f32 b[const static 1],
+    struct sl_vector_f32 y[const static 1]
+) {
+  assert(row < sl_csr_f32_num_rows(a));
+  assert(sl_csr_f32_num_cols(a) == sl_matrix_f32_num_rows(b));
+  assert(sl_vector_f32_size(y) == sl_matrix_f32_num_cols(b));
+  const size_t n = sl_vector_f32_size(y);
+  memset(y->data, 0, n * sizeof(float));
+  for (size_t i = a->row_ptr[row]; i < a->row_ptr[row + 1]; ++i) {
+    const float value  = a->values[i];
+    const float* b_row = b->data + (size_t)a->col_idx[i] * n;
+    for (size_t col = 0; col < n; ++col) {
+      y->data[col] += value * b_row[col];
+    }
+  }
+}
+
+void sl_la_csr_row_outer_add(
+    const struct sl_csr_f32 a[const static 1],
+    const size_t row,
+    const struct sl_vector_f32 x[const static 1],
+    struct sl_matrix_f32 b[const static 1]
+) {
+  assert(row < sl_csr_f32_num_rows(a));
+  assert(sl_csr_f32_num_cols(a) == sl_matrix_f32_num_rows(b));
+  assert(sl_vector_f32_size(x) == sl_matrix_f32_num_cols(b));
+  const size_t n = sl_vector_f32_size(x);
+  for (size_t i = a->row_ptr[row]; i < a->row_ptr[row + 1]; ++i) {
+    const float value = a->values[i];
+    float* b_row      = b->data + (size_t)a->col_idx[i] * n;
+    for (size_t col = 0; col < n; ++col) {
+      b_row[col] += value * x->data[col];
+    }
+  }
+}
+
 void sl_la_vec_add(const size_t count, float lhs[restrict count], const float rhs[restrict count]) {
-  assert(count <= (size_t)INT32_MAX);
-  cblas_saxpy((int)count, 1, rhs, 1, lhs, 1);
+  sl_la_simd_best()->add(count, lhs, rhs);
 }
 
 void sl_la_vec_sub(const size_t count, float lhs[restrict count], const float rhs[restrict count]) {
-  assert(count <= (size_t)INT32_MAX);
-  cblas_saxpy((int)count, -1, rhs, 1, lhs, 1);
+  sl_la_simd_best()->sub(count, lhs, rhs);
 }
 
 void sl_la_vec_mul(const size_t count, float lhs[restrict count], const float rhs[restrict count]) {
-  for (size_t i = 0; i < count; ++i) {
-    lhs[i] *= rhs[i];
-  }
+  sl_la_simd_best()->mul(count, lhs, rhs);
 }
 
 void sl_la_vec_min(const size_t count, float lhs[restrict count], const float rhs[restrict count]) {
-  for (size_t i = 0; i < count; ++i) {
-    lhs[i] = fminf(lhs[i], rhs[i]);
-  }
+  sl_la_simd_best()->min(count, lhs, rhs);
 }
 
 void sl_la_vec_max(const size_t count, float lhs[restrict count], const float rhs[restrict count]) {
-  for (size_t i = 0; i < count; ++i) {
-    lhs[i] = fmaxf(lhs[i], rhs[i]);
-  }
+  sl_la_simd_best()->max(count, lhs, rhs);
+}
+
+void sl_la_vec_scale(const size_t count, float x[count], const float alpha) {
+  sl_la_simd_best()->scale(count, x, alpha);
+}
+
+void sl_la_vec_axpby(
+    const size_t count,
+    const float alpha,
+    const float x[restrict count],
+    const float beta,
+    float y[restrict count]
+) {
+  sl_la_simd_best()->axpby(count, alpha, x, beta, y);
+}
+
+float sl_la_vec_dot(const size_t count, const float lhs[count], const float rhs[count]) {
+  return sl_la_simd_best()->dot(count, lhs, rhs);
 }
 
 bool sl_la_vector_is_finite(struct sl_vector_f32 v[const static 1]) {
@@ -120,21 +276,29 @@ bool sl_la_vector_is_finite(struct sl_vector_f32 v[const static 1]) {
 }
 
 void sl_la_vector_scale(struct sl_vector_f32 v[const static 1], const float alpha) {
-  assert(sl_vector_f32_size(v) <= (size_t)INT32_MAX);
-  cblas_sscal((int)sl_vector_f32_size(v), alpha, v->data, 1);
+  sl_la_vec_scale(sl_vector_f32_size(v), v->data, alpha);
 }
 
 void sl_la_vector_clear(struct sl_vector_f32 v[const static 1]) {
   memset(v->data, 0, sizeof(float) * sl_vector_f32_size(v));
 }
 
+void sl_la_vector_axpby(
+    const float alpha,
+    const struct sl_vector_f32 x[const static 1],
+    const float beta,
+    struct sl_vector_f32 y[const static 1]
+) {
+  assert(sl_vector_f32_size(x) == sl_vector_f32_size(y));
+  sl_la_vec_axpby(sl_vector_f32_size(y), alpha, x->data, beta, y->data);
+}
+
 float sl_la_vector_dot(
     const struct sl_vector_f32 a[const static 1],
     const struct sl_vector_f32 b[const static 1]
 ) {
   assert(sl_vector_f32_size(a) == sl_vector_f32_size(b));
-  assert(sl_vector_f32_size(a) <= (size_t)INT32_MAX);
-  return cblas_sdot((int)sl_vector_f32_size(a), a->data, 1, b->data, 1);
+  return sl_la_vec_dot(sl_vector_f32_size(a), a->data, b->data);
 }
 
 void sl_la_vector_add(
@@ -251,6 +415,91 @@ void sl_la_matrix_multiply(
   );
 }
 
+void sl_la_matrix_transpose_multiply_add(
+    const struct sl_matrix_f32 a[const static 1],
+    const struct sl_matrix_f32 b[const static 1],
+    struct sl_matrix_f32 c[const static 1]
+) {
+  // c := c + a^T b
+  assert(
+      sl_matrix_f32_num_rows(a) == sl_matrix_f32_num_rows(b)
+      && sl_matrix_f32_num_cols(a) == sl_matrix_f32_num_rows(c)
+      && sl_matrix_f32_num_cols(b) == sl_matrix_f32_num_cols(c)
+  );
+  assert(sl_matrix_f32_num_rows(a) <= (size_t)INT32_MAX);
+  assert(sl_matrix_f32_num_cols(a) <= (size_t)INT32_MAX);
+  assert(sl_matrix_f32_num_cols(b) <= (size_t)INT32_MAX);
+  cblas_sgemm(
+      CblasRowMajor,
+      CblasTrans,
+      CblasNoTrans,
+      (int)sl_matrix_f32_num_cols(a), /* m */
+      (int)sl_matrix_f32_num_cols(b), /* n */
+      (int)sl_matrix_f32_num_rows(a), /* k */
+      1,                              /* alpha */
+      a->data,                        /* a */
+      (int)sl_matrix_f32_num_cols(a), /* lda */
+      b->data,                        /* b */
+      (int)sl_matrix_f32_num_cols(b), /* ldb */
+      1,                              /* beta */
+      c->data,                        /* c */
+      (int)sl_matrix_f32_num_cols(c)  /* ldc */
+  );
+}
+
+void sl_la_matrix_vector_multiply(
+    const struct sl_matrix_f32 a[const static 1],
+    const struct sl_vector_f32 x[const static 1],
+    struct sl_vector_f32 y[const static 1]
+) {
+  assert(
+      sl_matrix_f32_num_cols(a) == sl_vector_f32_size(x)
+      && sl_matrix_f32_num_rows(a) == sl_vector_f32_size(y)
+  );
+  assert(sl_matrix_f32_num_rows(a) <= (size_t)INT32_MAX);
+  assert(sl_matrix_f32_num_cols(a) <= (size_t)INT32_MAX);
+  cblas_sgemv(
+      CblasRowMajor,
+      CblasNoTrans,
+      (int)sl_matrix_f32_num_rows(a), /* m */
+      (int)sl_matrix_f32_num_cols(a), /* n */
+      1,                              /* alpha */
+      a->data,                        /* a */
+      (int)sl_matrix_f32_num_cols(a), /* lda */
+      x->data,                        /* x */
+      1,                              /* incx */
+      0,                              /* beta */
+      y->data,                        /* y */
+      1                               /* incy */
+  );
+}
+
+void sl_la_csr_vector_multiply(
+    const struct sl_csr_f32 a[const static 1],
+    const struct sl_vector_f32 x[const static 1],
+    struct sl_vector_f32 y[const static 1]
+) {
+  assert(
+      sl_csr_f32_num_cols(a) == sl_vector_f32_size(x)
+      && sl_csr_f32_num_rows(a) == sl_vector_f32_size(y)
+  );
+  for (size_t row = 0; row < sl_csr_f32_num_rows(a); ++row) {
+    y->data[row] = sl_la_csr_row_dot(a, row, x);
+  }
+}
+
+void sl_la_csr_matrix_multiply(
+    const struct sl_csr_f32 a[const static 1],
+    const struct sl_matrix_f32 b[const static 1],
+    struct sl_matrix_f32 c[const static 1]
+) {
+  assert(sl_csr_f32_num_rows(a) == sl_matrix_f32_num_rows(c));
+  for (size_t row = 0; row < sl_csr_f32_num_rows(a); ++row) {
+    struct sl_vector_f32 c_row = sl_la_matrix_row_view(c, row);
+    sl_la_csr_row_matrix_multiply(a, row, b, &c_row);
+  }
+}
+
 double sl_la_matrix_trace(struct sl_matrix_f32 a[const static 1]) {
   double tr      = 0;
   const size_t n = SL_MIN(sl_matrix_f32_num_rows(a), sl_matrix_f32_num_cols(a));
@@ -282,6 +531,18 @@ void sl_la_matrix_copy_row(
   cblas_scopy((int)sl_vector_f32_size(dst), sl_matrix_f32_get(src, row, 0), 1, dst->data, 1);
 }
 
+void sl_la_matrix_row_axpy(
+    const struct sl_matrix_f32 a[const static 1],
+    const size_t row,
+    const float alpha,
+    struct sl_vector_f32 y[const static 1]
+) {
+  const size_t cols = sl_matrix_f32_num_cols(a);
+  assert(row < sl_matrix_f32_num_rows(a));
+  assert(cols == sl_vector_f32_size(y));
+  sl_la_vec_axpby(cols, alpha, a->data + (row * cols), 1, y->data);
+}
+
 void sl_la_matrix_saxpy_axis0(
     struct sl_matrix_f32 m[const static 1],
     struct sl_vector_f32 v[const static 1],
@@ -6,6 +6,7 @@
 
 #include <stufflib/context/context.h>
 #include <stufflib/math/math.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
 #include <stufflib/vector/sl_vector_f32.h>
 
@@ -14,6 +15,13 @@
     .data = (float[(n)]){0}, .length = {(n)}, .capacity = {(n)}, \
   }
 
+#define SL_LA_MATRIX_CREATE_INLINE(rows, cols) \
+  (struct sl_matrix_f32) {                     \
+    .data     = (float[(rows) * (cols)]){0},   \
+    .length   = {(rows), (cols)},              \
+    .capacity = {(rows), (cols)},              \
+  }
+
 #ifndef SL_LA_FLOAT_EQ_TOL
   #define SL_LA_FLOAT_EQ_TOL 1e-12
 #endif
@@ -36,14 +44,79 @@ bool sl_la_matrix_create(
 );
 void sl_la_matrix_destroy(struct sl_matrix_f32 a[const static 1]);
 struct sl_vector_f32 sl_la_matrix_row_view(struct sl_matrix_f32 a[const static 1], size_t row);
+bool sl_la_csr_create(
+    struct sl_context ctx[static 1],
+    size_t rows,
+    size_t cols,
+    size_t nnz_capacity,
+    struct sl_csr_f32 out[static 1]
+);
+void sl_la_csr_destroy(struct sl_csr_f32 a[const static 1]);
+bool sl_la_csr_reserve(
+    struct sl_context ctx[static 1],
+    struct sl_csr_f32 a[const static 1],
+    size_t nnz_capacity
+);
+void sl_la_csr_clear(struct sl_csr_f32 a[const static 1]);
+void sl_la_csr_to_dense(
+    struct sl_matrix_f32 dst[const static 1],
+    const struct sl_csr_f32 src[const static 1]
+);
+// dot product of row of a with v
+float sl_la_csr_row_dot(
+    const struct sl_csr_f32 a[const static 1],
+    size_t row,
+    const struct sl_vector_f32 v[const static 1]
+);
+// v += alpha * row of a, touches only the nonzeros of the row
+void sl_la_csr_row_axpy(
+    const struct sl_csr_f32 a[const static 1],
+    size_t row,
+    float alpha,
+    struct sl_vector_f32 v[const static 1]
+);
+// y := row of a times b
+void sl_la_csr_row_matrix_multiply(
+    const struct sl_csr_f32 a[const static 1],
+    size_t row,
+    const struct sl_matrix_f32 b[const static 1],
+    struct sl_vector_f32 y[const static 1]
+);
+// b += transpose of row of a times x, touches only the rows of b at the nonzeros of the row
+void sl_la_csr_row_outer_add(
+    const struct sl_csr_f32 a[const static 1],
+    size_t row,
+    const struct sl_vector_f32 x[const static 1],
+    struct sl_matrix_f32 b[const static 1]
+);
+// the sl_la_vec_* primitives run the widest SIMD kernels that the CPU supports, see simd.h
 void sl_la_vec_add(size_t count, float lhs[restrict count], const float rhs[restrict count]);
 void sl_la_vec_sub(size_t count, float lhs[restrict count], const float rhs[restrict count]);
 void sl_la_vec_mul(size_t count, float lhs[restrict count], const float rhs[restrict count]);
+// lhs := elementwise min or max of lhs and rhs
+// like fminf and fmaxf, a NaN in either operand is ignored, the result is NaN only if both are
 void sl_la_vec_min(size_t count, float lhs[restrict count], const float rhs[restrict count]);
 void sl_la_vec_max(size_t count, float lhs[restrict count], const float rhs[restrict count]);
+void sl_la_vec_scale(size_t count, float x[count], float alpha);
+// y := alpha x + beta y, in one pass over x and y
+void sl_la_vec_axpby(
+    size_t count,
+    float alpha,
+    const float x[restrict count],
+    float beta,
+    float y[restrict count]
+);
+float sl_la_vec_dot(size_t count, const float lhs[count], const float rhs[count]);
 bool sl_la_vector_is_finite(struct sl_vector_f32 v[const static 1]);
 void sl_la_vector_scale(struct sl_vector_f32 v[const static 1], float alpha);
 void sl_la_vector_clear(struct sl_vector_f32 v[const static 1]);
+// y := alpha x + beta y
+void sl_la_vector_axpby(
+    float alpha,
+    const struct sl_vector_f32 x[const static 1],
+    float beta,
+    struct sl_vector_f32 y[const static 1]
+);
 float sl_la_vector_dot(
     const struct sl_vector_f32 a[const static 1],
     const struct sl_vector_f32 b[const static 1]
@@ -79,6 +152,30 @@ void sl_la_matrix_multiply(
     const struct sl_matrix_f32 b[const static 1],
     struct sl_matrix_f32 c[const static 1]
 );
+// c := c + transpose of a times b
+void sl_la_matrix_transpose_multiply_add(
+    const struct sl_matrix_f32 a[const static 1],
+    const struct sl_matrix_f32 b[const static 1],
+    struct sl_matrix_f32 c[const static 1]
+);
+// y := a x
+void sl_la_matrix_vector_multiply(
+    const struct sl_matrix_f32 a[const static 1],
+    const struct sl_vector_f32 x[const static 1],
+    struct sl_vector_f32 y[const static 1]
+);
+// y := a x, touches only the nonzeros of a
+void sl_la_csr_vector_multiply(
+    const struct sl_csr_f32 a[const static 1],
+    const struct sl_vector_f32 x[const static 1],
+    struct sl_vector_f32 y[const static 1]
+);
+// c := a b, touches only the nonzeros of a
+void sl_la_csr_matrix_multiply(
+    const struct sl_csr_f32 a[const static 1],
+    const struct sl_matrix_f32 b[const static 1],
+    struct sl_matrix_f32 c[const static 1]
+);
 double sl_la_matrix_trace(struct sl_matrix_f32 a[const static 1]);
 double sl_la_matrix_frobenius_norm(struct sl_matrix_f32 a[const static 1]);
 void sl_la_matrix_copy_row(
@@ -86,6 +183,13 @@ void sl_la_matrix_copy_row(
     struct sl_matrix_f32 src[const static 1],
     size_t row
 );
+// y += alpha * row of a, reads the row in place
+void sl_la_matrix_row_axpy(
+    const struct sl_matrix_f32 a[const static 1],
+    size_t row,
+    float alpha,
+    struct sl_vector_f32 y[const static 1]
+);
 void sl_la_matrix_saxpy_axis0(
     struct sl_matrix_f32 m[const static 1],
     struct sl_vector_f32 v[const static 1],
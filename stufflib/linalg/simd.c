@@ -0,0 +1,386 @@
+#include <math.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <stufflib/linalg/simd.h>
+#include <stufflib/macros/macros.h>
+
+// the vector kernels use generic vectors as wide as one register of the target,
+// wider vectors are split into registers by the compiler, but not always efficiently,
+// items left over from the full-width loops are processed 4 at a time before the last 0 to 3
+typedef float sl_la_f32x4 __attribute__((vector_size(4 * sizeof(float))));
+typedef float sl_la_f32x8 __attribute__((vector_size(8 * sizeof(float))));
+typedef float sl_la_f32x16 __attribute__((vector_size(16 * sizeof(float))));
+
+// unaligned loads and stores
+#define SL_LA_SIMD_LOAD(dst, src)  memcpy(&(dst), (src), sizeof(dst))
+#define SL_LA_SIMD_STORE(dst, src) memcpy((dst), &(src), sizeof(src))
+
+// lanes of lhs where mask is set, otherwise lanes of rhs
+#define SL_LA_SIMD_SELECT(mask, lhs, rhs) \
+  ((typeof(lhs))(((typeof(mask))(lhs) & (mask)) | ((typeof(mask))(rhs) & ~(mask))))
+
+#define SL_LA_SIMD_ADD(lhs, rhs) ((lhs) + (rhs))
+#define SL_LA_SIMD_SUB(lhs, rhs) ((lhs) - (rhs))
+#define SL_LA_SIMD_MUL(lhs, rhs) ((lhs) * (rhs))
+
+// lanes of x that are NaN, the only value that is not ordered with itself
+#define SL_LA_SIMD_VISNAN(x) (~((x) >= (x)))
+
+// like fminf and fmaxf, a NaN in either operand is ignored and the result is NaN only if both are,
+// the vector and scalar forms agree on which lane is kept
+#define SL_LA_SIMD_MIN(lhs, rhs)  ((rhs) < (lhs) || isnan(lhs) ? (rhs) : (lhs))
+#define SL_LA_SIMD_MAX(lhs, rhs)  ((rhs) > (lhs) || isnan(lhs) ? (rhs) : (lhs))
+#define SL_LA_SIMD_VMIN(lhs, rhs) \
+  SL_LA_SIMD_SELECT(((rhs) < (lhs)) | SL_LA_SIMD_VISNAN(lhs), (rhs), (lhs))
+#define SL_LA_SIMD_VMAX(lhs, rhs) \
+  SL_LA_SIMD_SELECT(((rhs) > (lhs)) | SL_LA_SIMD_VISNAN(lhs), (rhs), (lhs))
+
+#if defined(__x86_64__)
+  #define SL_LA_SIMD_BASELINE "sse2"
+#elif defined(__ARM_NEON)
+  #define SL_LA_SIMD_BASELINE "neon"
+#else
+  #define SL_LA_SIMD_BASELINE "generic"
+#endif
+
+#define SL_LA_SIMD_BINARY_IMPLEMENT(NAME, ATTRIBUTE, WIDTH, VECTOR_OP, SCALAR_OP) \
+  ATTRIBUTE static void NAME(                                                     \
+      const size_t count,                                                         \
+      float lhs[restrict count],                                                  \
+      const float rhs[restrict count]                                             \
+  ) {                                                                             \
+    size_t i = 0;                                                                 \
+    for (; i + (WIDTH) <= count; i += (WIDTH)) {                                  \
+      sl_la_f32x##WIDTH lhs_i = {0};                                              \
+      sl_la_f32x##WIDTH rhs_i = {0};                                              \
+      SL_LA_SIMD_LOAD(lhs_i, lhs + i);                                            \
+      SL_LA_SIMD_LOAD(rhs_i, rhs + i);                                            \
+      lhs_i = VECTOR_OP(lhs_i, rhs_i);                                            \
+      SL_LA_SIMD_STORE(lhs + i, lhs_i);                                           \
+    }                                                                             \
+    for (; i + 4 <= count; i += 4) {                                              \
+      sl_la_f32x4 lhs_i = {0};                                                    \
+      sl_la_f32x4 rhs_i = {0};                                                    \
+      SL_LA_SIMD_LOAD(lhs_i, lhs + i);                                            \
+      SL_LA_SIMD_LOAD(rhs_i, rhs + i);                                            \
+      lhs_i = VECTOR_OP(lhs_i, rhs_i);                                            \
+      SL_LA_SIMD_STORE(lhs + i, lhs_i);                                           \
+    }                                                                             \
+    for (; i < count; ++i) {                                                      \
+      lhs[i] = SCALAR_OP(lhs[i], rhs[i]);                                         \
+    }                                                                             \
+  }
+
+#define SL_LA_SIMD_DOT_STEP(acc, lhs, rhs) \
+  do {                                     \
+    typeof(acc) lhs_i = {0};               \
+    typeof(acc) rhs_i = {0};               \
+    SL_LA_SIMD_LOAD(lhs_i, (lhs));         \
+    SL_LA_SIMD_LOAD(rhs_i, (rhs));         \
+    (acc) += lhs_i * rhs_i;                \
+  } while (false)
+
+#define SL_LA_SIMD_KERNELS_IMPLEMENT(SUFFIX, NAME, ATTRIBUTE, WIDTH, IS_SUPPORTED) \
+  SL_LA_SIMD_BINARY_IMPLEMENT(                                                     \
+      sl_la_simd_add_##SUFFIX,                                                     \
+      ATTRIBUTE,                                                                   \
+      WIDTH,                                                                       \
+      SL_LA_SIMD_ADD,                                                              \
+      SL_LA_SIMD_ADD                                                               \
+  )                                                                                \
+  SL_LA_SIMD_BINARY_IMPLEMENT(                                                     \
+      sl_la_simd_sub_##SUFFIX,                                                     \
+      ATTRIBUTE,                                                                   \
+      WIDTH,                                                                       \
+      SL_LA_SIMD_SUB,                                                              \
+      SL_LA_SIMD_SUB                                                               \
+  )                                                                                \
+  SL_LA_SIMD_BINARY_IMPLEMENT(                                                     \
+      sl_la_simd_mul_##SUFFIX,                                                     \
+      ATTRIBUTE,                                                                   \
+      WIDTH,                                                                       \
+      SL_LA_SIMD_MUL,                                                              \
+      SL_LA_SIMD_MUL                                                               \
+  )                                                                                \
+  SL_LA_SIMD_BINARY_IMPLEMENT(                                                     \
+      sl_la_simd_min_##SUFFIX,                                                     \
+      ATTRIBUTE,                                                                   \
+      WIDTH,                                                                       \
+      SL_LA_SIMD_VMIN,                                                             \
+      SL_LA_SIMD_MIN                                                               \
+  )                                                                                \
+  SL_LA_SIMD_BINARY_IMPLEMENT(                                                     \
+      sl_la_simd_max_##SUFFIX,                                                     \
+      ATTRIBUTE,                                                                   \
+      WIDTH,                                                                       \
+      SL_LA_SIMD_VMAX,                                                             \
+      SL_LA_SIMD_MAX                                                               \
+  )                                                                                \
+                                                                                   \
+  ATTRIBUTE static void sl_la_simd_scale_##SUFFIX(                                 \
+      const size_t count,                                                          \
+      float x[count],                                                              \
+      const float alpha                                                            \
+  ) {                                                                              \
+    size_t i = 0;                                                                  \
+    for (; i + (WIDTH) <= count; i += (WIDTH)) {                                   \
+      sl_la_f32x##WIDTH x_i = {0};                                                 \
+      SL_LA_SIMD_LOAD(x_i, x + i);                                                 \
+      x_i *= alpha;                                                                \
+      SL_LA_SIMD_STORE(x + i, x_i);                                                \
+    }                                                                              \
+    for (; i + 4 <= count; i += 4) {                                               \
+      sl_la_f32x4 x_i = {0};                                                       \
+      SL_LA_SIMD_LOAD(x_i, x + i);                                                 \
+      x_i *= alpha;                                                                \
+      SL_LA_SIMD_STORE(x + i, x_i);                                                \
+    }                                                                              \
+    for (; i < count; ++i) {                                                       \
+      x[i] *= alpha;                                                               \
+    }                                                                              \
+  }                                                                                \
+                                                                                   \
+  ATTRIBUTE static void sl_la_simd_axpby_##SUFFIX(                                 \
+      const size_t count,                                                          \
+      const float alpha,                                                           \
+      const float x[restrict count],                                               \
+      const float beta,                                                            \
+      float y[restrict count]                                                      \
+  ) {                                                                              \
+    size_t i = 0;                                                                  \
+    for (; i + (WIDTH) <= count; i += (WIDTH)) {                                   \
+      sl_la_f32x##WIDTH x_i = {0};                                                 \
+      sl_la_f32x##WIDTH y_i = {0};                                                 \
+      SL_LA_SIMD_LOAD(x_i, x + i);                                                 \
+      SL_LA_SIMD_LOAD(y_i, y + i);                                                 \
+      y_i = (alpha * x_i) + (beta * y_i);                                          \
+      SL_LA_SIMD_STORE(y + i, y_i);                                                \
+    }                                                                              \
+    for (; i + 4 <= count; i += 4) {                                               \
+      sl_la_f32x4 x_i = {0};                                                       \
+      sl_la_f32x4 y_i = {0};                                                       \
+      SL_LA_SIMD_LOAD(x_i, x + i);                                                 \
+      SL_LA_SIMD_LOAD(y_i, y + i);                                                 \
+      y_i = (alpha * x_i) + (beta * y_i);                                          \
+      SL_LA_SIMD_STORE(y + i, y_i);                                                \
+    }                                                                              \
+    for (; i < count; ++i) {                                                       \
+      y[i] = (alpha * x[i]) + (beta * y[i]);                                       \
+    }                                                                              \
+  }                                                                                \
+                                                                                   \
+  /* four independent accumulators hide the latency of the fused multiply-adds */  \
+  ATTRIBUTE static float sl_la_simd_dot_##SUFFIX(                                  \
+      const size_t count,                                                          \
+      const float lhs[count],                                                      \
+      const float rhs[count]                                                       \
+  ) {                                                                              \
+    const size_t step      = 4 * (WIDTH);                                          \
+    sl_la_f32x##WIDTH acc0 = {0};                                                  \
+    sl_la_f32x##WIDTH acc1 = {0};                                                  \
+    sl_la_f32x##WIDTH acc2 = {0};                                                  \
+    sl_la_f32x##WIDTH acc3 = {0};                                                  \
+    sl_la_f32x4 tail       = {0};                                                  \
+    size_t i               = 0;                                                    \
+    for (; i + step <= count; i += step) {                                         \
+      SL_LA_SIMD_DOT_STEP(acc0, lhs + i, rhs + i);                                 \
+      SL_LA_SIMD_DOT_STEP(acc1, lhs + i + (WIDTH), rhs + i + (WIDTH));             \
+      SL_LA_SIMD_DOT_STEP(acc2, lhs + i + 2 * (WIDTH), rhs + i + 2 * (WIDTH));     \
+      SL_LA_SIMD_DOT_STEP(acc3, lhs + i + 3 * (WIDTH), rhs + i + 3 * (WIDTH));     \
+    }                                                                              \
+    for (; i + (WIDTH) <= count; i += (WIDTH)) {                                   \
+      SL_LA_SIMD_DOT_STEP(acc0, lhs + i, rhs + i);                                 \
+    }                                                                              \
+    for (; i + 4 <= count; i += 4) {                                               \
+      SL_LA_SIMD_DOT_STEP(tail, lhs + i, rhs + i);                                 \
+    }                                                                              \
+    acc0      = (acc0 + acc1) + (acc2 + acc3);                                     \
+    float sum = 0;                                                                 \
+    for (size_t lane = 0; lane < (WIDTH); ++lane) {                                \
+      sum += acc0[lane];                                                           \
+    }                                                                              \
+    for (size_t lane = 0; lane < 4; ++lane) {                                      \
+      sum += tail[lane];                                                           \
+    }                                                                              \
+    for (; i < count; ++i) {                                                       \
+      sum += lhs[i] * rhs[i];                                                      \
+    }                                                                              \
+    return sum;                                                                    \
+  }                                                                                \
+                                                                                   \
+  static const struct sl_la_simd_kernels sl_la_simd_kernels_##SUFFIX = {           \
+      .name         = (NAME),                                                      \
+      .is_supported = (IS_SUPPORTED),                                              \
+      .add          = sl_la_simd_add_##SUFFIX,                                     \
+      .sub          = sl_la_simd_sub_##SUFFIX,                                     \
+      .mul          = sl_la_simd_mul_##SUFFIX,                                     \
+      .min          = sl_la_simd_min_##SUFFIX,                                     \
+      .max          = sl_la_simd_max_##SUFFIX,                                     \
+      .scale        = sl_la_simd_scale_##SUFFIX,                                   \
+      .axpby        = sl_la_simd_axpby_##SUFFIX,                                   \
+      .dot          = sl_la_simd_dot_##SUFFIX,                                     \
+  };
+
+// plain loops, which may or may not be vectorized by the compiler
+
+static void sl_la_simd_add_scalar(
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count]
+) {
+  for (size_t i = 0; i < count; ++i) {
+    lhs[i] += rhs[i];
+  }
+}
+
+static void sl_la_simd_sub_scalar(
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count]
+) {
+  for (size_t i = 0; i < count; ++i) {
+    lhs[i] -= rhs[i];
+  }
+}
+
+static void sl_la_simd_mul_scalar(
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count]
+) {
+  for (size_t i = 0; i < count; ++i) {
+    lhs[i] *= rhs[i];
+  }
+}
+
+static void sl_la_simd_min_scalar(
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count]
+) {
+  for (size_t i = 0; i < count; ++i) {
+    lhs[i] = SL_LA_SIMD_MIN(lhs[i], rhs[i]);
+  }
+}
+
+static void sl_la_simd_max_scalar(
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count]
+) {
+  for (size_t i = 0; i < count; ++i) {
+    lhs[i] = SL_LA_SIMD_MAX(lhs[i], rhs[i]);
+  }
+}
+
+static void sl_la_simd_scale_scalar(const size_t count, float x[count], const float alpha) {
+  for (size_t i = 0; i < count; ++i) {
+    x[i] *= alpha;
+  }
+}
+
+static void sl_la_simd_axpby_scalar(
+    const size_t count,
+    const float alpha,
+    const float x[restrict count],
+    const float beta,
+    float y[restrict count]
+) {
+  for (size_t i = 0; i < count; ++i) {
+    y[i] = (alpha * x[i]) + (beta * y[i]);
+  }
+}
+
+static float sl_la_simd_dot_scalar(
+    const size_t count,
+    const float lhs[count],
+    const float rhs[count]
+) {
+  float sum = 0;
+  for (size_t i = 0; i < count; ++i) {
+    sum += lhs[i] * rhs[i];
+  }
+  return sum;
+}
+
+static bool sl_la_simd_always_supported(void) {
+  return true;
+}
+
+static const struct sl_la_simd_kernels sl_la_simd_kernels_scalar = {
+    .name         = "scalar",
+    .is_supported = sl_la_simd_always_supported,
+    .add          = sl_la_simd_add_scalar,
+    .sub          = sl_la_simd_sub_scalar,
+    .mul          = sl_la_simd_mul_scalar,
+    .min          = sl_la_simd_min_scalar,
+    .max          = sl_la_simd_max_scalar,
+    .scale        = sl_la_simd_scale_scalar,
+    .axpby        = sl_la_simd_axpby_scalar,
+    .dot          = sl_la_simd_dot_scalar,
+};
+
+// vectors of the baseline instruction set, that every CPU of the target supports
+SL_LA_SIMD_KERNELS_IMPLEMENT(baseline, SL_LA_SIMD_BASELINE, , 4, sl_la_simd_always_supported)
+
+#if defined(__x86_64__)
+static bool sl_la_simd_avx2_is_supported(void) {
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static bool sl_la_simd_avx512_is_supported(void) {
+  return sl_la_simd_avx2_is_supported() && __builtin_cpu_supports("avx512f");
+}
+
+SL_LA_SIMD_KERNELS_IMPLEMENT(
+    avx2,
+    "avx2",
+    __attribute__((target("avx2,fma"))),
+    8,
+    sl_la_simd_avx2_is_supported
+)
+SL_LA_SIMD_KERNELS_IMPLEMENT(
+    avx512,
+    "avx512",
+    __attribute__((target("avx512f,avx2,fma"))),
+    16,
+    sl_la_simd_avx512_is_supported
+)
+#endif
+
+// from the scalar kernels to the widest vectors
+static const struct sl_la_simd_kernels* const sl_la_simd_kernels[] = {
+    &sl_la_simd_kernels_scalar,
+    &sl_la_simd_kernels_baseline,
+#if defined(__x86_64__)
+    &sl_la_simd_kernels_avx2,
+    &sl_la_simd_kernels_avx512,
+#endif
+};
+
+size_t sl_la_simd_count(void) {
+  return SL_ARRAY_LEN(sl_la_simd_kernels);
+}
+
+const struct sl_la_simd_kernels* sl_la_simd_get(const size_t index) {
+  return index < SL_ARRAY_LEN(sl_la_simd_kernels) ? sl_la_simd_kernels[index] : nullptr;
+}
+
+const struct sl_la_simd_kernels* sl_la_simd_best(void) {
+  // every thread that finds it unset chooses the same kernels
+  static _Atomic(const struct sl_la_simd_kernels*) best = nullptr;
+
+  const struct sl_la_simd_kernels* kernels = atomic_load_explicit(&best, memory_order_acquire);
+  if (!kernels) {
+    for (size_t i = SL_ARRAY_LEN(sl_la_simd_kernels); i > 0 && !kernels; --i) {
+      if (sl_la_simd_kernels[i - 1]->is_supported()) {
+        kernels = sl_la_simd_kernels[i - 1];
+      }
+    }
+    atomic_store_explicit(&best, kernels, memory_order_release);
+  }
+  return kernels;
+}
@@ -0,0 +1,37 @@
+#ifndef SL_LINALG_SIMD_H_INCLUDED
+#define SL_LINALG_SIMD_H_INCLUDED
+/*
+ * kernels of the sl_la_vec_* primitives, compiled once per instruction set
+ * the widest set that the CPU supports is chosen at runtime on first use,
+ * the scalar kernels are plain loops and serve as a reference
+ */
+
+#include <stddef.h>
+
+struct sl_la_simd_kernels {
+  const char* name;
+  bool (*is_supported)(void);
+  void (*add)(size_t count, float lhs[restrict count], const float rhs[restrict count]);
+  void (*sub)(size_t count, float lhs[restrict count], const float rhs[restrict count]);
+  void (*mul)(size_t count, float lhs[restrict count], const float rhs[restrict count]);
+  void (*min)(size_t count, float lhs[restrict count], const float rhs[restrict count]);
+  void (*max)(size_t count, float lhs[restrict count], const float rhs[restrict count]);
+  void (*scale)(size_t count, float x[count], float alpha);
+  // y := alpha x + beta y
+  void (*axpby)(
+      size_t count,
+      float alpha,
+      const float x[restrict count],
+      float beta,
+      float y[restrict count]
+  );
+  float (*dot)(size_t count, const float lhs[count], const float rhs[count]);
+};
+
+// number of kernel sets compiled for this platform, the first one is scalar
+size_t sl_la_simd_count(void);
+const struct sl_la_simd_kernels* sl_la_simd_get(size_t index);
+// widest kernels supported by the CPU
+const struct sl_la_simd_kernels* sl_la_simd_best(void);
+
+#endif  // SL_LINALG_SIMD_H_INCLUDED
@@ -0,0 +1,36 @@
+#ifndef SL_CSR_F32_H_INCLUDED
+#define SL_CSR_F32_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+// compressed sparse row matrix
+// nonzeros of row i are values[row_ptr[i]] to values[row_ptr[i + 1] - 1]
+// at column indexes col_idx[row_ptr[i]] to col_idx[row_ptr[i + 1] - 1]
+struct sl_csr_f32 {
+  size_t num_rows;
+  size_t num_cols;
+  size_t row_capacity;
+  size_t nnz_capacity;
+  size_t* row_ptr;
+  uint32_t* col_idx;
+  float* values;
+};
+
+static inline size_t sl_csr_f32_num_rows(const struct sl_csr_f32 a[const static 1]) {
+  return a->num_rows;
+}
+
+static inline size_t sl_csr_f32_num_cols(const struct sl_csr_f32 a[const static 1]) {
+  return a->num_cols;
+}
+
+static inline size_t sl_csr_f32_nnz(const struct sl_csr_f32 a[const static 1]) {
+  return a->row_ptr[a->num_rows];
+}
+
+static inline size_t sl_csr_f32_row_nnz(const struct sl_csr_f32 a[const static 1], size_t row) {
+  return a->row_ptr[row + 1] - a->row_ptr[row];
+}
+
+#endif /* SL_CSR_F32_H_INCLUDED */
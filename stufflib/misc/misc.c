@@ -1,4 +1,5 @@
 #include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -59,25 +60,56 @@ void sl_misc_swap(
     const size_t count
 ) {
   assert(count < SL_MISC_SWAP_MAX_SIZE);
-  static unsigned char tmp[SL_MISC_SWAP_MAX_SIZE] = {0};
+  // not static, swaps may run concurrently on several threads
+  unsigned char tmp[SL_MISC_SWAP_MAX_SIZE];
   memcpy(tmp, a, count);
   memcpy(a, b, count);
   memcpy(b, tmp, count);
 }
 
+// zero runs are checked one 64-bit word at a time
+
 bool sl_misc_is_zero(const size_t count, const unsigned char data[count]) {
-  for (size_t i = 0; i < count; ++i) {
-    if (data[i]) {
-      return false;
+  uint64_t acc = 0;
+  size_t i     = 0;
+  for (; i + sizeof(uint64_t) <= count; i += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, data + i, sizeof(word));
+    acc |= word;
+  }
+  for (; i < count; ++i) {
+    acc |= data[i];
+  }
+  return acc == 0;
+}
+
+size_t sl_misc_next_nonzero(
+    const size_t size,
+    const size_t count,
+    const unsigned char data[size * count],
+    const size_t begin
+) {
+  const size_t n_bytes = size * count;
+  size_t pos           = begin * size;
+  for (; pos + sizeof(uint64_t) <= n_bytes; pos += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    memcpy(&word, data + pos, sizeof(word));
+    if (word) {
+      break;
+    }
+  }
+  for (size_t i = pos / size; i < count; ++i) {
+    if (!sl_misc_is_zero(size, data + (i * size))) {
+      return i;
     }
   }
-  return true;
+  return count;
 }
 
 size_t sl_misc_count_nonzero(const size_t size, const size_t count, unsigned char data[count]) {
   size_t n = 0;
-  for (size_t i = 0; i < count; ++i) {
-    n += !sl_misc_is_zero(size, data + (i * size));
+  for (size_t i = sl_misc_next_nonzero(size, count, data, 0); i < count; ++n) {
+    i = sl_misc_next_nonzero(size, count, data, i + 1);
   }
   return n;
 }
@@ -15,6 +15,12 @@ unsigned char* sl_misc_encode_big_endian(size_t size, unsigned char dst[size], s
 size_t sl_misc_vmax_size_t(size_t n, const size_t v[n]);
 void sl_misc_swap(unsigned char a[const static 1], unsigned char b[const static 1], size_t count);
 bool sl_misc_is_zero(size_t count, const unsigned char data[count]);
+size_t sl_misc_next_nonzero(
+    size_t size,
+    size_t count,
+    const unsigned char data[size * count],
+    size_t begin
+);
 size_t sl_misc_count_nonzero(size_t size, size_t count, unsigned char data[count]);
 
 static inline size_t sl_misc_midpoint(const size_t lo, const size_t hi) {
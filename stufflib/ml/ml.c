@@ -1,12 +1,19 @@
+#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 #include <stufflib/context/context.h>
+#include <stufflib/json/writer.h>
 #include <stufflib/linalg/linalg.h>
+#include <stufflib/macros/macros.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
+#include <stufflib/memory/memory.h>
 #include <stufflib/ml/ml.h>
 #include <stufflib/random/random.h>
 #include <stufflib/vector/sl_vector_f32.h>
@@ -61,6 +68,41 @@ void sl_ml_minmax_fit(
   }
 }
 
+void sl_ml_minmax_reset(struct sl_ml_minmax_scaler scaler[const static 1]) {
+  assert(sl_vector_f32_size(&scaler->lo) == sl_vector_f32_size(&scaler->hi));
+  for (size_t i = 0; i < sl_vector_f32_size(&scaler->lo); ++i) {
+    scaler->lo.data[i] = INFINITY;
+    scaler->hi.data[i] = -INFINITY;
+  }
+  scaler->is_cached = false;
+}
+
+void sl_ml_minmax_fit_vector(
+    struct sl_ml_minmax_scaler scaler[const static 1],
+    const struct sl_vector_f32 x[const static 1]
+) {
+  assert(
+      sl_vector_f32_size(&scaler->lo) == sl_vector_f32_size(x)
+      && sl_vector_f32_size(&scaler->hi) == sl_vector_f32_size(x)
+  );
+  scaler->is_cached = false;
+  sl_la_vec_min(sl_vector_f32_size(x), scaler->lo.data, x->data);
+  sl_la_vec_max(sl_vector_f32_size(x), scaler->hi.data, x->data);
+}
+
+void sl_ml_minmax_merge(
+    struct sl_ml_minmax_scaler scaler[const static 1],
+    const struct sl_ml_minmax_scaler other[const static 1]
+) {
+  assert(
+      sl_vector_f32_size(&scaler->lo) == sl_vector_f32_size(&other->lo)
+      && sl_vector_f32_size(&scaler->hi) == sl_vector_f32_size(&other->hi)
+  );
+  scaler->is_cached = false;
+  sl_la_vec_min(sl_vector_f32_size(&scaler->lo), scaler->lo.data, other->lo.data);
+  sl_la_vec_max(sl_vector_f32_size(&scaler->hi), scaler->hi.data, other->hi.data);
+}
+
 void sl_ml_minmax_apply(
     struct sl_ml_minmax_scaler scaler[const static 1],
     struct sl_matrix_f32 m[const static 1],
@@ -78,8 +120,14 @@ void sl_ml_minmax_apply(
     }
     scaler->is_cached = true;
   }
-  sl_la_matrix_mul_axis0(m, scale);
-  sl_la_matrix_add_axis0(m, offset);
+  // scale and shift each row in the same pass
+  const size_t n_cols = sl_matrix_f32_num_cols(m);
+  for (size_t row = 0; row < sl_matrix_f32_num_rows(m); ++row) {
+    float* x = sl_matrix_f32_get(m, row, 0);
+    for (size_t col = 0; col < n_cols; ++col) {
+      x[col] = (x[col] * scale->data[col]) + offset->data[col];
+    }
+  }
 }
 
 void sl_ml_classification_update(
@@ -94,6 +142,29 @@ void sl_ml_classification_update(
   cls->fn += real_class && !pred_class;
 }
 
+void sl_ml_classification_update_scores(
+    struct sl_ml_classification cls[const static 1],
+    const size_t n,
+    const float scores[const static n],
+    const uint16_t real_classes[const static n]
+) {
+  // branchless counts that vectorize, the rest follow from the totals
+  int tp     = 0;
+  int n_pred = 0;
+  int n_real = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const int pred = scores[i] > 0;
+    const int real = real_classes[i] != 0;
+    tp += pred & real;
+    n_pred += pred;
+    n_real += real;
+  }
+  cls->tp += tp;
+  cls->fp += n_pred - tp;
+  cls->fn += n_real - tp;
+  cls->tn += (int)n - n_pred - n_real + tp;
+}
+
 double sl_ml_classification_accuracy(struct sl_ml_classification cls[const static 1]) {
   return (double)(cls->tp + cls->tn) / (cls->tp + cls->tn + cls->fp + cls->fn);
 }
@@ -110,20 +181,47 @@ double sl_ml_classification_f1_score(struct sl_ml_classification cls[const stati
   return (double)(2 * cls->tp) / (2 * cls->tp + cls->fp + cls->fn);
 }
 
-void sl_ml_classification_print(
+bool sl_ml_classification_write(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_ml_classification cls[const static 1]
+) {
+  const char* const count_keys[] = {"tp", "tn", "fp", "fn"};
+  const int counts[]             = {cls->tp, cls->tn, cls->fp, cls->fn};
+  const char* const score_keys[] = {"accuracy", "precision", "recall", "f1_score"};
+  const double scores[]          = {
+      sl_ml_classification_accuracy(cls),
+      sl_ml_classification_precision(cls),
+      sl_ml_classification_recall(cls),
+      sl_ml_classification_f1_score(cls),
+  };
+  if (!sl_json_writer_object_begin(ctx, writer)) {
+    return false;
+  }
+  for (size_t i = 0; i < SL_ARRAY_LEN(counts); ++i) {
+    if (!(sl_json_writer_key(ctx, writer, count_keys[i])
+          && sl_json_writer_int(ctx, writer, counts[i]))) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < SL_ARRAY_LEN(scores); ++i) {
+    if (!(sl_json_writer_key(ctx, writer, score_keys[i])
+          && sl_json_writer_double(ctx, writer, scores[i]))) {
+      return false;
+    }
+  }
+  return sl_json_writer_object_end(ctx, writer);
+}
+
+bool sl_ml_classification_print(
+    struct sl_context ctx[static 1],
     FILE stream[const static 1],
     struct sl_ml_classification cls[const static 1]
 ) {
-  fprintf(stream, "{");
-  fprintf(stream, "\"tp\":%d,", cls->tp);
-  fprintf(stream, "\"tn\":%d,", cls->tn);
-  fprintf(stream, "\"fp\":%d,", cls->fp);
-  fprintf(stream, "\"fn\":%d,", cls->fn);
-  fprintf(stream, "\"accuracy\":%.3f,", sl_ml_classification_accuracy(cls));
-  fprintf(stream, "\"precision\":%.3f,", sl_ml_classification_precision(cls));
-  fprintf(stream, "\"recall\":%.3f,", sl_ml_classification_recall(cls));
-  fprintf(stream, "\"f1_score\":%.3f", sl_ml_classification_f1_score(cls));
-  fprintf(stream, "}\n");
+  unsigned char buffer[256]    = {0};
+  struct sl_json_writer writer = {0};
+  sl_json_writer_init(&writer, stream, sizeof(buffer), buffer);
+  return sl_ml_classification_write(ctx, &writer, cls) && sl_json_writer_flush(ctx, &writer);
 }
 
 uint8_t sl_ml_svm_binary_predict(
@@ -133,26 +231,52 @@ uint8_t sl_ml_svm_binary_predict(
   return (sl_la_vector_dot(&(svm->w), x) > 0) ? 1 : 0;
 }
 
-// implements mini-batch pegasos by Shalev-Shwartz et al. (2011)
+void sl_ml_svm_scores(
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_matrix_f32 data[const static 1],
+    struct sl_vector_f32 scores[const static 1]
+) {
+  sl_la_matrix_vector_multiply(data, &(svm->w), scores);
+}
+
+void sl_ml_svm_scores_csr(
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    struct sl_vector_f32 scores[const static 1]
+) {
+  sl_la_csr_vector_multiply(data, &(svm->w), scores);
+}
+
 void sl_ml_svm_linear_fit(
     uint64_t prng[static 1],
     struct sl_ml_svm svm[const static 1],
     struct sl_matrix_f32 data[const static 1],
     const uint16_t classes[const static 1]
 ) {
-  for (size_t i = 0; i < sl_matrix_f32_num_rows(data); ++i) {
+  const size_t n_rows = sl_matrix_f32_num_rows(data);
+  for (size_t i = 0; i < n_rows; ++i) {
     svm->shuffle_buffer[i] = i;
   }
+  sl_ml_svm_linear_fit_rows(prng, svm, data, classes, n_rows);
+}
 
+// implements mini-batch pegasos by Shalev-Shwartz et al. (2011)
+void sl_ml_svm_linear_fit_rows(
+    uint64_t prng[static 1],
+    struct sl_ml_svm svm[const static 1],
+    struct sl_matrix_f32 data[const static 1],
+    const uint16_t classes[const static 1],
+    const size_t n_rows
+) {
   const int k            = svm->batch_size;
   const float lambda     = svm->learning_rate;
-  const int n_iterations = svm->n_epochs * (int)sl_matrix_f32_num_rows(data) / svm->batch_size;
+  const int n_iterations = svm->n_epochs * (int)n_rows / svm->batch_size;
 
-  int batch_begin = (int)sl_matrix_f32_num_rows(data);
+  int batch_begin = (int)n_rows;
 
   for (int t = 1; t <= n_iterations; ++t) {
-    if (batch_begin + k >= (int)sl_matrix_f32_num_rows(data)) {
-      sl_random_shuffle(prng, svm->shuffle_buffer, sizeof(size_t), sl_matrix_f32_num_rows(data));
+    if (batch_begin + k >= (int)n_rows) {
+      sl_random_shuffle(prng, svm->shuffle_buffer, sizeof(size_t), n_rows);
       batch_begin = 0;
     }
 
@@ -160,18 +284,874 @@ void sl_ml_svm_linear_fit(
     sl_la_vector_clear(&(svm->s));
 
     for (int i = 0; i < k; ++i) {
-      const size_t idx = svm->shuffle_buffer[batch_begin + i];
-      sl_la_matrix_copy_row(&(svm->x), data, idx);
-      const float y = (classes[idx] == 1) ? 1 : -1;
-      if (y * sl_la_vector_dot(&(svm->w), &(svm->x)) < 1) {
-        sl_la_vector_scale(&(svm->x), y);
-        sl_la_vector_add(&(svm->s), &(svm->x));
+      const size_t idx             = svm->shuffle_buffer[batch_begin + i];
+      const struct sl_vector_f32 x = sl_la_matrix_row_view(data, idx);
+      const float y                = (classes[idx] == 1) ? 1 : -1;
+      if (y * sl_la_vector_dot(&(svm->w), &x) < 1) {
+        sl_la_matrix_row_axpy(data, idx, y, &(svm->s));
       }
     }
     batch_begin += k;
 
-    sl_la_vector_scale(&(svm->w), 1 - (eta * lambda));
-    sl_la_vector_scale(&(svm->s), eta / (float)k);
-    sl_la_vector_add(&(svm->w), &(svm->s));
+    // shrink w and add the batch subgradient in one pass
+    sl_la_vector_axpby(eta / (float)k, &(svm->s), 1 - (eta * lambda), &(svm->w));
+  }
+}
+
+uint8_t sl_ml_svm_binary_predict_csr(
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const size_t row
+) {
+  return (sl_la_csr_row_dot(data, row, &(svm->w)) > 0) ? 1 : 0;
+}
+
+// shuffle buffer entries of rows that violate the margin in the current batch
+#define SL_ML_SVM_VIOLATOR_BIT ((size_t)1 << (sizeof(size_t) * 8 - 1))
+// below this, the weight scale is folded into w to keep it within float range
+#define SL_ML_SVM_MIN_SCALE 1e-6F
+
+// same iterations as sl_ml_svm_linear_fit, but w is stored as scale * svm->w
+// such that the regularization shrink is a single multiplication of scale
+// and each iteration touches only the nonzeros of the batch rows
+void sl_ml_svm_linear_fit_csr(
+    uint64_t prng[static 1],
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint16_t classes[const static 1]
+) {
+  const size_t n_rows = sl_csr_f32_num_rows(data);
+  assert(n_rows < SL_ML_SVM_VIOLATOR_BIT);
+  for (size_t i = 0; i < n_rows; ++i) {
+    svm->shuffle_buffer[i] = i;
+  }
+
+  const int k            = svm->batch_size;
+  const float lambda     = svm->learning_rate;
+  const int n_iterations = svm->n_epochs * (int)n_rows / svm->batch_size;
+
+  int batch_begin = (int)n_rows;
+  float scale     = 1;
+
+  for (int t = 1; t <= n_iterations; ++t) {
+    if (batch_begin + k >= (int)n_rows) {
+      sl_random_shuffle(prng, svm->shuffle_buffer, sizeof(size_t), n_rows);
+      batch_begin = 0;
+    }
+    size_t* batch = svm->shuffle_buffer + batch_begin;
+
+    for (int i = 0; i < k; ++i) {
+      const size_t idx = batch[i];
+      const float y    = (classes[idx] == 1) ? 1 : -1;
+      if (y * scale * sl_la_csr_row_dot(data, idx, &(svm->w)) < 1) {
+        batch[i] |= SL_ML_SVM_VIOLATOR_BIT;
+      }
+    }
+
+    const float eta = 1.0F / (lambda * (float)t);
+    scale *= 1 - (eta * lambda);
+    if (fabsf(scale) < SL_ML_SVM_MIN_SCALE) {
+      sl_la_vector_scale(&(svm->w), scale);
+      scale = 1;
+    }
+
+    const float step = eta / ((float)k * scale);
+    for (int i = 0; i < k; ++i) {
+      if (batch[i] & SL_ML_SVM_VIOLATOR_BIT) {
+        batch[i] &= ~SL_ML_SVM_VIOLATOR_BIT;
+        const float y = (classes[batch[i]] == 1) ? 1 : -1;
+        sl_la_csr_row_axpy(data, batch[i], y * step, &(svm->w));
+      }
+    }
+    batch_begin += k;
+  }
+
+  sl_la_vector_scale(&(svm->w), scale);
+}
+
+// distance between the PCG streams of two workers
+#define SL_ML_SVM_STREAM_STRIDE ((uint64_t)1 << 48)
+
+// state shared by all workers of sl_ml_svm_linear_fit_parallel
+struct sl_ml_svm_workers {
+  const struct sl_csr_f32* data;
+  const uint16_t* classes;
+  int batch_size;
+  float lambda;
+  size_t n_iterations;
+  // hogwild only, number of iterations taken by all workers
+  atomic_size_t step;
+};
+
+struct sl_ml_svm_worker {
+  struct sl_ml_svm_workers* workers;
+  uint64_t prng;
+  // sum of y * x over all margin violators, shared by all workers in hogwild mode
+  _Atomic(float)* sum;
+  // mini-batches are taken from a permutation of the rows of this worker,
+  // which is reshuffled when exhausted
+  size_t* order;
+  size_t order_len;
+  size_t order_pos;
+  size_t* batch;
+  // averaging only, the iterations of the current round are step_begin + 1 to step_end
+  size_t step_begin;
+  size_t step_end;
+  pthread_t thread;
+  bool is_started;
+};
+
+// dot product of a row and sum, loads of sum are relaxed and may see other workers half-way
+static float sl_ml_svm_sum_dot(
+    const struct sl_csr_f32 data[const static 1],
+    const size_t row,
+    _Atomic(float) sum[const static 1]
+) {
+  float dot = 0;
+  for (size_t i = data->row_ptr[row]; i < data->row_ptr[row + 1]; ++i) {
+    dot += data->values[i] * atomic_load_explicit(sum + data->col_idx[i], memory_order_relaxed);
+  }
+  return dot;
+}
+
+// sum += alpha * row, concurrent updates of the same feature may overwrite each other
+static void sl_ml_svm_sum_axpy(
+    const struct sl_csr_f32 data[const static 1],
+    const size_t row,
+    const float alpha,
+    _Atomic(float) sum[const static 1]
+) {
+  for (size_t i = data->row_ptr[row]; i < data->row_ptr[row + 1]; ++i) {
+    _Atomic(float)* const s = sum + data->col_idx[i];
+    const float value       = atomic_load_explicit(s, memory_order_relaxed);
+    atomic_store_explicit(s, value + (alpha * data->values[i]), memory_order_relaxed);
+  }
+}
+
+// the pegasos weights of iteration t are the sum of y * x over all margin violators
+// of earlier iterations, divided by lambda * k * (t - 1)
+static void sl_ml_svm_worker_iterate(
+    struct sl_ml_svm_worker worker[const static 1],
+    const size_t t
+) {
+  const struct sl_ml_svm_workers* const workers = worker->workers;
+  const struct sl_csr_f32* const data           = workers->data;
+  const int k                                   = workers->batch_size;
+
+  const float margin_scale = t > 1 ? 1.0F / (workers->lambda * (float)k * (float)(t - 1)) : 0.0F;
+
+  if (worker->order_pos + (size_t)k > worker->order_len) {
+    sl_random_shuffle(&(worker->prng), worker->order, sizeof(size_t), worker->order_len);
+    worker->order_pos = 0;
+  }
+  const size_t* const batch = worker->order + worker->order_pos;
+  worker->order_pos += (size_t)k;
+
+  int n_violators = 0;
+  for (int i = 0; i < k; ++i) {
+    const size_t idx = batch[i];
+    const float y    = (workers->classes[idx] == 1) ? 1 : -1;
+    if (y * margin_scale * sl_ml_svm_sum_dot(data, idx, worker->sum) < 1) {
+      worker->batch[n_violators++] = idx;
+    }
+  }
+  for (int i = 0; i < n_violators; ++i) {
+    const size_t idx = worker->batch[i];
+    const float y    = (workers->classes[idx] == 1) ? 1 : -1;
+    sl_ml_svm_sum_axpy(data, idx, y, worker->sum);
+  }
+}
+
+static void* sl_ml_svm_hogwild_run(void* arg) {
+  struct sl_ml_svm_worker* worker   = arg;
+  struct sl_ml_svm_workers* workers = worker->workers;
+  for (;;) {
+    const size_t t = atomic_fetch_add_explicit(&(workers->step), 1, memory_order_relaxed) + 1;
+    if (t > workers->n_iterations) {
+      break;
+    }
+    sl_ml_svm_worker_iterate(worker, t);
+  }
+  return nullptr;
+}
+
+static void* sl_ml_svm_averaging_run(void* arg) {
+  struct sl_ml_svm_worker* worker = arg;
+  for (size_t t = worker->step_begin + 1; t <= worker->step_end; ++t) {
+    sl_ml_svm_worker_iterate(worker, t);
+  }
+  return nullptr;
+}
+
+static bool sl_ml_svm_workers_run(
+    struct sl_context ctx[static 1],
+    const size_t n_threads,
+    struct sl_ml_svm_worker workers[const static n_threads],
+    void* run(void*)
+) {
+  bool ok = true;
+  for (size_t j = 0; j < n_threads; ++j) {
+    const int err = pthread_create(&(workers[j].thread), nullptr, run, workers + j);
+    if (err != 0) {
+      SL_ERROR(ctx, "failed starting SVM worker thread %zu (%s)", j, strerror(err));
+      ok = false;
+      break;
+    }
+    workers[j].is_started = true;
+  }
+  for (size_t j = 0; j < n_threads; ++j) {
+    if (workers[j].is_started) {
+      pthread_join(workers[j].thread, nullptr);
+      workers[j].is_started = false;
+    }
+  }
+  return ok;
+}
+
+bool sl_ml_svm_linear_fit_parallel(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint16_t classes[const static 1],
+    const size_t n_threads,
+    const size_t sync_steps
+) {
+  bool ok                          = false;
+  struct sl_ml_svm_worker* workers = nullptr;
+  const size_t n_sums              = sync_steps > 0 ? n_threads : 1;
+  const size_t n_features          = sl_vector_f32_size(&(svm->w));
+  const size_t n_rows              = sl_csr_f32_num_rows(data);
+  // sums is freed through sums_buffer, which is not atomic
+  void* sums_buffer    = nullptr;
+  _Atomic(float)* sums = nullptr;
+
+  assert(n_features == sl_csr_f32_num_cols(data));
+  if (n_threads == 0 || svm->batch_size <= 0 || svm->n_epochs < 0
+      || n_rows / n_threads < (size_t)svm->batch_size) {
+    SL_ERROR(
+        ctx,
+        "cannot fit SVM with %zu threads, batch size %d, %d epochs and %zu rows",
+        n_threads,
+        svm->batch_size,
+        svm->n_epochs,
+        n_rows
+    );
+    goto done;
+  }
+
+  struct sl_ml_svm_workers shared = {
+      .data         = data,
+      .classes      = classes,
+      .batch_size   = svm->batch_size,
+      .lambda       = svm->learning_rate,
+      .n_iterations = (size_t)(svm->n_epochs * (int)n_rows / svm->batch_size),
+  };
+  atomic_init(&(shared.step), 0);
+
+  workers     = sl_alloc(ctx, n_threads, sizeof(*workers));
+  sums_buffer = sl_alloc(ctx, n_sums * n_features, sizeof(*sums));
+  sums        = sums_buffer;
+  if (!workers || !sums) {
+    SL_ERROR(ctx, "failed allocating %zu SVM workers", n_threads);
+    goto done;
+  }
+  for (size_t i = 0; i < n_sums * n_features; ++i) {
+    atomic_init(sums + i, 0.0F);
+  }
+
+  uint64_t stream = (uint64_t)sl_random_pcg32(prng) << 32;
+  stream |= sl_random_pcg32(prng);
+  sl_random_pcg32_init(&stream, stream);
+  // each worker samples from its own contiguous range of rows
+  for (size_t j = 0; j < n_threads; ++j) {
+    const size_t rows_begin = j * n_rows / n_threads;
+    const size_t rows_len   = ((j + 1) * n_rows / n_threads) - rows_begin;
+
+    workers[j] = (struct sl_ml_svm_worker){
+        .workers   = &shared,
+        .prng      = stream,
+        .sum       = sums + ((sync_steps > 0 ? j : 0) * n_features),
+        .order     = sl_alloc(ctx, rows_len, sizeof(size_t)),
+        .order_len = rows_len,
+        .order_pos = rows_len,
+        .batch     = sl_alloc(ctx, (size_t)svm->batch_size, sizeof(size_t)),
+    };
+    if (!workers[j].order || !workers[j].batch) {
+      SL_ERROR(ctx, "failed allocating SVM worker %zu", j);
+      goto done;
+    }
+    for (size_t i = 0; i < rows_len; ++i) {
+      workers[j].order[i] = rows_begin + i;
+    }
+    sl_random_pcg32_advance(&stream, SL_ML_SVM_STREAM_STRIDE);
+  }
+
+  size_t n_steps = shared.n_iterations;
+  if (sync_steps == 0) {
+    if (!sl_ml_svm_workers_run(ctx, n_threads, workers, sl_ml_svm_hogwild_run)) {
+      goto done;
+    }
+  } else {
+    // each worker fits on its own, all sums are replaced by their mean every sync_steps
+    n_steps = shared.n_iterations / n_threads;
+    for (size_t step = 0; step < n_steps; step += sync_steps) {
+      for (size_t j = 0; j < n_threads; ++j) {
+        workers[j].step_begin = step;
+        workers[j].step_end   = SL_MIN(n_steps, step + sync_steps);
+      }
+      if (!sl_ml_svm_workers_run(ctx, n_threads, workers, sl_ml_svm_averaging_run)) {
+        goto done;
+      }
+      for (size_t i = 0; i < n_features; ++i) {
+        float mean = 0;
+        for (size_t j = 0; j < n_threads; ++j) {
+          mean += atomic_load_explicit(workers[j].sum + i, memory_order_relaxed);
+        }
+        mean /= (float)n_threads;
+        for (size_t j = 0; j < n_threads; ++j) {
+          atomic_store_explicit(workers[j].sum + i, mean, memory_order_relaxed);
+        }
+      }
+    }
+  }
+
+  const float scale
+      = n_steps > 0 ? 1.0F / (shared.lambda * (float)shared.batch_size * (float)n_steps) : 0.0F;
+  for (size_t i = 0; i < n_features; ++i) {
+    svm->w.data[i] = scale * atomic_load_explicit(sums + i, memory_order_relaxed);
+  }
+
+  ok = true;
+done:
+  if (workers) {
+    for (size_t j = 0; j < n_threads; ++j) {
+      sl_free(workers[j].order);
+      sl_free(workers[j].batch);
+    }
+  }
+  sl_free(workers);
+  sl_free(sums_buffer);
+  return ok;
+}
+
+void sl_ml_svm_ovr_scores(
+    struct sl_ml_svm_ovr svm[const static 1],
+    const struct sl_matrix_f32 data[const static 1],
+    struct sl_matrix_f32 scores[const static 1]
+) {
+  sl_la_matrix_multiply(data, &(svm->w), scores);
+}
+
+void sl_ml_svm_ovr_scores_csr(
+    struct sl_ml_svm_ovr svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    struct sl_matrix_f32 scores[const static 1]
+) {
+  sl_la_csr_matrix_multiply(data, &(svm->w), scores);
+}
+
+uint16_t sl_ml_svm_ovr_predict(
+    const struct sl_matrix_f32 scores[const static 1],
+    const size_t row
+) {
+  const size_t n_classes = sl_matrix_f32_num_cols(scores);
+  assert(row < sl_matrix_f32_num_rows(scores));
+  assert(n_classes <= UINT16_MAX);
+  const float* s = scores->data + row * n_classes;
+  uint16_t best  = 0;
+  for (size_t c = 1; c < n_classes; ++c) {
+    if (s[c] > s[best]) {
+      best = (uint16_t)c;
+    }
+  }
+  return best;
+}
+
+// replaces the scores of the batch with the update coefficients of w,
+// y * step for classes whose margin is violated, zero for the others
+static void sl_ml_svm_ovr_updates(
+    struct sl_ml_svm_ovr svm[const static 1],
+    const size_t batch[const static 1],
+    const uint8_t labels[const static 1],
+    const float scale,
+    const float step
+) {
+  const size_t n_classes = sl_matrix_f32_num_cols(&(svm->w));
+  for (int i = 0; i < svm->batch_size; ++i) {
+    const uint8_t* y_row = labels + batch[i] * n_classes;
+    float* s_row         = sl_matrix_f32_get(&(svm->s), (size_t)i, 0);
+    for (size_t c = 0; c < n_classes; ++c) {
+      const float y = y_row[c] ? 1 : -1;
+      s_row[c]      = (y * scale * s_row[c] < 1) ? y * step : 0;
+    }
+  }
+}
+
+void sl_ml_svm_ovr_fit(
+    uint64_t prng[static 1],
+    struct sl_ml_svm_ovr svm[const static 1],
+    struct sl_matrix_f32 data[const static 1],
+    const uint8_t labels[const static 1]
+) {
+  const size_t n_rows = sl_matrix_f32_num_rows(data);
+  for (size_t i = 0; i < n_rows; ++i) {
+    svm->shuffle_buffer[i] = i;
+  }
+
+  const int k            = svm->batch_size;
+  const float lambda     = svm->learning_rate;
+  const int n_iterations = svm->n_epochs * (int)n_rows / svm->batch_size;
+
+  int batch_begin = (int)n_rows;
+  float scale     = 1;
+
+  for (int t = 1; t <= n_iterations; ++t) {
+    if (batch_begin + k >= (int)n_rows) {
+      sl_random_shuffle(prng, svm->shuffle_buffer, sizeof(size_t), n_rows);
+      batch_begin = 0;
+    }
+    const size_t* batch = svm->shuffle_buffer + batch_begin;
+
+    for (int i = 0; i < k; ++i) {
+      struct sl_vector_f32 x = sl_la_matrix_row_view(&(svm->x), (size_t)i);
+      sl_la_matrix_copy_row(&x, data, batch[i]);
+    }
+    sl_la_matrix_multiply(&(svm->x), &(svm->w), &(svm->s));
+
+    const float margin_scale = scale;
+    const float eta          = 1.0F / (lambda * (float)t);
+    scale *= 1 - (eta * lambda);
+    if (fabsf(scale) < SL_ML_SVM_MIN_SCALE) {
+      sl_la_matrix_mul_axis2(&(svm->w), scale);
+      scale = 1;
+    }
+
+    sl_ml_svm_ovr_updates(svm, batch, labels, margin_scale, eta / ((float)k * scale));
+    sl_la_matrix_transpose_multiply_add(&(svm->x), &(svm->s), &(svm->w));
+    batch_begin += k;
+  }
+
+  sl_la_matrix_mul_axis2(&(svm->w), scale);
+}
+
+void sl_ml_svm_ovr_fit_csr(
+    uint64_t prng[static 1],
+    struct sl_ml_svm_ovr svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint8_t labels[const static 1]
+) {
+  const size_t n_rows = sl_csr_f32_num_rows(data);
+  for (size_t i = 0; i < n_rows; ++i) {
+    svm->shuffle_buffer[i] = i;
+  }
+
+  const int k            = svm->batch_size;
+  const float lambda     = svm->learning_rate;
+  const int n_iterations = svm->n_epochs * (int)n_rows / svm->batch_size;
+
+  int batch_begin = (int)n_rows;
+  float scale     = 1;
+
+  for (int t = 1; t <= n_iterations; ++t) {
+    if (batch_begin + k >= (int)n_rows) {
+      sl_random_shuffle(prng, svm->shuffle_buffer, sizeof(size_t), n_rows);
+      batch_begin = 0;
+    }
+    const size_t* batch = svm->shuffle_buffer + batch_begin;
+
+    for (int i = 0; i < k; ++i) {
+      struct sl_vector_f32 s = sl_la_matrix_row_view(&(svm->s), (size_t)i);
+      sl_la_csr_row_matrix_multiply(data, batch[i], &(svm->w), &s);
+    }
+
+    const float margin_scale = scale;
+    const float eta          = 1.0F / (lambda * (float)t);
+    scale *= 1 - (eta * lambda);
+    if (fabsf(scale) < SL_ML_SVM_MIN_SCALE) {
+      sl_la_matrix_mul_axis2(&(svm->w), scale);
+      scale = 1;
+    }
+
+    sl_ml_svm_ovr_updates(svm, batch, labels, margin_scale, eta / ((float)k * scale));
+    for (int i = 0; i < k; ++i) {
+      struct sl_vector_f32 s = sl_la_matrix_row_view(&(svm->s), (size_t)i);
+      sl_la_csr_row_outer_add(data, batch[i], &s, &(svm->w));
+    }
+    batch_begin += k;
+  }
+
+  sl_la_matrix_mul_axis2(&(svm->w), scale);
+}
+
+void sl_ml_linear_scores_csr(
+    struct sl_ml_linear model[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    struct sl_vector_f32 scores[const static 1]
+) {
+  sl_la_csr_vector_multiply(data, &(model->a), scores);
+}
+
+void sl_ml_sigmoid(const size_t n, float scores[static n]) {
+  for (size_t i = 0; i < n; ++i) {
+    scores[i] = 1 / (1 + expf(-scores[i]));
+  }
+}
+
+// negative derivative of the loss with respect to the margin z, never negative
+static double sl_ml_loss_gradient(const enum sl_ml_loss loss, const double z) {
+  double g = 0;
+  switch (loss) {
+    case sl_ml_loss_hinge: {
+      g = (z < 1) ? 1 : 0;
+    } break;
+    case sl_ml_loss_logistic: {
+      // exp of a non-positive number cannot overflow
+      g = (z < 0) ? 1 / (1 + exp(z)) : exp(-z) / (1 + exp(-z));
+    } break;
+    case sl_ml_loss_squared_hinge: {
+      g = (z < 1) ? 1 - z : 0;
+    } break;
+  }
+  return g;
+}
+
+// the weights are w / w_div and the averaged weights (a + w_frac * w) / a_div
+struct sl_ml_linear_scale {
+  double w_div;
+  double a_div;
+  double w_frac;
+};
+
+// fold the scale when either divisor exceeds this
+#define SL_ML_LINEAR_MAX_DIVISOR 1e5
+
+static void sl_ml_linear_fold_scale(
+    struct sl_ml_linear model[const static 1],
+    struct sl_ml_linear_scale scale[const static 1]
+) {
+  const float a_coef = (float)(1 / scale->a_div);
+  const float w_coef = (float)(scale->w_frac / scale->a_div);
+  sl_la_vector_axpby(w_coef, &(model->w), a_coef, &(model->a));
+  sl_la_vector_scale(&(model->w), (float)(1 / scale->w_div));
+  *scale = (struct sl_ml_linear_scale){.w_div = 1, .a_div = 1, .w_frac = 0};
+}
+
+// a is w until averaging begins, which is a zero a with w_frac = 1 and a_div = w_div
+static void sl_ml_linear_reset_average(
+    struct sl_ml_linear model[const static 1],
+    struct sl_ml_linear_scale scale[const static 1]
+) {
+  if (model->n_steps <= model->average_begin) {
+    sl_la_vector_clear(&(model->a));
+    scale->a_div  = scale->w_div;
+    scale->w_frac = 1;
+  }
+}
+
+// sparse ASGD by Bottou (2012), Stochastic Gradient Descent Tricks, section 5.3
+void sl_ml_linear_fit_csr(
+    uint64_t prng[static 1],
+    struct sl_ml_linear model[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint16_t classes[const static 1]
+) {
+  assert(sl_vector_f32_size(&(model->w)) == sl_vector_f32_size(&(model->a)));
+  const size_t n_rows = sl_csr_f32_num_rows(data);
+  for (size_t i = 0; i < n_rows; ++i) {
+    model->shuffle_buffer[i] = i;
+  }
+
+  const double eta0   = (double)model->learning_rate;
+  const double lambda = (double)model->lambda;
+
+  struct sl_ml_linear_scale scale = {.w_div = 1, .a_div = 1, .w_frac = 0};
+  sl_ml_linear_reset_average(model, &scale);
+
+  for (int epoch = 0; epoch < model->n_epochs; ++epoch) {
+    sl_random_shuffle(prng, model->shuffle_buffer, sizeof(size_t), n_rows);
+
+    for (size_t i = 0; i < n_rows; ++i) {
+      if (scale.w_div > SL_ML_LINEAR_MAX_DIVISOR || scale.a_div > SL_ML_LINEAR_MAX_DIVISOR) {
+        sl_ml_linear_fold_scale(model, &scale);
+        sl_ml_linear_reset_average(model, &scale);
+      }
+      const size_t row = model->shuffle_buffer[i];
+      const double y   = (classes[row] == 1) ? 1 : -1;
+      const double t   = (double)model->n_steps;
+      const double eta = eta0 / pow(1 + (lambda * eta0 * t), 0.75);
+
+      const double score = (double)sl_la_csr_row_dot(data, row, &(model->w)) / scale.w_div;
+      scale.w_div /= 1 - (eta * lambda);
+
+      const double g    = sl_ml_loss_gradient(model->loss, y * score);
+      const double step = eta * g * y * scale.w_div;
+      if (g > 0) {
+        sl_la_csr_row_axpy(data, row, (float)step, &(model->w));
+      }
+
+      // a is the mean of the iterates since step t0 = average_begin, with weight
+      // mu = 1 / max(1, t - t0 + 1) for the latest one, so a is w up to and including step t0
+      const double mu = 1 / fmax(1, t - (double)model->average_begin + 1);
+      if (mu >= 1) {
+        scale.a_div  = scale.w_div;
+        scale.w_frac = 1;
+      } else {
+        if (g > 0) {
+          sl_la_csr_row_axpy(data, row, (float)(-scale.w_frac * step), &(model->a));
+        }
+        scale.a_div /= 1 - mu;
+        scale.w_frac += mu * scale.a_div / scale.w_div;
+      }
+      ++model->n_steps;
+    }
+  }
+
+  sl_ml_linear_fold_scale(model, &scale);
+}
+
+bool sl_ml_kfold_create(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    const size_t n_rows,
+    const size_t n_folds,
+    struct sl_ml_kfold kfold[static 1]
+) {
+  if (n_folds < 2 || n_folds > n_rows) {
+    SL_ERROR(ctx, "cannot split %zu rows into %zu folds", n_rows, n_folds);
+    return false;
+  }
+  size_t* rows = sl_alloc(ctx, n_rows, sizeof(size_t));
+  if (!rows) {
+    SL_ERROR(ctx, "failed allocating row indices of %zu folds", n_folds);
+    return false;
+  }
+  for (size_t i = 0; i < n_rows; ++i) {
+    rows[i] = i;
+  }
+  sl_random_shuffle(prng, rows, sizeof(size_t), n_rows);
+  *kfold = (struct sl_ml_kfold){
+      .n_rows  = n_rows,
+      .n_folds = n_folds,
+      .rows    = rows,
+  };
+  return true;
+}
+
+void sl_ml_kfold_destroy(struct sl_ml_kfold kfold[static 1]) {
+  sl_free(kfold->rows);
+  *kfold = (struct sl_ml_kfold){0};
+}
+
+size_t sl_ml_kfold_begin(const struct sl_ml_kfold kfold[const static 1], const size_t fold) {
+  assert(fold <= kfold->n_folds);
+  return fold * kfold->n_rows / kfold->n_folds;
+}
+
+size_t sl_ml_kfold_train_rows(
+    const struct sl_ml_kfold kfold[const static 1],
+    const size_t fold,
+    size_t rows[static 1]
+) {
+  const size_t test_begin = sl_ml_kfold_begin(kfold, fold);
+  const size_t test_end   = sl_ml_kfold_begin(kfold, fold + 1);
+  memcpy(rows, kfold->rows, sizeof(size_t) * test_begin);
+  memcpy(rows + test_begin, kfold->rows + test_end, sizeof(size_t) * (kfold->n_rows - test_end));
+  return kfold->n_rows - (test_end - test_begin);
+}
+
+size_t sl_ml_svm_grid_size(const struct sl_ml_svm_grid grid[const static 1]) {
+  return grid->n_learning_rates * grid->n_batch_sizes * grid->n_epoch_counts;
+}
+
+void sl_ml_svm_grid_get(
+    const struct sl_ml_svm_grid grid[const static 1],
+    const size_t configuration,
+    struct sl_ml_svm svm[const static 1]
+) {
+  assert(configuration < sl_ml_svm_grid_size(grid));
+  const size_t epochs_idx = configuration % grid->n_epoch_counts;
+  const size_t batch_idx  = (configuration / grid->n_epoch_counts) % grid->n_batch_sizes;
+  const size_t rate_idx   = configuration / (grid->n_epoch_counts * grid->n_batch_sizes);
+  svm->learning_rate      = grid->learning_rates[rate_idx];
+  svm->batch_size         = grid->batch_sizes[batch_idx];
+  svm->n_epochs           = grid->epoch_counts[epochs_idx];
+}
+
+// state shared by all workers of sl_ml_svm_cross_validate
+struct sl_ml_svm_cv {
+  const struct sl_ml_svm_grid* grid;
+  const struct sl_ml_kfold* kfold;
+  struct sl_matrix_f32* data;
+  const uint16_t* classes;
+  struct sl_ml_classification* results;
+  // stream of task 0, task i uses the stream advanced by i strides
+  uint64_t prng;
+  size_t n_tasks;
+  _Atomic(size_t) next_task;
+};
+
+struct sl_ml_svm_cv_worker {
+  struct sl_ml_svm_cv* cv;
+  struct sl_ml_svm svm;
+  pthread_t thread;
+  bool is_started;
+};
+
+static void sl_ml_svm_cv_task(
+    struct sl_ml_svm_cv_worker worker[const static 1],
+    const size_t task
+) {
+  const struct sl_ml_svm_cv* const cv = worker->cv;
+  struct sl_ml_svm* const svm         = &(worker->svm);
+  const size_t n_folds                = cv->kfold->n_folds;
+  const size_t fold                   = task % n_folds;
+
+  uint64_t prng = cv->prng;
+  sl_random_pcg32_advance(&prng, task * SL_ML_SVM_STREAM_STRIDE);
+
+  sl_ml_svm_grid_get(cv->grid, task / n_folds, svm);
+  sl_la_vector_clear(&(svm->w));
+  const size_t n_train = sl_ml_kfold_train_rows(cv->kfold, fold, svm->shuffle_buffer);
+  sl_ml_svm_linear_fit_rows(&prng, svm, cv->data, cv->classes, n_train);
+
+  struct sl_ml_classification cls = {0};
+  const size_t test_end           = sl_ml_kfold_begin(cv->kfold, fold + 1);
+  for (size_t i = sl_ml_kfold_begin(cv->kfold, fold); i < test_end; ++i) {
+    const size_t row       = cv->kfold->rows[i];
+    struct sl_vector_f32 x = sl_la_matrix_row_view(cv->data, row);
+    sl_ml_classification_update(&cls, sl_ml_svm_binary_predict(svm, &x), cv->classes[row]);
+  }
+  cv->results[task] = cls;
+}
+
+static void* sl_ml_svm_cv_run(void* arg) {
+  struct sl_ml_svm_cv_worker* worker = arg;
+  struct sl_ml_svm_cv* cv            = worker->cv;
+  for (;;) {
+    const size_t task = atomic_fetch_add_explicit(&(cv->next_task), 1, memory_order_relaxed);
+    if (task >= cv->n_tasks) {
+      break;
+    }
+    sl_ml_svm_cv_task(worker, task);
+  }
+  return nullptr;
+}
+
+bool sl_ml_svm_cross_validate(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    const struct sl_ml_svm_grid grid[const static 1],
+    const struct sl_ml_kfold kfold[const static 1],
+    struct sl_matrix_f32 data[const static 1],
+    const uint16_t classes[const static 1],
+    const size_t n_threads,
+    struct sl_ml_classification results[static 1]
+) {
+  bool ok                             = false;
+  struct sl_ml_svm_cv_worker* workers = nullptr;
+  const size_t n_features             = sl_matrix_f32_num_cols(data);
+
+  assert(kfold->n_rows == sl_matrix_f32_num_rows(data));
+  if (n_threads == 0) {
+    SL_ERROR(ctx, "cannot cross-validate SVM with 0 threads");
+    goto done;
+  }
+  for (size_t i = 0; i < grid->n_batch_sizes; ++i) {
+    if (grid->batch_sizes[i] <= 0) {
+      SL_ERROR(ctx, "cannot cross-validate SVM with batch size %d", grid->batch_sizes[i]);
+      goto done;
+    }
+  }
+
+  struct sl_ml_svm_cv cv = {
+      .grid    = grid,
+      .kfold   = kfold,
+      .data    = data,
+      .classes = classes,
+      .results = results,
+      .n_tasks = sl_ml_svm_grid_size(grid) * kfold->n_folds,
+  };
+  atomic_init(&(cv.next_task), 0);
+  cv.prng = (uint64_t)sl_random_pcg32(prng) << 32;
+  cv.prng |= sl_random_pcg32(prng);
+  sl_random_pcg32_init(&(cv.prng), cv.prng);
+
+  workers = sl_alloc(ctx, n_threads, sizeof(*workers));
+  if (!workers) {
+    SL_ERROR(ctx, "failed allocating %zu cross-validation workers", n_threads);
+    goto done;
+  }
+  for (size_t j = 0; j < n_threads; ++j) {
+    struct sl_ml_svm_cv_worker* worker = workers + j;
+    worker->cv                         = &cv;
+    worker->svm.shuffle_buffer         = sl_alloc(ctx, kfold->n_rows, sizeof(size_t));
+    if (!worker->svm.shuffle_buffer || !sl_la_vector_create(ctx, n_features, &(worker->svm.w))
+        || !sl_la_vector_create(ctx, n_features, &(worker->svm.s))) {
+      SL_ERROR(ctx, "failed allocating cross-validation worker %zu", j);
+      goto done;
+    }
+  }
+
+  for (size_t j = 0; j < n_threads; ++j) {
+    const int err = pthread_create(&(workers[j].thread), nullptr, sl_ml_svm_cv_run, workers + j);
+    if (err != 0) {
+      SL_ERROR(ctx, "failed starting cross-validation thread %zu (%s)", j, strerror(err));
+      goto done;
+    }
+    workers[j].is_started = true;
+  }
+
+  ok = true;
+done:
+  if (workers) {
+    // workers that did start finish all tasks, even if others failed to start
+    for (size_t j = 0; j < n_threads; ++j) {
+      if (workers[j].is_started) {
+        pthread_join(workers[j].thread, nullptr);
+      }
+      sl_la_vector_destroy(&(workers[j].svm.w));
+      sl_la_vector_destroy(&(workers[j].svm.s));
+      sl_free(workers[j].svm.shuffle_buffer);
+    }
+  }
+  sl_free(workers);
+  return ok;
+}
+
+bool sl_ml_svm_cross_validation_write(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const struct sl_ml_svm_grid grid[const static 1],
+    const size_t configuration,
+    const size_t n_folds,
+    struct sl_ml_classification results[const static 1]
+) {
+  struct sl_ml_svm svm = {0};
+  sl_ml_svm_grid_get(grid, configuration, &svm);
+  struct sl_ml_classification* const folds = results + (configuration * n_folds);
+  struct sl_ml_classification total        = {0};
+
+  if (!(sl_json_writer_object_begin(ctx, writer)
+        && sl_json_writer_key(ctx, writer, "learning_rate")
+        && sl_json_writer_double(ctx, writer, (double)svm.learning_rate)
+        && sl_json_writer_key(ctx, writer, "batch_size")
+        && sl_json_writer_int(ctx, writer, svm.batch_size)
+        && sl_json_writer_key(ctx, writer, "n_epochs")
+        && sl_json_writer_int(ctx, writer, svm.n_epochs)
+        && sl_json_writer_key(ctx, writer, "folds") && sl_json_writer_array_begin(ctx, writer))) {
+    return false;
+  }
+  for (size_t fold = 0; fold < n_folds; ++fold) {
+    if (!sl_ml_classification_write(ctx, writer, folds + fold)) {
+      return false;
+    }
+    total.tp += folds[fold].tp;
+    total.tn += folds[fold].tn;
+    total.fp += folds[fold].fp;
+    total.fn += folds[fold].fn;
   }
+  return sl_json_writer_array_end(ctx, writer) && sl_json_writer_key(ctx, writer, "total")
+         && sl_ml_classification_write(ctx, writer, &total)
+         && sl_json_writer_object_end(ctx, writer);
 }
@@ -6,7 +6,9 @@
 #include <stdio.h>
 
 #include <stufflib/context/context.h>
+#include <stufflib/json/writer.h>
 #include <stufflib/linalg/linalg.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
 #include <stufflib/vector/sl_vector_f32.h>
 
@@ -32,7 +34,6 @@ struct sl_ml_classification {
 // Support Vector Machine
 struct sl_ml_svm {
   struct sl_vector_f32 w;
-  struct sl_vector_f32 x;
   struct sl_vector_f32 s;
   size_t* shuffle_buffer;
   int batch_size;
@@ -40,6 +41,72 @@ struct sl_ml_svm {
   float learning_rate;
 };
 
+// one-vs-rest Support Vector Machine, a binary linear SVM for each class trained from the same
+// mini-batches, labels are a row-major n_rows x n_classes matrix with nonzero entries for the
+// classes of each row, such that a row may belong to any number of classes
+struct sl_ml_svm_ovr {
+  // n_features x n_classes, column c is the weight vector of class c
+  struct sl_matrix_f32 w;
+  // batch_size x n_features, rows of the current mini-batch, only used by the dense fit
+  struct sl_matrix_f32 x;
+  // batch_size x n_classes, scores of the current mini-batch
+  struct sl_matrix_f32 s;
+  size_t* shuffle_buffer;
+  int batch_size;
+  int n_epochs;
+  float learning_rate;
+};
+
+// losses of sl_ml_linear in terms of the margin z = y * score, where y is -1 or 1
+enum sl_ml_loss : unsigned char {
+  // max(0, 1 - z)
+  sl_ml_loss_hinge = 0,
+  // log(1 + exp(-z))
+  sl_ml_loss_logistic = 1,
+  // max(0, 1 - z)^2 / 2
+  sl_ml_loss_squared_hinge = 2,
+};
+
+// linear model trained with averaged stochastic gradient descent (ASGD)
+// https://leon.bottou.org/projects/sgd
+// 2024-06-30
+struct sl_ml_linear {
+  // weights of the last SGD step
+  struct sl_vector_f32 w;
+  // average of the SGD weights since step average_begin, used for scoring
+  struct sl_vector_f32 a;
+  size_t* shuffle_buffer;
+  enum sl_ml_loss loss;
+  int n_epochs;
+  // initial step size, decreases as learning_rate / (1 + lambda * learning_rate * t)^0.75
+  float learning_rate;
+  // strength of the L2 regularization
+  float lambda;
+  // SGD steps taken over all fits, fitting can continue batch by batch
+  size_t n_steps;
+  size_t average_begin;
+};
+
+// k-fold cross-validation split of row indices, the rows themselves are never copied
+// fold f tests on rows[sl_ml_kfold_begin(f), sl_ml_kfold_begin(f + 1)) and trains on the rest
+struct sl_ml_kfold {
+  size_t n_rows;
+  size_t n_folds;
+  // random permutation of 0, ..., n_rows - 1
+  size_t* rows;
+};
+
+// hyperparameter grid of sl_ml_svm, configuration c is the c-th combination of the values
+// in order of learning rate, batch size and number of epochs, the last one changing fastest
+struct sl_ml_svm_grid {
+  size_t n_learning_rates;
+  const float* learning_rates;
+  size_t n_batch_sizes;
+  const int* batch_sizes;
+  size_t n_epoch_counts;
+  const int* epoch_counts;
+};
+
 void sl_ml_random_train_test_split(
     struct sl_context ctx[static 1],
     uint64_t prng[static 1],
@@ -50,10 +117,24 @@ void sl_ml_random_train_test_split(
     uint16_t train_classes[const static 1],
     uint16_t test_classes[const static 1]
 );
+// lo and hi are accumulated over all fits, such that a scaler can be fit batch by batch
+// or on separate threads with their own scalers that are then merged
+// a reset scaler has an empty range that does not change the range of any fit or merge
+void sl_ml_minmax_reset(struct sl_ml_minmax_scaler scaler[const static 1]);
 void sl_ml_minmax_fit(
     struct sl_ml_minmax_scaler scaler[const static 1],
     struct sl_matrix_f32 m[const static 1]
 );
+void sl_ml_minmax_fit_vector(
+    struct sl_ml_minmax_scaler scaler[const static 1],
+    const struct sl_vector_f32 x[const static 1]
+);
+// extends the range of scaler with the range of other
+void sl_ml_minmax_merge(
+    struct sl_ml_minmax_scaler scaler[const static 1],
+    const struct sl_ml_minmax_scaler other[const static 1]
+);
+// rescales m into [a, b] in a single pass, e.g. right after reading a batch
 void sl_ml_minmax_apply(
     struct sl_ml_minmax_scaler scaler[const static 1],
     struct sl_matrix_f32 m[const static 1],
@@ -65,11 +146,24 @@ void sl_ml_classification_update(
     uint16_t pred_class,
     uint16_t real_class
 );
+// row i is predicted as class 1 if scores[i] is positive
+void sl_ml_classification_update_scores(
+    struct sl_ml_classification cls[const static 1],
+    size_t n,
+    const float scores[const static n],
+    const uint16_t real_classes[const static n]
+);
 double sl_ml_classification_accuracy(struct sl_ml_classification cls[const static 1]);
 double sl_ml_classification_precision(struct sl_ml_classification cls[const static 1]);
 double sl_ml_classification_recall(struct sl_ml_classification cls[const static 1]);
 double sl_ml_classification_f1_score(struct sl_ml_classification cls[const static 1]);
-void sl_ml_classification_print(
+bool sl_ml_classification_write(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_ml_classification cls[const static 1]
+);
+bool sl_ml_classification_print(
+    struct sl_context ctx[static 1],
     FILE stream[const static 1],
     struct sl_ml_classification cls[const static 1]
 );
@@ -77,12 +171,151 @@ uint8_t sl_ml_svm_binary_predict(
     struct sl_ml_svm svm[const static 1],
     struct sl_vector_f32 x[const static 1]
 );
+// scores[i] := dot(w, row i of data), all rows at once
+void sl_ml_svm_scores(
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_matrix_f32 data[const static 1],
+    struct sl_vector_f32 scores[const static 1]
+);
+void sl_ml_svm_scores_csr(
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    struct sl_vector_f32 scores[const static 1]
+);
 void sl_ml_svm_linear_fit(
     uint64_t prng[static 1],
     struct sl_ml_svm svm[const static 1],
     struct sl_matrix_f32 data[const static 1],
     const uint16_t classes[const static 1]
 );
+// sl_ml_svm_linear_fit on the rows of data whose indices are in svm->shuffle_buffer[0, n_rows)
+void sl_ml_svm_linear_fit_rows(
+    uint64_t prng[static 1],
+    struct sl_ml_svm svm[const static 1],
+    struct sl_matrix_f32 data[const static 1],
+    const uint16_t classes[const static 1],
+    size_t n_rows
+);
+uint8_t sl_ml_svm_binary_predict_csr(
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    size_t row
+);
+// sparse sl_ml_svm_linear_fit, cost of each iteration is linear in the nonzeros of the batch
+// svm->s is not used
+void sl_ml_svm_linear_fit_csr(
+    uint64_t prng[static 1],
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint16_t classes[const static 1]
+);
+// Hogwild by Niu et al. (2011), n_threads workers sample mini-batches from their own PCG streams
+// and add margin violators into shared weights without locks, overlapping updates may be lost
+// if sync_steps is positive, workers instead fit their own weights and average them every
+// sync_steps iterations, n_epochs is split evenly between the workers
+// svm->s and svm->shuffle_buffer are not used
+bool sl_ml_svm_linear_fit_parallel(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    struct sl_ml_svm svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint16_t classes[const static 1],
+    size_t n_threads,
+    size_t sync_steps
+);
+// scores := data w, row i has the scores of row i of data for all classes
+void sl_ml_svm_ovr_scores(
+    struct sl_ml_svm_ovr svm[const static 1],
+    const struct sl_matrix_f32 data[const static 1],
+    struct sl_matrix_f32 scores[const static 1]
+);
+void sl_ml_svm_ovr_scores_csr(
+    struct sl_ml_svm_ovr svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    struct sl_matrix_f32 scores[const static 1]
+);
+// class with the highest score on row of scores
+uint16_t sl_ml_svm_ovr_predict(const struct sl_matrix_f32 scores[const static 1], size_t row);
+// mini-batch pegasos for all classes at once, each batch is scored against all classes with one
+// matrix product and all classes are updated from the same batch
+// all classes share the regularization shrink, which is applied as a single scale of w
+void sl_ml_svm_ovr_fit(
+    uint64_t prng[static 1],
+    struct sl_ml_svm_ovr svm[const static 1],
+    struct sl_matrix_f32 data[const static 1],
+    const uint8_t labels[const static 1]
+);
+// sparse sl_ml_svm_ovr_fit, each iteration touches only the rows of w at the nonzeros of the batch
+// svm->x is not used
+void sl_ml_svm_ovr_fit_csr(
+    uint64_t prng[static 1],
+    struct sl_ml_svm_ovr svm[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint8_t labels[const static 1]
+);
+// scores[i] := dot(a, row i of data)
+void sl_ml_linear_scores_csr(
+    struct sl_ml_linear model[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    struct sl_vector_f32 scores[const static 1]
+);
+// scores[i] := 1 / (1 + exp(-scores[i])), probabilities of class 1 if the loss is logistic
+void sl_ml_sigmoid(size_t n, float scores[static n]);
+// one ASGD step per row and epoch, touches only the nonzeros of the row
+// the L2 shrink and the averaging are kept as scalars and folded into w and a when they grow
+// too large or fitting ends, which makes each step linear in the nonzeros of the row
+void sl_ml_linear_fit_csr(
+    uint64_t prng[static 1],
+    struct sl_ml_linear model[const static 1],
+    const struct sl_csr_f32 data[const static 1],
+    const uint16_t classes[const static 1]
+);
+bool sl_ml_kfold_create(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    size_t n_rows,
+    size_t n_folds,
+    struct sl_ml_kfold kfold[static 1]
+);
+void sl_ml_kfold_destroy(struct sl_ml_kfold kfold[static 1]);
+// index into kfold->rows of the first test row of fold, fold n_folds is one past the last row
+size_t sl_ml_kfold_begin(const struct sl_ml_kfold kfold[const static 1], size_t fold);
+// writes the indices of the training rows of fold into rows and returns how many there are
+size_t sl_ml_kfold_train_rows(
+    const struct sl_ml_kfold kfold[const static 1],
+    size_t fold,
+    size_t rows[static 1]
+);
+size_t sl_ml_svm_grid_size(const struct sl_ml_svm_grid grid[const static 1]);
+// sets the learning rate, batch size and number of epochs of svm to those of configuration
+void sl_ml_svm_grid_get(
+    const struct sl_ml_svm_grid grid[const static 1],
+    size_t configuration,
+    struct sl_ml_svm svm[const static 1]
+);
+// fits every configuration of grid on the training rows of every fold and classifies the test
+// rows of the fold, results[configuration * n_folds + fold] is the classification
+// n_threads workers take (configuration, fold) tasks in turn, each task has its own PCG stream
+// such that the results do not depend on n_threads
+bool sl_ml_svm_cross_validate(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    const struct sl_ml_svm_grid grid[const static 1],
+    const struct sl_ml_kfold kfold[const static 1],
+    struct sl_matrix_f32 data[const static 1],
+    const uint16_t classes[const static 1],
+    size_t n_threads,
+    struct sl_ml_classification results[static 1]
+);
+// writes configuration of grid and the classifications of its folds as an object
+bool sl_ml_svm_cross_validation_write(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const struct sl_ml_svm_grid grid[const static 1],
+    size_t configuration,
+    size_t n_folds,
+    struct sl_ml_classification results[const static 1]
+);
 
 #define SL_ML_MINMAX_SCALER_CREATE_INLINE(n_features)   \
   (struct sl_ml_minmax_scaler) {                        \
@@ -0,0 +1,175 @@
+#include <stddef.h>
+#include <string.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/filesystem/filesystem.h>
+#include <stufflib/io/io.h>
+#include <stufflib/macros/macros.h>
+#include <stufflib/ml/ml.h>
+#include <stufflib/ml/model.h>
+#include <stufflib/record/record.h>
+#include <stufflib/record/writer.h>
+#include <stufflib/span/span.h>
+#include <stufflib/vector/sl_vector_f32.h>
+
+// view of row of a row-major model with n_features columns
+static struct sl_vector_f32 sl_ml_model_row(
+    const size_t n_features,
+    float data[const static 1],
+    const size_t row
+) {
+  return (struct sl_vector_f32){
+      .length   = {n_features},
+      .capacity = {n_features},
+      .data     = data + (row * n_features),
+  };
+}
+
+bool sl_ml_model_save(
+    struct sl_context ctx[static 1],
+    const char path[const static 1],
+    const char name[const static 1],
+    const struct sl_ml_svm svm[const static 1],
+    const struct sl_ml_minmax_scaler* minmax
+) {
+  bool ok                 = false;
+  struct sl_file file     = {0};
+  const size_t n_features = sl_vector_f32_size(&(svm->w));
+  const size_t n_rows     = minmax ? SL_ML_MODEL_SVM_MINMAX_ROWS : SL_ML_MODEL_SVM_ROWS;
+
+  struct sl_record record = {
+      .layout   = "dense",
+      .type     = "float32",
+      .size     = n_rows * n_features,
+      .n_dims   = 2,
+      .dim_size = {n_rows, n_features},
+  };
+  struct sl_record_writer writer = {
+      .file   = &file,
+      .record = &record,
+  };
+
+  if (strlen(path) >= sizeof(record.path) || strlen(name) >= sizeof(record.name)) {
+    SL_ERROR(ctx, "path or name of model '%s' is too long", name);
+    goto done;
+  }
+  memcpy(record.path, path, strlen(path) + 1);
+  memcpy(record.name, name, strlen(name) + 1);
+
+  const struct sl_vector_f32* rows[SL_ML_MODEL_SVM_MINMAX_ROWS] = {&(svm->w)};
+  if (minmax) {
+    if (!minmax->is_cached) {
+      SL_ERROR(ctx, "cannot save model '%s', scale and offset of its scaler are not cached", name);
+      goto done;
+    }
+    rows[1] = &(minmax->lo);
+    rows[2] = &(minmax->hi);
+    rows[3] = &(minmax->scale);
+    rows[4] = &(minmax->offset);
+  }
+  for (size_t i = 0; i < n_rows; ++i) {
+    if (sl_vector_f32_size(rows[i]) != n_features) {
+      SL_ERROR(ctx, "cannot save model '%s', row %zu is not %zu features", name, i, n_features);
+      goto done;
+    }
+  }
+
+  if (!sl_record_write_metadata(ctx, &record) || !sl_record_writer_open(ctx, &writer)) {
+    SL_ERROR(ctx, "cannot write model '%s' to '%s'", name, path);
+    goto done;
+  }
+  for (size_t i = 0; i < n_rows; ++i) {
+    struct sl_span row = sl_span_view(sizeof(float) * n_features, (void*)rows[i]->data);
+    if (!sl_record_writer_write(ctx, &writer, &row)) {
+      SL_ERROR(ctx, "failed writing row %zu of model '%s'", i, name);
+      goto done;
+    }
+  }
+  if (!sl_record_writer_finish(ctx, &writer)) {
+    SL_ERROR(ctx, "failed writing model '%s'", name);
+    goto done;
+  }
+
+  ok = true;
+done:
+  sl_record_writer_close(&writer);
+  return ok;
+}
+
+bool sl_ml_model_load(
+    struct sl_context ctx[static 1],
+    const char path[const static 1],
+    const char name[const static 1],
+    struct sl_ml_model model[static 1]
+) {
+  *model                  = (struct sl_ml_model){0};
+  struct sl_record record = {0};
+  if (!sl_record_read_metadata(ctx, &record, path, name)) {
+    SL_ERROR(ctx, "failed reading metadata of model '%s'", name);
+    return false;
+  }
+
+  const size_t n_rows     = record.dim_size[0];
+  const size_t n_features = record.dim_size[1];
+  if (sl_record_layout_of(&record) != sl_record_layout_dense
+      || sl_record_type_of(&record) != sl_record_type_float32 || record.n_dims != 2
+      || record.n_shards != 0
+      || (n_rows != SL_ML_MODEL_SVM_ROWS && n_rows != SL_ML_MODEL_SVM_MINMAX_ROWS)
+      || n_features == 0 || record.size != n_rows * n_features) {
+    SL_ERROR(
+        ctx,
+        "model '%s' is not a dense float32 record of %d or %d rows",
+        name,
+        SL_ML_MODEL_SVM_ROWS,
+        SL_ML_MODEL_SVM_MINMAX_ROWS
+    );
+    return false;
+  }
+
+  char data_path[1'024] = {0};
+  if (!sl_file_format_path(
+          SL_ARRAY_LEN(data_path),
+          data_path,
+          record.path,
+          record.name,
+          ".sl_record_data"
+      )) {
+    SL_ERROR(ctx, "failed formatting data file path of model '%s'", name);
+    return false;
+  }
+  if (!sl_fs_map_file(ctx, data_path, &(model->mapping))) {
+    SL_ERROR(ctx, "failed mapping data of model '%s'", name);
+    return false;
+  }
+  if (model->mapping.size != sizeof(float) * record.size) {
+    SL_ERROR(
+        ctx,
+        "data of model '%s' has %zu bytes, expected %zu",
+        name,
+        model->mapping.size,
+        sizeof(float) * record.size
+    );
+    sl_ml_model_unload(model);
+    return false;
+  }
+
+  // the mapping is page aligned
+  float* const data = (void*)model->mapping.data;
+  model->svm.w      = sl_ml_model_row(n_features, data, 0);
+  if (n_rows == SL_ML_MODEL_SVM_MINMAX_ROWS) {
+    model->minmax = (struct sl_ml_minmax_scaler){
+        .lo        = sl_ml_model_row(n_features, data, 1),
+        .hi        = sl_ml_model_row(n_features, data, 2),
+        .scale     = sl_ml_model_row(n_features, data, 3),
+        .offset    = sl_ml_model_row(n_features, data, 4),
+        .is_cached = true,
+    };
+    model->has_minmax = true;
+  }
+  return true;
+}
+
+void sl_ml_model_unload(struct sl_ml_model model[static 1]) {
+  sl_fs_unmap_file(&(model->mapping));
+  *model = (struct sl_ml_model){0};
+}
@@ -0,0 +1,45 @@
+#ifndef SL_ML_MODEL_H_INCLUDED
+#define SL_ML_MODEL_H_INCLUDED
+/*
+ * trained linear SVM and the minmax scaler of its inputs, saved as a dense float32 record
+ * with one column per feature and the rows w, lo, hi, scale and offset, or only w without a scaler
+ * dense record data is raw floats, such that a loaded model is a read-only view into the
+ * mapped data file and only the small metadata file is parsed
+ */
+
+#include <stddef.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/ml/ml.h>
+#include <stufflib/span/span.h>
+
+// rows of a saved model with and without a scaler
+#define SL_ML_MODEL_SVM_ROWS 1
+#define SL_ML_MODEL_SVM_MINMAX_ROWS 5
+
+// vectors of svm and minmax point into mapping and must not be written to
+// shuffle_buffer and s of svm are not set, the model can be used for scoring but not fitting
+struct sl_ml_model {
+  struct sl_ml_svm svm;
+  struct sl_ml_minmax_scaler minmax;
+  bool has_minmax;
+  struct sl_span mapping;
+};
+
+// minmax may be null, otherwise it must have been applied such that its scale and offset are cached
+bool sl_ml_model_save(
+    struct sl_context ctx[static 1],
+    const char path[const static 1],
+    const char name[const static 1],
+    const struct sl_ml_svm svm[const static 1],
+    const struct sl_ml_minmax_scaler* minmax
+);
+bool sl_ml_model_load(
+    struct sl_context ctx[static 1],
+    const char path[const static 1],
+    const char name[const static 1],
+    struct sl_ml_model model[static 1]
+);
+void sl_ml_model_unload(struct sl_ml_model model[static 1]);
+
+#endif  // SL_ML_MODEL_H_INCLUDED
@@ -0,0 +1,42 @@
+#ifndef SL_NUMBER_H_INCLUDED
+#define SL_NUMBER_H_INCLUDED
+/*
+ * parsers for decimal numbers in text that is not necessarily null-terminated
+ * each parser reads a number from the beginning of str[len] and returns the amount of bytes read,
+ * or 0 if str does not begin with a number or the number does not fit the output type
+ *
+ * integers are read 8 digits at a time
+ * floats are rounded to the nearest representable value with the Eisel-Lemire algorithm,
+ * strtod is used in the C locale for the rare inputs where the algorithm cannot decide
+ * the rounding, ctx gets an error if the input cannot be copied for strtod
+ */
+
+#include <locale.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <stufflib/context/context.h>
+
+// [0-9]+
+size_t sl_number_parse_u64(size_t len, const char str[static len], uint64_t out[static 1]);
+// -?[0-9]+
+size_t sl_number_parse_i64(size_t len, const char str[static len], int64_t out[static 1]);
+// [+-]?([0-9]+\.?[0-9]*|\.[0-9]+)([eE][+-]?[0-9]+)?
+size_t sl_number_parse_f64(
+    struct sl_context ctx[static 1],
+    size_t len,
+    const char str[static len],
+    double out[static 1]
+);
+size_t sl_number_parse_f32(
+    struct sl_context ctx[static 1],
+    size_t len,
+    const char str[static len],
+    float out[static 1]
+);
+
+// the "C" locale, in which the decimal point is '.' regardless of LC_NUMERIC
+// created on first use, returns (locale_t)0 if it cannot be created
+locale_t sl_number_c_locale(void);
+
+#endif  // SL_NUMBER_H_INCLUDED
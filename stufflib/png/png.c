@@ -7,6 +7,7 @@
 
 #include <stufflib/context/context.h>
 #include <stufflib/hash/hash.h>
+#include <stufflib/json/writer.h>
 #include <stufflib/macros/macros.h>
 #include <stufflib/memory/memory.h>
 #include <stufflib/misc/misc.h>
@@ -128,63 +129,90 @@ bool sl_png_is_supported(struct sl_png_header header) {
   );
 }
 
-void sl_png_dump_header(FILE stream[const static 1], struct sl_png_header header) {
-  fprintf(stream, "{");
-  fprintf(stream, "\"width\":%zu,", header.width);
-  fprintf(stream, "\"height\":%zu,", header.height);
-  fprintf(stream, "\"bit depth\":%u,", header.bit_depth);
-  fprintf(stream, "\"color type\":\"%s\",", sl_png_color_types[header.color_type]);
-  fprintf(stream, "\"compression\":%u,", header.compression);
-  fprintf(stream, "\"filter\":%u,", header.filter);
-  fprintf(stream, "\"interlace\":%u", header.interlace);
-  fprintf(stream, "}");
-}
-
-void sl_png_dump_img_data_info(FILE stream[const static 1], struct sl_png_image image) {
-  fprintf(stream, "{");
-  fprintf(stream, "\"length\":%zu,", image.data.size);
-  fprintf(stream, "\"filters\":{");
+bool sl_png_dump_header(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_header header
+) {
+  const char* const color_type = (size_t)header.color_type < SL_ARRAY_LEN(sl_png_color_types)
+                                     ? sl_png_color_types[header.color_type]
+                                     : nullptr;
+  return sl_json_writer_object_begin(ctx, writer)
+         && sl_json_writer_key(ctx, writer, "width")
+         && sl_json_writer_uint(ctx, writer, header.width)
+         && sl_json_writer_key(ctx, writer, "height")
+         && sl_json_writer_uint(ctx, writer, header.height)
+         && sl_json_writer_key(ctx, writer, "bit depth")
+         && sl_json_writer_uint(ctx, writer, header.bit_depth)
+         && sl_json_writer_key(ctx, writer, "color type")
+         && (color_type ? sl_json_writer_string(ctx, writer, color_type)
+                        : sl_json_writer_null(ctx, writer))
+         && sl_json_writer_key(ctx, writer, "compression")
+         && sl_json_writer_uint(ctx, writer, header.compression)
+         && sl_json_writer_key(ctx, writer, "filter")
+         && sl_json_writer_uint(ctx, writer, header.filter)
+         && sl_json_writer_key(ctx, writer, "interlace")
+         && sl_json_writer_uint(ctx, writer, header.interlace)
+         && sl_json_writer_object_end(ctx, writer);
+}
+
+bool sl_png_dump_img_data_info(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_image image
+) {
   size_t freq[sl_png_num_filter_types] = {0};
   for (size_t i = 0; i < image.filter.size; ++i) {
     ++freq[image.filter.data[i]];
   }
-  bool did_print = false;
+  if (!(sl_json_writer_object_begin(ctx, writer) && sl_json_writer_key(ctx, writer, "length")
+        && sl_json_writer_uint(ctx, writer, image.data.size)
+        && sl_json_writer_key(ctx, writer, "filters")
+        && sl_json_writer_object_begin(ctx, writer))) {
+    return false;
+  }
   for (size_t filter = 0; filter < sl_png_num_filter_types; ++filter) {
-    if (freq[filter]) {
-      const char* filter_name = sl_png_filter_types[filter];
-      if (did_print) {
-        fprintf(stream, ",");
-      }
-      fprintf(stream, "\"%s\":%zu", filter_name, freq[filter]);
-      did_print = true;
+    if (freq[filter]
+        && !(sl_json_writer_key(ctx, writer, sl_png_filter_types[filter])
+             && sl_json_writer_uint(ctx, writer, freq[filter]))) {
+      return false;
     }
   }
-  fprintf(stream, "}}");
+  return sl_json_writer_object_end(ctx, writer) && sl_json_writer_object_end(ctx, writer);
 }
 
-void sl_png_dump_img_meta(FILE stream[const static 1], struct sl_png_image image) {
-  sl_png_dump_img_data_info(stream, image);
-  sl_png_dump_header(stream, image.header);
+bool sl_png_dump_img_meta(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_image image
+) {
+  return sl_json_writer_object_begin(ctx, writer) && sl_json_writer_key(ctx, writer, "data")
+         && sl_png_dump_img_data_info(ctx, writer, image)
+         && sl_json_writer_key(ctx, writer, "header")
+         && sl_png_dump_header(ctx, writer, image.header)
+         && sl_json_writer_object_end(ctx, writer);
 }
 
-void sl_png_dump_chunk_type_freq(FILE stream[const static 1], struct sl_png_chunks chunks) {
-  fprintf(stream, "{");
+bool sl_png_dump_chunk_type_freq(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_chunks chunks
+) {
   size_t freq[sl_png_num_chunk_types] = {0};
   for (size_t i = 0; i < chunks.count; ++i) {
     ++freq[chunks.chunks[i].type];
   }
-  bool did_print = false;
+  if (!sl_json_writer_object_begin(ctx, writer)) {
+    return false;
+  }
   for (size_t type = 0; type < sl_png_num_chunk_types; ++type) {
-    if (freq[type]) {
-      const char* type_name = sl_png_chunk_types[type];
-      if (did_print) {
-        fprintf(stream, ",");
-      }
-      fprintf(stream, "\"%s\":%zu", type_name, freq[type]);
-      did_print = true;
+    if (freq[type]
+        && !(sl_json_writer_key(ctx, writer, type ? sl_png_chunk_types[type] : "unknown")
+             && sl_json_writer_uint(ctx, writer, freq[type]))) {
+      return false;
     }
   }
-  fprintf(stream, "}");
+  return sl_json_writer_object_end(ctx, writer);
 }
 
 enum sl_png_chunk_type sl_png_find_chunk_type(const char type_id[const static 1]) {
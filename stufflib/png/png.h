@@ -10,6 +10,7 @@
 #include <stdio.h>
 
 #include <stufflib/context/context.h>
+#include <stufflib/json/writer.h>
 #include <stufflib/span/span.h>
 
 enum sl_png_chunk_type {
@@ -104,10 +105,26 @@ void sl_png_image_set_pixel(
     const unsigned char* new_value
 );
 bool sl_png_is_supported(struct sl_png_header header);
-void sl_png_dump_header(FILE stream[const static 1], struct sl_png_header header);
-void sl_png_dump_img_data_info(FILE stream[const static 1], struct sl_png_image image);
-void sl_png_dump_img_meta(FILE stream[const static 1], struct sl_png_image image);
-void sl_png_dump_chunk_type_freq(FILE stream[const static 1], struct sl_png_chunks chunks);
+bool sl_png_dump_header(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_header header
+);
+bool sl_png_dump_img_data_info(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_image image
+);
+bool sl_png_dump_img_meta(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_image image
+);
+bool sl_png_dump_chunk_type_freq(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    struct sl_png_chunks chunks
+);
 enum sl_png_chunk_type sl_png_find_chunk_type(const char type_id[const static 1]);
 struct sl_png_chunk
 sl_png_read_next_chunk(struct sl_context ctx[static 1], FILE fp[const static 1]);
@@ -33,6 +33,24 @@ void sl_random_pcg32_init(uint64_t state[const static 1], uint64_t seed) {
   (void)sl_random_pcg32(state);
 }
 
+// https://www.pcg-random.org/pdf/hmc-cs-2014-0905.pdf section 4.3.1
+// 2026-10-19
+void sl_random_pcg32_advance(uint64_t state[const static 1], uint64_t delta) {
+  uint64_t mult     = SL_RANDOM_PCG_MULTIPLIER;
+  uint64_t plus     = SL_RANDOM_PCG_INCREMENT;
+  uint64_t acc_mult = 1;
+  uint64_t acc_plus = 0;
+  for (; delta > 0; delta >>= 1) {
+    if (delta & 1) {
+      acc_mult *= mult;
+      acc_plus = (acc_plus * mult) + plus;
+    }
+    plus *= mult + 1;
+    mult *= mult;
+  }
+  *state = (acc_mult * *state) + acc_plus;
+}
+
 size_t sl_random_int(uint64_t state[const static 1], size_t a, size_t b) {
   // return random integer i such that a <= i < b
   if (a >= b) {
@@ -15,6 +15,9 @@ static inline uint32_t sl_random_pcg_rotate(uint32_t x, unsigned r) {
 bool sl_random_read_device_seed(struct sl_context ctx[static 1], uint64_t out[static 1]);
 uint32_t sl_random_pcg32(uint64_t state[static 1]);
 void sl_random_pcg32_init(uint64_t state[static 1], uint64_t seed);
+// jumps state delta steps ahead in O(log delta),
+// states advanced by distinct multiples of a large stride are non-overlapping streams
+void sl_random_pcg32_advance(uint64_t state[static 1], uint64_t delta);
 size_t sl_random_int(uint64_t state[static 1], size_t a, size_t b);
 void sl_random_fill_double(uint64_t state[static 1], size_t n, double dst[n], double scale);
 void sl_random_set_zero_double(
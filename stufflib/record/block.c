@@ -0,0 +1,367 @@
+#include <stdint.h>
+#include <string.h>
+
+#include <assert.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/macros/macros.h>
+#include <stufflib/memory/memory.h>
+#include <stufflib/misc/misc.h>
+#include <stufflib/record/block.h>
+#include <stufflib/record/record.h>
+#include <stufflib/span/span.h>
+
+// LEB128 varints take at most 10 bytes for 64-bit values
+#define SL_RECORD_VARINT_MAX_LEN 10
+
+static size_t sl_record_varint_encode(uint64_t value, unsigned char out[const static 1]) {
+  size_t n = 0;
+  for (; value >= 0x80; value >>= 7) {
+    out[n++] = (unsigned char)(value | 0x80);
+  }
+  out[n++] = (unsigned char)value;
+  return n;
+}
+
+static bool sl_record_varint_decode(
+    const size_t size,
+    const unsigned char in[const size],
+    size_t pos[const static 1],
+    uint64_t out[const static 1]
+) {
+  uint64_t value = 0;
+  for (unsigned shift = 0; *pos < size && shift < 64; shift += 7) {
+    const unsigned char byte = in[(*pos)++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      *out = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t sl_record_zigzag_encode(const int64_t value) {
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t sl_record_zigzag_decode(const uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static int64_t sl_record_load_signed(
+    const size_t item_size,
+    const unsigned char src[const static 1]
+) {
+  switch (item_size) {
+    case sizeof(int8_t): {
+      int8_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+    case sizeof(int16_t): {
+      int16_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+    case sizeof(int32_t): {
+      int32_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+    default: {
+      int64_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+  }
+}
+
+static uint64_t sl_record_load_unsigned(
+    const size_t item_size,
+    const unsigned char src[const static 1]
+) {
+  switch (item_size) {
+    case sizeof(uint8_t): {
+      uint8_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+    case sizeof(uint16_t): {
+      uint16_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+    case sizeof(uint32_t): {
+      uint32_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+    default: {
+      uint64_t x = 0;
+      memcpy(&x, src, sizeof(x));
+      return x;
+    }
+  }
+}
+
+static void sl_record_store_unsigned(
+    const size_t item_size,
+    unsigned char dst[const static 1],
+    const uint64_t value
+) {
+  switch (item_size) {
+    case sizeof(uint8_t): {
+      const uint8_t x = (uint8_t)value;
+      memcpy(dst, &x, sizeof(x));
+      break;
+    }
+    case sizeof(uint16_t): {
+      const uint16_t x = (uint16_t)value;
+      memcpy(dst, &x, sizeof(x));
+      break;
+    }
+    case sizeof(uint32_t): {
+      const uint32_t x = (uint32_t)value;
+      memcpy(dst, &x, sizeof(x));
+      break;
+    }
+    default: {
+      memcpy(dst, &value, sizeof(value));
+      break;
+    }
+  }
+}
+
+enum sl_record_block_encoding sl_record_block_encoding_of(
+    const struct sl_record r[const static 1]
+) {
+  switch (sl_record_type_of(r)) {
+    case sl_record_type_float32:
+      // byte planes, e.g. all sign and exponent bytes next to each other, only pay off if the
+      // data file is compressed afterwards, otherwise they just cost a transpose both ways
+      return r->shuffle ? sl_record_block_shuffled : sl_record_block_raw;
+    case sl_record_type_int8:
+    case sl_record_type_int16:
+    case sl_record_type_int32:
+    case sl_record_type_int64:
+      return sl_record_block_zigzag;
+    case sl_record_type_uint8:
+    case sl_record_type_uint16:
+    case sl_record_type_uint32:
+    case sl_record_type_uint64:
+      return sl_record_block_varint;
+    case sl_record_type_unknown:
+      return sl_record_block_raw;
+  }
+  return sl_record_block_raw;
+}
+
+bool sl_record_block_create(
+    struct sl_context ctx[static 1],
+    struct sl_record_block block[const static 1],
+    const size_t item_size
+) {
+  assert(item_size > 0 && item_size <= sizeof(uint64_t));
+  const size_t max_encoded_size
+      = (3 * SL_RECORD_VARINT_MAX_LEN)
+        + (SL_RECORD_BLOCK_LEN * (SL_RECORD_VARINT_MAX_LEN + SL_RECORD_VARINT_MAX_LEN));
+  *block = (struct sl_record_block){
+      .item_size = item_size,
+      .positions = sl_alloc(ctx, SL_RECORD_BLOCK_LEN, sizeof(uint32_t)),
+      .values    = sl_alloc(ctx, SL_RECORD_BLOCK_LEN, item_size),
+  };
+  if (!block->positions || !block->values
+      || !sl_span_create(ctx, max_encoded_size, &(block->encoded))) {
+    SL_ERROR(ctx, "failed allocating record block buffers");
+    sl_record_block_destroy(block);
+    return false;
+  }
+  return true;
+}
+
+void sl_record_block_destroy(struct sl_record_block block[const static 1]) {
+  sl_free(block->positions);
+  sl_free(block->values);
+  sl_span_destroy(&(block->encoded));
+  *block = (struct sl_record_block){0};
+}
+
+size_t sl_record_block_append(
+    struct sl_record_block block[const static 1],
+    const size_t count,
+    const unsigned char dense[const static 1]
+) {
+  assert(block->length + count <= SL_RECORD_BLOCK_LEN);
+  const size_t item_size = block->item_size;
+  const size_t nnz_begin = block->nnz;
+
+  size_t i = sl_misc_next_nonzero(item_size, count, dense, 0);
+  while (i < count) {
+    block->positions[block->nnz] = (uint32_t)(block->length + i);
+    memcpy(block->values + (block->nnz * item_size), dense + (i * item_size), item_size);
+    ++(block->nnz);
+    i = sl_misc_next_nonzero(item_size, count, dense, i + 1);
+  }
+  block->length += count;
+  return block->nnz - nnz_begin;
+}
+
+void sl_record_block_clear(struct sl_record_block block[const static 1]) {
+  block->length = 0;
+  block->nnz    = 0;
+}
+
+size_t sl_record_block_scatter(
+    const struct sl_record_block block[const static 1],
+    size_t nz_begin,
+    const size_t begin,
+    const size_t end,
+    unsigned char dense[const static 1]
+) {
+  const size_t item_size = block->item_size;
+  for (; nz_begin < block->nnz && block->positions[nz_begin] < end; ++nz_begin) {
+    const size_t pos = block->positions[nz_begin];
+    assert(pos >= begin);
+    memcpy(dense + ((pos - begin) * item_size), block->values + (nz_begin * item_size), item_size);
+  }
+  return nz_begin;
+}
+
+size_t sl_record_block_encode(struct sl_record_block block[const static 1]) {
+  const size_t item_size = block->item_size;
+  const size_t nnz       = block->nnz;
+  unsigned char* out     = block->encoded.data;
+
+  size_t n = 0;
+  n += sl_record_varint_encode(block->length, out + n);
+  n += sl_record_varint_encode(nnz, out + n);
+  out[n++] = (unsigned char)block->encoding;
+
+  for (size_t k = 0, prev = 0; k < nnz; prev = block->positions[k], ++k) {
+    n += sl_record_varint_encode(block->positions[k] - prev, out + n);
+  }
+
+  switch (block->encoding) {
+    case sl_record_block_shuffled: {
+      // byte plane b holds byte b of every value
+      for (size_t b = 0; b < item_size; ++b) {
+        for (size_t k = 0; k < nnz; ++k) {
+          out[n++] = block->values[(k * item_size) + b];
+        }
+      }
+    } break;
+    case sl_record_block_varint: {
+      for (size_t k = 0; k < nnz; ++k) {
+        const uint64_t value = sl_record_load_unsigned(item_size, block->values + (k * item_size));
+        n += sl_record_varint_encode(value, out + n);
+      }
+    } break;
+    case sl_record_block_zigzag: {
+      for (size_t k = 0; k < nnz; ++k) {
+        const int64_t value = sl_record_load_signed(item_size, block->values + (k * item_size));
+        n += sl_record_varint_encode(sl_record_zigzag_encode(value), out + n);
+      }
+    } break;
+    case sl_record_block_raw: {
+      memcpy(out + n, block->values, nnz * item_size);
+      n += nnz * item_size;
+    } break;
+  }
+
+  assert(n <= block->encoded.size);
+  return n;
+}
+
+bool sl_record_block_decode(
+    struct sl_context ctx[static 1],
+    struct sl_record_block block[const static 1],
+    const size_t size
+) {
+  const size_t item_size  = block->item_size;
+  const unsigned char* in = block->encoded.data;
+
+  if (size > block->encoded.size) {
+    SL_ERROR(ctx, "record block of %zu bytes does not fit block buffer", size);
+    return false;
+  }
+
+  size_t pos      = 0;
+  uint64_t length = 0;
+  uint64_t nnz    = 0;
+  if (!sl_record_varint_decode(size, in, &pos, &length)
+      || !sl_record_varint_decode(size, in, &pos, &nnz) || pos >= size) {
+    SL_ERROR(ctx, "truncated record block header");
+    return false;
+  }
+  if (length > SL_RECORD_BLOCK_LEN || nnz > length) {
+    SL_ERROR(
+        ctx,
+        "invalid record block with length %zu and %zu nonzeros",
+        (size_t)length,
+        (size_t)nnz
+    );
+    return false;
+  }
+  if (in[pos] > sl_record_block_zigzag) {
+    SL_ERROR(ctx, "unknown record block encoding %d", in[pos]);
+    return false;
+  }
+  block->length   = length;
+  block->nnz      = nnz;
+  block->encoding = in[pos++];
+
+  for (size_t k = 0, prev = 0; k < nnz; ++k) {
+    uint64_t delta = 0;
+    // prev < length, so the bounds check never wraps, and positions must be increasing
+    if (!sl_record_varint_decode(size, in, &pos, &delta) || delta >= length - prev
+        || (k > 0 && prev + delta <= prev)) {
+      SL_ERROR(ctx, "invalid position of nonzero %zu in record block", k);
+      return false;
+    }
+    prev += delta;
+    block->positions[k] = (uint32_t)prev;
+  }
+
+  switch (block->encoding) {
+    case sl_record_block_shuffled: {
+      if (size - pos < nnz * item_size) {
+        SL_ERROR(ctx, "truncated shuffled values in record block");
+        return false;
+      }
+      for (size_t b = 0; b < item_size; ++b) {
+        for (size_t k = 0; k < nnz; ++k) {
+          block->values[(k * item_size) + b] = in[pos++];
+        }
+      }
+    } break;
+    case sl_record_block_varint:
+    case sl_record_block_zigzag: {
+      for (size_t k = 0; k < nnz; ++k) {
+        uint64_t value = 0;
+        if (!sl_record_varint_decode(size, in, &pos, &value)) {
+          SL_ERROR(ctx, "truncated varint value %zu in record block", k);
+          return false;
+        }
+        if (block->encoding == sl_record_block_zigzag) {
+          value = (uint64_t)sl_record_zigzag_decode(value);
+        }
+        sl_record_store_unsigned(item_size, block->values + (k * item_size), value);
+      }
+    } break;
+    case sl_record_block_raw: {
+      if (size - pos < nnz * item_size) {
+        SL_ERROR(ctx, "truncated raw values in record block");
+        return false;
+      }
+      memcpy(block->values, in + pos, nnz * item_size);
+      pos += nnz * item_size;
+    } break;
+  }
+
+  if (pos != size) {
+    SL_ERROR(ctx, "record block has %zu trailing bytes", size - pos);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,62 @@
+#ifndef SL_RECORD_BLOCK_H_INCLUDED
+#define SL_RECORD_BLOCK_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/record/record.h>
+#include <stufflib/span/span.h>
+
+// number of dense items encoded in each block of a "blocked" record
+// every block except the last covers exactly this many items
+#define SL_RECORD_BLOCK_LEN 65'536
+
+// on-disk block payload:
+// varint length, varint nnz, u8 encoding,
+// nnz varint position deltas, then nnz values encoded as given by the encoding
+enum sl_record_block_encoding : unsigned char {
+  sl_record_block_raw      = 0,
+  sl_record_block_shuffled = 1,
+  sl_record_block_varint   = 2,
+  sl_record_block_zigzag   = 3,
+};
+
+struct sl_record_block {
+  size_t item_size;
+  size_t length;
+  size_t nnz;
+  enum sl_record_block_encoding encoding;
+  uint32_t* positions;
+  unsigned char* values;
+  struct sl_span encoded;
+};
+
+enum sl_record_block_encoding sl_record_block_encoding_of(const struct sl_record r[const static 1]);
+bool sl_record_block_create(
+    struct sl_context ctx[static 1],
+    struct sl_record_block block[const static 1],
+    size_t item_size
+);
+void sl_record_block_destroy(struct sl_record_block block[const static 1]);
+size_t sl_record_block_append(
+    struct sl_record_block block[const static 1],
+    size_t count,
+    const unsigned char dense[const static 1]
+);
+void sl_record_block_clear(struct sl_record_block block[const static 1]);
+size_t sl_record_block_scatter(
+    const struct sl_record_block block[const static 1],
+    size_t nz_begin,
+    size_t begin,
+    size_t end,
+    unsigned char dense[const static 1]
+);
+size_t sl_record_block_encode(struct sl_record_block block[const static 1]);
+bool sl_record_block_decode(
+    struct sl_context ctx[static 1],
+    struct sl_record_block block[const static 1],
+    size_t size
+);
+
+#endif  // SL_RECORD_BLOCK_H_INCLUDED
@@ -0,0 +1,165 @@
+#include <stddef.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/matrix/sl_csr_f32.h>
+#include <stufflib/record/prefetch.h>
+#include <stufflib/record/reader.h>
+#include <stufflib/span/span.h>
+
+static void* sl_record_prefetcher_run(void* arg) {
+  struct sl_record_prefetcher* p = arg;
+  struct sl_context* ctx         = &(p->worker_ctx);
+
+  pthread_mutex_lock(&(p->mutex));
+  while (!p->stop) {
+    if (p->is_full[p->fill_idx]) {
+      // backpressure: both buffers hold batches the caller has not released yet
+      pthread_cond_wait(&(p->cond), &(p->mutex));
+      continue;
+    }
+    const size_t fill_idx = p->fill_idx;
+    pthread_mutex_unlock(&(p->mutex));
+
+    bool ok            = true;
+    const bool is_done = sl_record_reader_is_done(ctx, p->reader);
+    if (!is_done) {
+      ok = p->read(ctx, p->reader, p->batches[fill_idx]);
+    }
+
+    pthread_mutex_lock(&(p->mutex));
+    if (!ok || sl_context_error_occurred(ctx)) {
+      p->has_failed = true;
+    } else if (is_done) {
+      p->is_done = true;
+    } else {
+      p->is_full[fill_idx] = true;
+      p->fill_idx          = 1 - fill_idx;
+    }
+    pthread_cond_broadcast(&(p->cond));
+    if (p->has_failed || p->is_done) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&(p->mutex));
+  return nullptr;
+}
+
+bool sl_record_prefetcher_open(
+    struct sl_context ctx[static 1],
+    struct sl_record_prefetcher prefetcher[const static 1]
+) {
+  if (!prefetcher->reader || !prefetcher->read || !prefetcher->batches[0]
+      || !prefetcher->batches[1]) {
+    SL_ERROR(ctx, "record prefetcher needs a reader, a read function and two batches");
+    return false;
+  }
+  prefetcher->worker_ctx = (struct sl_context){0};
+  prefetcher->is_full[0] = false;
+  prefetcher->is_full[1] = false;
+  prefetcher->fill_idx   = 0;
+  prefetcher->take_idx   = 0;
+  prefetcher->is_taken   = false;
+  prefetcher->is_done    = false;
+  prefetcher->has_failed = false;
+  prefetcher->stop       = false;
+
+  if (pthread_mutex_init(&(prefetcher->mutex), nullptr) != 0) {
+    SL_ERROR(ctx, "failed initializing record prefetcher mutex");
+    return false;
+  }
+  if (pthread_cond_init(&(prefetcher->cond), nullptr) != 0) {
+    SL_ERROR(ctx, "failed initializing record prefetcher condition variable");
+    pthread_mutex_destroy(&(prefetcher->mutex));
+    return false;
+  }
+  const int err = pthread_create(
+      &(prefetcher->thread),
+      nullptr,
+      sl_record_prefetcher_run,
+      prefetcher
+  );
+  if (err != 0) {
+    SL_ERROR(ctx, "failed starting record prefetcher thread (%s)", strerror(err));
+    pthread_cond_destroy(&(prefetcher->cond));
+    pthread_mutex_destroy(&(prefetcher->mutex));
+    return false;
+  }
+  prefetcher->is_running = true;
+  return true;
+}
+
+void sl_record_prefetcher_close(struct sl_record_prefetcher prefetcher[const static 1]) {
+  if (!prefetcher->is_running) {
+    return;
+  }
+  pthread_mutex_lock(&(prefetcher->mutex));
+  prefetcher->stop = true;
+  pthread_cond_broadcast(&(prefetcher->cond));
+  pthread_mutex_unlock(&(prefetcher->mutex));
+
+  pthread_join(prefetcher->thread, nullptr);
+  pthread_cond_destroy(&(prefetcher->cond));
+  pthread_mutex_destroy(&(prefetcher->mutex));
+  prefetcher->is_running = false;
+}
+
+bool sl_record_prefetcher_next(
+    struct sl_context ctx[static 1],
+    struct sl_record_prefetcher prefetcher[const static 1],
+    void* batch[const static 1]
+) {
+  *batch = nullptr;
+  if (!prefetcher->is_running) {
+    SL_ERROR(ctx, "record prefetcher is not running");
+    return false;
+  }
+
+  pthread_mutex_lock(&(prefetcher->mutex));
+
+  if (prefetcher->is_taken) {
+    // release the batch returned by the previous call so the worker can refill it
+    prefetcher->is_full[prefetcher->take_idx] = false;
+    prefetcher->take_idx                      = 1 - prefetcher->take_idx;
+    prefetcher->is_taken                      = false;
+    pthread_cond_broadcast(&(prefetcher->cond));
+  }
+
+  while (!prefetcher->is_full[prefetcher->take_idx] && !prefetcher->is_done
+         && !prefetcher->has_failed) {
+    pthread_cond_wait(&(prefetcher->cond), &(prefetcher->mutex));
+  }
+
+  bool ok = true;
+  if (prefetcher->is_full[prefetcher->take_idx]) {
+    *batch               = prefetcher->batches[prefetcher->take_idx];
+    prefetcher->is_taken = true;
+  } else if (prefetcher->has_failed) {
+    sl_context_move_errors(ctx, &(prefetcher->worker_ctx));
+    SL_ERROR(ctx, "record prefetcher failed reading batch");
+    ok = false;
+  }
+
+  pthread_mutex_unlock(&(prefetcher->mutex));
+  return ok;
+}
+
+bool sl_record_prefetch_read_span(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    void* batch
+) {
+  struct sl_span* buffer = batch;
+  sl_span_clear(buffer);
+  return sl_record_reader_read(ctx, reader, buffer);
+}
+
+bool sl_record_prefetch_read_csr(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    void* batch
+) {
+  return sl_record_reader_read_csr(ctx, reader, (struct sl_csr_f32*)batch);
+}
@@ -0,0 +1,62 @@
+#ifndef STUFFLIB_RECORD_PREFETCH_H_INCLUDED
+#define STUFFLIB_RECORD_PREFETCH_H_INCLUDED
+
+#include <stddef.h>
+
+#include <pthread.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/record/reader.h>
+#include <stufflib/span/span.h>
+
+// decodes one batch from reader into batch, e.g. a span or a CSR matrix
+typedef bool sl_record_prefetch_read(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    void* batch
+);
+
+// double-buffered record reader
+// a worker thread reads the next batch into one buffer while the caller works on the other
+// the worker owns the reader from open until close
+struct sl_record_prefetcher {
+  struct sl_record_reader* reader;
+  sl_record_prefetch_read* read;
+  void* batches[2];
+  // worker state, guarded by mutex
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  struct sl_context worker_ctx;
+  bool is_full[2];
+  size_t fill_idx;
+  size_t take_idx;
+  bool is_taken;
+  bool is_done;
+  bool has_failed;
+  bool stop;
+  bool is_running;
+};
+
+bool sl_record_prefetcher_open(
+    struct sl_context ctx[static 1],
+    struct sl_record_prefetcher prefetcher[const static 1]
+);
+void sl_record_prefetcher_close(struct sl_record_prefetcher prefetcher[const static 1]);
+bool sl_record_prefetcher_next(
+    struct sl_context ctx[static 1],
+    struct sl_record_prefetcher prefetcher[const static 1],
+    void* batch[const static 1]
+);
+bool sl_record_prefetch_read_span(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    void* batch
+);
+bool sl_record_prefetch_read_csr(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    void* batch
+);
+
+#endif  // STUFFLIB_RECORD_PREFETCH_H_INCLUDED
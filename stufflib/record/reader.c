@@ -4,19 +4,130 @@
 
 #include <stufflib/context/context.h>
 #include <stufflib/io/io.h>
+#include <stufflib/linalg/linalg.h>
 #include <stufflib/macros/macros.h>
+#include <stufflib/matrix/sl_csr_f32.h>
+#include <stufflib/memory/memory.h>
+#include <stufflib/record/block.h>
 #include <stufflib/record/reader.h>
 #include <stufflib/record/record.h>
 #include <stufflib/span/span.h>
 
-bool sl_record_reader_open(
+static bool sl_record_reader_open_block_index(
     struct sl_context ctx[static 1],
     struct sl_record_reader reader[const static 1]
 ) {
-  if (!reader->file || !reader->record) {
-    SL_ERROR(ctx, "incorrectly initialized record reader");
+  bool ok                   = false;
+  struct sl_file index_file = {0};
+
+  char full_path[1'024] = {0};
+  if (!sl_file_format_path(
+          SL_ARRAY_LEN(full_path),
+          full_path,
+          reader->record->path,
+          reader->record->name,
+          ".sl_record_index"
+      )) {
+    SL_ERROR(ctx, "failed formatting record block index file path");
+    goto done;
+  }
+  if (!sl_file_open(ctx, &index_file, full_path, "rb")) {
+    SL_ERROR(ctx, "cannot open record block index file '%s'", full_path);
+    goto done;
+  }
+
+  if (fseek(index_file.file, 0, SEEK_END) != 0) {
+    SL_ERROR(ctx, "failed seeking to end of %s", full_path);
+    goto done;
+  }
+  const long index_size = ftell(index_file.file);
+  if (index_size < 0 || (size_t)index_size % sizeof(uint64_t) != 0) {
+    SL_ERROR(ctx, "invalid record block index %s", full_path);
+    goto done;
+  }
+  rewind(index_file.file);
+
+  reader->n_blocks = (size_t)index_size / sizeof(uint64_t);
+  if (reader->n_blocks > 0) {
+    reader->block_offsets = sl_alloc(ctx, reader->n_blocks, sizeof(uint64_t));
+    if (!reader->block_offsets
+        || reader->n_blocks
+               != fread(
+                   reader->block_offsets,
+                   sizeof(uint64_t),
+                   reader->n_blocks,
+                   index_file.file
+               )) {
+      SL_ERROR(ctx, "failed reading %zu block offsets from %s", reader->n_blocks, full_path);
+      goto done;
+    }
+  }
+
+  if (!sl_record_block_create(ctx, &(reader->block), reader->item_size)) {
+    SL_ERROR(ctx, "failed creating record reader block");
+    goto done;
+  }
+  reader->block_idx = 0;
+  reader->block_pos = 0;
+  reader->block_nz  = 0;
+
+  ok = true;
+done:
+  sl_file_close(&index_file);
+  return ok;
+}
+
+static bool sl_record_reader_next_block(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1]
+) {
+  uint32_t block_size = 0;
+  if (1 != fread(&block_size, sizeof(block_size), 1, reader->file->file)
+      || block_size > reader->block.encoded.size
+      || block_size != fread(reader->block.encoded.data, 1, block_size, reader->file->file)) {
+    SL_ERROR(ctx, "failed reading block %zu from %s", reader->block_idx, reader->file->path);
+    return false;
+  }
+  if (!sl_record_block_decode(ctx, &(reader->block), block_size)) {
+    SL_ERROR(ctx, "failed decoding block %zu from %s", reader->block_idx, reader->file->path);
+    return false;
+  }
+  if (reader->block_idx + 1 < reader->n_blocks && reader->block.length != SL_RECORD_BLOCK_LEN) {
+    SL_ERROR(
+        ctx,
+        "block %zu from %s has length %zu but only the last block can be shorter than %d",
+        reader->block_idx,
+        reader->file->path,
+        reader->block.length,
+        SL_RECORD_BLOCK_LEN
+    );
     return false;
   }
+  reader->block_idx += 1;
+  reader->block_pos = 0;
+  reader->block_nz  = 0;
+  return true;
+}
+
+static bool sl_record_reader_open_data(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1]
+) {
+  reader->layout    = sl_record_layout_of(reader->record);
+  reader->type      = sl_record_type_of(reader->record);
+  reader->item_size = sl_record_type_size(reader->type);
+  reader->disk_size = sl_record_disk_size(reader->record, reader->layout, reader->item_size);
+  if (reader->layout == sl_record_layout_unknown || reader->item_size == 0) {
+    SL_ERROR(
+        ctx,
+        "unknown data layout '%s' or type '%s' in record %s",
+        reader->record->layout,
+        reader->record->type,
+        reader->record->name
+    );
+    return false;
+  }
+
   char full_path[1'024] = {0};
   if (!sl_file_format_path(
           SL_ARRAY_LEN(full_path),
@@ -32,21 +143,80 @@ bool sl_record_reader_open(
     SL_ERROR(ctx, "cannot open record data file '%s'", full_path);
     return false;
   }
+  if (reader->layout == sl_record_layout_blocked
+      && !sl_record_reader_open_block_index(ctx, reader)) {
+    SL_ERROR(ctx, "cannot open block index of record %s", reader->record->name);
+    return false;
+  }
   return true;
 }
 
+static void sl_record_reader_close_data(struct sl_record_reader reader[const static 1]) {
+  sl_record_block_destroy(&(reader->block));
+  sl_free(reader->block_offsets);
+  reader->block_offsets = nullptr;
+  reader->n_blocks      = 0;
+  if (reader->file) {
+    sl_file_close(reader->file);
+  }
+}
+
+static bool sl_record_reader_open_shard(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    const size_t shard_idx
+) {
+  sl_record_reader_close_data(reader);
+  if (!sl_record_shard(ctx, reader->sharded, shard_idx, &(reader->shard))) {
+    return false;
+  }
+  reader->shard_idx         = shard_idx;
+  reader->shard_pos         = 0;
+  reader->index             = 0;
+  reader->sparse_offset     = 0;
+  reader->has_sparse_offset = false;
+  return sl_record_reader_open_data(ctx, reader);
+}
+
+static size_t sl_record_reader_shard_length(const struct sl_record_reader reader[const static 1]) {
+  return reader->record->dim_size[0] * sl_record_row_length(reader->record);
+}
+
+bool sl_record_reader_open(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1]
+) {
+  if (!reader->file || !reader->record) {
+    SL_ERROR(ctx, "incorrectly initialized record reader");
+    return false;
+  }
+  if (reader->record->n_shards > 0) {
+    reader->sharded = reader->record;
+    reader->record  = &(reader->shard);
+    return sl_record_reader_open_shard(ctx, reader, 0);
+  }
+  return sl_record_reader_open_data(ctx, reader);
+}
+
 void sl_record_reader_close(struct sl_record_reader reader[const static 1]) {
-  sl_file_close(reader->file);
+  sl_record_reader_close_data(reader);
+  if (reader->sharded) {
+    reader->record  = reader->sharded;
+    reader->sharded = nullptr;
+  }
 }
 
 long long sl_record_reader_ftell(struct sl_record_reader reader[const static 1]) {
   return reader->file && reader->file->file ? ftell(reader->file->file) : -1;
 }
 
-bool sl_record_reader_is_done(
+static bool sl_record_reader_is_data_done(
     struct sl_context ctx[static 1],
     struct sl_record_reader reader[const static 1]
 ) {
+  if (reader->file && reader->layout == sl_record_layout_blocked) {
+    return reader->block_idx >= reader->n_blocks && reader->block_pos >= reader->block.length;
+  }
   if (!reader->file || feof(reader->file->file)) {
     return true;
   }
@@ -55,11 +225,24 @@ bool sl_record_reader_is_done(
     SL_ERROR(ctx, "failed retrieving file pos for sl_record reader");
     return true;
   }
-  const size_t sl_record_disk_size
-      = ((SL_STR_EQ(reader->record->layout, "sparse") ? sizeof(int64_t) : 0)
-         + sl_record_item_size(reader->record))
-        * reader->record->size;
-  return (size_t)fpos >= sl_record_disk_size;
+  return (size_t)fpos >= reader->disk_size;
+}
+
+bool sl_record_reader_is_done(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1]
+) {
+  if (!sl_record_reader_is_data_done(ctx, reader)) {
+    return false;
+  }
+  if (reader->sharded) {
+    for (size_t k = reader->shard_idx + 1; k < reader->sharded->n_shards; ++k) {
+      if (reader->sharded->shard_size[k] > 0) {
+        return false;
+      }
+    }
+  }
+  return true;
 }
 
 bool sl_record_reader_read_sparse_data(
@@ -69,17 +252,13 @@ bool sl_record_reader_read_sparse_data(
 ) {
   sl_span_clear(buffer);
 
-  // TODO cache in reader on open?
-  const size_t item_size     = sl_record_item_size(reader->record);
+  const size_t item_size     = reader->item_size;
   const size_t buffer_length = buffer->size / item_size;
 
-  if (reader->sparse_offset > buffer_length) {
-    reader->index += buffer_length;
-    reader->sparse_offset -= buffer_length;
-    return true;
-  }
+  const size_t batch_begin = reader->index;
+  const size_t batch_end   = batch_begin + buffer_length;
 
-  while (sl_file_can_read(reader->file) && !sl_record_reader_is_done(ctx, reader)) {
+  while (sl_file_can_read(reader->file) && !sl_record_reader_is_data_done(ctx, reader)) {
     if (!reader->has_sparse_offset) {
       int64_t offset = -1;
       if (1 != fread(&offset, sizeof(offset), 1, reader->file->file) || offset < 0) {
@@ -97,22 +276,14 @@ bool sl_record_reader_read_sparse_data(
       reader->has_sparse_offset = true;
     }
 
-    const size_t idx    = reader->index;
-    const size_t offset = reader->sparse_offset;
-
-    const size_t curr_batch   = idx / buffer_length;
-    const size_t batch_offset = idx % buffer_length;
-
-    const size_t next_batch = (idx + offset) / buffer_length;
-    const size_t buf_idx    = (idx + offset) % buffer_length;
-
-    if (next_batch > curr_batch) {
-      const size_t n_skip = buffer_length - batch_offset;
-      reader->sparse_offset -= n_skip;
-      reader->index += n_skip;
+    const size_t idx = reader->index + reader->sparse_offset;
+    if (idx >= batch_end) {
+      reader->sparse_offset = idx - batch_end;
+      reader->index         = batch_end;
       return true;
     }
 
+    const size_t buf_idx = idx - batch_begin;
     if (1 != fread(buffer->data + (buf_idx * item_size), item_size, 1, reader->file->file)) {
       SL_ERROR(
           ctx,
@@ -125,7 +296,7 @@ bool sl_record_reader_read_sparse_data(
     }
 
     reader->n_read += 1;
-    reader->index += reader->sparse_offset;
+    reader->index             = idx;
     reader->sparse_offset     = 0;
     reader->has_sparse_offset = false;
   }
@@ -133,12 +304,49 @@ bool sl_record_reader_read_sparse_data(
   return true;
 }
 
+bool sl_record_reader_read_blocked_data(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    struct sl_span buffer[const static 1]
+) {
+  sl_span_clear(buffer);
+
+  const size_t item_size     = reader->item_size;
+  const size_t buffer_length = buffer->size / item_size;
+
+  for (size_t buf_idx = 0; buf_idx < buffer_length;) {
+    if (reader->block_pos == reader->block.length) {
+      if (reader->block_idx == reader->n_blocks) {
+        break;
+      }
+      if (!sl_record_reader_next_block(ctx, reader)) {
+        return false;
+      }
+    }
+    const size_t count  = SL_MIN(reader->block.length - reader->block_pos, buffer_length - buf_idx);
+    const size_t nz_end = sl_record_block_scatter(
+        &(reader->block),
+        reader->block_nz,
+        reader->block_pos,
+        reader->block_pos + count,
+        buffer->data + (buf_idx * item_size)
+    );
+    reader->n_read += nz_end - reader->block_nz;
+    reader->block_nz = nz_end;
+    reader->block_pos += count;
+    reader->index += count;
+    buf_idx += count;
+  }
+
+  return true;
+}
+
 bool sl_record_reader_read_dense_data(
     struct sl_context ctx[static 1],
     struct sl_record_reader reader[const static 1],
     struct sl_span buffer[const static 1]
 ) {
-  const size_t item_size     = sl_record_item_size(reader->record);
+  const size_t item_size     = reader->item_size;
   const size_t buffer_length = buffer->size / item_size;
 
   const size_t n_read = fread(buffer->data, item_size, buffer_length, reader->file->file);
@@ -152,44 +360,361 @@ bool sl_record_reader_read_dense_data(
   return true;
 }
 
-bool sl_record_reader_read(
+// finalizes all rows before row and makes room for one more nonzero
+static bool sl_record_csr_prepare_append(
+    struct sl_context ctx[static 1],
+    struct sl_csr_f32 out[const static 1],
+    const size_t row,
+    size_t n_done_rows[const static 1],
+    const size_t nnz
+) {
+  for (; *n_done_rows < row; ++(*n_done_rows)) {
+    out->row_ptr[*n_done_rows + 1] = nnz;
+  }
+  if (nnz == out->nnz_capacity && !sl_la_csr_reserve(ctx, out, 2 * out->nnz_capacity)) {
+    SL_ERROR(ctx, "failed growing CSR matrix to fit more than %zu nonzeros", nnz);
+    return false;
+  }
+  return true;
+}
+
+static bool sl_record_reader_read_csr_data(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    struct sl_csr_f32 out[const static 1]
+) {
+  const struct sl_record* const record = reader->record;
+  const bool is_blocked                = reader->layout == sl_record_layout_blocked;
+  if ((!is_blocked && reader->layout != sl_record_layout_sparse)
+      || reader->type != sl_record_type_float32) {
+    SL_ERROR(
+        ctx,
+        "cannot read %s %s record %s into a float32 CSR matrix",
+        record->layout,
+        record->type,
+        record->name
+    );
+    return false;
+  }
+
+  // last dimension is the row length, all other dimensions are flattened into rows
+  const size_t n_cols = record->dim_size[record->n_dims - 1];
+  size_t n_rows_total = 1;
+  for (int dim = 0; dim < record->n_dims - 1; ++dim) {
+    n_rows_total *= record->dim_size[dim];
+  }
+  if (n_cols != sl_csr_f32_num_cols(out)) {
+    SL_ERROR(
+        ctx,
+        "record %s has rows of length %zu but CSR matrix has %zu columns",
+        record->name,
+        n_cols,
+        sl_csr_f32_num_cols(out)
+    );
+    return false;
+  }
+
+  const size_t first_row   = reader->index / n_cols;
+  const size_t n_rows      = first_row < n_rows_total
+                                 ? SL_MIN(out->row_capacity, n_rows_total - first_row)
+                                 : 0;
+  const size_t batch_begin = first_row * n_cols;
+  const size_t batch_end   = batch_begin + (n_rows * n_cols);
+
+  sl_la_csr_clear(out);
+  out->num_rows = n_rows;
+
+  size_t nnz = 0;
+  size_t row = 0;
+
+  while (is_blocked && reader->index < batch_end) {
+    if (reader->block_pos == reader->block.length) {
+      if (reader->block_idx == reader->n_blocks) {
+        break;
+      }
+      if (!sl_record_reader_next_block(ctx, reader)) {
+        return false;
+      }
+    }
+    const size_t block_begin = reader->index - reader->block_pos;
+    const size_t block_end
+        = SL_MIN(reader->block.length, reader->block_pos + (batch_end - reader->index));
+    for (; reader->block_nz < reader->block.nnz
+           && reader->block.positions[reader->block_nz] < block_end;
+         ++(reader->block_nz)) {
+      const size_t idx = block_begin + reader->block.positions[reader->block_nz];
+      if (!sl_record_csr_prepare_append(ctx, out, (idx - batch_begin) / n_cols, &row, nnz)) {
+        return false;
+      }
+      memcpy(
+          out->values + nnz,
+          reader->block.values + (reader->block_nz * sizeof(float)),
+          sizeof(float)
+      );
+      out->col_idx[nnz] = (uint32_t)(idx % n_cols);
+      ++nnz;
+      reader->n_read += 1;
+    }
+    reader->index += block_end - reader->block_pos;
+    reader->block_pos = block_end;
+  }
+
+  while (!is_blocked && sl_file_can_read(reader->file)
+         && !sl_record_reader_is_data_done(ctx, reader)) {
+    if (!reader->has_sparse_offset) {
+      int64_t offset = -1;
+      if (1 != fread(&offset, sizeof(offset), 1, reader->file->file) || offset < 0) {
+        SL_ERROR(
+            ctx,
+            "failed reading sparse index offset from %s at index %zu with "
+            "n_read %zu",
+            reader->file->path,
+            reader->index,
+            reader->n_read
+        );
+        return false;
+      }
+      reader->sparse_offset     = (size_t)(offset);
+      reader->has_sparse_offset = true;
+    }
+
+    const size_t idx = reader->index + reader->sparse_offset;
+    if (idx >= batch_end) {
+      reader->sparse_offset = idx - batch_end;
+      reader->index         = batch_end;
+      break;
+    }
+
+    if (!sl_record_csr_prepare_append(ctx, out, (idx - batch_begin) / n_cols, &row, nnz)) {
+      return false;
+    }
+    if (1 != fread(out->values + nnz, sizeof(float), 1, reader->file->file)) {
+      SL_ERROR(
+          ctx,
+          "failed reading sparse data from %s at index %zu with n_read %zu",
+          reader->file->path,
+          reader->index,
+          reader->n_read
+      );
+      return false;
+    }
+    out->col_idx[nnz] = (uint32_t)(idx % n_cols);
+    ++nnz;
+
+    reader->n_read += 1;
+    reader->index             = idx;
+    reader->sparse_offset     = 0;
+    reader->has_sparse_offset = false;
+  }
+
+  for (; row < n_rows; ++row) {
+    out->row_ptr[row + 1] = nnz;
+  }
+  if (reader->index < batch_end) {
+    reader->index = batch_end;
+  }
+
+  return true;
+}
+
+// CSR batches of sharded records end at shard boundaries
+bool sl_record_reader_read_csr(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    struct sl_csr_f32 out[const static 1]
+) {
+  if (!reader->sharded) {
+    return sl_record_reader_read_csr_data(ctx, reader, out);
+  }
+  const size_t shard_length = sl_record_reader_shard_length(reader);
+  if (reader->shard_pos >= shard_length && reader->shard_idx + 1 < reader->sharded->n_shards
+      && !sl_record_reader_open_shard(ctx, reader, reader->shard_idx + 1)) {
+    return false;
+  }
+  if (!sl_record_reader_read_csr_data(ctx, reader, out)) {
+    return false;
+  }
+  reader->shard_pos = SL_MIN(reader->index, sl_record_reader_shard_length(reader));
+  return true;
+}
+
+static bool sl_record_reader_seek_data(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    const size_t index
+) {
+  const enum sl_record_layout layout = reader->layout;
+
+  if (layout == sl_record_layout_dense) {
+    if (index > reader->record->size
+        || fseek(reader->file->file, (long)(index * reader->item_size), SEEK_SET) != 0) {
+      SL_ERROR(ctx, "failed seeking to index %zu in %s", index, reader->file->path);
+      return false;
+    }
+    reader->index = index;
+    return true;
+  }
+
+  if (layout == sl_record_layout_blocked) {
+    const size_t block_idx = index / SL_RECORD_BLOCK_LEN;
+    if (block_idx >= reader->n_blocks
+        || fseek(reader->file->file, (long)reader->block_offsets[block_idx], SEEK_SET) != 0) {
+      SL_ERROR(ctx, "failed seeking to block %zu in %s", block_idx, reader->file->path);
+      return false;
+    }
+    reader->block_idx = block_idx;
+    if (!sl_record_reader_next_block(ctx, reader)) {
+      return false;
+    }
+    reader->block_pos = SL_MIN(index % SL_RECORD_BLOCK_LEN, reader->block.length);
+    while (reader->block_nz < reader->block.nnz
+           && reader->block.positions[reader->block_nz] < reader->block_pos) {
+      ++(reader->block_nz);
+    }
+    reader->index = (block_idx * SL_RECORD_BLOCK_LEN) + reader->block_pos;
+    return true;
+  }
+
+  SL_ERROR(
+      ctx,
+      "cannot seek in record %s with %s data layout",
+      reader->record->name,
+      reader->record->layout
+  );
+  return false;
+}
+
+bool sl_record_reader_seek(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    const size_t index
+) {
+  if (!reader->sharded) {
+    return sl_record_reader_seek_data(ctx, reader, index);
+  }
+  const struct sl_record* const sharded = reader->sharded;
+  const size_t row_length               = sl_record_row_length(sharded);
+  size_t shard_begin                    = 0;
+  size_t shard_idx                      = 0;
+  for (; shard_idx + 1 < sharded->n_shards; ++shard_idx) {
+    const size_t shard_length = sharded->shard_rows[shard_idx] * row_length;
+    if (index < shard_begin + shard_length) {
+      break;
+    }
+    shard_begin += shard_length;
+  }
+  if (shard_idx != reader->shard_idx && !sl_record_reader_open_shard(ctx, reader, shard_idx)) {
+    return false;
+  }
+  if (!sl_record_reader_seek_data(ctx, reader, index - shard_begin)) {
+    return false;
+  }
+  reader->shard_pos = reader->index;
+  return true;
+}
+
+static bool sl_record_reader_read_data(
     struct sl_context ctx[static 1],
     struct sl_record_reader reader[const static 1],
     struct sl_span buffer[const static 1]
 ) {
-  const char* const layout = reader->record->layout;
-  if (SL_STR_EQ(layout, "sparse")) {
-    return sl_record_reader_read_sparse_data(ctx, reader, buffer);
-  } else if (SL_STR_EQ(layout, "dense")) {
-    return sl_record_reader_read_dense_data(ctx, reader, buffer);
+  switch (reader->layout) {
+    case sl_record_layout_sparse:
+      return sl_record_reader_read_sparse_data(ctx, reader, buffer);
+    case sl_record_layout_dense:
+      return sl_record_reader_read_dense_data(ctx, reader, buffer);
+    case sl_record_layout_blocked:
+      return sl_record_reader_read_blocked_data(ctx, reader, buffer);
+    case sl_record_layout_unknown:
+      break;
   }
-  SL_ERROR(ctx, "unknown data layout %s", layout);
+  SL_ERROR(ctx, "unknown data layout %s", reader->record->layout);
   return false;
 }
 
+// fills buffer from consecutive shards, zeros past the end of the record
+static bool sl_record_reader_read_shards(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    struct sl_span buffer[const static 1]
+) {
+  sl_span_clear(buffer);
+
+  const size_t item_size     = reader->item_size;
+  const size_t buffer_length = buffer->size / item_size;
+
+  for (size_t buf_idx = 0; buf_idx < buffer_length;) {
+    const size_t shard_length = sl_record_reader_shard_length(reader);
+    if (reader->shard_pos == shard_length) {
+      if (reader->shard_idx + 1 == reader->sharded->n_shards) {
+        break;
+      }
+      if (!sl_record_reader_open_shard(ctx, reader, reader->shard_idx + 1)) {
+        return false;
+      }
+      continue;
+    }
+    const size_t count = SL_MIN(shard_length - reader->shard_pos, buffer_length - buf_idx);
+    struct sl_span part
+        = sl_span_view(count * item_size, buffer->data + (buf_idx * item_size));
+    if (!sl_record_reader_read_data(ctx, reader, &part)) {
+      return false;
+    }
+    reader->shard_pos += count;
+    buf_idx += count;
+  }
+
+  return true;
+}
+
+bool sl_record_reader_read(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    struct sl_span buffer[const static 1]
+) {
+  if (reader->sharded) {
+    return sl_record_reader_read_shards(ctx, reader, buffer);
+  }
+  return sl_record_reader_read_data(ctx, reader, buffer);
+}
+
+// reads many whole records, e.g. per-image features, one after the other
+// each record is opened, read to the end and closed before the next, nothing is kept in between
+// buffers[i] must have room for all items of records[i]
+bool sl_record_read_batch(
+    struct sl_context ctx[static 1],
+    const size_t n_records,
+    struct sl_record records[const static n_records],
+    struct sl_span buffers[const static n_records]
+) {
+  struct sl_file file = {0};
+  for (size_t i = 0; i < n_records; ++i) {
+    struct sl_record_reader reader = {
+        .file   = &file,
+        .record = records + i,
+    };
+    const bool ok = sl_record_reader_open(ctx, &reader)
+                    && sl_record_reader_read(ctx, &reader, buffers + i)
+                    && sl_record_reader_is_done(ctx, &reader);
+    sl_record_reader_close(&reader);
+    if (!ok) {
+      SL_ERROR(ctx, "failed reading record %zu of %zu", i, n_records);
+      return false;
+    }
+  }
+  return true;
+}
+
 bool sl_record_read_all(
     struct sl_context ctx[static 1],
     struct sl_record record[const static 1],
     const size_t bufsize,
     void* buffer
 ) {
-  bool ok                        = false;
-  struct sl_file file            = {0};
-  struct sl_record_reader reader = {
-      .file   = &file,
-      .record = record,
-  };
-  if (!sl_record_reader_open(ctx, &reader)) {
-    SL_ERROR(ctx, "failed opening data file, cannot read record");
-    goto done;
-  }
   struct sl_span data = sl_span_view(bufsize, buffer);
-  if (!sl_record_reader_read(ctx, &reader, &data) || !sl_record_reader_is_done(ctx, &reader)) {
+  if (!sl_record_read_batch(ctx, 1, record, &data)) {
     SL_ERROR(ctx, "failed reading record data");
-    goto done;
+    return false;
   }
-  ok = true;
-done:
-  sl_record_reader_close(&reader);
-  return ok;
+  return true;
 }
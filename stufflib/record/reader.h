@@ -2,19 +2,39 @@
 #define STUFFLIB_RECORD_READER_H_INCLUDED
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <stufflib/context/context.h>
 #include <stufflib/io/io.h>
+#include <stufflib/matrix/sl_csr_f32.h>
+#include <stufflib/record/block.h>
 #include <stufflib/record/record.h>
 #include <stufflib/span/span.h>
 
+// sharded records are read as if their shards were concatenated
+// record then points to the current shard and sharded to the full record
+// layout, type and sizes are resolved from record when opened
 struct sl_record_reader {
   struct sl_file* file;
   struct sl_record* record;
+  enum sl_record_layout layout;
+  enum sl_record_type type;
+  size_t item_size;
+  size_t disk_size;
+  struct sl_record* sharded;
+  struct sl_record shard;
+  size_t shard_idx;
+  size_t shard_pos;
   size_t n_read;
   size_t index;
   size_t sparse_offset;
   bool has_sparse_offset;
+  struct sl_record_block block;
+  uint64_t* block_offsets;
+  size_t n_blocks;
+  size_t block_idx;
+  size_t block_pos;
+  size_t block_nz;
 };
 
 bool sl_record_reader_open(
@@ -32,16 +52,37 @@ bool sl_record_reader_read_sparse_data(
     struct sl_record_reader reader[const static 1],
     struct sl_span buffer[const static 1]
 );
+bool sl_record_reader_read_blocked_data(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    struct sl_span buffer[const static 1]
+);
 bool sl_record_reader_read_dense_data(
     struct sl_context ctx[static 1],
     struct sl_record_reader reader[const static 1],
     struct sl_span buffer[const static 1]
 );
+bool sl_record_reader_read_csr(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    struct sl_csr_f32 out[const static 1]
+);
+bool sl_record_reader_seek(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    size_t index
+);
 bool sl_record_reader_read(
     struct sl_context ctx[static 1],
     struct sl_record_reader reader[const static 1],
     struct sl_span buffer[const static 1]
 );
+bool sl_record_read_batch(
+    struct sl_context ctx[static 1],
+    size_t n_records,
+    struct sl_record records[const static n_records],
+    struct sl_span buffers[const static n_records]
+);
 bool sl_record_read_all(
     struct sl_context ctx[static 1],
     struct sl_record record[const static 1],
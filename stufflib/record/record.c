@@ -1,5 +1,7 @@
+#include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <stufflib/context/context.h>
@@ -7,46 +9,117 @@
 #include <stufflib/macros/macros.h>
 #include <stufflib/record/record.h>
 
+struct sl_record_type_info {
+  const char* name;
+  size_t size;
+};
+
+static const struct sl_record_type_info sl_record_types[] = {
+    [sl_record_type_unknown] = {"",        0               },
+    [sl_record_type_float32] = {"float32", sizeof(float)   },
+    [sl_record_type_int8]    = {"int8",    sizeof(int8_t)  },
+    [sl_record_type_int16]   = {"int16",   sizeof(int16_t) },
+    [sl_record_type_int32]   = {"int32",   sizeof(int32_t) },
+    [sl_record_type_int64]   = {"int64",   sizeof(int64_t) },
+    [sl_record_type_uint8]   = {"uint8",   sizeof(uint8_t) },
+    [sl_record_type_uint16]  = {"uint16",  sizeof(uint16_t)},
+    [sl_record_type_uint32]  = {"uint32",  sizeof(uint32_t)},
+    [sl_record_type_uint64]  = {"uint64",  sizeof(uint64_t)},
+};
+
+enum sl_record_layout sl_record_layout_of(const struct sl_record r[const static 1]) {
+  if (SL_STR_EQ(r->layout, "dense")) {
+    return sl_record_layout_dense;
+  }
+  if (SL_STR_EQ(r->layout, "sparse")) {
+    return sl_record_layout_sparse;
+  }
+  if (SL_STR_EQ(r->layout, "blocked")) {
+    return sl_record_layout_blocked;
+  }
+  return sl_record_layout_unknown;
+}
+
+enum sl_record_type sl_record_type_of(const struct sl_record r[const static 1]) {
+  for (size_t t = 1; t < SL_ARRAY_LEN(sl_record_types); ++t) {
+    if (SL_STR_EQ(r->type, sl_record_types[t].name)) {
+      return (enum sl_record_type)t;
+    }
+  }
+  return sl_record_type_unknown;
+}
+
+size_t sl_record_type_size(const enum sl_record_type type) {
+  return type < SL_ARRAY_LEN(sl_record_types) ? sl_record_types[type].size : 0;
+}
+
 size_t sl_record_item_size(const struct sl_record r[const static 1]) {
-  if (SL_STR_EQ(r->type, "float32")) {
-    return sizeof(float);
-  } else if (SL_STR_EQ(r->type, "int8")) {
-    return sizeof(int8_t);
-  } else if (SL_STR_EQ(r->type, "int16")) {
-    return sizeof(int16_t);
-  } else if (SL_STR_EQ(r->type, "int32")) {
-    return sizeof(int32_t);
-  } else if (SL_STR_EQ(r->type, "int64")) {
-    return sizeof(int64_t);
-  } else if (SL_STR_EQ(r->type, "uint8")) {
-    return sizeof(uint8_t);
-  } else if (SL_STR_EQ(r->type, "uint16")) {
-    return sizeof(uint16_t);
-  } else if (SL_STR_EQ(r->type, "uint32")) {
-    return sizeof(uint32_t);
-  } else if (SL_STR_EQ(r->type, "uint64")) {
-    return sizeof(uint64_t);
-  } else {
-    return 0;
+  return sl_record_type_size(sl_record_type_of(r));
+}
+
+// size of the data file in bytes, blocked records are compressed and have no fixed size
+size_t sl_record_disk_size(
+    const struct sl_record r[const static 1],
+    const enum sl_record_layout layout,
+    const size_t item_size
+) {
+  switch (layout) {
+    case sl_record_layout_dense:
+      return item_size * r->size;
+    case sl_record_layout_sparse:
+      return (sizeof(int64_t) + item_size) * r->size;
+    case sl_record_layout_blocked:
+    case sl_record_layout_unknown:
+      return 0;
+  }
+  return 0;
+}
+
+size_t sl_record_row_length(const struct sl_record r[const static 1]) {
+  size_t length = 1;
+  for (int d = 1; d < r->n_dims; ++d) {
+    length *= r->dim_size[d];
   }
+  return length;
+}
+
+bool sl_record_shard(
+    struct sl_context ctx[static 1],
+    const struct sl_record r[const static 1],
+    const size_t shard_idx,
+    struct sl_record shard[const static 1]
+) {
+  if (shard_idx >= r->n_shards) {
+    SL_ERROR(ctx, "record %s has no shard %zu", r->name, shard_idx);
+    return false;
+  }
+  *shard = *r;
+  const int n = snprintf(shard->name, sizeof(shard->name), "%s.shard%zu", r->name, shard_idx);
+  if (n < 0 || (size_t)n >= sizeof(shard->name)) {
+    SL_ERROR(ctx, "too long name for shard %zu of record %s", shard_idx, r->name);
+    return false;
+  }
+  shard->size        = r->shard_size[shard_idx];
+  shard->dim_size[0] = r->shard_rows[shard_idx];
+  shard->n_shards    = 0;
+  return true;
 }
 
 bool sl_record_validate_metadata(
     struct sl_context ctx[static 1],
     const struct sl_record r[const static 1]
 ) {
-  if (r->n_dims <= 0) {
-    SL_ERROR(ctx, "n_dims must be positive");
+  if (r->n_dims <= 0 || (size_t)r->n_dims > SL_ARRAY_LEN(r->dim_size)) {
+    SL_ERROR(ctx, "n_dims must be positive and at most %zu", SL_ARRAY_LEN(r->dim_size));
     return false;
   }
 
-  bool is_sparse = SL_STR_EQ(r->layout, "sparse");
-  bool is_dense  = SL_STR_EQ(r->layout, "dense");
-  if (!is_sparse && !is_dense) {
+  const enum sl_record_layout layout = sl_record_layout_of(r);
+  if (layout == sl_record_layout_unknown) {
     SL_ERROR(ctx, "unknown data layout '%s'", r->layout);
     return false;
   }
-  if (is_dense && !r->size) {
+  if (layout == sl_record_layout_dense && !r->size) {
     SL_ERROR(ctx, "dense data layout must have a size");
     return false;
   }
@@ -56,6 +129,37 @@ bool sl_record_validate_metadata(
     return false;
   }
 
+  if (r->shuffle
+      && (sl_record_layout_of(r) != sl_record_layout_blocked
+          || sl_record_type_of(r) != sl_record_type_float32)) {
+    SL_ERROR(ctx, "only blocked float32 records can be shuffled, not %s %s", r->layout, r->type);
+    return false;
+  }
+
+  if (r->n_shards > SL_RECORD_MAX_SHARDS) {
+    SL_ERROR(ctx, "too many shards %zu, at most %d supported", r->n_shards, SL_RECORD_MAX_SHARDS);
+    return false;
+  }
+  if (r->n_shards > 0) {
+    size_t n_rows = 0;
+    size_t size   = 0;
+    for (size_t k = 0; k < r->n_shards; ++k) {
+      n_rows += r->shard_rows[k];
+      size += r->shard_size[k];
+    }
+    if (n_rows != r->dim_size[0] || size != r->size) {
+      SL_ERROR(
+          ctx,
+          "shards have %zu rows and %zu items but record has %zu rows and %zu items",
+          n_rows,
+          size,
+          r->dim_size[0],
+          r->size
+      );
+      return false;
+    }
+  }
+
   // TODO
 #if 0
   for (int d = 0; d < r->n_dims; ++d) {
@@ -69,6 +173,118 @@ bool sl_record_validate_metadata(
   return true;
 }
 
+// parses a decimal number and returns the first character after it, or nullptr on failure
+static const char* sl_record_parse_size(
+    const char str[const static 1],
+    size_t out[const static 1]
+) {
+  if (*str < '0' || *str > '9') {
+    return nullptr;
+  }
+  char* end                      = nullptr;
+  errno                          = 0;
+  const unsigned long long value = strtoull(str, &end, 10);
+  if (errno != 0) {
+    return nullptr;
+  }
+  *out = (size_t)value;
+  return end;
+}
+
+static bool sl_record_copy_field(
+    const size_t size,
+    char dst[const size],
+    const char src[const static 1]
+) {
+  const size_t length = strlen(src);
+  if (length >= size) {
+    return false;
+  }
+  memcpy(dst, src, length + 1);
+  return true;
+}
+
+// parses one "key: value" line of a metadata file, blanks around the value are ignored
+// dimK and shardK lines must appear in order after the dims and shards lines
+static bool sl_record_parse_metadata_line(
+    struct sl_record record[const static 1],
+    const size_t length,
+    char line[const length],
+    size_t n_dims_read[const static 1],
+    size_t n_shards_read[const static 1]
+) {
+  char* value = memchr(line, ':', length);
+  if (!value) {
+    return false;
+  }
+  *value = '\0';
+  value += 1;
+  while (*value == ' ' || *value == '\t') {
+    ++value;
+  }
+  for (char* end = line + length; end > value && (end[-1] == ' ' || end[-1] == '\r');) {
+    *(--end) = '\0';
+  }
+
+  const char* const key = line;
+  const char* end       = nullptr;
+  size_t num            = 0;
+
+  if (SL_STR_EQ(key, "name")) {
+    return sl_record_copy_field(sizeof(record->name), record->name, value);
+  }
+  if (SL_STR_EQ(key, "type")) {
+    return sl_record_copy_field(sizeof(record->type), record->type, value);
+  }
+  if (SL_STR_EQ(key, "layout")) {
+    return sl_record_copy_field(sizeof(record->layout), record->layout, value);
+  }
+  if (SL_STR_EQ(key, "size")) {
+    end = sl_record_parse_size(value, &(record->size));
+    return end && *end == '\0';
+  }
+  if (SL_STR_EQ(key, "dims")) {
+    end = sl_record_parse_size(value, &num);
+    if (!end || *end != '\0' || num == 0 || num > SL_ARRAY_LEN(record->dim_size)) {
+      return false;
+    }
+    record->n_dims = (int)num;
+    return true;
+  }
+  if (SL_STR_EQ(key, "shuffle")) {
+    end             = sl_record_parse_size(value, &num);
+    record->shuffle = num == 1;
+    return end && *end == '\0' && num <= 1;
+  }
+  if (SL_STR_EQ(key, "shards")) {
+    end = sl_record_parse_size(value, &(record->n_shards));
+    return end && *end == '\0' && record->n_shards <= SL_RECORD_MAX_SHARDS;
+  }
+  if (strncmp(key, "dim", 3) == 0) {
+    end = sl_record_parse_size(key + 3, &num);
+    if (!end || *end != '\0' || num != *n_dims_read || num >= (size_t)record->n_dims) {
+      return false;
+    }
+    end = sl_record_parse_size(value, record->dim_size + num);
+    *n_dims_read += 1;
+    return end && *end == '\0';
+  }
+  if (strncmp(key, "shard", 5) == 0) {
+    end = sl_record_parse_size(key + 5, &num);
+    if (!end || *end != '\0' || num != *n_shards_read || num >= record->n_shards) {
+      return false;
+    }
+    end = sl_record_parse_size(value, record->shard_rows + num);
+    if (!end || *end != ' ') {
+      return false;
+    }
+    end = sl_record_parse_size(end + 1, record->shard_size + num);
+    *n_shards_read += 1;
+    return end && *end == '\0';
+  }
+  return false;
+}
+
 bool sl_record_read_metadata(
     struct sl_context ctx[static 1],
     struct sl_record record[const static 1],
@@ -96,27 +312,48 @@ bool sl_record_read_metadata(
   strncpy(record->name, name, sizeof(record->name) - 1);
   record->name[sizeof(record->name) - 1] = '\0';
 
-  if (5
-          != fscanf(
-              file.file,
-              "name: %s\ntype: %s\nlayout: %s\nsize: %zu\ndims: %d\n",
-              record->name,
-              record->type,
-              record->layout,
-              &(record->size),
-              &(record->n_dims)
-          )
-      || record->n_dims == 0) {
-    SL_ERROR(ctx, "failed reading %s", file.path);
-    goto done;
-  }
+  record->type[0]   = '\0';
+  record->layout[0] = '\0';
+  record->size      = 0;
+  record->n_dims    = 0;
+  record->shuffle   = false;
+  record->n_shards  = 0;
 
-  for (int d = 0; d < record->n_dims; ++d) {
-    if (1 != fscanf(file.file, "dim%*d: %zu\n", record->dim_size + d)) {
-      SL_ERROR(ctx, "failed reading dimension %d from %s", d, file.path);
+  size_t n_dims_read   = 0;
+  size_t n_shards_read = 0;
+  size_t line_num      = 0;
+  char line[512]       = {0};
+  while (fgets(line, sizeof(line), file.file)) {
+    ++line_num;
+    size_t length = strlen(line);
+    if (length > 0 && line[length - 1] == '\n') {
+      line[--length] = '\0';
+    } else if (!feof(file.file)) {
+      SL_ERROR(ctx, "too long line %zu in %s", line_num, file.path);
+      goto done;
+    }
+    if (length > 0
+        && !sl_record_parse_metadata_line(record, length, line, &n_dims_read, &n_shards_read)) {
+      SL_ERROR(ctx, "invalid line %zu in %s", line_num, file.path);
       goto done;
     }
   }
+  if (ferror(file.file) != 0) {
+    SL_ERROR(ctx, "failed reading %s", file.path);
+    goto done;
+  }
+  if (n_dims_read != (size_t)record->n_dims || n_shards_read != record->n_shards) {
+    SL_ERROR(
+        ctx,
+        "%s has %zu of %d dimensions and %zu of %zu shards",
+        file.path,
+        n_dims_read,
+        record->n_dims,
+        n_shards_read,
+        record->n_shards
+    );
+    goto done;
+  }
 
   if (!sl_record_validate_metadata(ctx, record)) {
     goto done;
@@ -177,6 +414,30 @@ bool sl_record_write_metadata(
     }
   }
 
+  if (record->shuffle && 0 > fprintf(file.file, "shuffle: 1\n")) {
+    SL_ERROR(ctx, "failed writing shuffle to '%s'", file.path);
+    goto done;
+  }
+
+  if (record->n_shards > 0) {
+    if (0 > fprintf(file.file, "shards: %zu\n", record->n_shards)) {
+      SL_ERROR(ctx, "failed writing shard count to '%s'", file.path);
+      goto done;
+    }
+    for (size_t k = 0; k < record->n_shards; ++k) {
+      if (0 > fprintf(
+              file.file,
+              "shard%zu: %zu %zu\n",
+              k,
+              record->shard_rows[k],
+              record->shard_size[k]
+          )) {
+        SL_ERROR(ctx, "failed writing shard %zu to '%s'", k, file.path);
+        goto done;
+      }
+    }
+  }
+
   ok = true;
 done:
   sl_file_close(&file);
@@ -7,21 +7,66 @@
 
 #include <stufflib/context/context.h>
 
+#define SL_RECORD_MAX_SHARDS 64
+
+enum sl_record_layout : unsigned char {
+  sl_record_layout_unknown = 0,
+  sl_record_layout_dense   = 1,
+  sl_record_layout_sparse  = 2,
+  sl_record_layout_blocked = 3,
+};
+
+enum sl_record_type : unsigned char {
+  sl_record_type_unknown = 0,
+  sl_record_type_float32 = 1,
+  sl_record_type_int8    = 2,
+  sl_record_type_int16   = 3,
+  sl_record_type_int32   = 4,
+  sl_record_type_int64   = 5,
+  sl_record_type_uint8   = 6,
+  sl_record_type_uint16  = 7,
+  sl_record_type_uint32  = 8,
+  sl_record_type_uint64  = 9,
+};
+
+// layout and type are stored by name in the metadata and resolved to enums when opened
+// a sharded record is split along its first dimension into n_shards data files
+// shard k holds shard_rows[k] rows and shard_size[k] stored items
+// blocked float32 records store their values as byte planes if shuffle is set
 struct sl_record {
-  char layout[8];  // TODO enum
-  char type[64];   // TODO enum
+  char layout[8];
+  char type[64];
   char name[128];
   char path[2'048];
   size_t size;
   int n_dims;
   size_t dim_size[8];
+  bool shuffle;
+  size_t n_shards;
+  size_t shard_rows[SL_RECORD_MAX_SHARDS];
+  size_t shard_size[SL_RECORD_MAX_SHARDS];
 };
 
+enum sl_record_layout sl_record_layout_of(const struct sl_record r[const static 1]);
+enum sl_record_type sl_record_type_of(const struct sl_record r[const static 1]);
+size_t sl_record_type_size(enum sl_record_type type);
 size_t sl_record_item_size(const struct sl_record r[const static 1]);
+size_t sl_record_disk_size(
+    const struct sl_record r[const static 1],
+    enum sl_record_layout layout,
+    size_t item_size
+);
 bool sl_record_validate_metadata(
     struct sl_context ctx[static 1],
     const struct sl_record r[const static 1]
 );
+size_t sl_record_row_length(const struct sl_record r[const static 1]);
+bool sl_record_shard(
+    struct sl_context ctx[static 1],
+    const struct sl_record r[const static 1],
+    size_t shard_idx,
+    struct sl_record shard[const static 1]
+);
 bool sl_record_read_metadata(
     struct sl_context ctx[static 1],
     struct sl_record record[const static 1],
@@ -0,0 +1,211 @@
+#include <stddef.h>
+#include <string.h>
+
+#include <pthread.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/io/io.h>
+#include <stufflib/memory/memory.h>
+#include <stufflib/record/reader.h>
+#include <stufflib/record/record.h>
+#include <stufflib/record/shard.h>
+#include <stufflib/record/writer.h>
+
+struct sl_record_shard_task {
+  struct sl_context ctx;
+  struct sl_record shard;
+  struct sl_file file;
+  struct sl_record_writer writer;
+  struct sl_record_reader reader;
+  size_t shard_idx;
+  sl_record_shard_write* write;
+  sl_record_shard_read* read;
+  void* arg;
+  pthread_t thread;
+  bool is_started;
+  bool ok;
+};
+
+static void* sl_record_shard_write_run(void* arg) {
+  struct sl_record_shard_task* task = arg;
+  task->ok = task->write(&(task->ctx), &(task->writer), task->shard_idx, task->arg)
+             && sl_record_writer_finish(&(task->ctx), &(task->writer));
+  return nullptr;
+}
+
+static void* sl_record_shard_read_run(void* arg) {
+  struct sl_record_shard_task* task = arg;
+  task->ok = task->read(&(task->ctx), &(task->reader), task->shard_idx, task->arg);
+  return nullptr;
+}
+
+// joins all started tasks and moves their errors to ctx
+static bool sl_record_shard_join(
+    struct sl_context ctx[static 1],
+    const size_t n_tasks,
+    struct sl_record_shard_task tasks[const static n_tasks]
+) {
+  bool ok = true;
+  for (size_t k = 0; k < n_tasks; ++k) {
+    if (!tasks[k].is_started) {
+      ok = false;
+      continue;
+    }
+    pthread_join(tasks[k].thread, nullptr);
+    tasks[k].is_started = false;
+    if (!tasks[k].ok) {
+      sl_context_move_errors(ctx, &(tasks[k].ctx));
+      SL_ERROR(ctx, "failed processing shard %zu", k);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+bool sl_record_write_shards(
+    struct sl_context ctx[static 1],
+    struct sl_record record[const static 1],
+    const size_t n_shards,
+    sl_record_shard_write* write,
+    void* arg
+) {
+  bool ok                            = false;
+  struct sl_record_shard_task* tasks = nullptr;
+
+  if (n_shards == 0 || n_shards > SL_RECORD_MAX_SHARDS) {
+    SL_ERROR(ctx, "cannot write %zu shards, at most %d supported", n_shards, SL_RECORD_MAX_SHARDS);
+    goto done;
+  }
+  tasks = sl_alloc(ctx, n_shards, sizeof(*tasks));
+  if (!tasks) {
+    SL_ERROR(ctx, "failed allocating %zu shard writers", n_shards);
+    goto done;
+  }
+
+  record->n_shards = n_shards;
+  memset(record->shard_rows, 0, sizeof(record->shard_rows));
+  memset(record->shard_size, 0, sizeof(record->shard_size));
+
+  for (size_t k = 0; k < n_shards; ++k) {
+    struct sl_record_shard_task* task = tasks + k;
+    if (!sl_record_shard(ctx, record, k, &(task->shard))) {
+      goto done;
+    }
+    // sizes are counted while writing, validate shards with the size of the record
+    task->shard.size        = record->size;
+    task->shard.dim_size[0] = 0;
+    task->shard_idx         = k;
+    task->write             = write;
+    task->arg               = arg;
+
+    task->writer = (struct sl_record_writer){
+        .file   = &(task->file),
+        .record = &(task->shard),
+    };
+    if (!sl_record_writer_open(ctx, &(task->writer))) {
+      SL_ERROR(ctx, "cannot open writer for shard %zu of record %s", k, record->name);
+      goto done;
+    }
+  }
+
+  for (size_t k = 0; k < n_shards; ++k) {
+    const int err
+        = pthread_create(&(tasks[k].thread), nullptr, sl_record_shard_write_run, tasks + k);
+    if (err != 0) {
+      SL_ERROR(ctx, "failed starting writer thread for shard %zu (%s)", k, strerror(err));
+      goto done;
+    }
+    tasks[k].is_started = true;
+  }
+
+  if (!sl_record_shard_join(ctx, n_shards, tasks)) {
+    SL_ERROR(ctx, "failed writing shards of record %s", record->name);
+    goto done;
+  }
+
+  record->dim_size[0] = 0;
+  record->size        = 0;
+  for (size_t k = 0; k < n_shards; ++k) {
+    record->shard_rows[k] = tasks[k].shard.dim_size[0];
+    record->shard_size[k] = tasks[k].writer.n_written;
+    record->dim_size[0] += record->shard_rows[k];
+    record->size += record->shard_size[k];
+  }
+
+  ok = true;
+done:
+  if (tasks) {
+    sl_record_shard_join(ctx, n_shards, tasks);
+    for (size_t k = 0; k < n_shards; ++k) {
+      sl_record_writer_close(&(tasks[k].writer));
+    }
+  }
+  sl_free(tasks);
+  return ok;
+}
+
+bool sl_record_read_shards(
+    struct sl_context ctx[static 1],
+    const struct sl_record record[const static 1],
+    sl_record_shard_read* read,
+    void* arg
+) {
+  bool ok                            = false;
+  struct sl_record_shard_task* tasks = nullptr;
+  const size_t n_shards              = record->n_shards;
+
+  if (n_shards == 0) {
+    SL_ERROR(ctx, "record %s is not sharded", record->name);
+    goto done;
+  }
+  tasks = sl_alloc(ctx, n_shards, sizeof(*tasks));
+  if (!tasks) {
+    SL_ERROR(ctx, "failed allocating %zu shard readers", n_shards);
+    goto done;
+  }
+
+  for (size_t k = 0; k < n_shards; ++k) {
+    struct sl_record_shard_task* task = tasks + k;
+    if (!sl_record_shard(ctx, record, k, &(task->shard))) {
+      goto done;
+    }
+    task->shard_idx = k;
+    task->read      = read;
+    task->arg       = arg;
+
+    task->reader = (struct sl_record_reader){
+        .file   = &(task->file),
+        .record = &(task->shard),
+    };
+    if (!sl_record_reader_open(ctx, &(task->reader))) {
+      SL_ERROR(ctx, "cannot open reader for shard %zu of record %s", k, record->name);
+      goto done;
+    }
+  }
+
+  for (size_t k = 0; k < n_shards; ++k) {
+    const int err
+        = pthread_create(&(tasks[k].thread), nullptr, sl_record_shard_read_run, tasks + k);
+    if (err != 0) {
+      SL_ERROR(ctx, "failed starting reader thread for shard %zu (%s)", k, strerror(err));
+      goto done;
+    }
+    tasks[k].is_started = true;
+  }
+
+  if (!sl_record_shard_join(ctx, n_shards, tasks)) {
+    SL_ERROR(ctx, "failed reading shards of record %s", record->name);
+    goto done;
+  }
+
+  ok = true;
+done:
+  if (tasks) {
+    sl_record_shard_join(ctx, n_shards, tasks);
+    for (size_t k = 0; k < n_shards; ++k) {
+      sl_record_reader_close(&(tasks[k].reader));
+    }
+  }
+  sl_free(tasks);
+  return ok;
+}
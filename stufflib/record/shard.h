@@ -0,0 +1,42 @@
+#ifndef STUFFLIB_RECORD_SHARD_H_INCLUDED
+#define STUFFLIB_RECORD_SHARD_H_INCLUDED
+
+#include <stddef.h>
+
+#include <stufflib/context/context.h>
+#include <stufflib/record/reader.h>
+#include <stufflib/record/record.h>
+#include <stufflib/record/writer.h>
+
+// writes shard shard_idx on its own thread
+// writer->record is the shard and write counts the rows it writes in writer->record->dim_size[0]
+typedef bool sl_record_shard_write(
+    struct sl_context ctx[static 1],
+    struct sl_record_writer writer[const static 1],
+    size_t shard_idx,
+    void* arg
+);
+
+// reads shard shard_idx on its own thread
+typedef bool sl_record_shard_read(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    size_t shard_idx,
+    void* arg
+);
+
+bool sl_record_write_shards(
+    struct sl_context ctx[static 1],
+    struct sl_record record[const static 1],
+    size_t n_shards,
+    sl_record_shard_write* write,
+    void* arg
+);
+bool sl_record_read_shards(
+    struct sl_context ctx[static 1],
+    const struct sl_record record[const static 1],
+    sl_record_shard_read* read,
+    void* arg
+);
+
+#endif  // STUFFLIB_RECORD_SHARD_H_INCLUDED
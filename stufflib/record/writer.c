@@ -2,10 +2,13 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <assert.h>
+
 #include <stufflib/context/context.h>
 #include <stufflib/io/io.h>
 #include <stufflib/macros/macros.h>
 #include <stufflib/misc/misc.h>
+#include <stufflib/record/block.h>
 #include <stufflib/record/record.h>
 #include <stufflib/record/writer.h>
 #include <stufflib/span/span.h>
@@ -18,6 +21,9 @@ bool sl_record_writer_open(
     SL_ERROR(ctx, "invalid record writer");
     return false;
   }
+  writer->layout    = sl_record_layout_of(writer->record);
+  writer->item_size = sl_record_item_size(writer->record);
+
   char full_path[1'024] = {0};
   if (!sl_file_format_path(
           SL_ARRAY_LEN(full_path),
@@ -33,49 +39,142 @@ bool sl_record_writer_open(
     SL_ERROR(ctx, "cannot open record data file '%s'", full_path);
     return false;
   }
+  if (writer->layout == sl_record_layout_sparse) {
+    if (!sl_span_create(ctx, SL_RECORD_WRITER_STAGING_SIZE, &(writer->staging))) {
+      SL_ERROR(ctx, "failed allocating record writer staging buffer");
+      return false;
+    }
+    writer->n_staged = 0;
+  }
+  if (writer->layout == sl_record_layout_blocked) {
+    if (!sl_file_format_path(
+            SL_ARRAY_LEN(full_path),
+            full_path,
+            writer->record->path,
+            writer->record->name,
+            ".sl_record_index"
+        )) {
+      SL_ERROR(ctx, "failed formatting record block index file path");
+      return false;
+    }
+    if (!sl_file_open(ctx, &(writer->block_index), full_path, "wb")) {
+      SL_ERROR(ctx, "cannot open record block index file '%s'", full_path);
+      return false;
+    }
+    if (!sl_record_block_create(ctx, &(writer->block), writer->item_size)) {
+      SL_ERROR(ctx, "failed creating record writer block");
+      return false;
+    }
+    writer->block.encoding = sl_record_block_encoding_of(writer->record);
+    writer->block_offset   = 0;
+  }
   return true;
 }
 
 void sl_record_writer_close(struct sl_record_writer writer[const static 1]) {
+  if (writer->block.length > 0 || writer->n_staged > 0) {
+    struct sl_context ctx = {0};
+    if (!sl_record_writer_finish(&ctx, writer)) {
+      sl_context_unwind_errors(&ctx, stderr);
+    }
+  }
+  sl_span_destroy(&(writer->staging));
+  writer->n_staged = 0;
+  sl_record_block_destroy(&(writer->block));
+  sl_file_close(&(writer->block_index));
   if (writer->file) {
     sl_file_close(writer->file);
   }
 }
 
+static bool sl_record_writer_write_block(
+    struct sl_context ctx[static 1],
+    struct sl_record_writer writer[const static 1]
+) {
+  const size_t size = sl_record_block_encode(&(writer->block));
+  assert(size <= (size_t)UINT32_MAX);
+  const uint32_t block_size   = (uint32_t)size;
+  const uint64_t block_offset = writer->block_offset;
+  if (1 != fwrite(&block_size, sizeof(block_size), 1, writer->file->file)
+      || size != fwrite(writer->block.encoded.data, 1, size, writer->file->file)
+      || ferror(writer->file->file) != 0) {
+    SL_ERROR(ctx, "failed appending block to %s", writer->file->path);
+    return false;
+  }
+  if (1 != fwrite(&block_offset, sizeof(block_offset), 1, writer->block_index.file)
+      || ferror(writer->block_index.file) != 0) {
+    SL_ERROR(ctx, "failed appending block offset to %s", writer->block_index.path);
+    return false;
+  }
+  writer->block_offset += sizeof(block_size) + size;
+  sl_record_block_clear(&(writer->block));
+  return true;
+}
+
+static bool sl_record_writer_flush(
+    struct sl_context ctx[static 1],
+    struct sl_record_writer writer[const static 1]
+) {
+  if (writer->n_staged == 0) {
+    return true;
+  }
+  if (writer->n_staged != fwrite(writer->staging.data, 1, writer->n_staged, writer->file->file)
+      || ferror(writer->file->file) != 0) {
+    SL_ERROR(ctx, "failed appending %zu staged bytes to %s", writer->n_staged, writer->file->path);
+    return false;
+  }
+  writer->n_staged = 0;
+  return true;
+}
+
+bool sl_record_writer_finish(
+    struct sl_context ctx[static 1],
+    struct sl_record_writer writer[const static 1]
+) {
+  if (!sl_record_writer_flush(ctx, writer)) {
+    SL_ERROR(ctx, "failed writing staged data of record %s", writer->record->name);
+    return false;
+  }
+  if (writer->block.length > 0 && !sl_record_writer_write_block(ctx, writer)) {
+    SL_ERROR(ctx, "failed writing last block of record %s", writer->record->name);
+    return false;
+  }
+  return true;
+}
+
 bool sl_record_writer_write(
     struct sl_context ctx[static 1],
     struct sl_record_writer writer[const static 1],
     struct sl_span buffer[const static 1]
 ) {
-  const char* const layout   = writer->record->layout;
-  const size_t item_size     = sl_record_item_size(writer->record);
-  const size_t buffer_length = buffer->size / item_size;
+  const enum sl_record_layout layout = writer->layout;
+  const size_t item_size             = writer->item_size;
+  const size_t buffer_length         = buffer->size / item_size;
 
-  if (SL_STR_EQ(layout, "sparse")) {
-    int64_t offset = (int64_t)writer->sparse_offset;
-    for (size_t buf_idx = 0; buf_idx < buffer_length; ++buf_idx) {
-      unsigned char* value = buffer->data + (buf_idx * item_size);
-      if (!sl_misc_is_zero(item_size, value)) {
-        if (1 != fwrite(&offset, sizeof(offset), 1, writer->file->file)
-            || ferror(writer->file->file) != 0) {
-          SL_ERROR(ctx, "failed appending offset to %s", writer->file->path);
-          return false;
-        }
-        if (1 != fwrite(value, item_size, 1, writer->file->file)
-            || ferror(writer->file->file) != 0) {
-          SL_ERROR(ctx, "failed appending data to %s", writer->file->path);
-          return false;
-        }
-        writer->n_written += 1;
-        offset = 0;
+  if (layout == sl_record_layout_sparse) {
+    const size_t pair_size = sizeof(int64_t) + item_size;
+    // offsets are relative to the previous nonzero, possibly in an earlier buffer
+    int64_t prev   = -(int64_t)writer->sparse_offset;
+    size_t buf_idx = sl_misc_next_nonzero(item_size, buffer_length, buffer->data, 0);
+    while (buf_idx < buffer_length) {
+      if (writer->n_staged + pair_size > writer->staging.size
+          && !sl_record_writer_flush(ctx, writer)) {
+        return false;
       }
-      offset += 1;
+      const int64_t offset = (int64_t)buf_idx - prev;
+      unsigned char* pair  = writer->staging.data + writer->n_staged;
+      memcpy(pair, &offset, sizeof(offset));
+      memcpy(pair + sizeof(offset), buffer->data + (buf_idx * item_size), item_size);
+      writer->n_staged += pair_size;
+      writer->n_written += 1;
+      prev    = (int64_t)buf_idx;
+      buf_idx = sl_misc_next_nonzero(item_size, buffer_length, buffer->data, buf_idx + 1);
     }
-    writer->sparse_offset = (size_t)offset;
+    writer->sparse_offset = (size_t)((int64_t)buffer_length - prev);
     return true;
   }
 
-  if (SL_STR_EQ(layout, "dense")) {
+  if (layout == sl_record_layout_dense) {
     const size_t n_written = fwrite(buffer->data, item_size, buffer_length, writer->file->file);
     writer->n_written += n_written;
     if (ferror(writer->file->file) != 0 || buffer_length != n_written) {
@@ -85,7 +184,22 @@ bool sl_record_writer_write(
     return true;
   }
 
-  SL_ERROR(ctx, "unknown data layout %s", layout);
+  if (layout == sl_record_layout_blocked) {
+    for (size_t buf_idx = 0; buf_idx < buffer_length;) {
+      const size_t count
+          = SL_MIN(SL_RECORD_BLOCK_LEN - writer->block.length, buffer_length - buf_idx);
+      writer->n_written
+          += sl_record_block_append(&(writer->block), count, buffer->data + (buf_idx * item_size));
+      buf_idx += count;
+      if (writer->block.length == SL_RECORD_BLOCK_LEN
+          && !sl_record_writer_write_block(ctx, writer)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  SL_ERROR(ctx, "unknown data layout %s", writer->record->layout);
   return false;
 }
 
@@ -106,7 +220,7 @@ bool sl_record_write_all(
     goto done;
   }
   struct sl_span data = sl_span_view(bufsize, buffer);
-  if (!sl_record_writer_write(ctx, &writer, &data)) {
+  if (!sl_record_writer_write(ctx, &writer, &data) || !sl_record_writer_finish(ctx, &writer)) {
     SL_ERROR(ctx, "failed writing record data");
     goto done;
   }
@@ -5,14 +5,26 @@
 
 #include <stufflib/context/context.h>
 #include <stufflib/io/io.h>
+#include <stufflib/record/block.h>
 #include <stufflib/record/record.h>
 #include <stufflib/span/span.h>
 
+// sparse offset and value pairs are staged and appended with one write per full buffer
+#define SL_RECORD_WRITER_STAGING_SIZE 65'536
+
+// layout and item size are resolved from record when opened
 struct sl_record_writer {
   struct sl_file* file;
   struct sl_record* record;
+  enum sl_record_layout layout;
+  size_t item_size;
   size_t n_written;
   size_t sparse_offset;
+  struct sl_span staging;
+  size_t n_staged;
+  struct sl_file block_index;
+  struct sl_record_block block;
+  size_t block_offset;
 };
 
 bool sl_record_writer_open(
@@ -20,6 +32,10 @@ bool sl_record_writer_open(
     struct sl_record_writer writer[const static 1]
 );
 void sl_record_writer_close(struct sl_record_writer writer[const static 1]);
+bool sl_record_writer_finish(
+    struct sl_context ctx[static 1],
+    struct sl_record_writer writer[const static 1]
+);
 bool sl_record_writer_write(
     struct sl_context ctx[static 1],
     struct sl_record_writer writer[const static 1],
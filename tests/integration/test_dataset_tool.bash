@@ -12,3 +12,25 @@ source ${self_dir}/../common.bash $@
 dataset_tool="$1"
 
 $dataset_tool rcv1 ${root_dir}/test-data/datasets/rcv1 ${test_dir}
+
+# blocked layout is smaller on disk than the sparse layout
+mkdir ${test_dir}/blocked
+$dataset_tool rcv1 ${root_dir}/test-data/datasets/rcv1 ${test_dir}/blocked --blocked
+for name in rcv1_train_samples rcv1_test_samples; do
+  sparse_size=$(cat ${test_dir}/${name}.shard*.sl_record_data | wc -c)
+  blocked_size=$(cat ${test_dir}/blocked/${name}.shard*.sl_record_data | wc -c)
+  if [[ $blocked_size -ge $sparse_size ]]; then
+    printf "blocked record '%s' is %d bytes but sparse is %d bytes\n" $name $blocked_size $sparse_size
+    exit 1
+  fi
+done
+
+# a malformed topics line fails the conversion
+mkdir ${test_dir}/malformed ${test_dir}/malformed_out
+cp ${root_dir}/test-data/datasets/rcv1/* ${test_dir}/malformed
+printf "CCAT x 1\n" >> ${test_dir}/malformed/rcv1-v2.topics.qrels
+if timeout 60 $dataset_tool rcv1 ${test_dir}/malformed ${test_dir}/malformed_out 2> ${test_dir}/malformed.log; then
+  printf "expected rcv1 conversion to fail on a malformed topics line\n"
+  exit 1
+fi
+grep -q "lineno 28: cannot parse document ID" ${test_dir}/malformed.log
@@ -167,3 +167,87 @@ assert_get ".a.b.c"  '1'         "$duplicates"
 assert_get ".a.c.b"  '2'         "$duplicates"
 assert_get ".a.b.d"  '4'         "$duplicates"
 assert_get ".a.b"    '{"c": 1}'  "$duplicates"
+
+# get many paths from one parse
+assert_get_many() {
+  local file="$1"
+  local expected="$2"
+  shift 2
+  local actual=$($json_tool get "$@" "$file")
+  if [[ "$actual" != "$expected" ]]; then
+    printf "'%s' get '%s': expected '%s', got '%s'\n" $json_tool "$*" "$expected" "$actual"
+    exit 1
+  fi
+}
+
+assert_get_many "$simple_object" $'"info"\n42\ntrue\n"c"' ".level" ".line" ".nested.y.z" ".tags[2]"
+assert_get_many "$simple_array" $'{"key": "val"}\n"val"\n20' "[7]" "[7].key" "[8][1]"
+assert_get_many "$types" $'"line1\\nline2"\n{}\n20' ".escaped" ".empty_obj" ".nested.arr[1]"
+
+assert_get_fails_many() {
+  local file="$1"
+  shift
+  local exit_code=0
+  $json_tool get "$@" "$file" 2> /dev/null > /dev/null || exit_code=$?
+  if [[ $exit_code -eq 0 ]]; then
+    printf "'%s' get '%s' should have failed but succeeded\n" $json_tool "$*"
+    exit 1
+  fi
+}
+
+assert_get_fails_many "$simple_object" ".level" ".missing"
+# many paths need a complete valid document
+assert_get_fails_many "$duplicates" ".a.b.c" ".a.b.d"
+
+# NDJSON, one compact valid document per line
+ndjson=${test_dir}/valid.ndjson
+: > $ndjson
+for json_file in $valid_json_paths; do
+  line=$(jq --compact-output . $json_file 2> /dev/null) || continue
+  printf '%s\n' "$line" > ${test_dir}/line.json
+  $json_tool count-nodes ${test_dir}/line.json >> ${test_dir}/expected_counts.txt
+  printf '%s\n\n' "$line" >> $ndjson
+done
+if ! $json_tool check --ndjson $ndjson; then
+  printf "'%s' failed to parse valid NDJSON file '%s'\n" $json_tool $ndjson
+  exit 1
+fi
+$json_tool count-nodes --ndjson --threads=3 $ndjson > ${test_dir}/counts.txt
+cmp ${test_dir}/counts.txt ${test_dir}/expected_counts.txt
+
+printf '{"a": 1}\n{"a": 2}\n{"a": [3\n{"a": 4}\n' > ${test_dir}/invalid.ndjson
+if $json_tool check --ndjson ${test_dir}/invalid.ndjson 2> /dev/null; then
+  printf "'%s' failed to reject invalid NDJSON file\n" $json_tool
+  exit 1
+fi
+actual=$($json_tool get --ndjson .a ${test_dir}/invalid.ndjson 2> /dev/null || true)
+if [[ "$actual" != $'1\n2' ]]; then
+  printf "'%s' get --ndjson: expected output up to the invalid line, got '%s'\n" $json_tool "$actual"
+  exit 1
+fi
+
+# NDJSON larger than one chunk per thread, output is in input order
+python3 -c '
+import json
+for i in range(200000):
+    print(json.dumps({"id": i, "tags": ["x", str(i % 7)], "nested": {"y": [i, {"z": -i}]}}))
+' > ${test_dir}/large.ndjson
+python3 -c '
+for i in range(200000):
+    print(i)
+    print("\"%d\"" % (i % 7))
+    print(-i)
+' > ${test_dir}/expected_get.txt
+for threads in 1 4; do
+  $json_tool get --ndjson --threads=$threads .id '.tags[1]' '.nested.y[1].z' ${test_dir}/large.ndjson \
+    > ${test_dir}/get.txt
+  cmp ${test_dir}/get.txt ${test_dir}/expected_get.txt
+done
+
+# output errors such as a full disk fail the command
+if [[ -e /dev/full ]]; then
+  if $json_tool get --ndjson .id ${test_dir}/large.ndjson > /dev/full 2> /dev/null; then
+    printf "'%s' get --ndjson succeeded writing to /dev/full\n" $json_tool
+    exit 1
+  fi
+fi
@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+set -o nounset
+set -o pipefail
+set -o errexit
+set -o errtrace
+trap 'echo error:$? line:$LINENO cmd:$BASH_COMMAND' ERR
+
+
+self_dir=$(dirname "$0")
+source ${self_dir}/../common.bash $@
+
+linalg_tool="$1"
+
+kernels=(add sub mul min max scale axpby dot)
+output=${test_dir}/bench.ndjson
+
+# sizes around the vector widths and their tails, the tool fails if any kernel disagrees with scalar
+for size in 1 3 4 7 8 15 16 17 57 63 64 65 1000; do
+  if ! $linalg_tool bench --size=$size --repeat=2 > $output; then
+    printf "'%s' bench failed for size %d\n" $linalg_tool $size
+    exit 1
+  fi
+  for kernel in ${kernels[*]}; do
+    implementations=$(jq -r "select(.kernel == \"$kernel\") | .implementation" $output)
+    if [[ $(printf '%s\n' $implementations | head -n 1) != 'scalar' ]]; then
+      printf "'%s' bench did not start %s with scalar for size %d\n" $linalg_tool $kernel $size
+      exit 1
+    fi
+    if [[ $(printf '%s\n' $implementations | wc -l) -lt 2 ]]; then
+      printf "'%s' bench has no vector implementation of %s for size %d\n" $linalg_tool $kernel $size
+      exit 1
+    fi
+  done
+  if [[ $(jq -r "select(.size != $size or .repeat != 2 or .ns_per_item <= 0) | .kernel" $output) ]]; then
+    printf "'%s' bench wrote invalid results for size %d\n" $linalg_tool $size
+    exit 1
+  fi
+done
+
+if $linalg_tool 2> /dev/null; then
+  printf "'%s' succeeded without a command\n" $linalg_tool
+  exit 1
+fi
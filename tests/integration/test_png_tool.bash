@@ -48,6 +48,27 @@ for input in $(find ${root_dir}/test-data/png -name '*.png'); do
   done
 done
 
+# info of many PNG files writes one JSON object per line
+png_inputs=$(find ${root_dir}/test-data/png -name '*.png')
+$png_tool info $png_inputs > ${test_dir}/stufflib_output.ndjson
+num_inputs=$(echo "$png_inputs" | wc -l)
+num_headers=$(jq -c .header ${test_dir}/stufflib_output.ndjson | wc -l)
+if [ $num_headers -ne $num_inputs ]; then
+  printf "expected info of %d PNG files but got %d\n" $num_inputs $num_headers
+  exit 1
+fi
+
+# a PNG that cannot be read ends the output with a complete object that has an error
+if $png_tool info $(echo "$png_inputs" | head -n 1) ${test_dir}/missing.png \
+  > ${test_dir}/stufflib_output.ndjson 2> /dev/null; then
+  printf "'%s' info succeeded for a missing PNG\n" $png_tool
+  exit 1
+fi
+if [[ $(tail -n 1 ${test_dir}/stufflib_output.ndjson | jq -r 'has("error")') != 'true' ]]; then
+  printf "'%s' info did not end with an error object for a missing PNG\n" $png_tool
+  exit 1
+fi
+
 for segment_threshold in 10 20 30; do
   input=${root_dir}/docs/img/tokyo.png
   expect=${root_dir}/docs/img/tokyo_segmented_${segment_threshold}p.png
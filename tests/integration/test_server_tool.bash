@@ -102,3 +102,31 @@ if ! grep --quiet "$message_content" client.out; then
   cat client.out
   exit 1
 fi
+
+# JSON requests are parsed while their chunks arrive
+python3 -c "\
+import socket, time
+def request(chunks, shutdown=False):
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.connect(('$bind_host', $listen_port))
+        for chunk in chunks:
+            s.sendall(chunk)
+            time.sleep(0.1)
+        if shutdown:
+            s.shutdown(socket.SHUT_WR)
+        print(s.recv(1024).decode('utf-8').strip())
+request([b'{\"a\": [1, 2', b', tr', b'ue], \"b\": {\"c\": \"x\\\\u00', b'e4\"}}'])
+request([b'  [' + b'1, ' * 10000 + b'2]'])
+request([b'[1, }'])
+request([b'[1, 2'], shutdown=True)
+" > client.out 2>&1
+
+check_no_server_errors
+expected_responses='{"keys": 3, "values": 7}
+{"keys": 0, "values": 10002}
+{"error": "invalid JSON"}
+{"error": "invalid JSON"}'
+if [[ "$(cat client.out)" != "$expected_responses" ]]; then
+  cat client.out
+  exit 1
+fi
@@ -116,4 +116,28 @@ SL_TEST(test_read_lines) {
   return true;
 }
 
+SL_TEST(test_map_file) {
+  unsigned char buf[128] = {0};
+  struct sl_span buffer  = sl_span_view(SL_ARRAY_LEN(buf), buf);
+
+  for (size_t i = 0; i < SL_ARRAY_LEN(sl_test_data_file_paths); ++i) {
+    struct sl_span mapped = {0};
+    SL_ASSERT_TRUE(sl_fs_map_file(ctx, sl_test_data_file_paths[i], &mapped));
+    SL_ASSERT_FALSE(mapped.owned);
+    SL_ASSERT_EQ_LL(mapped.size, sl_test_data_file_sizes[i]);
+    struct sl_span data = sl_fs_read_file(ctx, sl_test_data_file_paths[i], &buffer);
+    SL_ASSERT_EQ_LL(sl_span_compare(&mapped, &data), 0);
+    sl_span_destroy(&data);
+    sl_fs_unmap_file(&mapped);
+    SL_ASSERT_TRUE(mapped.data == nullptr);
+  }
+
+  struct sl_span mapped = {0};
+  SL_ASSERT_FALSE(sl_fs_map_file(ctx, "./test-data/does-not-exist", &mapped));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot open");
+  SL_ASSERT_FALSE(sl_fs_map_file(ctx, "./test-data", &mapped));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot map");
+  return true;
+}
+
 SL_TEST_MAIN()
@@ -1,8 +1,14 @@
+#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
+#include <stufflib/context/context.h>
 #include <stufflib/json/json.h>
+#include <stufflib/json/writer.h>
+#include <stufflib/macros/macros.h>
+#include <stufflib/random/random.h>
 #include <stufflib/testing/testing.h>
 
 #define SL_ASSERT_JSON_VALID(s)   SL_ASSERT_TRUE(sl_json_is_valid(ctx, strlen(s), s))
@@ -369,6 +375,59 @@ SL_TEST(test_json_count_invalid) {
   return true;
 }
 
+SL_TEST(test_json_count_across_blocks) {
+  // strings and whitespace runs spanning several 64 byte blocks
+  const char* json
+      = "{\"a\":                                                                    \n"
+        "                                                                  [\"0123456789abcdef"
+        "0123456789abcdef0123456789abcdef0123456789abcdef0123456789ab\\\"cdef0123456789abcdef\","
+        "\"\\u00e9\\n\\\\\", 1, true]                                                         }";
+  SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen(json), json), 6);
+
+  struct sl_json_node node = {0};
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(".a[2]"), ".a[2]", &node));
+  SL_ASSERT_EQ_LL(node.type, sl_json_type_number);
+  SL_ASSERT_EQ_LL(node.value_len, 1);
+  SL_ASSERT_EQ_LL(json[node.value_begin], '1');
+  return true;
+}
+
+SL_TEST(test_json_count_invalid_across_blocks) {
+  const char* control
+      = "[\"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\t\"]";
+  SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen(control), control), 0);
+  SL_ASSERT_ERROR_OCCURRED(ctx, "invalid control character 0x9 in string at offset 66");
+
+  const char* escape
+      = "[\"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abc\\x\"]";
+  SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen(escape), escape), 0);
+  SL_ASSERT_ERROR_OCCURRED(ctx, "invalid escape character 0x78 at offset 64");
+
+  const char* unterminated
+      = "[\"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+  SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen(unterminated), unterminated), 0);
+  SL_ASSERT_ERROR_OCCURRED(ctx, "unexpected end of input at offset 66");
+
+  const char* trailing = "[1]                                                                 x";
+  SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen(trailing), trailing), 0);
+  SL_ASSERT_ERROR_OCCURRED(ctx, "unexpected character 0x78 after value at offset 68");
+  return true;
+}
+
+SL_TEST(test_json_count_max_depth) {
+  char json[2 * SL_JSON_PARSE_MAX_DEPTH + 3] = {0};
+  memset(json, '[', SL_JSON_PARSE_MAX_DEPTH);
+  memset(json + SL_JSON_PARSE_MAX_DEPTH, ']', SL_JSON_PARSE_MAX_DEPTH);
+  SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen(json), json), SL_JSON_PARSE_MAX_DEPTH);
+
+  memmove(json + 1, json, strlen(json));
+  json[0]            = '[';
+  json[strlen(json)] = ']';
+  SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen(json), json), 0);
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON is nested deeper than");
+  return true;
+}
+
 SL_TEST(test_json_count_scalars) {
   SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen("null"), "null"), 1);
   SL_ASSERT_EQ_LL(sl_json_count_nodes(ctx, strlen("true"), "true"), 1);
@@ -448,6 +507,21 @@ SL_TEST(test_find_top_level_zero) {
   return true;
 }
 
+SL_TEST(test_find_top_level_double) {
+  const char* json         = "{\"x\":-1.25e-3,\"n\":12,\"s\":\"1.5\"}";
+  struct sl_json_node node = {0};
+  double val               = 0;
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(".x"), ".x", &node));
+  SL_ASSERT_TRUE(sl_json_get_double(ctx, &node, json, &val));
+  SL_ASSERT_EQ_DOUBLE(val, -1.25e-3, 1e-15);
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(".n"), ".n", &node));
+  SL_ASSERT_TRUE(sl_json_get_double(ctx, &node, json, &val));
+  SL_ASSERT_EQ_DOUBLE(val, 12, 1e-15);
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(".s"), ".s", &node));
+  SL_ASSERT_FALSE(sl_json_get_double(ctx, &node, json, &val));
+  return true;
+}
+
 SL_TEST(test_find_top_level_str) {
   const char* json         = "{\"key\":\"hello\"}";
   struct sl_json_node node = {0};
@@ -577,6 +651,34 @@ SL_TEST(test_find_array_of_objects) {
   return true;
 }
 
+SL_TEST(test_find_nested_array_positions) {
+  // positions of enclosing arrays are restored when nested containers close
+  const char* json = "[[0, [1, 2]], {\"a\": [3, [4]]}, [[5]], 6]";
+  const struct {
+    const char* path;
+    long long value;
+  } cases[] = {
+      {"[0][0]",      0},
+      {"[0][1][1]",   2},
+      {"[1].a[1][0]", 4},
+      {"[2][0][0]",   5},
+      {"[3]",         6},
+  };
+  for (size_t i = 0; i < SL_ARRAY_LEN(cases); ++i) {
+    const char* path         = cases[i].path;
+    struct sl_json_node node = {0};
+    SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(path), path, &node));
+    long long val = 0;
+    SL_ASSERT_TRUE(sl_json_get_int(&node, json, &val));
+    SL_ASSERT_EQ_LL(val, cases[i].value);
+  }
+  struct sl_json_node node = {0};
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen("[2][0]"), "[2][0]", &node));
+  SL_ASSERT_EQ_LL(node.type, sl_json_type_array);
+  SL_ASSERT_EQ_LL(node.value_len, strlen("[5]"));
+  return true;
+}
+
 SL_TEST(test_find_wrong_type_check) {
   const char* json         = "{\"a\":1}";
   struct sl_json_node node = {0};
@@ -636,6 +738,89 @@ SL_TEST(test_find_str_escaped_unicode) {
   return true;
 }
 
+SL_TEST(test_find_str_escaped_utf8) {
+  const struct {
+    const char* json;
+    const char* expected;
+  } cases[] = {
+      {"\"\\u00e4\"",        "\xc3\xa4"                },
+      {"\"\\u20AC\"",        "\xe2\x82\xac"            },
+      {"\"\\ud83d\\ude00\"", "\xf0\x9f\x98\x80"        },
+      {"\"a\\ud800b\"",      "a\xef\xbf\xbd" "b"       },
+      {"\"\\udc00\\ud800\"", "\xef\xbf\xbd\xef\xbf\xbd"},
+      {"\"\\/\"",            "/"                       },
+  };
+  for (size_t i = 0; i < SL_ARRAY_LEN(cases); ++i) {
+    const char* json               = cases[i].json;
+    const struct sl_json_node node = {
+        .type      = sl_json_type_string,
+        .value_len = strlen(json),
+    };
+    char val[16];
+    SL_ASSERT_TRUE(sl_json_get_str(ctx, &node, json, sizeof(val), val));
+    SL_ASSERT_EQ_STR(val, cases[i].expected);
+  }
+  return true;
+}
+
+SL_TEST(test_find_str_escapes_across_words) {
+  // escapes at every offset relative to the 8 byte words scanned for backslashes
+  char json[64]     = {0};
+  char expected[64] = {0};
+  for (size_t offset = 0; offset < 20; ++offset) {
+    memset(json, 'x', sizeof(json) - 1);
+    memset(expected, 'x', sizeof(expected) - 1);
+    json[0]          = '"';
+    json[offset + 1] = '\\';
+    json[offset + 2] = 'n';
+    json[40]         = '"';
+    json[41]         = 0;
+    expected[offset] = '\n';
+    expected[38]     = 0;
+    const struct sl_json_node node = {
+        .type      = sl_json_type_string,
+        .value_len = strlen(json),
+    };
+    char val[64];
+    SL_ASSERT_TRUE(sl_json_get_str(ctx, &node, json, sizeof(val), val));
+    SL_ASSERT_EQ_STR(val, expected);
+  }
+  return true;
+}
+
+SL_TEST(test_find_str_view) {
+  const char* json         = "{\"a\": \"no escapes here\", \"b\": \"tab\\t\", \"c\": 1}";
+  struct sl_json_node node = {0};
+  size_t len               = 0;
+  const char* str          = nullptr;
+
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(".a"), ".a", &node));
+  SL_ASSERT_TRUE(sl_json_get_str_view(&node, json, &len, &str));
+  SL_ASSERT_EQ_LL(len, strlen("no escapes here"));
+  SL_ASSERT_STRNCMP(0, str, "no escapes here", len);
+  SL_ASSERT_TRUE(str == json + node.value_begin + 1);
+
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(".b"), ".b", &node));
+  SL_ASSERT_FALSE(sl_json_get_str_view(&node, json, &len, &str));
+  SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(".c"), ".c", &node));
+  SL_ASSERT_FALSE(sl_json_get_str_view(&node, json, &len, &str));
+  SL_ASSERT_EQ_LL(len, strlen("no escapes here"));
+  return true;
+}
+
+SL_TEST(test_unescape_in_place) {
+  char str[] = "a\\\"b\\u00e4\\ud83d\\ude00c\\\\";
+  const char expected[] = "a\"b\xc3\xa4\xf0\x9f\x98\x80" "c\\";
+  const size_t len      = sl_json_unescape(strlen(str), str);
+  SL_ASSERT_EQ_LL(len, strlen(expected));
+  SL_ASSERT_STRNCMP(0, str, expected, len);
+
+  char plain[] = "plain";
+  SL_ASSERT_EQ_LL(sl_json_unescape(strlen(plain), plain), strlen("plain"));
+  SL_ASSERT_EQ_STR(plain, "plain");
+  return true;
+}
+
 SL_TEST(test_find_str_buffer_too_small) {
   const char* json         = "{\"key\":\"hello\"}";
   struct sl_json_node node = {0};
@@ -801,6 +986,424 @@ SL_TEST(test_parse_path_error_dot_only) {
   return true;
 }
 
+SL_TEST(test_json_tape) {
+  const char* json
+      = "{\"a\": {\"b\": [1, {\"c\": \"x\"}, [2, 3]], \"d\": null}, \"e\": -1.5e3, \"f\": {}}";
+  struct sl_json_tape tape = {0};
+  SL_ASSERT_TRUE(sl_json_tape_parse(ctx, &tape, strlen(json), json));
+  // root, a, b, 1, {c}, "x", [2, 3], 2, 3, d, e, f
+  SL_ASSERT_EQ_LL(tape.size, 12);
+  SL_ASSERT_EQ_LL(tape.nodes[0].next, 12);
+  SL_ASSERT_EQ_LL(tape.nodes[1].next, 10);
+  SL_ASSERT_EQ_LL(tape.nodes[2].next, 9);
+  SL_ASSERT_EQ_LL(tape.nodes[4].next, 6);
+
+  const struct {
+    const char* path;
+    enum sl_json_type type;
+    const char* value;
+  } lookups[] = {
+      {".a.b[0]",    sl_json_type_number,   "1"             },
+      {".a.b[1].c",  sl_json_type_string,   "\"x\""         },
+      {".a.b[2]",    sl_json_type_array,    "[2, 3]"        },
+      {".a.b[2][1]", sl_json_type_number,   "3"             },
+      {".a.d",       sl_json_type_lit_null, "null"          },
+      {".e",         sl_json_type_number,   "-1.5e3"        },
+      {".f",         sl_json_type_object,   "{}"            },
+      {".a.b[1]",    sl_json_type_object,   "{\"c\": \"x\"}"},
+  };
+  for (size_t i = 0; i < SL_ARRAY_LEN(lookups); ++i) {
+    struct sl_json_node node = {0};
+    const char* path         = lookups[i].path;
+    SL_ASSERT_TRUE(sl_json_tape_find(ctx, &tape, json, strlen(path), path, &node));
+    SL_ASSERT_EQ_LL(node.type, lookups[i].type);
+    SL_ASSERT_EQ_LL(node.value_len, strlen(lookups[i].value));
+    SL_ASSERT_EQ_LL(memcmp(json + node.value_begin, lookups[i].value, node.value_len), 0);
+  }
+
+  const char* missing[] = {".x", ".a.b[3]", ".a.b[1].d", ".e.x", ".f.x", "[0]", ".a.b.c"};
+  for (size_t i = 0; i < SL_ARRAY_LEN(missing); ++i) {
+    struct sl_json_node node = {0};
+    SL_ASSERT_FALSE(sl_json_tape_find(ctx, &tape, json, strlen(missing[i]), missing[i], &node));
+    SL_ASSERT_FALSE(sl_context_error_occurred(ctx));
+  }
+
+  sl_json_tape_destroy(&tape);
+  return true;
+}
+
+SL_TEST(test_json_tape_duplicate_keys) {
+  const char* json = "{\"a\": {\"b\": 1}, \"a\": {\"c\": 2}, \"a\": {\"c\": 3, \"d\": 4}}";
+  struct sl_json_tape tape = {0};
+  SL_ASSERT_TRUE(sl_json_tape_parse(ctx, &tape, strlen(json), json));
+  const char* paths[]    = {".a.b", ".a.c", ".a.d"};
+  const char* expected[] = {"1", "2", "4"};
+  for (size_t i = 0; i < SL_ARRAY_LEN(paths); ++i) {
+    struct sl_json_node node = {0};
+    SL_ASSERT_TRUE(sl_json_tape_find(ctx, &tape, json, strlen(paths[i]), paths[i], &node));
+    SL_ASSERT_EQ_LL(memcmp(json + node.value_begin, expected[i], node.value_len), 0);
+    struct sl_json_node streamed = {0};
+    SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(paths[i]), paths[i], &streamed));
+    SL_ASSERT_EQ_LL(node.value_begin, streamed.value_begin);
+    SL_ASSERT_EQ_LL(node.value_len, streamed.value_len);
+  }
+  sl_json_tape_destroy(&tape);
+  return true;
+}
+
+SL_TEST(test_json_tape_invalid) {
+  struct sl_json_tape tape = {0};
+  SL_ASSERT_TRUE(sl_json_tape_parse(ctx, &tape, strlen("[1, 2]"), "[1, 2]"));
+  SL_ASSERT_EQ_LL(tape.size, 3);
+
+  // tape is reused and left empty on failure
+  SL_ASSERT_FALSE(sl_json_tape_parse(ctx, &tape, strlen("{\"a\": [1,"), "{\"a\": [1,"));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "unexpected end of input");
+  SL_ASSERT_EQ_LL(tape.size, 0);
+  struct sl_json_node node = {0};
+  SL_ASSERT_FALSE(sl_json_tape_find(ctx, &tape, "", strlen(".a"), ".a", &node));
+
+  SL_ASSERT_FALSE(sl_json_tape_parse(ctx, &tape, strlen("[1] 2"), "[1] 2"));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "unexpected character");
+
+  SL_ASSERT_TRUE(sl_json_tape_parse(ctx, &tape, strlen("\"s\""), "\"s\""));
+  SL_ASSERT_EQ_LL(tape.size, 1);
+  sl_json_tape_destroy(&tape);
+  return true;
+}
+
+// compiles n paths such as ".a.b[1]" into trie, steps must have room for all steps of all paths
+static bool compile_path_trie(
+    struct sl_context ctx[static 1],
+    struct sl_json_path_trie trie[static 1],
+    const size_t n,
+    const char* const path_strs[static n],
+    const size_t max_steps,
+    struct sl_json_path_step steps[static max_steps],
+    struct sl_json_path paths[static n]
+) {
+  size_t n_steps = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const size_t path_steps = sl_json_parse_path(
+        ctx,
+        strlen(path_strs[i]),
+        path_strs[i],
+        max_steps - n_steps,
+        steps + n_steps
+    );
+    if (sl_context_error_occurred(ctx)) {
+      return false;
+    }
+    paths[i] = (struct sl_json_path){.n_steps = path_steps, .steps = steps + n_steps};
+    n_steps += path_steps;
+  }
+  return sl_json_path_trie_compile(ctx, trie, n, paths);
+}
+
+SL_TEST(test_json_find_paths) {
+  const char* json = "{\"a\": {\"b\": [1, {\"c\": \"x\"}, [2, 3]], \"d\": null}, \"e\": -1.5e3}";
+  const char* path_strs[] = {
+      ".a.b[0]",
+      ".a.b[1].c",
+      ".a.b[2]",
+      ".a.b[2][1]",
+      ".a.d",
+      ".e",
+      ".a.x",
+      ".a.b[3]",
+      ".a.b[1]",
+      ".a.d",
+      ".a.b[1].c",
+  };
+  const char* expected[] = {
+      "1",
+      "\"x\"",
+      "[2, 3]",
+      "3",
+      "null",
+      "-1.5e3",
+      nullptr,
+      nullptr,
+      "{\"c\": \"x\"}",
+      "null",
+      "\"x\"",
+  };
+  enum { n_paths = SL_ARRAY_LEN(path_strs) };
+
+  struct sl_json_path_trie trie;
+  struct sl_json_path_step steps[64];
+  struct sl_json_path paths[n_paths];
+  SL_ASSERT_TRUE(
+      compile_path_trie(ctx, &trie, n_paths, path_strs, SL_ARRAY_LEN(steps), steps, paths)
+  );
+  // root, a, b, 0, 1, c, 2, 1, d, e, x, 3
+  SL_ASSERT_EQ_LL(trie.size, 12);
+
+  struct sl_json_node nodes[n_paths];
+  SL_ASSERT_EQ_LL(sl_json_find_paths(ctx, &trie, strlen(json), json, nodes), n_paths - 2);
+  for (size_t i = 0; i < n_paths; ++i) {
+    if (!expected[i]) {
+      SL_ASSERT_EQ_LL(nodes[i].type, sl_json_type_NONE);
+      continue;
+    }
+    SL_ASSERT_EQ_LL(nodes[i].value_len, strlen(expected[i]));
+    SL_ASSERT_EQ_LL(memcmp(json + nodes[i].value_begin, expected[i], nodes[i].value_len), 0);
+    struct sl_json_node node = {0};
+    const char* path         = path_strs[i];
+    SL_ASSERT_TRUE(sl_json_find(ctx, strlen(json), json, strlen(path), path, &node));
+    SL_ASSERT_EQ_LL(nodes[i].type, node.type);
+    SL_ASSERT_EQ_LL(nodes[i].value_begin, node.value_begin);
+  }
+  SL_ASSERT_FALSE(sl_context_error_occurred(ctx));
+  return true;
+}
+
+SL_TEST(test_json_find_paths_duplicate_keys) {
+  const char* json = "{\"a\": {\"b\": 1}, \"a\": {\"c\": [2]}, \"a\": {\"c\": 3, \"d\": 4}}";
+  const char* path_strs[] = {".a.b", ".a.c", ".a.d", ".a"};
+  const char* expected[]  = {"1", "[2]", "4", "{\"b\": 1}"};
+  enum { n_paths = SL_ARRAY_LEN(path_strs) };
+
+  struct sl_json_path_trie trie;
+  struct sl_json_path_step steps[16];
+  struct sl_json_path paths[n_paths];
+  SL_ASSERT_TRUE(
+      compile_path_trie(ctx, &trie, n_paths, path_strs, SL_ARRAY_LEN(steps), steps, paths)
+  );
+  struct sl_json_node nodes[n_paths];
+  SL_ASSERT_EQ_LL(sl_json_find_paths(ctx, &trie, strlen(json), json, nodes), n_paths);
+  for (size_t i = 0; i < n_paths; ++i) {
+    SL_ASSERT_EQ_LL(nodes[i].value_len, strlen(expected[i]));
+    SL_ASSERT_EQ_LL(memcmp(json + nodes[i].value_begin, expected[i], nodes[i].value_len), 0);
+  }
+  return true;
+}
+
+SL_TEST(test_json_find_paths_stops_early) {
+  // everything after the last searched value is never parsed
+  const char* json        = "[{\"id\": 7, \"tags\": [\"p\", \"q\"]}, {\"id\": oops";
+  const char* path_strs[] = {"[0].id", "[0].tags[1]", "[0].tags"};
+  enum { n_paths = SL_ARRAY_LEN(path_strs) };
+
+  struct sl_json_path_trie trie;
+  struct sl_json_path_step steps[16];
+  struct sl_json_path paths[n_paths];
+  SL_ASSERT_TRUE(
+      compile_path_trie(ctx, &trie, n_paths, path_strs, SL_ARRAY_LEN(steps), steps, paths)
+  );
+  struct sl_json_node nodes[n_paths];
+  SL_ASSERT_EQ_LL(sl_json_find_paths(ctx, &trie, strlen(json), json, nodes), n_paths);
+  SL_ASSERT_FALSE(sl_context_error_occurred(ctx));
+  SL_ASSERT_EQ_LL(nodes[1].type, sl_json_type_string);
+  SL_ASSERT_EQ_LL(memcmp(json + nodes[2].value_begin, "[\"p\", \"q\"]", nodes[2].value_len), 0);
+
+  // a parse error before all paths are found is an error, values found before it are kept
+  const char* more_strs[] = {"[0].id", "[1].name"};
+  struct sl_json_path more[2];
+  SL_ASSERT_TRUE(
+      compile_path_trie(ctx, &trie, 2, more_strs, SL_ARRAY_LEN(steps), steps, more)
+  );
+  SL_ASSERT_EQ_LL(sl_json_find_paths(ctx, &trie, strlen(json), json, nodes), 1);
+  SL_ASSERT_ERROR_OCCURRED(ctx, "unexpected character");
+  SL_ASSERT_EQ_LL(nodes[0].type, sl_json_type_number);
+  SL_ASSERT_EQ_LL(nodes[1].type, sl_json_type_NONE);
+  return true;
+}
+
+SL_TEST(test_json_path_trie_capacity) {
+  struct sl_json_path_trie trie;
+  struct sl_json_path paths[SL_JSON_PATH_TRIE_MAX_PATHS + 1] = {0};
+  SL_ASSERT_FALSE(sl_json_path_trie_compile(ctx, &trie, SL_ARRAY_LEN(paths), paths));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot search");
+  SL_ASSERT_FALSE(sl_json_path_trie_compile(ctx, &trie, 0, paths));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot search");
+
+  // one long path of distinct array indexes
+  struct sl_json_path_step steps[SL_JSON_PATH_TRIE_MAX_SIZE];
+  for (size_t i = 0; i < SL_ARRAY_LEN(steps); ++i) {
+    steps[i] = (struct sl_json_path_step){.is_index = true, .index = i};
+  }
+  paths[0] = (struct sl_json_path){.n_steps = SL_ARRAY_LEN(steps) - 1, .steps = steps};
+  SL_ASSERT_TRUE(sl_json_path_trie_compile(ctx, &trie, 1, paths));
+  SL_ASSERT_EQ_LL(trie.size, SL_JSON_PATH_TRIE_MAX_SIZE);
+  paths[0].n_steps = SL_ARRAY_LEN(steps);
+  SL_ASSERT_FALSE(sl_json_path_trie_compile(ctx, &trie, 1, paths));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON paths have more than");
+  return true;
+}
+
+// feeds json to stream in chunks of chunk_size bytes and writes its events into trace
+static bool stream_events(
+    struct sl_context ctx[static 1],
+    const char json[static 1],
+    const size_t chunk_size,
+    const size_t capacity,
+    const size_t trace_size,
+    char trace[static trace_size]
+) {
+  struct sl_json_stream stream = {0};
+  if (!sl_json_stream_create(ctx, &stream, capacity)) {
+    return false;
+  }
+  const size_t len = strlen(json);
+  size_t n_trace   = 0;
+  trace[0]         = 0;
+  for (size_t pos = 0; !stream.is_final;) {
+    if (pos < len) {
+      const size_t chunk_len = SL_MIN(chunk_size, len - pos);
+      const size_t n         = sl_json_stream_feed(ctx, &stream, chunk_len, json + pos);
+      if (n == 0) {
+        break;
+      }
+      pos += n;
+    } else {
+      sl_json_stream_finish(&stream);
+    }
+    while (sl_json_stream_next(ctx, &stream)) {
+      const struct sl_json_parser* p = &(stream.parser);
+      const char* data               = stream.data;
+      char* out                      = trace + n_trace;
+      const size_t out_size          = trace_size - n_trace;
+      int n                          = 0;
+      switch (p->event.type) {
+        case sl_json_key: {
+          n = snprintf(out, out_size, "k:%.*s ", (int)p->key_len, data + p->key_begin);
+        } break;
+        case sl_json_begin_node:
+        case sl_json_end_node: {
+          n = snprintf(out, out_size, "%c ", data[p->pos - 1]);
+        } break;
+        case sl_json_value: {
+          const int value_len = (int)(p->pos - p->value_begin);
+          n = snprintf(out, out_size, "v:%.*s ", value_len, data + p->value_begin);
+        } break;
+      }
+      n_trace += (size_t)n;
+    }
+  }
+  const bool ok = sl_json_stream_is_done(&stream) && !sl_context_error_occurred(ctx);
+  sl_json_stream_destroy(&stream);
+  return ok;
+}
+
+SL_TEST(test_json_stream) {
+  const struct {
+    const char* json;
+    const char* events;
+  } docs[] = {
+      {"{\"a\": [1, -2.5e+3, true], \"bc\": {\"d\": \"x\\u00e4\\\"\"}, \"e\": null}",
+       "{ k:a [ v:1 v:-2.5e+3 v:true ] k:bc { k:d v:\"x\\u00e4\\\"\" } k:e v:null } "},
+      {"  [false, [], {}, 0, \"\"]  \n",           "[ v:false [ ] { } v:0 v:\"\" ] "},
+      {"12345678901234567890",                     "v:12345678901234567890 "          },
+      {"\"s\"",                                     "v:\"s\" "                          },
+      {"[[[[\"deep\"]]]]",                           "[ [ [ [ v:\"deep\" ] ] ] ] "        },
+  };
+  for (size_t i = 0; i < SL_ARRAY_LEN(docs); ++i) {
+    for (size_t chunk_size = 1; chunk_size <= strlen(docs[i].json); ++chunk_size) {
+      char trace[256] = {0};
+      SL_ASSERT_TRUE(stream_events(ctx, docs[i].json, chunk_size, 32, sizeof(trace), trace));
+      SL_ASSERT_EQ_STR(trace, docs[i].events);
+    }
+  }
+
+  // containers are complete as soon as they are closed, before the end of input
+  struct sl_json_stream stream = {0};
+  SL_ASSERT_TRUE(sl_json_stream_create(ctx, &stream, 16));
+  const char* json = "{\"a\": 1}";
+  SL_ASSERT_EQ_LL(sl_json_stream_feed(ctx, &stream, strlen(json), json), strlen(json));
+  size_t n_events = 0;
+  while (sl_json_stream_next(ctx, &stream)) {
+    ++n_events;
+  }
+  SL_ASSERT_EQ_LL(n_events, 4);
+  SL_ASSERT_TRUE(sl_json_stream_needs_input(&stream));
+  sl_json_stream_finish(&stream);
+  SL_ASSERT_FALSE(sl_json_stream_next(ctx, &stream));
+  SL_ASSERT_TRUE(sl_json_stream_is_done(&stream));
+  SL_ASSERT_FALSE(sl_json_stream_needs_input(&stream));
+  sl_json_stream_destroy(&stream);
+  return true;
+}
+
+SL_TEST(test_json_stream_deep) {
+  enum { depth = 4 * SL_JSON_PARSE_MAX_DEPTH };
+  // alternating objects and arrays around a single value
+  static char json[8 * depth] = {0};
+  size_t n = 0;
+  for (size_t i = 0; i < depth; ++i) {
+    n += (size_t)snprintf(json + n, sizeof(json) - n, "%s", i % 2 ? "[" : "{\"k\":");
+  }
+  json[n++] = '1';
+  for (size_t i = depth; i > 0; --i) {
+    json[n++] = (i - 1) % 2 ? ']' : '}';
+  }
+  const size_t len = strlen(json);
+
+  struct sl_json_stream stream = {0};
+  SL_ASSERT_TRUE(sl_json_stream_create(ctx, &stream, 64));
+  for (size_t pos = 0; !sl_context_error_occurred(ctx);) {
+    SL_ASSERT_TRUE(pos < len);
+    pos += sl_json_stream_feed(ctx, &stream, len - pos, json + pos);
+    while (sl_json_stream_next(ctx, &stream)) {
+    }
+  }
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON is nested deeper than");
+  sl_json_stream_destroy(&stream);
+
+  static uint64_t is_array[SL_JSON_PARSE_STACK_WORDS(depth)];
+  static size_t array_pos[depth];
+  SL_ASSERT_TRUE(sl_json_stream_create(ctx, &stream, 64));
+  sl_json_stream_set_stack(
+      &stream,
+      (struct sl_json_parse_stack){
+          .capacity  = depth,
+          .is_array  = is_array,
+          .array_pos = array_pos,
+      }
+  );
+  size_t max_depth = 0;
+  size_t n_values  = 0;
+  for (size_t pos = 0; !sl_json_stream_is_done(&stream);) {
+    if (pos < len) {
+      pos += sl_json_stream_feed(ctx, &stream, len - pos, json + pos);
+    } else {
+      sl_json_stream_finish(&stream);
+    }
+    while (sl_json_stream_next(ctx, &stream)) {
+      max_depth = SL_MAX(max_depth, stream.parser.depth);
+      n_values += stream.parser.event.type == sl_json_value;
+    }
+    SL_ASSERT_FALSE(sl_context_error_occurred(ctx));
+  }
+  SL_ASSERT_EQ_LL(max_depth, depth);
+  SL_ASSERT_EQ_LL(n_values, 1);
+  sl_json_stream_destroy(&stream);
+  return true;
+}
+
+SL_TEST(test_json_stream_errors) {
+  char trace[256] = {0};
+  // token longer than the buffer
+  SL_ASSERT_FALSE(stream_events(ctx, "[\"0123456789abcdef\"]", 4, 16, sizeof(trace), trace));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON token at offset 1 does not fit");
+  SL_ASSERT_EQ_STR(trace, "[ ");
+
+  SL_ASSERT_FALSE(stream_events(ctx, "{\"a\": [1, 2", 3, 16, sizeof(trace), trace));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "unexpected end of input");
+  SL_ASSERT_EQ_STR(trace, "{ k:a [ v:1 v:2 ");
+
+  SL_ASSERT_FALSE(stream_events(ctx, "[tru]", 1, 16, sizeof(trace), trace));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "invalid literal");
+
+  SL_ASSERT_FALSE(stream_events(ctx, "", 1, 16, sizeof(trace), trace));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON content is empty");
+
+  struct sl_json_stream stream = {0};
+  SL_ASSERT_FALSE(sl_json_stream_create(ctx, &stream, SL_JSON_PARSE_LOOKAHEAD));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON stream capacity must be larger than");
+  return true;
+}
+
 SL_TEST(test_parse_path_error_double_dot) {
   const char* path = ".a..b";
   struct sl_json_path_step steps[64];
@@ -841,4 +1444,202 @@ SL_TEST(test_parse_path_error_unclosed_bracket) {
   return true;
 }
 
+#define SL_ASSERT_JSON_WRITTEN(writer, expected)                              \
+  do {                                                                        \
+    SL_ASSERT_EQ_LL((writer).size, strlen(expected));                         \
+    SL_ASSERT_STRNCMP(0, (writer).buffer.data, (expected), strlen(expected)); \
+  } while (false)
+
+SL_TEST(test_json_writer) {
+  struct sl_json_writer writer = {0};
+  // grows from a tiny buffer
+  SL_ASSERT_TRUE(sl_json_writer_create(ctx, &writer, nullptr, 4));
+  SL_ASSERT_TRUE(sl_json_writer_object_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "ints"));
+  SL_ASSERT_TRUE(sl_json_writer_array_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_int(ctx, &writer, 0));
+  SL_ASSERT_TRUE(sl_json_writer_int(ctx, &writer, -7));
+  SL_ASSERT_TRUE(sl_json_writer_int(ctx, &writer, 1'234'567'890));
+  SL_ASSERT_TRUE(sl_json_writer_int(ctx, &writer, INT64_MIN));
+  SL_ASSERT_TRUE(sl_json_writer_uint(ctx, &writer, UINT64_MAX));
+  SL_ASSERT_TRUE(sl_json_writer_array_end(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "doubles"));
+  SL_ASSERT_TRUE(sl_json_writer_array_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, 0.1));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, 100.0));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, -0.0));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, 1.0 / 3.0));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, 5e-324));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, 1e300));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, 1e23));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, 0x1p-1022));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, (double)0.1F));
+  SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, NAN));
+  SL_ASSERT_TRUE(sl_json_writer_array_end(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "esc\"aped"));
+  SL_ASSERT_TRUE(sl_json_writer_string(ctx, &writer, "a\\b\n\t\x01ä"));
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "empty"));
+  SL_ASSERT_TRUE(sl_json_writer_object_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_object_end(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "literals"));
+  SL_ASSERT_TRUE(sl_json_writer_array_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_bool(ctx, &writer, true));
+  SL_ASSERT_TRUE(sl_json_writer_bool(ctx, &writer, false));
+  SL_ASSERT_TRUE(sl_json_writer_null(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_array_end(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_object_end(ctx, &writer));
+  // top-level values are written one per line
+  SL_ASSERT_TRUE(sl_json_writer_string(ctx, &writer, ""));
+  SL_ASSERT_JSON_WRITTEN(
+      writer,
+      "{\"ints\":[0,-7,1234567890,-9223372036854775808,18446744073709551615],"
+      "\"doubles\":[0.1,100,-0,0.3333333333333333,5e-324,1e+300,1e+23,2.2250738585072014e-308,"
+      "0.10000000149011612,null],"
+      "\"esc\\\"aped\":\"a\\\\b\\n\\t\\u0001ä\",\"empty\":{},\"literals\":[true,false,null]}\n"
+      "\"\"\n"
+  );
+  SL_ASSERT_TRUE(sl_json_is_valid(ctx, writer.size - 3, (const char*)writer.buffer.data));
+  sl_json_writer_destroy(&writer);
+  return true;
+}
+
+SL_TEST(test_json_writer_errors) {
+  unsigned char buffer[16]     = {0};
+  struct sl_json_writer writer = {0};
+
+  sl_json_writer_init(&writer, nullptr, sizeof(buffer), buffer);
+  SL_ASSERT_FALSE(sl_json_writer_key(ctx, &writer, "a"));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer cannot write key 'a' outside of an object");
+  SL_ASSERT_FALSE(sl_json_writer_object_end(ctx, &writer));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer has no open object to end");
+
+  SL_ASSERT_TRUE(sl_json_writer_object_begin(ctx, &writer));
+  SL_ASSERT_FALSE(sl_json_writer_int(ctx, &writer, 1));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer expected an object key before the value");
+  SL_ASSERT_FALSE(sl_json_writer_array_end(ctx, &writer));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer has no open array to end");
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "a"));
+  SL_ASSERT_FALSE(sl_json_writer_key(ctx, &writer, "b"));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer expected a value before key 'b'");
+  SL_ASSERT_FALSE(sl_json_writer_object_end(ctx, &writer));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer expected a value for the last key");
+  SL_ASSERT_TRUE(sl_json_writer_int(ctx, &writer, 1));
+  SL_ASSERT_TRUE(sl_json_writer_object_end(ctx, &writer));
+  SL_ASSERT_JSON_WRITTEN(writer, "{\"a\":1}\n");
+
+  // caller-provided buffers do not grow
+  SL_ASSERT_FALSE(sl_json_writer_string(ctx, &writer, "0123456789"));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer buffer of 16 bytes is full");
+
+  sl_json_writer_init(&writer, nullptr, sizeof(buffer), buffer);
+  for (size_t depth = 0; depth < SL_JSON_WRITER_MAX_DEPTH; ++depth) {
+    writer.size = 0;
+    SL_ASSERT_TRUE(sl_json_writer_array_begin(ctx, &writer));
+  }
+  SL_ASSERT_FALSE(sl_json_writer_array_begin(ctx, &writer));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "JSON writer supports at most 64 nested containers");
+
+  // values left open part-way can be ended, a key without a value gets null
+  unsigned char large_buffer[32] = {0};
+  sl_json_writer_init(&writer, nullptr, sizeof(large_buffer), large_buffer);
+  SL_ASSERT_TRUE(sl_json_writer_object_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "a"));
+  SL_ASSERT_TRUE(sl_json_writer_array_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_object_begin(ctx, &writer));
+  SL_ASSERT_TRUE(sl_json_writer_key(ctx, &writer, "b"));
+  SL_ASSERT_TRUE(sl_json_writer_end_to_depth(ctx, &writer, 1));
+  SL_ASSERT_EQ_LL(writer.depth, 1);
+  SL_ASSERT_TRUE(sl_json_writer_end_to_depth(ctx, &writer, 0));
+  SL_ASSERT_JSON_WRITTEN(writer, "{\"a\":[{\"b\":null}]}\n");
+  return true;
+}
+
+static bool double_bits_equal(const double lhs, const double rhs) {
+  return memcmp(&lhs, &rhs, sizeof(lhs)) == 0;
+}
+
+SL_TEST(test_json_writer_double_shortest) {
+  unsigned char buffer[32]     = {0};
+  struct sl_json_writer writer = {0};
+  sl_json_writer_init(&writer, nullptr, sizeof(buffer), buffer);
+
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  for (int i = 0; i < 10'000; ++i) {
+    uint64_t bits = (uint64_t)sl_random_pcg32(&prng) << 32;
+    bits |= sl_random_pcg32(&prng);
+    const uint32_t bits32 = (uint32_t)bits;
+
+    // random bit patterns, floats widened to double and short decimals
+    double value  = 0;
+    float value32 = 0;
+    switch (i % 3) {
+      case 0: {
+        memcpy(&value, &bits, sizeof(value));
+      } break;
+      case 1: {
+        memcpy(&value32, &bits32, sizeof(value32));
+        value = (double)value32;
+      } break;
+      default: {
+        value = (double)(bits % 1'000'000) / 1e3;
+      } break;
+    }
+    // integers are written by the integer formatter
+    if (!isfinite(value)
+        || (fabs(value) < 0x1p53 && double_bits_equal(value, (double)(int64_t)value))) {
+      continue;
+    }
+
+    // fewest significant digits that parse back, searched one precision at a time
+    char expected[32] = {0};
+    for (int precision = 1; precision <= 17; ++precision) {
+      snprintf(expected, sizeof(expected), "%.*g", precision, value);
+      if (double_bits_equal(strtod(expected, nullptr), value)) {
+        break;
+      }
+    }
+
+    writer.size = 0;
+    SL_ASSERT_TRUE(sl_json_writer_double(ctx, &writer, value));
+    SL_ASSERT_EQ_LL(writer.size, strlen(expected) + 1);
+    SL_ASSERT_STRNCMP(0, writer.buffer.data, expected, strlen(expected));
+  }
+  return true;
+}
+
+SL_TEST(test_json_writer_stream) {
+  FILE* stream = tmpfile();
+  SL_ASSERT_TRUE(stream);
+
+  // smaller than most values, every append flushes or bypasses the buffer
+  unsigned char buffer[8]      = {0};
+  struct sl_json_writer writer = {0};
+  sl_json_writer_init(&writer, stream, sizeof(buffer), buffer);
+
+  char long_str[100] = {0};
+  memset(long_str, 'x', sizeof(long_str) - 1);
+  for (int64_t i = 0; i < 3; ++i) {
+    SL_ASSERT_TRUE(sl_json_writer_array_begin(ctx, &writer));
+    SL_ASSERT_TRUE(sl_json_writer_int(ctx, &writer, i));
+    SL_ASSERT_TRUE(sl_json_writer_string(ctx, &writer, long_str));
+    SL_ASSERT_TRUE(sl_json_writer_array_end(ctx, &writer));
+  }
+  SL_ASSERT_TRUE(sl_json_writer_flush(ctx, &writer));
+  SL_ASSERT_EQ_LL(writer.size, 0);
+
+  char expected[512] = {0};
+  char output[512]   = {0};
+  for (int i = 0; i < 3; ++i) {
+    const size_t len = strlen(expected);
+    snprintf(expected + len, sizeof(expected) - len, "[%d,\"%s\"]\n", i, long_str);
+  }
+  rewind(stream);
+  const size_t n_read = fread(output, 1, sizeof(output) - 1, stream);
+  fclose(stream);
+  SL_ASSERT_EQ_LL(n_read, strlen(expected));
+  SL_ASSERT_EQ_STR(output, expected);
+  return true;
+}
+
 SL_TEST_MAIN()
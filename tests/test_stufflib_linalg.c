@@ -1,7 +1,11 @@
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <stufflib/linalg/linalg.h>
+#include <stufflib/linalg/simd.h>
 #include <stufflib/math/math.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
 #include <stufflib/testing/testing.h>
 #include <stufflib/vector/sl_vector_f32.h>
@@ -386,6 +390,32 @@ SL_TEST(test_matrix_multiply) {
   return check_matrix_equal(ctx, &result, &expected);
 }
 
+SL_TEST(test_matrix_vector_multiply) {
+  (void)ctx;
+  struct sl_matrix_f32 a = {
+      .length   = {4, 3},
+      .capacity = {4, 3},
+      .data     = (float[]){0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}
+  };
+  struct sl_vector_f32 x = {
+      .length   = {3},
+      .capacity = {3},
+      .data     = (float[]){-3, 1, 5},
+  };
+  struct sl_vector_f32 result = {
+      .length   = {4},
+      .capacity = {4},
+      .data     = (float[]){-1, -1, -1, -1},
+  };
+  sl_la_matrix_vector_multiply(&a, &x, &result);
+  struct sl_vector_f32 expected = {
+      .length   = {4},
+      .capacity = {4},
+      .data     = (float[]){11, 20, 29, 38},
+  };
+  return check_vector_equal(ctx, &result, &expected);
+}
+
 SL_TEST(test_matrix_frobenius_norm) {
   (void)ctx;
   struct sl_matrix_f32 a = {
@@ -418,6 +448,60 @@ SL_TEST(test_vector_scale) {
   return true;
 }
 
+SL_TEST(test_vector_axpby) {
+  (void)ctx;
+  for (int alpha = -3; alpha <= 3; ++alpha) {
+    for (int beta = -3; beta <= 3; ++beta) {
+      struct sl_vector_f32 x = {
+          .length   = {9},
+          .capacity = {9},
+          .data     = (float[]){-4, -3, -2, -1, 0, 1, 2, 3, 4},
+      };
+      struct sl_vector_f32 y = {
+          .length   = {9},
+          .capacity = {9},
+          .data     = (float[]){1, 2, 3, 4, 5, 6, 7, 8, 9},
+      };
+      sl_la_vector_axpby((float)alpha, &x, (float)beta, &y);
+      for (size_t i = 0; i < sl_vector_f32_size(&y); ++i) {
+        const double expected = (alpha * ((double)i - 4)) + (beta * ((double)i + 1));
+        SL_ASSERT_TRUE(fequal((double)y.data[i], expected));
+        SL_ASSERT_TRUE(fequal((double)x.data[i], (double)i - 4));
+      }
+    }
+  }
+  return true;
+}
+
+SL_TEST(test_matrix_row_axpy) {
+  struct sl_matrix_f32 a = {
+      .length   = {3, 2},
+      .capacity = {3, 2},
+      .data     = (float[]){1, 2, 3, 4, 5, 6},
+  };
+  struct sl_vector_f32 y = {
+      .length   = {2},
+      .capacity = {2},
+      .data     = (float[]){1, 1},
+  };
+  sl_la_matrix_row_axpy(&a, 1, 2, &y);
+  struct sl_vector_f32 expected = {
+      .length   = {2},
+      .capacity = {2},
+      .data     = (float[]){7, 9},
+  };
+  if (!check_vector_equal(ctx, &y, &expected)) {
+    return false;
+  }
+  sl_la_matrix_row_axpy(&a, 2, -1, &y);
+  expected.data[0] = 2;
+  expected.data[1] = 3;
+  if (!check_vector_equal(ctx, &y, &expected)) {
+    return false;
+  }
+  return true;
+}
+
 SL_TEST(test_vector_equal) {
   (void)ctx;
   {
@@ -535,4 +619,255 @@ SL_TEST(test_vector_sub) {
   return true;
 }
 
+SL_TEST(test_simd_kernels) {
+  (void)ctx;
+  const struct sl_la_simd_kernels* const scalar = sl_la_simd_get(0);
+  SL_ASSERT_TRUE(sl_la_simd_count() >= 2);
+  SL_ASSERT_TRUE(sl_la_simd_get(sl_la_simd_count()) == nullptr);
+  SL_ASSERT_TRUE(sl_la_simd_best()->is_supported());
+
+  // small integers and quarters, such that every kernel is exact regardless of summation order
+  enum { max_count = 75 };
+  float x[max_count]        = {0};
+  float y[max_count]        = {0};
+  float expected[max_count] = {0};
+  float actual[max_count]   = {0};
+  for (size_t i = 0; i < max_count; ++i) {
+    x[i] = (float)((i * 7) % 13) - 6;
+    y[i] = ((float)((i * 5) % 11) - 5) / 4;
+  }
+
+  for (size_t k = 0; k < sl_la_simd_count(); ++k) {
+    const struct sl_la_simd_kernels* const kernels = sl_la_simd_get(k);
+    if (!kernels->is_supported()) {
+      continue;
+    }
+    // every count up to a few full iterations of the widest vectors, then the tails
+    for (size_t count = 0; count <= max_count; ++count) {
+      const size_t bytes = count * sizeof(float);
+
+      memcpy(expected, x, bytes);
+      memcpy(actual, x, bytes);
+      scalar->add(count, expected, y);
+      kernels->add(count, actual, y);
+      SL_ASSERT_TRUE(memcmp(actual, expected, bytes) == 0);
+
+      memcpy(expected, x, bytes);
+      memcpy(actual, x, bytes);
+      scalar->sub(count, expected, y);
+      kernels->sub(count, actual, y);
+      SL_ASSERT_TRUE(memcmp(actual, expected, bytes) == 0);
+
+      memcpy(expected, x, bytes);
+      memcpy(actual, x, bytes);
+      scalar->mul(count, expected, y);
+      kernels->mul(count, actual, y);
+      SL_ASSERT_TRUE(memcmp(actual, expected, bytes) == 0);
+
+      memcpy(expected, x, bytes);
+      memcpy(actual, x, bytes);
+      scalar->scale(count, expected, -0.5f);
+      kernels->scale(count, actual, -0.5f);
+      SL_ASSERT_TRUE(memcmp(actual, expected, bytes) == 0);
+
+      memcpy(expected, x, bytes);
+      memcpy(actual, x, bytes);
+      scalar->axpby(count, 0.25f, y, -2, expected);
+      kernels->axpby(count, 0.25f, y, -2, actual);
+      SL_ASSERT_TRUE(memcmp(actual, expected, bytes) == 0);
+
+      SL_ASSERT_TRUE(fequal(
+          (double)kernels->dot(count, x, y),
+          (double)scalar->dot(count, x, y)
+      ));
+    }
+
+    // like fminf and fmaxf, NaNs in either operand are ignored by min and max,
+    // also in every lane of the vectors, and lanes where both are NaN stay NaN
+    float x_nan[max_count] = {0};
+    float y_nan[max_count] = {0};
+    memcpy(x_nan, x, sizeof(x));
+    memcpy(y_nan, y, sizeof(y));
+    for (size_t i = 0; i < max_count; i += 3) {
+      y_nan[i] = NAN;
+    }
+    for (size_t i = 0; i < max_count; i += 5) {
+      x_nan[i] = NAN;
+    }
+    memcpy(actual, x_nan, sizeof(x_nan));
+    kernels->min(max_count, actual, y_nan);
+    for (size_t i = 0; i < max_count; ++i) {
+      const float expect = fminf(x_nan[i], y_nan[i]);
+      SL_ASSERT_TRUE(isnan(expect) ? isnan(actual[i]) : fequal((double)actual[i], (double)expect));
+    }
+    memcpy(actual, x_nan, sizeof(x_nan));
+    kernels->max(max_count, actual, y_nan);
+    for (size_t i = 0; i < max_count; ++i) {
+      const float expect = fmaxf(x_nan[i], y_nan[i]);
+      SL_ASSERT_TRUE(isnan(expect) ? isnan(actual[i]) : fequal((double)actual[i], (double)expect));
+    }
+  }
+  return true;
+}
+
+SL_TEST(test_csr_row_dot_axpy) {
+  (void)ctx;
+  // 0 2 0 0 1
+  // 0 0 0 0 0
+  // 3 0 0 -1 0
+  struct sl_csr_f32 a = {
+      .num_rows     = 3,
+      .num_cols     = 5,
+      .row_capacity = 3,
+      .nnz_capacity = 4,
+      .row_ptr      = (size_t[]){0, 2, 2, 4},
+      .col_idx      = (uint32_t[]){1, 4, 0, 3},
+      .values       = (float[]){2, 1, 3, -1},
+  };
+  struct sl_vector_f32 v = {
+      .length   = {5},
+      .capacity = {5},
+      .data     = (float[]){1, 2, 3, 4, 5},
+  };
+  SL_ASSERT_TRUE(fequal((double)sl_la_csr_row_dot(&a, 0, &v), 9));
+  SL_ASSERT_TRUE(fequal((double)sl_la_csr_row_dot(&a, 1, &v), 0));
+  SL_ASSERT_TRUE(fequal((double)sl_la_csr_row_dot(&a, 2, &v), -1));
+
+  sl_la_csr_row_axpy(&a, 0, 2, &v);
+  sl_la_csr_row_axpy(&a, 1, 2, &v);
+  sl_la_csr_row_axpy(&a, 2, -1, &v);
+  struct sl_vector_f32 expected = {
+      .length   = {5},
+      .capacity = {5},
+      .data     = (float[]){-2, 6, 3, 5, 7},
+  };
+  if (!check_vector_equal(ctx, &v, &expected)) {
+    return false;
+  }
+  return true;
+}
+
+SL_TEST(test_csr_vector_multiply) {
+  (void)ctx;
+  struct sl_csr_f32 a = {
+      .num_rows     = 3,
+      .num_cols     = 5,
+      .row_capacity = 3,
+      .nnz_capacity = 4,
+      .row_ptr      = (size_t[]){0, 2, 2, 4},
+      .col_idx      = (uint32_t[]){1, 4, 0, 3},
+      .values       = (float[]){2, 1, 3, -1},
+  };
+  struct sl_vector_f32 x = {
+      .length   = {5},
+      .capacity = {5},
+      .data     = (float[]){1, 2, 3, 4, 5},
+  };
+  struct sl_vector_f32 result = {
+      .length   = {3},
+      .capacity = {3},
+      .data     = (float[]){-1, -1, -1},
+  };
+  sl_la_csr_vector_multiply(&a, &x, &result);
+  struct sl_vector_f32 expected = {
+      .length   = {3},
+      .capacity = {3},
+      .data     = (float[]){9, 0, -1},
+  };
+  if (!check_vector_equal(ctx, &result, &expected)) {
+    return false;
+  }
+
+  struct sl_matrix_f32 dense = {
+      .length   = {3, 5},
+      .capacity = {3, 5},
+      .data     = (float[3 * 5]){0},
+  };
+  sl_la_csr_to_dense(&dense, &a);
+  sl_la_matrix_vector_multiply(&dense, &x, &result);
+  return check_vector_equal(ctx, &result, &expected);
+}
+
+SL_TEST(test_csr_matrix_multiply) {
+  (void)ctx;
+  struct sl_csr_f32 a = {
+      .num_rows     = 3,
+      .num_cols     = 5,
+      .row_capacity = 3,
+      .nnz_capacity = 4,
+      .row_ptr      = (size_t[]){0, 2, 2, 4},
+      .col_idx      = (uint32_t[]){1, 4, 0, 3},
+      .values       = (float[]){2, 1, 3, -1},
+  };
+  struct sl_matrix_f32 b = {
+      .length   = {5, 2},
+      .capacity = {5, 2},
+      .data     = (float[]){1, -1, 2, -2, 3, -3, 4, -4, 5, -5},
+  };
+  struct sl_matrix_f32 result = {
+      .length   = {3, 2},
+      .capacity = {3, 2},
+      .data     = (float[]){-1, -1, -1, -1, -1, -1},
+  };
+  sl_la_csr_matrix_multiply(&a, &b, &result);
+  struct sl_matrix_f32 expected = {
+      .length   = {3, 2},
+      .capacity = {3, 2},
+      .data     = (float[]){9, -9, 0, 0, -1, 1},
+  };
+  if (!check_matrix_equal(ctx, &result, &expected)) {
+    return false;
+  }
+
+  struct sl_matrix_f32 dense = SL_LA_MATRIX_CREATE_INLINE(3, 5);
+  sl_la_csr_to_dense(&dense, &a);
+  sl_la_matrix_multiply(&dense, &b, &result);
+  return check_matrix_equal(ctx, &result, &expected);
+}
+
+SL_TEST(test_csr_row_outer_add) {
+  (void)ctx;
+  struct sl_csr_f32 a = {
+      .num_rows     = 3,
+      .num_cols     = 5,
+      .row_capacity = 3,
+      .nnz_capacity = 4,
+      .row_ptr      = (size_t[]){0, 2, 2, 4},
+      .col_idx      = (uint32_t[]){1, 4, 0, 3},
+      .values       = (float[]){2, 1, 3, -1},
+  };
+  struct sl_matrix_f32 dense = SL_LA_MATRIX_CREATE_INLINE(3, 5);
+  sl_la_csr_to_dense(&dense, &a);
+  struct sl_matrix_f32 x = {
+      .length   = {3, 2},
+      .capacity = {3, 2},
+      .data     = (float[]){1, 2, 3, 4, -1, 0.5f},
+  };
+  struct sl_matrix_f32 result = {
+      .length   = {5, 2},
+      .capacity = {5, 2},
+      .data     = (float[]){1, -1, 2, -2, 3, -3, 4, -4, 5, -5},
+  };
+  struct sl_matrix_f32 expected = {
+      .length   = {5, 2},
+      .capacity = {5, 2},
+      .data     = (float[]){-2, 0.5f, 4, 2, 3, -3, 5, -4.5f, 6, -3},
+  };
+  for (size_t row = 0; row < 3; ++row) {
+    struct sl_vector_f32 x_row = sl_la_matrix_row_view(&x, row);
+    sl_la_csr_row_outer_add(&a, row, &x_row, &result);
+  }
+  if (!check_matrix_equal(ctx, &result, &expected)) {
+    return false;
+  }
+
+  struct sl_matrix_f32 b = {
+      .length   = {5, 2},
+      .capacity = {5, 2},
+      .data     = (float[]){1, -1, 2, -2, 3, -3, 4, -4, 5, -5},
+  };
+  sl_la_matrix_transpose_multiply_add(&dense, &x, &b);
+  return check_matrix_equal(ctx, &b, &expected);
+}
+
 SL_TEST_MAIN()
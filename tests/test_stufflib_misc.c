@@ -0,0 +1,50 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stufflib/macros/macros.h>
+#include <stufflib/misc/misc.h>
+#include <stufflib/testing/testing.h>
+
+SL_TEST(test_is_zero) {
+  (void)ctx;
+  unsigned char data[19] = {0};
+  SL_ASSERT_TRUE(sl_misc_is_zero(sizeof(data), data));
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = 1;
+    SL_ASSERT_TRUE(!sl_misc_is_zero(sizeof(data), data));
+    SL_ASSERT_TRUE(sl_misc_is_zero(i, data));
+    data[i] = 0;
+  }
+  return true;
+}
+
+SL_TEST(test_next_nonzero) {
+  (void)ctx;
+  {
+    float data[37] = {0};
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(sizeof(float), SL_ARRAY_LEN(data), (void*)data, 0), 37);
+    data[0]  = 1;
+    data[17] = -1;
+    data[36] = 2;
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(sizeof(float), SL_ARRAY_LEN(data), (void*)data, 0), 0);
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(sizeof(float), SL_ARRAY_LEN(data), (void*)data, 1), 17);
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(sizeof(float), SL_ARRAY_LEN(data), (void*)data, 18), 36);
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(sizeof(float), SL_ARRAY_LEN(data), (void*)data, 37), 37);
+    SL_ASSERT_EQ_LL(sl_misc_count_nonzero(sizeof(float), SL_ARRAY_LEN(data), (void*)data), 3);
+  }
+  {
+    // items that do not divide a 64-bit word
+    unsigned char data[3 * 11] = {0};
+    data[3 * 4 + 2]            = 1;
+    data[3 * 9]                = 1;
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(3, 11, data, 0), 4);
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(3, 11, data, 5), 9);
+    SL_ASSERT_EQ_LL(sl_misc_next_nonzero(3, 11, data, 10), 11);
+    SL_ASSERT_EQ_LL(sl_misc_count_nonzero(3, 11, data), 2);
+  }
+  return true;
+}
+
+SL_TEST_MAIN()
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <stufflib/macros/macros.h>
 #include <stufflib/testing/testing.h>
@@ -10,9 +11,14 @@
 
 #include <stufflib/linalg/linalg.h>
 #include <stufflib/math/math.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
+#include <stufflib/misc/misc.h>
 #include <stufflib/ml/ml.h>
+#include <stufflib/ml/model.h>
 #include <stufflib/random/random.h>
+#include <stufflib/record/record.h>
+#include <stufflib/record/writer.h>
 #include <stufflib/vector/sl_vector_f32.h>
 
 bool check_vector_equal(
@@ -175,6 +181,37 @@ SL_TEST(test_minmax_normalization) {
   return true;
 }
 
+SL_TEST(test_minmax_merge) {
+  (void)ctx;
+  struct sl_matrix_f32 a = {
+      .length   = {4, 3},
+      .capacity = {4, 3},
+      .data     = (float[]){6, 2, -1, 3, 3, -8, 1, 6, 10, 8, 10, -4},
+  };
+  struct sl_ml_minmax_scaler full = SL_ML_MINMAX_SCALER_CREATE_INLINE(3);
+  sl_ml_minmax_reset(&full);
+  sl_ml_minmax_fit(&full, &a);
+  // the reset range is empty, zeros are not included
+  SL_ASSERT_TRUE(sl_math_double_almost((double)full.lo.data[0], 1, SL_LA_FLOAT_EQ_TOL));
+  SL_ASSERT_TRUE(sl_math_double_almost((double)full.lo.data[1], 2, SL_LA_FLOAT_EQ_TOL));
+  SL_ASSERT_TRUE(sl_math_double_almost((double)full.hi.data[2], 10, SL_LA_FLOAT_EQ_TOL));
+
+  for (size_t split = 0; split <= 4; ++split) {
+    struct sl_ml_minmax_scaler head = SL_ML_MINMAX_SCALER_CREATE_INLINE(3);
+    struct sl_ml_minmax_scaler tail = SL_ML_MINMAX_SCALER_CREATE_INLINE(3);
+    sl_ml_minmax_reset(&head);
+    sl_ml_minmax_reset(&tail);
+    for (size_t row = 0; row < 4; ++row) {
+      struct sl_vector_f32 x = sl_la_matrix_row_view(&a, row);
+      sl_ml_minmax_fit_vector(row < split ? &head : &tail, &x);
+    }
+    sl_ml_minmax_merge(&head, &tail);
+    SL_ASSERT_TRUE(sl_la_vector_equal(&(head.lo), &(full.lo)));
+    SL_ASSERT_TRUE(sl_la_vector_equal(&(head.hi), &(full.hi)));
+  }
+  return true;
+}
+
 SL_TEST(test_random_train_test_split) {
   uint64_t prng = 0;
   sl_random_pcg32_init(&prng, 0);
@@ -246,7 +283,6 @@ SL_TEST(test_svm_linear_fit) {
         struct sl_ml_svm svm = {
             .w              = SL_LA_VECTOR_CREATE_INLINE(3),
             .s              = SL_LA_VECTOR_CREATE_INLINE(3),
-            .x              = SL_LA_VECTOR_CREATE_INLINE(3),
             .shuffle_buffer = (size_t[4]){0},
             .batch_size     = batch_size,
             .n_epochs       = n_epochs,
@@ -264,4 +300,782 @@ SL_TEST(test_svm_linear_fit) {
   return true;
 }
 
+SL_TEST(test_svm_linear_fit_csr) {
+  (void)ctx;
+  // 1 0 3
+  // 0 5 6
+  // -3 0 0
+  // -6 -5 0
+  struct sl_matrix_f32 dense = {
+      .length   = {4, 3},
+      .capacity = {4, 3},
+      .data     = (float[]){1, 0, 3, 0, 5, 6, -3, 0, 0, -6, -5, 0},
+  };
+  struct sl_csr_f32 sparse = {
+      .num_rows     = 4,
+      .num_cols     = 3,
+      .row_capacity = 4,
+      .nnz_capacity = 7,
+      .row_ptr      = (size_t[]){0, 2, 4, 5, 7},
+      .col_idx      = (uint32_t[]){0, 2, 1, 2, 0, 0, 1},
+      .values       = (float[]){1, 3, 5, 6, -3, -6, -5},
+  };
+  uint16_t classes[4] = {1, 1, 0, 0};
+
+  uint64_t prng_dense  = 0;
+  uint64_t prng_sparse = 0;
+  sl_random_pcg32_init(&prng_dense, 0);
+  sl_random_pcg32_init(&prng_sparse, 0);
+  for (int iter = 0; iter < 100; ++iter) {
+    for (int batch_size = 1; batch_size < 3; ++batch_size) {
+      for (int n_epochs = 1; n_epochs < 10; ++n_epochs) {
+        struct sl_ml_svm svm_dense = {
+            .w              = SL_LA_VECTOR_CREATE_INLINE(3),
+            .s              = SL_LA_VECTOR_CREATE_INLINE(3),
+            .shuffle_buffer = (size_t[4]){0},
+            .batch_size     = batch_size,
+            .n_epochs       = n_epochs,
+            .learning_rate  = 1e-6f,
+        };
+        struct sl_ml_svm svm_sparse = {
+            .w              = SL_LA_VECTOR_CREATE_INLINE(3),
+            .shuffle_buffer = (size_t[4]){0},
+            .batch_size     = batch_size,
+            .n_epochs       = n_epochs,
+            .learning_rate  = 1e-6f,
+        };
+        sl_ml_svm_linear_fit(&prng_dense, &svm_dense, &dense, classes);
+        sl_ml_svm_linear_fit_csr(&prng_sparse, &svm_sparse, &sparse, classes);
+
+        // same shuffles and updates, up to rounding
+        for (size_t i = 0; i < 3; ++i) {
+          const double w_dense  = (double)svm_dense.w.data[i];
+          const double w_sparse = (double)svm_sparse.w.data[i];
+          SL_ASSERT_TRUE(fabs(w_dense - w_sparse) <= 1e-3 * fmax(1, fabs(w_dense)));
+        }
+        for (size_t i = 0; i < 4; ++i) {
+          SL_ASSERT_TRUE(svm_sparse.shuffle_buffer[i] == svm_dense.shuffle_buffer[i]);
+          struct sl_vector_f32 x = sl_la_matrix_row_view(&dense, i);
+          SL_ASSERT_TRUE(
+              sl_ml_svm_binary_predict(&svm_dense, &x)
+              == sl_ml_svm_binary_predict_csr(&svm_sparse, &sparse, i)
+          );
+        }
+      }
+    }
+  }
+  return true;
+}
+
+SL_TEST(test_svm_linear_fit_parallel) {
+  // 1 0 3
+  // 0 5 6
+  // -3 0 0
+  // -6 -5 0
+  struct sl_csr_f32 data = {
+      .num_rows     = 4,
+      .num_cols     = 3,
+      .row_capacity = 4,
+      .nnz_capacity = 7,
+      .row_ptr      = (size_t[]){0, 2, 4, 5, 7},
+      .col_idx      = (uint32_t[]){0, 2, 1, 2, 0, 0, 1},
+      .values       = (float[]){1, 3, 5, 6, -3, -6, -5},
+  };
+  uint16_t classes[4] = {1, 1, 0, 0};
+
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  for (size_t n_threads = 1; n_threads <= 4; ++n_threads) {
+    for (size_t sync_steps = 0; sync_steps < 10; sync_steps += 3) {
+      struct sl_ml_svm svm = {
+          .w             = SL_LA_VECTOR_CREATE_INLINE(3),
+          .batch_size    = 1,
+          .n_epochs      = 100,
+          .learning_rate = 1e-3f,
+      };
+      SL_ASSERT_TRUE(
+          sl_ml_svm_linear_fit_parallel(ctx, &prng, &svm, &data, classes, n_threads, sync_steps)
+      );
+      SL_ASSERT_TRUE(sl_la_vector_is_finite(&(svm.w)));
+      for (size_t i = 0; i < 4; ++i) {
+        SL_ASSERT_TRUE(classes[i] == sl_ml_svm_binary_predict_csr(&svm, &data, i));
+      }
+    }
+  }
+
+  // with one worker, averaging changes nothing
+  struct sl_ml_svm svm_hogwild = {
+      .w             = SL_LA_VECTOR_CREATE_INLINE(3),
+      .batch_size    = 1,
+      .n_epochs      = 10,
+      .learning_rate = 1e-3f,
+  };
+  struct sl_ml_svm svm_averaging = svm_hogwild;
+  svm_averaging.w                = SL_LA_VECTOR_CREATE_INLINE(3);
+  uint64_t prng_hogwild          = prng;
+  uint64_t prng_averaging        = prng;
+  SL_ASSERT_TRUE(
+      sl_ml_svm_linear_fit_parallel(ctx, &prng_hogwild, &svm_hogwild, &data, classes, 1, 0)
+  );
+  SL_ASSERT_TRUE(
+      sl_ml_svm_linear_fit_parallel(ctx, &prng_averaging, &svm_averaging, &data, classes, 1, 3)
+  );
+  SL_ASSERT_TRUE(sl_la_vector_equal(&(svm_hogwild.w), &(svm_averaging.w)));
+
+  SL_ASSERT_FALSE(sl_ml_svm_linear_fit_parallel(ctx, &prng, &svm_hogwild, &data, classes, 0, 0));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot fit SVM with 0 threads");
+  // every worker needs at least one mini-batch of rows
+  SL_ASSERT_FALSE(sl_ml_svm_linear_fit_parallel(ctx, &prng, &svm_hogwild, &data, classes, 5, 0));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot fit SVM with 5 threads");
+  return true;
+}
+
+SL_TEST(test_classification_update_scores) {
+  (void)ctx;
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  for (size_t n = 0; n < 100; ++n) {
+    float scores[100]     = {0};
+    uint16_t classes[100] = {0};
+    for (size_t i = 0; i < n; ++i) {
+      scores[i]  = (float)sl_random_int(&prng, 0, 5) - 2;
+      classes[i] = (uint16_t)sl_random_int(&prng, 0, 2);
+    }
+    struct sl_ml_classification expected = {0};
+    for (size_t i = 0; i < n; ++i) {
+      sl_ml_classification_update(&expected, scores[i] > 0, classes[i]);
+    }
+    struct sl_ml_classification cls = {.tp = 1, .tn = 2, .fp = 3, .fn = 4};
+    sl_ml_classification_update_scores(&cls, n, scores, classes);
+    SL_ASSERT_EQ_LL(cls.tp, expected.tp + 1);
+    SL_ASSERT_EQ_LL(cls.tn, expected.tn + 2);
+    SL_ASSERT_EQ_LL(cls.fp, expected.fp + 3);
+    SL_ASSERT_EQ_LL(cls.fn, expected.fn + 4);
+  }
+  return true;
+}
+
+SL_TEST(test_svm_scores) {
+  (void)ctx;
+  struct sl_matrix_f32 dense = {
+      .length   = {4, 3},
+      .capacity = {4, 3},
+      .data     = (float[]){1, 0, 3, 0, 5, 6, -3, 0, 0, -6, -5, 0},
+  };
+  struct sl_csr_f32 sparse = {
+      .num_rows     = 4,
+      .num_cols     = 3,
+      .row_capacity = 4,
+      .nnz_capacity = 7,
+      .row_ptr      = (size_t[]){0, 2, 4, 5, 7},
+      .col_idx      = (uint32_t[]){0, 2, 1, 2, 0, 0, 1},
+      .values       = (float[]){1, 3, 5, 6, -3, -6, -5},
+  };
+  struct sl_ml_svm svm = {
+      .w = {.length = {3}, .capacity = {3}, .data = (float[]){1, -1, 0.5f}},
+  };
+  struct sl_vector_f32 expected = {
+      .length   = {4},
+      .capacity = {4},
+      .data     = (float[]){2.5f, -2, -3, -1},
+  };
+  struct sl_vector_f32 scores = SL_LA_VECTOR_CREATE_INLINE(4);
+  sl_ml_svm_scores(&svm, &dense, &scores);
+  SL_ASSERT_TRUE(sl_la_vector_equal(&scores, &expected));
+  for (size_t i = 0; i < 4; ++i) {
+    struct sl_vector_f32 x = sl_la_matrix_row_view(&dense, i);
+    SL_ASSERT_TRUE(sl_ml_svm_binary_predict(&svm, &x) == (scores.data[i] > 0));
+  }
+  sl_la_vector_clear(&scores);
+  sl_ml_svm_scores_csr(&svm, &sparse, &scores);
+  SL_ASSERT_TRUE(sl_la_vector_equal(&scores, &expected));
+  return true;
+}
+
+SL_TEST(test_svm_ovr_fit) {
+  (void)ctx;
+  // 1 0 3
+  // 0 5 6
+  // -3 0 0
+  // -6 -5 0
+  struct sl_matrix_f32 dense = {
+      .length   = {4, 3},
+      .capacity = {4, 3},
+      .data     = (float[]){1, 0, 3, 0, 5, 6, -3, 0, 0, -6, -5, 0},
+  };
+  struct sl_csr_f32 sparse = {
+      .num_rows     = 4,
+      .num_cols     = 3,
+      .row_capacity = 4,
+      .nnz_capacity = 7,
+      .row_ptr      = (size_t[]){0, 2, 4, 5, 7},
+      .col_idx      = (uint32_t[]){0, 2, 1, 2, 0, 0, 1},
+      .values       = (float[]){1, 3, 5, 6, -3, -6, -5},
+  };
+  uint16_t classes[4] = {1, 1, 0, 0};
+  // class 1 is the binary problem and class 0 its complement
+  uint8_t labels[4 * 2] = {0, 1, 0, 1, 1, 0, 1, 0};
+
+  uint64_t prng_binary = 0;
+  uint64_t prng_dense  = 0;
+  uint64_t prng_sparse = 0;
+  sl_random_pcg32_init(&prng_binary, 0);
+  sl_random_pcg32_init(&prng_dense, 0);
+  sl_random_pcg32_init(&prng_sparse, 0);
+  for (int iter = 0; iter < 100; ++iter) {
+    for (int batch_size = 1; batch_size < 3; ++batch_size) {
+      for (int n_epochs = 1; n_epochs < 10; ++n_epochs) {
+        struct sl_ml_svm svm = {
+            .w              = SL_LA_VECTOR_CREATE_INLINE(3),
+            .s              = SL_LA_VECTOR_CREATE_INLINE(3),
+            .shuffle_buffer = (size_t[4]){0},
+            .batch_size     = batch_size,
+            .n_epochs       = n_epochs,
+            .learning_rate  = 1e-6f,
+        };
+        struct sl_ml_svm_ovr ovr_dense = {
+            .w              = SL_LA_MATRIX_CREATE_INLINE(3, 2),
+            .x              = SL_LA_MATRIX_CREATE_INLINE(2, 3),
+            .s              = SL_LA_MATRIX_CREATE_INLINE(2, 2),
+            .shuffle_buffer = (size_t[4]){0},
+            .batch_size     = batch_size,
+            .n_epochs       = n_epochs,
+            .learning_rate  = 1e-6f,
+        };
+        struct sl_ml_svm_ovr ovr_sparse = {
+            .w              = SL_LA_MATRIX_CREATE_INLINE(3, 2),
+            .s              = SL_LA_MATRIX_CREATE_INLINE(2, 2),
+            .shuffle_buffer = (size_t[4]){0},
+            .batch_size     = batch_size,
+            .n_epochs       = n_epochs,
+            .learning_rate  = 1e-6f,
+        };
+        ovr_dense.x.length[0]  = (size_t)batch_size;
+        ovr_dense.s.length[0]  = (size_t)batch_size;
+        ovr_sparse.s.length[0] = (size_t)batch_size;
+        sl_ml_svm_linear_fit(&prng_binary, &svm, &dense, classes);
+        sl_ml_svm_ovr_fit(&prng_dense, &ovr_dense, &dense, labels);
+        sl_ml_svm_ovr_fit_csr(&prng_sparse, &ovr_sparse, &sparse, labels);
+
+        // same shuffles and updates as the binary fit, up to rounding
+        for (size_t i = 0; i < 3; ++i) {
+          const double w_binary = (double)svm.w.data[i];
+          const double w_dense  = (double)*sl_matrix_f32_get(&(ovr_dense.w), i, 1);
+          const double w_sparse = (double)*sl_matrix_f32_get(&(ovr_sparse.w), i, 1);
+          const double w_other  = (double)*sl_matrix_f32_get(&(ovr_dense.w), i, 0);
+          SL_ASSERT_TRUE(fabs(w_binary - w_dense) <= 1e-3 * fmax(1, fabs(w_binary)));
+          SL_ASSERT_TRUE(fabs(w_binary - w_sparse) <= 1e-3 * fmax(1, fabs(w_binary)));
+          SL_ASSERT_TRUE(fabs(w_dense + w_other) <= 1e-3 * fmax(1, fabs(w_dense)));
+        }
+        for (size_t i = 0; i < 4; ++i) {
+          SL_ASSERT_TRUE(ovr_dense.shuffle_buffer[i] == svm.shuffle_buffer[i]);
+          SL_ASSERT_TRUE(ovr_sparse.shuffle_buffer[i] == svm.shuffle_buffer[i]);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+SL_TEST(test_svm_ovr_predict) {
+  (void)ctx;
+  // three clusters with a constant bias feature
+  struct sl_matrix_f32 dense = {
+      .length   = {6, 3},
+      .capacity = {6, 3},
+      .data     = (float[]){4, 0, 1, 5, 1, 1, 0, 4, 1, 1, 5, 1, -4, -4, 1, -5, -4, 1},
+  };
+  struct sl_csr_f32 sparse = {
+      .num_rows     = 6,
+      .num_cols     = 3,
+      .row_capacity = 6,
+      .nnz_capacity = 16,
+      .row_ptr      = (size_t[]){0, 2, 5, 7, 10, 13, 16},
+      .col_idx      = (uint32_t[]){0, 2, 0, 1, 2, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2},
+      .values       = (float[]){4, 1, 5, 1, 1, 4, 1, 1, 5, 1, -4, -4, 1, -5, -4, 1},
+  };
+  uint16_t classes[6]   = {0, 0, 1, 1, 2, 2};
+  uint8_t labels[6 * 3] = {1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1};
+
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  for (int batch_size = 1; batch_size < 4; ++batch_size) {
+    struct sl_ml_svm_ovr svm = {
+        .w              = SL_LA_MATRIX_CREATE_INLINE(3, 3),
+        .x              = SL_LA_MATRIX_CREATE_INLINE(3, 3),
+        .s              = SL_LA_MATRIX_CREATE_INLINE(3, 3),
+        .shuffle_buffer = (size_t[6]){0},
+        .batch_size     = batch_size,
+        .n_epochs       = 100,
+        .learning_rate  = 1e-2f,
+    };
+    svm.x.length[0] = (size_t)batch_size;
+    svm.s.length[0] = (size_t)batch_size;
+    sl_ml_svm_ovr_fit(&prng, &svm, &dense, labels);
+
+    struct sl_matrix_f32 scores        = SL_LA_MATRIX_CREATE_INLINE(6, 3);
+    struct sl_matrix_f32 sparse_scores = SL_LA_MATRIX_CREATE_INLINE(6, 3);
+    sl_ml_svm_ovr_scores(&svm, &dense, &scores);
+    sl_ml_svm_ovr_scores_csr(&svm, &sparse, &sparse_scores);
+    SL_ASSERT_TRUE(sl_la_matrix_equal(&scores, &sparse_scores));
+    for (size_t i = 0; i < 6; ++i) {
+      SL_ASSERT_EQ_LL(sl_ml_svm_ovr_predict(&scores, i), classes[i]);
+    }
+  }
+  return true;
+}
+
+// ASGD with explicit shrinking and averaging of every weight in every step
+static void linear_fit_reference(
+    uint64_t prng[static 1],
+    struct sl_ml_linear model[const static 1],
+    struct sl_matrix_f32 data[const static 1],
+    const uint16_t classes[const static 1]
+) {
+  const size_t n_rows = sl_matrix_f32_num_rows(data);
+  const size_t n_cols = sl_matrix_f32_num_cols(data);
+  for (size_t i = 0; i < n_rows; ++i) {
+    model->shuffle_buffer[i] = i;
+  }
+  const double eta0   = (double)model->learning_rate;
+  const double lambda = (double)model->lambda;
+  for (int epoch = 0; epoch < model->n_epochs; ++epoch) {
+    sl_random_shuffle(prng, model->shuffle_buffer, sizeof(size_t), n_rows);
+    for (size_t i = 0; i < n_rows; ++i) {
+      const size_t row       = model->shuffle_buffer[i];
+      struct sl_vector_f32 x = sl_la_matrix_row_view(data, row);
+      const double y         = (classes[row] == 1) ? 1 : -1;
+      const double eta = eta0 / pow(1 + (lambda * eta0 * (double)model->n_steps), 0.75);
+      const double z   = y * (double)sl_la_vector_dot(&(model->w), &x);
+      double g         = 0;
+      switch (model->loss) {
+        case sl_ml_loss_hinge: {
+          g = (z < 1) ? 1 : 0;
+        } break;
+        case sl_ml_loss_logistic: {
+          g = 1 / (1 + exp(z));
+        } break;
+        case sl_ml_loss_squared_hinge: {
+          g = (z < 1) ? 1 - z : 0;
+        } break;
+      }
+      const double mu = 1 / fmax(1, (double)model->n_steps - (double)model->average_begin + 1);
+      for (size_t j = 0; j < n_cols; ++j) {
+        const double w = ((1 - (eta * lambda)) * (double)model->w.data[j])
+                         + (eta * g * y * (double)x.data[j]);
+        model->w.data[j] = (float)w;
+        model->a.data[j] = (float)(((1 - mu) * (double)model->a.data[j]) + (mu * w));
+      }
+      ++model->n_steps;
+    }
+  }
+}
+
+SL_TEST(test_linear_fit_csr) {
+  (void)ctx;
+  // 1 0 3
+  // 0 5 6
+  // -3 0 0
+  // -6 -5 0
+  struct sl_matrix_f32 dense = {
+      .length   = {4, 3},
+      .capacity = {4, 3},
+      .data     = (float[]){1, 0, 3, 0, 5, 6, -3, 0, 0, -6, -5, 0},
+  };
+  struct sl_csr_f32 sparse = {
+      .num_rows     = 4,
+      .num_cols     = 3,
+      .row_capacity = 4,
+      .nnz_capacity = 7,
+      .row_ptr      = (size_t[]){0, 2, 4, 5, 7},
+      .col_idx      = (uint32_t[]){0, 2, 1, 2, 0, 0, 1},
+      .values       = (float[]){1, 3, 5, 6, -3, -6, -5},
+  };
+  uint16_t classes[4] = {1, 1, 0, 0};
+
+  const enum sl_ml_loss losses[] = {
+      sl_ml_loss_hinge,
+      sl_ml_loss_logistic,
+      sl_ml_loss_squared_hinge,
+  };
+  // large lambdas shrink the weights enough to fold the scale during fitting
+  const float lambdas[]        = {1e-4f, 0.1f, 0.9f};
+  const size_t average_begin[] = {0, 3, 100};
+
+  uint64_t prng_reference = 0;
+  uint64_t prng_sparse    = 0;
+  sl_random_pcg32_init(&prng_reference, 0);
+  sl_random_pcg32_init(&prng_sparse, 0);
+  for (size_t l = 0; l < SL_ARRAY_LEN(losses); ++l) {
+    for (size_t k = 0; k < SL_ARRAY_LEN(lambdas); ++k) {
+      for (size_t b = 0; b < SL_ARRAY_LEN(average_begin); ++b) {
+        struct sl_ml_linear reference = {
+            .w              = SL_LA_VECTOR_CREATE_INLINE(3),
+            .a              = SL_LA_VECTOR_CREATE_INLINE(3),
+            .shuffle_buffer = (size_t[4]){0},
+            .loss           = losses[l],
+            .n_epochs       = 10,
+            .learning_rate  = 0.5f,
+            .lambda         = lambdas[k],
+            .average_begin  = average_begin[b],
+        };
+        struct sl_ml_linear model = reference;
+        model.w                   = (struct sl_vector_f32)SL_LA_VECTOR_CREATE_INLINE(3);
+        model.a                   = (struct sl_vector_f32)SL_LA_VECTOR_CREATE_INLINE(3);
+        model.shuffle_buffer      = (size_t[4]){0};
+
+        // fitting continues from the previous fit
+        for (int fit = 0; fit < 3; ++fit) {
+          linear_fit_reference(&prng_reference, &reference, &dense, classes);
+          sl_ml_linear_fit_csr(&prng_sparse, &model, &sparse, classes);
+          SL_ASSERT_EQ_LL(model.n_steps, reference.n_steps);
+          for (size_t i = 0; i < 3; ++i) {
+            const double w = (double)reference.w.data[i];
+            const double a = (double)reference.a.data[i];
+            SL_ASSERT_TRUE(fabs((double)model.w.data[i] - w) <= 1e-4 * fmax(1, fabs(w)));
+            SL_ASSERT_TRUE(fabs((double)model.a.data[i] - a) <= 1e-4 * fmax(1, fabs(a)));
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+SL_TEST(test_linear_average_begin) {
+  (void)ctx;
+  // 1 0 3
+  struct sl_csr_f32 data = {
+      .num_rows     = 1,
+      .num_cols     = 3,
+      .row_capacity = 1,
+      .nnz_capacity = 2,
+      .row_ptr      = (size_t[]){0, 2},
+      .col_idx      = (uint32_t[]){0, 2},
+      .values       = (float[]){1, 3},
+  };
+  uint16_t classes[1] = {1};
+
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  struct sl_ml_linear model = {
+      .w              = SL_LA_VECTOR_CREATE_INLINE(3),
+      .a              = SL_LA_VECTOR_CREATE_INLINE(3),
+      .shuffle_buffer = (size_t[1]){0},
+      .loss           = sl_ml_loss_hinge,
+      .n_epochs       = 1,
+      .learning_rate  = 0.5f,
+      .lambda         = 0.1f,
+      .average_begin  = 2,
+  };
+
+  // steps 0, 1 and 2 = average_begin, the average is the last iterate
+  for (int fit = 0; fit < 3; ++fit) {
+    sl_ml_linear_fit_csr(&prng, &model, &data, classes);
+    for (size_t i = 0; i < 3; ++i) {
+      const double w = (double)model.w.data[i];
+      SL_ASSERT_TRUE(fabs((double)model.a.data[i] - w) <= 1e-6 * fmax(1, fabs(w)));
+    }
+  }
+  SL_ASSERT_TRUE(model.w.data[0] > 0);
+
+  // step 3, the average of the iterates of steps 2 and 3
+  float w_prev[3] = {0};
+  for (size_t i = 0; i < 3; ++i) {
+    w_prev[i] = model.w.data[i];
+  }
+  sl_ml_linear_fit_csr(&prng, &model, &data, classes);
+  SL_ASSERT_EQ_LL(model.n_steps, 4);
+  for (size_t i = 0; i < 3; ++i) {
+    const double a = ((double)w_prev[i] + (double)model.w.data[i]) / 2;
+    SL_ASSERT_TRUE(fabs((double)model.a.data[i] - a) <= 1e-6 * fmax(1, fabs(a)));
+  }
+  return true;
+}
+
+SL_TEST(test_linear_predict) {
+  (void)ctx;
+  struct sl_csr_f32 data = {
+      .num_rows     = 4,
+      .num_cols     = 3,
+      .row_capacity = 4,
+      .nnz_capacity = 7,
+      .row_ptr      = (size_t[]){0, 2, 4, 5, 7},
+      .col_idx      = (uint32_t[]){0, 2, 1, 2, 0, 0, 1},
+      .values       = (float[]){1, 3, 5, 6, -3, -6, -5},
+  };
+  uint16_t classes[4] = {1, 1, 0, 0};
+
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  const enum sl_ml_loss losses[] = {
+      sl_ml_loss_hinge,
+      sl_ml_loss_logistic,
+      sl_ml_loss_squared_hinge,
+  };
+  for (size_t l = 0; l < SL_ARRAY_LEN(losses); ++l) {
+    struct sl_ml_linear model = {
+        .w              = SL_LA_VECTOR_CREATE_INLINE(3),
+        .a              = SL_LA_VECTOR_CREATE_INLINE(3),
+        .shuffle_buffer = (size_t[4]){0},
+        .loss           = losses[l],
+        .n_epochs       = 20,
+        .learning_rate  = 0.1f,
+        .lambda         = 1e-3f,
+        .average_begin  = 4,
+    };
+    sl_ml_linear_fit_csr(&prng, &model, &data, classes);
+
+    struct sl_vector_f32 scores = SL_LA_VECTOR_CREATE_INLINE(4);
+    sl_ml_linear_scores_csr(&model, &data, &scores);
+    struct sl_ml_classification cls = {0};
+    sl_ml_classification_update_scores(&cls, 4, scores.data, classes);
+    SL_ASSERT_EQ_LL(cls.tp, 2);
+    SL_ASSERT_EQ_LL(cls.tn, 2);
+
+    sl_ml_sigmoid(4, scores.data);
+    for (size_t i = 0; i < 4; ++i) {
+      SL_ASSERT_TRUE(0 < scores.data[i] && scores.data[i] < 1);
+      SL_ASSERT_TRUE((scores.data[i] > 0.5f) == (classes[i] == 1));
+    }
+  }
+  return true;
+}
+
+SL_TEST(test_kfold) {
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  struct sl_ml_kfold kfold = {0};
+  SL_ASSERT_TRUE(!sl_ml_kfold_create(ctx, &prng, 10, 1, &kfold));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot split 10 rows into 1 folds");
+  SL_ASSERT_TRUE(!sl_ml_kfold_create(ctx, &prng, 10, 11, &kfold));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot split 10 rows into 11 folds");
+
+  SL_ASSERT_TRUE(sl_ml_kfold_create(ctx, &prng, 10, 3, &kfold));
+  SL_ASSERT_EQ_LL(sl_ml_kfold_begin(&kfold, 0), 0);
+  SL_ASSERT_EQ_LL(sl_ml_kfold_begin(&kfold, 1), 3);
+  SL_ASSERT_EQ_LL(sl_ml_kfold_begin(&kfold, 2), 6);
+  SL_ASSERT_EQ_LL(sl_ml_kfold_begin(&kfold, 3), 10);
+
+  for (size_t fold = 0; fold < 3; ++fold) {
+    // every row is either a test row or a training row of the fold
+    int n_seen[10]       = {0};
+    size_t train[10]     = {0};
+    const size_t n_test  = sl_ml_kfold_begin(&kfold, fold + 1) - sl_ml_kfold_begin(&kfold, fold);
+    const size_t n_train = sl_ml_kfold_train_rows(&kfold, fold, train);
+    SL_ASSERT_EQ_LL(n_train + n_test, 10);
+    for (size_t i = 0; i < n_train; ++i) {
+      SL_ASSERT_TRUE(train[i] < 10);
+      ++n_seen[train[i]];
+    }
+    for (size_t i = 0; i < n_test; ++i) {
+      ++n_seen[kfold.rows[sl_ml_kfold_begin(&kfold, fold) + i]];
+    }
+    for (size_t i = 0; i < 10; ++i) {
+      SL_ASSERT_EQ_LL(n_seen[i], 1);
+    }
+  }
+  sl_ml_kfold_destroy(&kfold);
+  return true;
+}
+
+SL_TEST(test_svm_cross_validate) {
+  struct sl_matrix_f32 data = {
+      .length   = {12, 3},
+      .capacity = {12, 3},
+      // class 0 rows are the negated class 1 rows
+      .data = (float[]){1,  2,  3,  4,  5,  6,  2,  1,  3,  3,  3,  1,  1,  1,  1,  6,  5,  4,
+                        -1, -2, -3, -4, -5, -6, -2, -1, -3, -3, -3, -1, -1, -1, -1, -6, -5, -4},
+  };
+  uint16_t classes[12] = {1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0};
+
+  struct sl_ml_svm_grid grid = {
+      .n_learning_rates = 2,
+      .learning_rates   = (float[]){1e-6f, 1e-3f},
+      .n_batch_sizes    = 2,
+      .batch_sizes      = (int[]){1, 2},
+      .n_epoch_counts   = 3,
+      .epoch_counts     = (int[]){1, 2, 5},
+  };
+  SL_ASSERT_EQ_LL(sl_ml_svm_grid_size(&grid), 12);
+  struct sl_ml_svm svm = {0};
+  sl_ml_svm_grid_get(&grid, 10, &svm);
+  SL_ASSERT_TRUE(svm.learning_rate > 1e-4f);
+  SL_ASSERT_EQ_LL(svm.batch_size, 2);
+  SL_ASSERT_EQ_LL(svm.n_epochs, 2);
+
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 0);
+  struct sl_ml_kfold kfold = {0};
+  SL_ASSERT_TRUE(sl_ml_kfold_create(ctx, &prng, 12, 4, &kfold));
+
+  // same results with any number of threads
+  struct sl_ml_classification results[3][12 * 4] = {0};
+  const size_t n_threads[3]                       = {1, 3, 16};
+  for (size_t i = 0; i < 3; ++i) {
+    uint64_t prng_cv = prng;
+    SL_ASSERT_TRUE(sl_ml_svm_cross_validate(
+        ctx,
+        &prng_cv,
+        &grid,
+        &kfold,
+        &data,
+        classes,
+        n_threads[i],
+        results[i]
+    ));
+    SL_ASSERT_EQ_LL(memcmp(results[i], results[0], sizeof(results[0])), 0);
+  }
+
+  for (size_t c = 0; c < sl_ml_svm_grid_size(&grid); ++c) {
+    for (size_t fold = 0; fold < 4; ++fold) {
+      const struct sl_ml_classification cls = results[0][(c * 4) + fold];
+      SL_ASSERT_EQ_LL(cls.tp + cls.tn, 3);
+      SL_ASSERT_EQ_LL(cls.fp + cls.fn, 0);
+    }
+  }
+
+  SL_ASSERT_TRUE(
+      !sl_ml_svm_cross_validate(ctx, &prng, &grid, &kfold, &data, classes, 0, results[0])
+  );
+  SL_ASSERT_ERROR_OCCURRED(ctx, "cannot cross-validate SVM with 0 threads");
+  sl_ml_kfold_destroy(&kfold);
+  return true;
+}
+
+SL_TEST(test_svm_cross_validation_write) {
+  struct sl_ml_svm_grid grid = {
+      .n_learning_rates = 2,
+      .learning_rates   = (float[]){0.25f, 0.5f},
+      .n_batch_sizes    = 1,
+      .batch_sizes      = (int[]){2},
+      .n_epoch_counts   = 1,
+      .epoch_counts     = (int[]){3},
+  };
+  struct sl_ml_classification results[4] = {
+      {0},
+      {0},
+      {.tp = 1, .tn = 1},
+      {.tp = 1, .fp = 1},
+  };
+  struct sl_json_writer writer = {0};
+  SL_ASSERT_TRUE(sl_json_writer_create(ctx, &writer, nullptr, 64));
+  SL_ASSERT_TRUE(sl_ml_svm_cross_validation_write(ctx, &writer, &grid, 1, 2, results));
+  const char* const expected
+      = "{\"learning_rate\":0.5,\"batch_size\":2,\"n_epochs\":3,\"folds\":["
+        "{\"tp\":1,\"tn\":1,\"fp\":0,\"fn\":0,"
+        "\"accuracy\":1,\"precision\":1,\"recall\":1,\"f1_score\":1},"
+        "{\"tp\":1,\"tn\":0,\"fp\":1,\"fn\":0,"
+        "\"accuracy\":0.5,\"precision\":0.5,\"recall\":1,\"f1_score\":0.6666666666666666}],"
+        "\"total\":{\"tp\":2,\"tn\":1,\"fp\":1,\"fn\":0,"
+        "\"accuracy\":0.75,\"precision\":0.6666666666666666,\"recall\":1,\"f1_score\":0.8}}\n";
+  SL_ASSERT_EQ_LL(writer.size, strlen(expected));
+  SL_ASSERT_STRNCMP(0, (const char*)writer.buffer.data, expected, strlen(expected));
+  sl_json_writer_destroy(&writer);
+  return true;
+}
+
+SL_TEST(test_model_save_load) {
+  const char* const path = sl_misc_tmpdir();
+
+  struct sl_ml_svm svm = {
+      .w = {.length = {3}, .capacity = {3}, .data = (float[]){0.5f, -1, 2}},
+  };
+  struct sl_matrix_f32 data = {
+      .length   = {2, 3},
+      .capacity = {2, 3},
+      .data     = (float[]){1, 2, 3, -4, 5, 6},
+  };
+  struct sl_ml_minmax_scaler minmax = SL_ML_MINMAX_SCALER_CREATE_INLINE(3);
+  sl_ml_minmax_reset(&minmax);
+  sl_ml_minmax_fit(&minmax, &data);
+
+  // the scale and offset are saved, such that a loaded scaler never writes into the model
+  SL_ASSERT_TRUE(!sl_ml_model_save(ctx, path, "sl_test_model", &svm, &minmax));
+  SL_ASSERT_ERROR_OCCURRED(
+      ctx,
+      "cannot save model 'sl_test_model', scale and offset of its scaler are not cached"
+  );
+  sl_ml_minmax_apply(&minmax, &data, -1, 1);
+  SL_ASSERT_TRUE(sl_ml_model_save(ctx, path, "sl_test_model", &svm, &minmax));
+
+  struct sl_ml_model model = {0};
+  SL_ASSERT_TRUE(sl_ml_model_load(ctx, path, "sl_test_model", &model));
+  SL_ASSERT_TRUE(model.has_minmax);
+  SL_ASSERT_TRUE((void*)model.svm.w.data == (void*)model.mapping.data);
+  SL_ASSERT_TRUE(check_vector_equal(ctx, &(model.svm.w), &(svm.w)));
+  SL_ASSERT_TRUE(check_vector_equal(ctx, &(model.minmax.lo), &(minmax.lo)));
+  SL_ASSERT_TRUE(check_vector_equal(ctx, &(model.minmax.hi), &(minmax.hi)));
+  SL_ASSERT_TRUE(check_vector_equal(ctx, &(model.minmax.scale), &(minmax.scale)));
+  SL_ASSERT_TRUE(check_vector_equal(ctx, &(model.minmax.offset), &(minmax.offset)));
+
+  // inference with the loaded model reads the mapping only
+  struct sl_matrix_f32 loaded_data = {
+      .length   = {2, 3},
+      .capacity = {2, 3},
+      .data     = (float[]){1, 2, 3, -4, 5, 6},
+  };
+  sl_ml_minmax_apply(&(model.minmax), &loaded_data, -1, 1);
+  SL_ASSERT_TRUE(check_matrix_equal(ctx, &loaded_data, &data));
+  struct sl_vector_f32 scores        = SL_LA_VECTOR_CREATE_INLINE(2);
+  struct sl_vector_f32 loaded_scores = SL_LA_VECTOR_CREATE_INLINE(2);
+  sl_ml_svm_scores(&svm, &data, &scores);
+  sl_ml_svm_scores(&(model.svm), &loaded_data, &loaded_scores);
+  SL_ASSERT_TRUE(check_vector_equal(ctx, &loaded_scores, &scores));
+  sl_ml_model_unload(&model);
+  SL_ASSERT_TRUE(!model.mapping.data);
+
+  SL_ASSERT_TRUE(sl_ml_model_save(ctx, path, "sl_test_model", &svm, nullptr));
+  SL_ASSERT_TRUE(sl_ml_model_load(ctx, path, "sl_test_model", &model));
+  SL_ASSERT_TRUE(!model.has_minmax);
+  SL_ASSERT_TRUE(check_vector_equal(ctx, &(model.svm.w), &(svm.w)));
+  sl_ml_model_unload(&model);
+  return true;
+}
+
+SL_TEST(test_model_load_invalid) {
+  const char* const path   = sl_misc_tmpdir();
+  struct sl_ml_model model = {0};
+  SL_ASSERT_TRUE(!sl_ml_model_load(ctx, path, "sl_test_model_missing", &model));
+  // the errors of opening the metadata file are below the error of the model
+  struct sl_error_msg err = {0};
+  SL_ASSERT_TRUE(sl_error_pop(&(ctx->errors), &err));
+  SL_ASSERT_STR_STARTS_WITH(err.msg, "failed reading metadata of model 'sl_test_model_missing'");
+  sl_error_clear(&(ctx->errors));
+
+  struct sl_record record = {
+      .layout   = "dense",
+      .type     = "float32",
+      .name     = "sl_test_model_3_rows",
+      .size     = 6,
+      .n_dims   = 2,
+      .dim_size = {3, 2},
+  };
+  strncpy(record.path, path, sizeof(record.path) - 1);
+  SL_ASSERT_TRUE(sl_record_write_metadata(ctx, &record));
+  SL_ASSERT_TRUE(!sl_ml_model_load(ctx, path, "sl_test_model_3_rows", &model));
+  SL_ASSERT_ERROR_OCCURRED(
+      ctx,
+      "model 'sl_test_model_3_rows' is not a dense float32 record of 1 or 5 rows"
+  );
+
+  // metadata of one row of 3 features, but data of only 2 floats
+  record = (struct sl_record){
+      .layout   = "dense",
+      .type     = "float32",
+      .name     = "sl_test_model_truncated",
+      .size     = 3,
+      .n_dims   = 2,
+      .dim_size = {1, 3},
+  };
+  strncpy(record.path, path, sizeof(record.path) - 1);
+  SL_ASSERT_TRUE(sl_record_write_metadata(ctx, &record));
+  record.size = 2;
+  SL_ASSERT_TRUE(sl_record_write_all(ctx, &record, 2 * sizeof(float), (float[]){1, 2}));
+  SL_ASSERT_TRUE(!sl_ml_model_load(ctx, path, "sl_test_model_truncated", &model));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "data of model 'sl_test_model_truncated' has 8 bytes, expected 12");
+  SL_ASSERT_TRUE(!model.mapping.data);
+  return true;
+}
+
 SL_TEST_MAIN()
@@ -0,0 +1,198 @@
+#include <locale.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <stufflib/macros/macros.h>
+#include <stufflib/number/number.h>
+#include <stufflib/testing/testing.h>
+
+// inputs with the same syntax for strtod and sl_number, including rounding edge cases
+static const char* const float_inputs[] = {
+    "0",
+    "-0",
+    "-0.0e10",
+    "1",
+    "1.",
+    ".5",
+    "-.5",
+    "+.5",
+    "1e",
+    "1e+",
+    "0.1",
+    "3.14159",
+    "0.0497399253756",
+    "1e23",
+    "16777217",
+    "33554435",
+    "9007199254740993",
+    "9007199254740993.0000000000000000001",
+    "123456789012345678901234567890e-10",
+    "0000000000000000000000000000001.5",
+    "1.00000005960464477550",
+    "4.9e-324",
+    "2.4703282292062327e-324",
+    "2.4703282292062328e-324",
+    "2.2250738585072011e-308",
+    "2.2250738585072012e-308",
+    "1.7976931348623157e308",
+    "1.7976931348623159e308",
+    "1.4e-45",
+    "7.0064923216240854e-46",
+    "7.0064923216240862e-46",
+    "1.17549435e-38",
+    "3.4028235e38",
+    "3.4028236e38",
+    "1e400",
+    "-1e400",
+    "1e-400",
+    "1e99999999999999999999",
+    "1e-99999999999999999999",
+};
+
+static uint64_t f64_bits(double x) {
+  uint64_t bits = 0;
+  memcpy(&bits, &x, sizeof(x));
+  return bits;
+}
+
+static uint32_t f32_bits(float x) {
+  uint32_t bits = 0;
+  memcpy(&bits, &x, sizeof(x));
+  return bits;
+}
+
+SL_TEST(test_parse_u64) {
+  (void)ctx;
+  uint64_t x = 0;
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(1, "0", &x), 1);
+  SL_ASSERT_EQ_LL(x, 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(8, "12345678", &x), 8);
+  SL_ASSERT_EQ_LL(x, 12'345'678);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(13, "1234567890123", &x), 13);
+  SL_ASSERT_EQ_LL(x, 1'234'567'890'123);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(11, "42 17:0.5\n", &x), 2);
+  SL_ASSERT_EQ_LL(x, 42);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(20, "18446744073709551615", &x), 20);
+  SL_ASSERT_TRUE(x == UINT64_MAX);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(24, "000018446744073709551615", &x), 24);
+  SL_ASSERT_TRUE(x == UINT64_MAX);
+  // only len bytes are read
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(5, "1234567890", &x), 5);
+  SL_ASSERT_EQ_LL(x, 12'345);
+
+  x = 7;
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(20, "18446744073709551616", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(20, "28446744073709551616", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(21, "100000000000000000000", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(0, "", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(2, "-1", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_u64(2, " 1", &x), 0);
+  SL_ASSERT_EQ_LL(x, 7);
+  return true;
+}
+
+SL_TEST(test_parse_i64) {
+  (void)ctx;
+  int64_t x = 0;
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(2, "-0", &x), 2);
+  SL_ASSERT_EQ_LL(x, 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(4, "-42,", &x), 3);
+  SL_ASSERT_EQ_LL(x, -42);
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(19, "9223372036854775807", &x), 19);
+  SL_ASSERT_EQ_LL(x, INT64_MAX);
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(20, "-9223372036854775808", &x), 20);
+  SL_ASSERT_EQ_LL(x, INT64_MIN);
+
+  x = 7;
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(19, "9223372036854775808", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(20, "-9223372036854775809", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(1, "-", &x), 0);
+  SL_ASSERT_EQ_LL(sl_number_parse_i64(2, "+1", &x), 0);
+  SL_ASSERT_EQ_LL(x, 7);
+  return true;
+}
+
+SL_TEST(test_parse_f64) {
+  for (size_t i = 0; i < SL_ARRAY_LEN(float_inputs); ++i) {
+    const char* const str = float_inputs[i];
+    char* end             = nullptr;
+    const double expect   = strtod(str, &end);
+    double x              = 0;
+    SL_ASSERT_EQ_LL(sl_number_parse_f64(ctx, strlen(str), str, &x), end - str);
+    SL_ASSERT_TRUE(f64_bits(x) == f64_bits(expect));
+  }
+  return true;
+}
+
+SL_TEST(test_parse_f32) {
+  for (size_t i = 0; i < SL_ARRAY_LEN(float_inputs); ++i) {
+    const char* const str = float_inputs[i];
+    char* end             = nullptr;
+    const float expect    = strtof(str, &end);
+    float x               = 0;
+    SL_ASSERT_EQ_LL(sl_number_parse_f32(ctx, strlen(str), str, &x), end - str);
+    SL_ASSERT_TRUE(f32_bits(x) == f32_bits(expect));
+  }
+  return true;
+}
+
+SL_TEST(test_parse_float_long_input) {
+  // more significant digits than fit in the fallback buffer, halfway between 2^53 and 2^53 + 2
+  char str[256] = "9007199254740993.";
+  memset(str + strlen(str), '0', 200);
+  double x = 0;
+  SL_ASSERT_EQ_LL(sl_number_parse_f64(ctx, strlen(str), str, &x), strlen(str));
+  SL_ASSERT_TRUE(f64_bits(x) == f64_bits(9007199254740992.0));
+  str[strlen(str) - 1] = '1';
+  SL_ASSERT_EQ_LL(sl_number_parse_f64(ctx, strlen(str), str, &x), strlen(str));
+  SL_ASSERT_TRUE(f64_bits(x) == f64_bits(9007199254740994.0));
+  return true;
+}
+
+SL_TEST(test_parse_float_locale) {
+  SL_ASSERT_TRUE(sl_number_c_locale());
+  SL_ASSERT_TRUE(sl_number_c_locale() == sl_number_c_locale());
+
+  // the strtod fallback reads '.' as the decimal point also if the locale of the thread uses ','
+  // nothing to check if none of these locales is installed
+  const char* const comma_locales[] = {"de_DE.UTF-8", "fr_FR.UTF-8", "fi_FI.UTF-8"};
+  locale_t comma_locale             = (locale_t)0;
+  for (size_t i = 0; i < SL_ARRAY_LEN(comma_locales) && !comma_locale; ++i) {
+    comma_locale = newlocale(LC_NUMERIC_MASK, comma_locales[i], (locale_t)0);
+  }
+  if (!comma_locale) {
+    return true;
+  }
+  char str[256] = "9007199254740993.";
+  memset(str + strlen(str), '0', 200);
+  str[strlen(str) - 1] = '1';
+
+  const locale_t previous = uselocale(comma_locale);
+  double x                = 0;
+  const size_t n_read     = sl_number_parse_f64(ctx, strlen(str), str, &x);
+  uselocale(previous);
+  freelocale(comma_locale);
+
+  SL_ASSERT_EQ_LL(n_read, strlen(str));
+  SL_ASSERT_TRUE(f64_bits(x) == f64_bits(9007199254740994.0));
+  return true;
+}
+
+SL_TEST(test_parse_float_invalid) {
+  const char* const inputs[] = {"", ".", "-", "+", "e5", ".e5", "-.", "inf", "nan", " 1"};
+  for (size_t i = 0; i < SL_ARRAY_LEN(inputs); ++i) {
+    double x  = 7;
+    float x32 = 7;
+    SL_ASSERT_EQ_LL(sl_number_parse_f64(ctx, strlen(inputs[i]), inputs[i], &x), 0);
+    SL_ASSERT_EQ_LL(sl_number_parse_f32(ctx, strlen(inputs[i]), inputs[i], &x32), 0);
+    SL_ASSERT_TRUE(f64_bits(x) == f64_bits(7.0));
+  }
+  // only len bytes are read
+  double x = 0;
+  SL_ASSERT_EQ_LL(sl_number_parse_f64(ctx, 4, "1.5e10", &x), 3);
+  SL_ASSERT_TRUE(f64_bits(x) == f64_bits(1.5));
+  return true;
+}
+
+SL_TEST_MAIN()
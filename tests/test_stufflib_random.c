@@ -76,6 +76,33 @@ SL_TEST(test_randomint) {
   return true;
 }
 
+SL_TEST(test_random_pcg32_advance) {
+  (void)ctx;
+  for (uint64_t delta = 0; delta < 1000; delta += 7) {
+    uint64_t stepped  = 0;
+    uint64_t advanced = 0;
+    sl_random_pcg32_init(&stepped, delta);
+    sl_random_pcg32_init(&advanced, delta);
+    for (uint64_t i = 0; i < delta; ++i) {
+      (void)sl_random_pcg32(&stepped);
+    }
+    sl_random_pcg32_advance(&advanced, delta);
+    SL_ASSERT_TRUE(stepped == advanced);
+    SL_ASSERT_TRUE(sl_random_pcg32(&stepped) == sl_random_pcg32(&advanced));
+  }
+  {
+    // the period is 2^64
+    uint64_t prng = 0;
+    sl_random_pcg32_init(&prng, 1);
+    const uint64_t begin = prng;
+    sl_random_pcg32_advance(&prng, UINT64_MAX);
+    SL_ASSERT_TRUE(prng != begin);
+    sl_random_pcg32_advance(&prng, 1);
+    SL_ASSERT_TRUE(prng == begin);
+  }
+  return true;
+}
+
 SL_TEST(test_random_shuffle) {
   (void)ctx;
   uint64_t prng = 0;
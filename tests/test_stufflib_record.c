@@ -4,13 +4,19 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <stufflib/error/error.h>
 #include <stufflib/io/io.h>
+#include <stufflib/linalg/linalg.h>
 #include <stufflib/macros/macros.h>
 #include <stufflib/math/math.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
 #include <stufflib/memory/memory.h>
 #include <stufflib/misc/misc.h>
+#include <stufflib/record/block.h>
+#include <stufflib/record/prefetch.h>
 #include <stufflib/record/reader.h>
+#include <stufflib/record/shard.h>
 #include <stufflib/record/record.h>
 #include <stufflib/record/writer.h>
 #include <stufflib/span/span.h>
@@ -726,4 +732,633 @@ SL_TEST(test_sparse_batch_write_and_read) {
   return true;
 }
 
+SL_TEST(test_sparse_csr_read) {
+  struct sl_record record = {
+      .layout   = "sparse",
+      .type     = "float32",
+      .name     = "small6",
+      .size     = 16,
+      .n_dims   = 2,
+      .dim_size = {20, 5},
+  };
+  strncpy(record.path, sl_misc_tmpdir(), sizeof(record.path) - 1);
+  record.path[sizeof(record.path) - 1] = '\0';
+
+  struct sl_matrix_f32 data1 = {
+      .length   = {20, 5},
+      .capacity = {20, 5},
+      .data
+      = (float[]){1, 0, 0,  0, 0, 0, -2, 0,  0,  0, 0, 0, 0, 0, 0, 0, 0, 0,  4, 0, 0, 0, 0, 0, -5,
+                   0, 0, 0,  1, 0, 0, 0,  -2, 0,  0, 0, 0, 0, 0, 0, 4, 0, 0,  0, 0, 0, 5, 0, 0, 0,
+                   0, 0, -1, 0, 0, 0, 0,  0,  -2, 0, 0, 0, 0, 0, 3, 0, 0, 0,  4, 0, 0, 0, 0, 0, 0,
+                   0, 6, 0,  0, 0, 7, 0,  0,  0,  0, 0, 8, 0, 0, 0, 0, 0, -9, 0, 0, 0, 0, 0, 0, 0},
+  };
+  SL_ASSERT_TRUE(sl_record_write_all(
+      ctx,
+      &record,
+      sizeof(data1.data[0]) * sl_matrix_f32_size(&data1),
+      (void*)data1.data
+  ));
+
+  const size_t batch_size = 3;
+
+  struct sl_csr_f32 batch = {0};
+  SL_ASSERT_TRUE(sl_la_csr_create(ctx, batch_size, record.dim_size[1], 1, &batch));
+
+  struct sl_matrix_f32 data2 = {
+      .length   = {batch_size, 5},
+      .capacity = {batch_size, 5},
+      .data     = (float[3 * 5]){0},
+  };
+
+  struct sl_file file            = {0};
+  struct sl_record_reader reader = {
+      .file   = &file,
+      .record = &record,
+  };
+  SL_ASSERT_TRUE(sl_record_reader_open(ctx, &reader));
+
+  size_t n_rows = 0;
+  size_t nnz    = 0;
+  while (!sl_record_reader_is_done(ctx, &reader)) {
+    SL_ASSERT_TRUE(sl_record_reader_read_csr(ctx, &reader, &batch));
+    SL_ASSERT_TRUE(sl_csr_f32_num_rows(&batch) <= batch_size);
+    SL_ASSERT_EQ_LL(sl_csr_f32_num_cols(&batch), 5);
+
+    sl_la_csr_to_dense(&data2, &batch);
+    for (size_t row = 0; row < sl_csr_f32_num_rows(&batch); ++row) {
+      for (size_t col = 0; col < 5; ++col) {
+        SL_ASSERT_EQ_DOUBLE(
+            (double)*sl_matrix_f32_get(&data2, row, col),
+            (double)*sl_matrix_f32_get(&data1, n_rows + row, col),
+            1e-12
+        );
+      }
+    }
+
+    n_rows += sl_csr_f32_num_rows(&batch);
+    nnz += sl_csr_f32_nnz(&batch);
+  }
+  sl_record_reader_close(&reader);
+
+  // last batch contains only the 2 remaining rows
+  SL_ASSERT_EQ_LL(n_rows, 20);
+  SL_ASSERT_EQ_LL(nnz, record.size);
+  SL_ASSERT_TRUE(batch.nnz_capacity >= 3);
+
+  sl_la_csr_destroy(&batch);
+  return true;
+}
+
+SL_TEST(test_blocked_write_and_read) {
+  struct sl_record record = {
+      .layout   = "blocked",
+      .type     = "int32",
+      .name     = "large7",
+      .n_dims   = 2,
+      .dim_size = {100, 1'500},
+  };
+  strncpy(record.path, sl_misc_tmpdir(), sizeof(record.path) - 1);
+  record.path[sizeof(record.path) - 1] = '\0';
+
+  const size_t count = record.dim_size[0] * record.dim_size[1];
+  int32_t* data1     = sl_alloc(ctx, count, sizeof(int32_t));
+  int32_t* data2     = sl_alloc(ctx, count, sizeof(int32_t));
+  SL_ASSERT_TRUE(data1);
+  SL_ASSERT_TRUE(data2);
+  for (size_t i = 0; i < count; i += 7) {
+    data1[i] = (i % 2 ? -1 : 1) * (int32_t)((i % 1'000) + 1);
+  }
+  data1[count - 1] = INT32_MIN;
+  record.size      = sl_misc_count_nonzero(sizeof(int32_t), count, (void*)data1);
+
+  const size_t write_batch = 10'000;
+  {
+    struct sl_file file            = {0};
+    struct sl_record_writer writer = {
+        .file   = &file,
+        .record = &record,
+    };
+    SL_ASSERT_TRUE(sl_record_writer_open(ctx, &writer));
+    for (size_t begin = 0; begin < count; begin += write_batch) {
+      struct sl_span batch = sl_span_view(
+          sizeof(int32_t) * SL_MIN(write_batch, count - begin),
+          (void*)(data1 + begin)
+      );
+      SL_ASSERT_TRUE(sl_record_writer_write(ctx, &writer, &batch));
+    }
+    SL_ASSERT_TRUE(sl_record_writer_finish(ctx, &writer));
+    SL_ASSERT_EQ_LL(writer.n_written, record.size);
+    sl_record_writer_close(&writer);
+  }
+
+  const size_t read_batch = 15'000;
+  {
+    struct sl_file file            = {0};
+    struct sl_record_reader reader = {
+        .file   = &file,
+        .record = &record,
+    };
+    SL_ASSERT_TRUE(sl_record_reader_open(ctx, &reader));
+    SL_ASSERT_EQ_LL(reader.n_blocks, (count + SL_RECORD_BLOCK_LEN - 1) / SL_RECORD_BLOCK_LEN);
+    for (size_t begin = 0; begin < count; begin += read_batch) {
+      SL_ASSERT_TRUE(!sl_record_reader_is_done(ctx, &reader));
+      struct sl_span batch = sl_span_view(
+          sizeof(int32_t) * SL_MIN(read_batch, count - begin),
+          (void*)(data2 + begin)
+      );
+      SL_ASSERT_TRUE(sl_record_reader_read(ctx, &reader, &batch));
+    }
+    SL_ASSERT_TRUE(sl_record_reader_is_done(ctx, &reader));
+    SL_ASSERT_EQ_LL(reader.n_read, record.size);
+    SL_ASSERT_EQ_LL(memcmp(data1, data2, sizeof(int32_t) * count), 0);
+
+    const size_t seek_index = SL_RECORD_BLOCK_LEN + 10;
+    SL_ASSERT_TRUE(sl_record_reader_seek(ctx, &reader, seek_index));
+    int32_t values[20]   = {0};
+    struct sl_span batch = sl_span_view(sizeof(values), (void*)values);
+    SL_ASSERT_TRUE(sl_record_reader_read(ctx, &reader, &batch));
+    SL_ASSERT_EQ_LL(memcmp(data1 + seek_index, values, sizeof(values)), 0);
+
+    SL_ASSERT_TRUE(!sl_record_reader_seek(ctx, &reader, count + SL_RECORD_BLOCK_LEN));
+    SL_ASSERT_TRUE(sl_context_error_occurred(ctx));
+    sl_error_clear(&(ctx->errors));
+    sl_record_reader_close(&reader);
+  }
+
+  sl_free(data1);
+  sl_free(data2);
+  return true;
+}
+
+SL_TEST(test_blocked_csr_read) {
+  struct sl_record record = {
+      .layout   = "blocked",
+      .type     = "float32",
+      .name     = "large8",
+      .n_dims   = 2,
+      .dim_size = {1'000, 13},
+  };
+  strncpy(record.path, sl_misc_tmpdir(), sizeof(record.path) - 1);
+  record.path[sizeof(record.path) - 1] = '\0';
+
+  const size_t rows = record.dim_size[0];
+  const size_t cols = record.dim_size[1];
+
+  struct sl_matrix_f32 data1 = {0};
+  SL_ASSERT_TRUE(sl_la_matrix_create(ctx, rows, cols, &data1));
+  for (size_t i = 0; i < rows * cols; i += 3) {
+    data1.data[i] = (float)sqrt((double)i);
+  }
+  record.size = sl_misc_count_nonzero(sizeof(float), rows * cols, (void*)data1.data);
+
+  // floats are stored as is unless shuffled into byte planes
+  for (int shuffle = 0; shuffle <= 1; ++shuffle) {
+    record.shuffle = shuffle == 1;
+    SL_ASSERT_TRUE(
+        sl_record_write_all(ctx, &record, sizeof(float) * sl_matrix_f32_size(&data1), data1.data)
+    );
+    SL_ASSERT_TRUE(sl_record_write_metadata(ctx, &record));
+    struct sl_record metadata = {0};
+    SL_ASSERT_TRUE(sl_record_read_metadata(ctx, &metadata, record.path, record.name));
+    SL_ASSERT_TRUE(metadata.shuffle == record.shuffle);
+    SL_ASSERT_EQ_LL(
+        sl_record_block_encoding_of(&metadata),
+        record.shuffle ? sl_record_block_shuffled : sl_record_block_raw
+    );
+
+    const size_t batch_size = 300;
+
+    struct sl_csr_f32 batch = {0};
+    SL_ASSERT_TRUE(sl_la_csr_create(ctx, batch_size, cols, 16, &batch));
+    struct sl_matrix_f32 data2 = {0};
+    SL_ASSERT_TRUE(sl_la_matrix_create(ctx, batch_size, cols, &data2));
+
+    struct sl_file file            = {0};
+    struct sl_record_reader reader = {
+        .file   = &file,
+        .record = &record,
+    };
+    SL_ASSERT_TRUE(sl_record_reader_open(ctx, &reader));
+
+    size_t n_rows = 0;
+    while (!sl_record_reader_is_done(ctx, &reader)) {
+      SL_ASSERT_TRUE(sl_record_reader_read_csr(ctx, &reader, &batch));
+      sl_la_csr_to_dense(&data2, &batch);
+      for (size_t row = 0; row < sl_csr_f32_num_rows(&batch); ++row) {
+        for (size_t col = 0; col < cols; ++col) {
+          SL_ASSERT_EQ_DOUBLE(
+              (double)*sl_matrix_f32_get(&data2, row, col),
+              (double)*sl_matrix_f32_get(&data1, n_rows + row, col),
+              1e-12
+          );
+        }
+      }
+      n_rows += sl_csr_f32_num_rows(&batch);
+    }
+    sl_record_reader_close(&reader);
+
+    SL_ASSERT_EQ_LL(n_rows, rows);
+    SL_ASSERT_EQ_LL(reader.n_read, record.size);
+
+    sl_la_csr_destroy(&batch);
+    sl_la_matrix_destroy(&data2);
+  }
+
+  sl_la_matrix_destroy(&data1);
+  return true;
+}
+
+SL_TEST(test_block_decode_invalid_positions) {
+  struct sl_record_block block = {0};
+  SL_ASSERT_TRUE(sl_record_block_create(ctx, &block, sizeof(int16_t)));
+
+  // length 10, 2 nonzeros, raw encoding, position deltas 3 and 2^64 - 1, values 1 and 2
+  // 3 + 2^64 - 1 wraps to 2, which is within the block but not after 3
+  const char wrapping[] = "\x0a\x02\x00\x03"
+                          "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01"
+                          "\x01\x00\x02\x00";
+  memcpy(block.encoded.data, wrapping, sizeof(wrapping) - 1);
+  SL_ASSERT_TRUE(!sl_record_block_decode(ctx, &block, sizeof(wrapping) - 1));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "invalid position of nonzero 1 in record block");
+
+  // position deltas 3 and 0, positions are not increasing
+  const char repeated[] = "\x0a\x02\x00\x03\x00\x01\x00\x02\x00";
+  memcpy(block.encoded.data, repeated, sizeof(repeated) - 1);
+  SL_ASSERT_TRUE(!sl_record_block_decode(ctx, &block, sizeof(repeated) - 1));
+  SL_ASSERT_ERROR_OCCURRED(ctx, "invalid position of nonzero 1 in record block");
+
+  // position deltas 3 and 6, positions 3 and 9 are valid
+  const char valid[] = "\x0a\x02\x00\x03\x06\x01\x00\x02\x00";
+  memcpy(block.encoded.data, valid, sizeof(valid) - 1);
+  SL_ASSERT_TRUE(sl_record_block_decode(ctx, &block, sizeof(valid) - 1));
+  SL_ASSERT_EQ_LL(block.nnz, 2);
+  SL_ASSERT_EQ_LL(block.positions[0], 3);
+  SL_ASSERT_EQ_LL(block.positions[1], 9);
+
+  sl_record_block_destroy(&block);
+  return true;
+}
+
+SL_TEST(test_prefetched_read) {
+  struct sl_record record = {
+      .layout   = "sparse",
+      .type     = "float32",
+      .name     = "large9",
+      .n_dims   = 2,
+      .dim_size = {1'000, 13},
+  };
+  strncpy(record.path, sl_misc_tmpdir(), sizeof(record.path) - 1);
+  record.path[sizeof(record.path) - 1] = '\0';
+
+  const size_t rows = record.dim_size[0];
+  const size_t cols = record.dim_size[1];
+
+  struct sl_matrix_f32 data1 = {0};
+  SL_ASSERT_TRUE(sl_la_matrix_create(ctx, rows, cols, &data1));
+  for (size_t i = 0; i < rows * cols; i += 5) {
+    data1.data[i] = (float)i;
+  }
+  record.size = sl_misc_count_nonzero(sizeof(float), rows * cols, (void*)data1.data);
+  SL_ASSERT_TRUE(
+      sl_record_write_all(ctx, &record, sizeof(float) * sl_matrix_f32_size(&data1), data1.data)
+  );
+
+  // batch does not divide the record to check the partial last batch
+  const size_t batch_size = 70;
+
+  struct sl_matrix_f32 batches[2] = {0};
+  struct sl_span buffers[2]       = {0};
+  for (size_t i = 0; i < SL_ARRAY_LEN(batches); ++i) {
+    SL_ASSERT_TRUE(sl_la_matrix_create(ctx, batch_size, cols, batches + i));
+    buffers[i] = sl_span_view(sizeof(float) * batch_size * cols, (void*)batches[i].data);
+  }
+
+  struct sl_file file            = {0};
+  struct sl_record_reader reader = {
+      .file   = &file,
+      .record = &record,
+  };
+  SL_ASSERT_TRUE(sl_record_reader_open(ctx, &reader));
+
+  struct sl_record_prefetcher prefetcher = {
+      .reader  = &reader,
+      .read    = sl_record_prefetch_read_span,
+      .batches = {buffers + 0, buffers + 1},
+  };
+  SL_ASSERT_TRUE(sl_record_prefetcher_open(ctx, &prefetcher));
+
+  size_t n_rows = 0;
+  for (size_t batch_idx = 0;; ++batch_idx) {
+    void* batch = nullptr;
+    SL_ASSERT_TRUE(sl_record_prefetcher_next(ctx, &prefetcher, &batch));
+    if (!batch) {
+      break;
+    }
+    const size_t buffer_idx = batch_idx % 2;
+    SL_ASSERT_TRUE(batch == buffers + buffer_idx);
+    struct sl_matrix_f32* data2       = batches + buffer_idx;
+    const size_t n_batch_rows         = SL_MIN(batch_size, rows - n_rows);
+    for (size_t row = 0; row < n_batch_rows; ++row) {
+      for (size_t col = 0; col < cols; ++col) {
+        SL_ASSERT_EQ_DOUBLE(
+            (double)*sl_matrix_f32_get(data2, row, col),
+            (double)*sl_matrix_f32_get(&data1, n_rows + row, col),
+            1e-12
+        );
+      }
+    }
+    n_rows += n_batch_rows;
+  }
+  // end of record is sticky
+  {
+    void* batch = nullptr;
+    SL_ASSERT_TRUE(sl_record_prefetcher_next(ctx, &prefetcher, &batch));
+    SL_ASSERT_TRUE(!batch);
+  }
+  sl_record_prefetcher_close(&prefetcher);
+  sl_record_reader_close(&reader);
+
+  SL_ASSERT_EQ_LL(n_rows, rows);
+  SL_ASSERT_EQ_LL(reader.n_read, record.size);
+
+  for (size_t i = 0; i < SL_ARRAY_LEN(batches); ++i) {
+    sl_la_matrix_destroy(batches + i);
+  }
+  sl_la_matrix_destroy(&data1);
+  return true;
+}
+
+struct test_shards {
+  size_t n_rows;
+  size_t n_cols;
+  size_t n_shards;
+  float* data;
+  size_t n_read[3];
+};
+
+// shard k gets every row with index i such that i * n_shards / n_rows == k
+static size_t test_shard_begin(const struct test_shards t[const static 1], size_t shard_idx) {
+  return (shard_idx * t->n_rows + t->n_shards - 1) / t->n_shards;
+}
+
+static bool test_write_shard(
+    struct sl_context ctx[static 1],
+    struct sl_record_writer writer[const static 1],
+    size_t shard_idx,
+    void* arg
+) {
+  const struct test_shards* t = arg;
+  for (size_t row = test_shard_begin(t, shard_idx); row < test_shard_begin(t, shard_idx + 1);
+       ++row) {
+    struct sl_span buffer = sl_span_view(
+        sizeof(float) * t->n_cols,
+        (void*)(t->data + (row * t->n_cols))
+    );
+    if (!sl_record_writer_write(ctx, writer, &buffer)) {
+      return false;
+    }
+    writer->record->dim_size[0] += 1;
+  }
+  return true;
+}
+
+static bool test_read_shard(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    size_t shard_idx,
+    void* arg
+) {
+  struct test_shards* t = arg;
+  float row[7]          = {0};
+  for (size_t i = test_shard_begin(t, shard_idx); i < test_shard_begin(t, shard_idx + 1); ++i) {
+    struct sl_span buffer = sl_span_view(sizeof(row), (void*)row);
+    if (!sl_record_reader_read(ctx, reader, &buffer)
+        || memcmp(row, t->data + (i * t->n_cols), sizeof(row)) != 0) {
+      SL_ERROR(ctx, "unexpected row %zu in shard %zu", i, shard_idx);
+      return false;
+    }
+  }
+  t->n_read[shard_idx] = reader->n_read;
+  return true;
+}
+
+SL_TEST(test_sharded_write_and_read) {
+  const size_t rows = 200;
+  const size_t cols = 7;
+
+  struct sl_matrix_f32 data1 = {0};
+  SL_ASSERT_TRUE(sl_la_matrix_create(ctx, rows, cols, &data1));
+  for (size_t i = 0; i < rows * cols; i += 3) {
+    data1.data[i] = (float)i;
+  }
+
+  const char* layouts[] = {"dense", "sparse", "blocked"};
+  for (size_t l = 0; l < SL_ARRAY_LEN(layouts); ++l) {
+    struct sl_record record = {
+        .type     = "float32",
+        .name     = "sharded1",
+        .size     = 1,
+        .n_dims   = 2,
+        .dim_size = {0, cols},
+    };
+    strncpy(record.layout, layouts[l], sizeof(record.layout) - 1);
+    strncpy(record.path, sl_misc_tmpdir(), sizeof(record.path) - 1);
+    record.path[sizeof(record.path) - 1] = '\0';
+
+    struct test_shards shards = {
+        .n_rows   = rows,
+        .n_cols   = cols,
+        .n_shards = 3,
+        .data     = data1.data,
+    };
+    SL_ASSERT_TRUE(
+        sl_record_write_shards(ctx, &record, shards.n_shards, test_write_shard, &shards)
+    );
+    SL_ASSERT_EQ_LL(record.n_shards, 3);
+    SL_ASSERT_EQ_LL(record.dim_size[0], rows);
+    SL_ASSERT_EQ_LL(record.shard_rows[0], 67);
+    SL_ASSERT_EQ_LL(record.shard_rows[1], 67);
+    SL_ASSERT_EQ_LL(record.shard_rows[2], 66);
+    SL_ASSERT_TRUE(sl_record_write_metadata(ctx, &record));
+
+    struct sl_record record2;
+    SL_ASSERT_TRUE(sl_record_read_metadata(ctx, &record2, record.path, record.name));
+    SL_ASSERT_EQ_LL(record2.n_shards, record.n_shards);
+    SL_ASSERT_EQ_LL(record2.size, record.size);
+    for (size_t k = 0; k < record.n_shards; ++k) {
+      SL_ASSERT_EQ_LL(record2.shard_rows[k], record.shard_rows[k]);
+      SL_ASSERT_EQ_LL(record2.shard_size[k], record.shard_size[k]);
+    }
+
+    // shards in parallel
+    SL_ASSERT_TRUE(sl_record_read_shards(ctx, &record2, test_read_shard, &shards));
+    for (size_t k = 0; k < record.n_shards; ++k) {
+      SL_ASSERT_EQ_LL(shards.n_read[k], record.shard_size[k]);
+    }
+
+    // shards concatenated, batches cross shard boundaries
+    struct sl_file file            = {0};
+    struct sl_record_reader reader = {
+        .file   = &file,
+        .record = &record2,
+    };
+    SL_ASSERT_TRUE(sl_record_reader_open(ctx, &reader));
+    const size_t batch_size = 30;
+    float batch[30 * 7]     = {0};
+    for (size_t row = 0; !sl_record_reader_is_done(ctx, &reader); row += batch_size) {
+      struct sl_span buffer = sl_span_view(sizeof(batch), (void*)batch);
+      SL_ASSERT_TRUE(sl_record_reader_read(ctx, &reader, &buffer));
+      const size_t n = SL_MIN(batch_size, rows - row) * cols;
+      SL_ASSERT_EQ_LL(memcmp(batch, data1.data + (row * cols), n * sizeof(float)), 0);
+    }
+    if (!SL_STR_EQ(record.layout, "sparse")) {
+      SL_ASSERT_TRUE(sl_record_reader_seek(ctx, &reader, 150 * cols));
+      struct sl_span buffer = sl_span_view(sizeof(batch), (void*)batch);
+      SL_ASSERT_TRUE(sl_record_reader_read(ctx, &reader, &buffer));
+      SL_ASSERT_EQ_LL(memcmp(batch, data1.data + (150 * cols), sizeof(batch)), 0);
+    }
+    sl_record_reader_close(&reader);
+    SL_ASSERT_TRUE(reader.record == &record2);
+  }
+
+  sl_la_matrix_destroy(&data1);
+  return true;
+}
+
+SL_TEST(test_layout_and_type) {
+  struct sl_record record = {
+      .layout   = "sparse",
+      .type     = "uint16",
+      .size     = 10,
+      .n_dims   = 1,
+      .dim_size = {100},
+  };
+  SL_ASSERT_EQ_LL(sl_record_layout_of(&record), sl_record_layout_sparse);
+  SL_ASSERT_EQ_LL(sl_record_type_of(&record), sl_record_type_uint16);
+  SL_ASSERT_EQ_LL(sl_record_item_size(&record), sizeof(uint16_t));
+  SL_ASSERT_EQ_LL(
+      sl_record_disk_size(&record, sl_record_layout_sparse, sizeof(uint16_t)),
+      10 * (sizeof(int64_t) + sizeof(uint16_t))
+  );
+  SL_ASSERT_EQ_LL(
+      sl_record_disk_size(&record, sl_record_layout_dense, sizeof(uint16_t)),
+      10 * sizeof(uint16_t)
+  );
+  SL_ASSERT_EQ_LL(sl_record_disk_size(&record, sl_record_layout_blocked, sizeof(uint16_t)), 0);
+
+  const char* types[]  = {"float32", "int8", "int16", "int32", "int64", "uint8", "uint64"};
+  const size_t sizes[] = {4, 1, 2, 4, 8, 1, 8};
+  for (size_t i = 0; i < SL_ARRAY_LEN(types); ++i) {
+    strncpy(record.type, types[i], sizeof(record.type) - 1);
+    SL_ASSERT_TRUE(sl_record_type_of(&record) != sl_record_type_unknown);
+    SL_ASSERT_EQ_LL(sl_record_item_size(&record), sizes[i]);
+  }
+
+  strncpy(record.layout, "dense", sizeof(record.layout) - 1);
+  SL_ASSERT_EQ_LL(sl_record_layout_of(&record), sl_record_layout_dense);
+  strncpy(record.layout, "blocked", sizeof(record.layout) - 1);
+  SL_ASSERT_EQ_LL(sl_record_layout_of(&record), sl_record_layout_blocked);
+  strncpy(record.layout, "csr", sizeof(record.layout) - 1);
+  SL_ASSERT_EQ_LL(sl_record_layout_of(&record), sl_record_layout_unknown);
+  strncpy(record.type, "float16", sizeof(record.type) - 1);
+  SL_ASSERT_EQ_LL(sl_record_type_of(&record), sl_record_type_unknown);
+  SL_ASSERT_EQ_LL(sl_record_item_size(&record), 0);
+  return true;
+}
+
+static bool write_text_file(const char name[static 1], const char text[static 1]) {
+  char path[1'024] = {0};
+  if (!sl_file_format_path(SL_ARRAY_LEN(path), path, sl_misc_tmpdir(), name, ".sl_record_meta")) {
+    return false;
+  }
+  FILE* fp = fopen(path, "w");
+  if (!fp) {
+    return false;
+  }
+  const bool ok = fputs(text, fp) >= 0;
+  return fclose(fp) == 0 && ok;
+}
+
+SL_TEST(test_read_invalid_metadata) {
+  const char* valid_metadata
+      = "name: meta_valid\ntype: int32\nlayout: sparse\nsize: 3\ndims: 2\ndim0: 4\ndim1: 5\n"
+        "shards: 2\nshard0: 1 1\nshard1: 3 2";
+  SL_ASSERT_TRUE(write_text_file("meta_valid", valid_metadata));
+  struct sl_record record = {0};
+  SL_ASSERT_TRUE(sl_record_read_metadata(ctx, &record, sl_misc_tmpdir(), "meta_valid"));
+  SL_ASSERT_EQ_STR(record.type, "int32");
+  SL_ASSERT_EQ_STR(record.layout, "sparse");
+  SL_ASSERT_EQ_LL(record.size, 3);
+  SL_ASSERT_EQ_LL(record.n_dims, 2);
+  SL_ASSERT_EQ_LL(record.dim_size[0], 4);
+  SL_ASSERT_EQ_LL(record.dim_size[1], 5);
+  SL_ASSERT_EQ_LL(record.n_shards, 2);
+  SL_ASSERT_EQ_LL(record.shard_rows[1], 3);
+  SL_ASSERT_EQ_LL(record.shard_size[1], 2);
+
+  const char* invalid_metadata[] = {
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize: 3\ndims: 2\ndim0: 4\n",
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize: -3\ndims: 1\ndim0: 4\n",
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize: 3x\ndims: 1\ndim0: 4\n",
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize: 3\ndims: 9\n",
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize: 3\ndims: 1\ndim1: 4\n",
+      "name: meta_invalid\ntype: int32\nlayout: csr\nsize: 3\ndims: 1\ndim0: 4\n",
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize: 3\ndims: 1\ndim0: 4\nshards: 1\n",
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize: 3\ndims: 1\ndim0: 4\nextra: 1\n",
+      "name: meta_invalid\ntype: int32\nlayout: sparse\nsize 3\ndims: 1\ndim0: 4\n",
+      "name: meta_invalid\ntype: float32\nlayout: sparse\nsize: 3\ndims: 1\ndim0: 4\nshuffle: 1\n",
+      "name: meta_invalid\ntype: int32\nlayout: blocked\nsize: 3\ndims: 1\ndim0: 4\nshuffle: 1\n",
+      "name: meta_invalid\ntype: float32\nlayout: blocked\nsize: 3\ndims: 1\ndim0: 4\nshuffle: 2\n",
+  };
+  for (size_t i = 0; i < SL_ARRAY_LEN(invalid_metadata); ++i) {
+    SL_ASSERT_TRUE(write_text_file("meta_invalid", invalid_metadata[i]));
+    SL_ASSERT_FALSE(sl_record_read_metadata(ctx, &record, sl_misc_tmpdir(), "meta_invalid"));
+    SL_ASSERT_TRUE(sl_context_error_occurred(ctx));
+    sl_error_clear(&(ctx->errors));
+  }
+  return true;
+}
+
+SL_TEST(test_read_batch) {
+  enum { n_records = 200, n_items = 6 };
+  struct sl_record records[n_records]  = {0};
+  struct sl_span buffers[n_records]    = {0};
+  int16_t expected[n_records][n_items] = {0};
+  int16_t data[n_records][n_items]     = {0};
+  const char* layouts[]                = {"dense", "sparse", "blocked"};
+
+  for (size_t i = 0; i < n_records; ++i) {
+    struct sl_record* record = records + i;
+
+    *record = (struct sl_record){
+        .type     = "int16",
+        .size     = n_items,
+        .n_dims   = 2,
+        .dim_size = {2, n_items / 2},
+    };
+    strncpy(record->layout, layouts[i % SL_ARRAY_LEN(layouts)], sizeof(record->layout) - 1);
+    if (!SL_STR_EQ(record->layout, "dense")) {
+      record->size = n_items / 2;
+    }
+    strncpy(record->path, sl_misc_tmpdir(), sizeof(record->path) - 1);
+    const int name_len = snprintf(record->name, sizeof(record->name), "batch%zu", i);
+    SL_ASSERT_TRUE(name_len > 0);
+    for (size_t j = 0; j < n_items; ++j) {
+      expected[i][j] = (j % 2 == 0) ? (int16_t)(i + 1 + (j * 1'000)) : 0;
+    }
+    SL_ASSERT_TRUE(sl_record_write_all(ctx, record, sizeof(expected[i]), expected[i]));
+    buffers[i] = sl_span_view(sizeof(data[i]), (void*)data[i]);
+  }
+
+  SL_ASSERT_TRUE(sl_record_read_batch(ctx, n_records, records, buffers));
+  SL_ASSERT_EQ_LL(memcmp(data, expected, sizeof(data)), 0);
+
+  // first record is dense and does not fit in its buffer
+  buffers[0].size -= sizeof(int16_t);
+  SL_ASSERT_FALSE(sl_record_read_batch(ctx, n_records, records, buffers));
+  sl_error_clear(&(ctx->errors));
+  return true;
+}
+
 SL_TEST_MAIN()
@@ -1,4 +1,4 @@
-#include <errno.h>
+#include <ctype.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,8 +16,11 @@
 #include <stufflib/matrix/sl_matrix_f32.h>
 #include <stufflib/memory/memory.h>
 #include <stufflib/misc/misc.h>
+#include <stufflib/ml/ml.h>
+#include <stufflib/number/number.h>
 #include <stufflib/png/png.h>
 #include <stufflib/record/record.h>
+#include <stufflib/record/shard.h>
 #include <stufflib/record/writer.h>
 #include <stufflib/span/span.h>
 #include <stufflib/string/string.h>
@@ -162,6 +165,29 @@ done:
   return all_ok;
 }
 
+// parses one CSV line of spambase features followed by the class label
+static bool spambase_parse_line(
+    struct sl_context ctx[static 1],
+    size_t len,
+    const char line[static len],
+    float features[static SL_DATASET_SPAMBASE_FEATURES],
+    int64_t label[static 1]
+) {
+  size_t pos = 0;
+  for (size_t col = 0; col < SL_DATASET_SPAMBASE_FEATURES; ++col) {
+    const size_t n_read = sl_number_parse_f32(ctx, len - pos, line + pos, features + col);
+    if (n_read == 0) {
+      return false;
+    }
+    pos += n_read;
+    if (pos == len || line[pos] != ',') {
+      return false;
+    }
+    ++pos;
+  }
+  return sl_number_parse_i64(len - pos, line + pos, label) > 0;
+}
+
 bool spambase(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
   // spambase dataset parser
   // Data format reference: https://archive.ics.uci.edu/dataset/94/spambase
@@ -214,69 +240,12 @@ bool spambase(struct sl_context ctx[static 1], const struct sl_args args[const s
         continue;
       }
 
-      int label = 0;
-      // TODO maybe strof on char file reader buffer
-      if (58
-          != sscanf(
+      int64_t label = 0;
+      if (!spambase_parse_line(
+              ctx,
+              line->size,
               (const char*)line->data,
-              ("%f" SL_REPEAT_56(",%f") ",%d"),
               sl_matrix_f32_get(&data, (size_t)lineno, 0),
-              sl_matrix_f32_get(&data, (size_t)lineno, 1),
-              sl_matrix_f32_get(&data, (size_t)lineno, 2),
-              sl_matrix_f32_get(&data, (size_t)lineno, 3),
-              sl_matrix_f32_get(&data, (size_t)lineno, 4),
-              sl_matrix_f32_get(&data, (size_t)lineno, 5),
-              sl_matrix_f32_get(&data, (size_t)lineno, 6),
-              sl_matrix_f32_get(&data, (size_t)lineno, 7),
-              sl_matrix_f32_get(&data, (size_t)lineno, 8),
-              sl_matrix_f32_get(&data, (size_t)lineno, 9),
-              sl_matrix_f32_get(&data, (size_t)lineno, 10),
-              sl_matrix_f32_get(&data, (size_t)lineno, 11),
-              sl_matrix_f32_get(&data, (size_t)lineno, 12),
-              sl_matrix_f32_get(&data, (size_t)lineno, 13),
-              sl_matrix_f32_get(&data, (size_t)lineno, 14),
-              sl_matrix_f32_get(&data, (size_t)lineno, 15),
-              sl_matrix_f32_get(&data, (size_t)lineno, 16),
-              sl_matrix_f32_get(&data, (size_t)lineno, 17),
-              sl_matrix_f32_get(&data, (size_t)lineno, 18),
-              sl_matrix_f32_get(&data, (size_t)lineno, 19),
-              sl_matrix_f32_get(&data, (size_t)lineno, 20),
-              sl_matrix_f32_get(&data, (size_t)lineno, 21),
-              sl_matrix_f32_get(&data, (size_t)lineno, 22),
-              sl_matrix_f32_get(&data, (size_t)lineno, 23),
-              sl_matrix_f32_get(&data, (size_t)lineno, 24),
-              sl_matrix_f32_get(&data, (size_t)lineno, 25),
-              sl_matrix_f32_get(&data, (size_t)lineno, 26),
-              sl_matrix_f32_get(&data, (size_t)lineno, 27),
-              sl_matrix_f32_get(&data, (size_t)lineno, 28),
-              sl_matrix_f32_get(&data, (size_t)lineno, 29),
-              sl_matrix_f32_get(&data, (size_t)lineno, 30),
-              sl_matrix_f32_get(&data, (size_t)lineno, 31),
-              sl_matrix_f32_get(&data, (size_t)lineno, 32),
-              sl_matrix_f32_get(&data, (size_t)lineno, 33),
-              sl_matrix_f32_get(&data, (size_t)lineno, 34),
-              sl_matrix_f32_get(&data, (size_t)lineno, 35),
-              sl_matrix_f32_get(&data, (size_t)lineno, 36),
-              sl_matrix_f32_get(&data, (size_t)lineno, 37),
-              sl_matrix_f32_get(&data, (size_t)lineno, 38),
-              sl_matrix_f32_get(&data, (size_t)lineno, 39),
-              sl_matrix_f32_get(&data, (size_t)lineno, 40),
-              sl_matrix_f32_get(&data, (size_t)lineno, 41),
-              sl_matrix_f32_get(&data, (size_t)lineno, 42),
-              sl_matrix_f32_get(&data, (size_t)lineno, 43),
-              sl_matrix_f32_get(&data, (size_t)lineno, 44),
-              sl_matrix_f32_get(&data, (size_t)lineno, 45),
-              sl_matrix_f32_get(&data, (size_t)lineno, 46),
-              sl_matrix_f32_get(&data, (size_t)lineno, 47),
-              sl_matrix_f32_get(&data, (size_t)lineno, 48),
-              sl_matrix_f32_get(&data, (size_t)lineno, 49),
-              sl_matrix_f32_get(&data, (size_t)lineno, 50),
-              sl_matrix_f32_get(&data, (size_t)lineno, 51),
-              sl_matrix_f32_get(&data, (size_t)lineno, 52),
-              sl_matrix_f32_get(&data, (size_t)lineno, 53),
-              sl_matrix_f32_get(&data, (size_t)lineno, 54),
-              sl_matrix_f32_get(&data, (size_t)lineno, 55),
-              sl_matrix_f32_get(&data, (size_t)lineno, 56),
               &label
           )) {
         SL_LOG_ERROR("failed parsing CSV line %d", lineno);
@@ -355,6 +324,287 @@ done:
 //
 // http://www.ai.mit.edu/projects/jmlr/papers/volume5/lewis04a/lyrl2004_rcv1v2_README.htm
 // 2024-06-23
+struct sl_rcv1_metadata {
+  size_t index;
+  bool in_trainset;
+  bool is_ccat_class;
+  bool has_value;
+};
+
+// vectors files of one samples record, each file is converted into its own shard
+struct sl_rcv1_vectors {
+  const char* dataset_dir;
+  const char* const* names;
+  struct sl_rcv1_metadata* metadata;
+  size_t max_document_id;
+  // value ranges of the samples, one scaler per shard
+  struct sl_ml_minmax_scaler* minmax;
+  bool in_trainset;
+};
+
+// skips spaces between the values on one line of an RCV1 vectors file
+static size_t rcv1_skip_blank(size_t end, const char text[static end], size_t pos) {
+  while (pos < end && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r')) {
+    ++pos;
+  }
+  return pos;
+}
+
+static bool rcv1_write_vectors(
+    struct sl_context ctx[static 1],
+    struct sl_record_writer writer[const static 1],
+    const size_t shard_idx,
+    void* arg
+) {
+  const struct sl_rcv1_vectors* vectors = arg;
+  const char* const batch_name          = vectors->names[shard_idx];
+  const size_t max_document_id          = vectors->max_document_id;
+  struct sl_rcv1_metadata* metadata     = vectors->metadata;
+
+  bool all_ok                = false;
+  struct sl_span content     = {0};
+  struct sl_vector_f32 batch = {0};
+
+  if (!sl_la_vector_create(ctx, SL_DATASET_RCV1_FEATURES, &batch)) {
+    SL_LOG_ERROR("failed allocating RCV1 sample vector");
+    goto done;
+  }
+
+  char path[1024] = {0};
+  if (!sl_file_format_path(SL_ARRAY_LEN(path), path, vectors->dataset_dir, batch_name, ".dat")) {
+    SL_LOG_ERROR("failed formatting path '%s/%s.dat'", vectors->dataset_dir, batch_name);
+    goto done;
+  }
+
+  if (!sl_fs_map_file(ctx, path, &content)) {
+    SL_LOG_ERROR("cannot open file '%s' for reading", path);
+    goto done;
+  }
+
+  SL_LOG_INFO("reading RCV1 vectors from '%s' into shard %zu", path, shard_idx);
+
+  const char* const text = (const char*)content.data;
+  const size_t text_len  = content.size;
+
+  size_t lineno = 0;
+
+  for (size_t pos = 0, end = 0; pos < text_len; pos = end + 1, ++lineno) {
+    const char* const newline = memchr(text + pos, '\n', text_len - pos);
+    end                       = newline ? (size_t)(newline - text) : text_len;
+
+    uint64_t id         = 0;
+    const size_t n_read = sl_number_parse_u64(end - pos, text + pos, &id);
+    if (n_read == 0 || id >= max_document_id || !metadata[id].has_value) {
+      SL_LOG_ERROR(
+          "RCV1 file '%s' lineno %zu: unknown document with ID %zu",
+          path,
+          lineno,
+          (size_t)id
+      );
+      goto done;
+    }
+    pos += n_read;
+
+    metadata[id].in_trainset = vectors->in_trainset;
+
+    if (lineno % 10'000 == 0) {
+      SL_LOG_INFO(
+          "RCV1 file '%s' lineno %zu: document ID %zu sample index %zu",
+          path,
+          lineno,
+          (size_t)id,
+          metadata[id].index
+      );
+    }
+
+    sl_la_vector_clear(&batch);
+
+    for (pos = rcv1_skip_blank(end, text, pos); pos < end; pos = rcv1_skip_blank(end, text, pos)) {
+      uint64_t feature_id = 0;
+      size_t n_feature    = sl_number_parse_u64(end - pos, text + pos, &feature_id);
+      if (n_feature == 0 || feature_id == 0 || feature_id > SL_DATASET_RCV1_FEATURES) {
+        SL_LOG_ERROR("RCV1 file '%s' lineno %zu: cannot parse invalid feature ID", path, lineno);
+        goto done;
+      }
+      pos += n_feature;
+
+      if (pos == end || text[pos] != ':') {
+        SL_LOG_ERROR(
+            "RCV1 file '%s' lineno %zu: expected ':' after feature ID %zu",
+            path,
+            lineno,
+            (size_t)feature_id
+        );
+        goto done;
+      }
+      ++pos;
+
+      float value = 0;
+      n_feature   = sl_number_parse_f32(ctx, end - pos, text + pos, &value);
+      if (n_feature == 0) {
+        SL_LOG_ERROR(
+            "RCV1 file '%s' lineno %zu feature %zu: cannot parse float",
+            path,
+            lineno,
+            (size_t)feature_id
+        );
+        goto done;
+      }
+      if (value < 0 || value > 1) {
+        SL_LOG_ERROR(
+            "RCV1 file '%s' lineno %zu feature %zu value %g not in [0, 1]",
+            path,
+            lineno,
+            (size_t)feature_id,
+            (double)value
+        );
+        goto done;
+      }
+      batch.data[feature_id - 1] = value;
+
+      pos += n_feature;
+    }
+
+    sl_ml_minmax_fit_vector(vectors->minmax + shard_idx, &batch);
+
+    struct sl_span write_buffer
+        = sl_span_view(sizeof(float) * sl_vector_f32_size(&batch), (void*)(batch.data));
+    // TODO len N buffer instead of len 1
+    if (!sl_record_writer_write(ctx, writer, &write_buffer)) {
+      SL_LOG_ERROR("RCV1 file '%s' lineno %zu: failed writing sample", path, lineno);
+      goto done;
+    }
+    writer->record->dim_size[0] += 1;
+  }
+
+  all_ok = true;
+done:
+  sl_fs_unmap_file(&content);
+  sl_la_vector_destroy(&batch);
+  return all_ok;
+}
+
+// merges the value ranges of all shards of samples and writes them as a 2 x n_features record
+// named after samples, lo is on the first row and hi on the second
+static bool rcv1_write_minmax(
+    struct sl_context ctx[static 1],
+    const struct sl_record samples[const static 1],
+    const size_t n_shards,
+    struct sl_ml_minmax_scaler minmax[const static n_shards]
+) {
+  for (size_t k = 1; k < n_shards; ++k) {
+    sl_ml_minmax_merge(minmax, minmax + k);
+  }
+  struct sl_record record = {
+      .layout   = "dense",
+      .type     = "float32",
+      .size     = 2 * SL_DATASET_RCV1_FEATURES,
+      .n_dims   = 2,
+      .dim_size = {2, SL_DATASET_RCV1_FEATURES},
+  };
+  memcpy(record.path, samples->path, sizeof(record.path));
+  const int name_len = snprintf(
+      record.name,
+      sizeof(record.name),
+      "%s" SL_DATASET_RCV1_MINMAX_SUFFIX,
+      samples->name
+  );
+  if (name_len < 0 || (size_t)name_len >= sizeof(record.name)) {
+    SL_LOG_ERROR("name of the value ranges record of '%s' is too long", samples->name);
+    return false;
+  }
+  // lo and hi of the first scaler are adjacent in the buffer
+  if (!(sl_record_write_metadata(ctx, &record)
+        && sl_record_write_all(
+            ctx,
+            &record,
+            sizeof(float) * record.size,
+            (void*)(minmax[0].lo.data)
+        ))) {
+    SL_LOG_ERROR("failed writing RCV1 value ranges to '%s'", record.path);
+    return false;
+  }
+  return true;
+}
+
+// reads the topic of each document from lines "category document_id 1",
+// a document is of class CCAT if its last line has the category CCAT
+static bool rcv1_read_topics(
+    struct sl_context ctx[static 1],
+    const char path[const static 1],
+    const size_t max_document_id,
+    struct sl_rcv1_metadata metadata[const static 1]
+) {
+  bool all_ok            = false;
+  struct sl_span content = {0};
+
+  if (!sl_fs_map_file(ctx, path, &content)) {
+    SL_LOG_ERROR("cannot open file '%s' for reading", path);
+    goto done;
+  }
+
+  SL_LOG_INFO("reading RCV1 topics from '%s'", path);
+
+  const char* const text = (const char*)content.data;
+  const size_t text_len  = content.size;
+
+  size_t lineno = 0;
+
+  for (size_t pos = 0, end = 0; pos < text_len; pos = end + 1, ++lineno) {
+    const char* const newline = memchr(text + pos, '\n', text_len - pos);
+    end                       = newline ? (size_t)(newline - text) : text_len;
+
+    pos = rcv1_skip_blank(end, text, pos);
+    if (pos == end) {
+      continue;
+    }
+
+    const size_t category_begin = pos;
+    while (pos < end && text[pos] != ' ' && text[pos] != '\t' && text[pos] != '\r') {
+      ++pos;
+    }
+    const size_t category_len = pos - category_begin;
+    pos                       = rcv1_skip_blank(end, text, pos);
+
+    uint64_t id         = 0;
+    const size_t n_read = sl_number_parse_u64(end - pos, text + pos, &id);
+    if (n_read == 0) {
+      SL_LOG_ERROR("RCV1 file '%s' lineno %zu: cannot parse document ID", path, lineno);
+      goto done;
+    }
+    if (id >= max_document_id) {
+      SL_LOG_ERROR(
+          "RCV1 file '%s' lineno %zu: unexpectedly large document ID %zu",
+          path,
+          lineno,
+          (size_t)id
+      );
+      goto done;
+    }
+    pos = rcv1_skip_blank(end, text, pos + n_read);
+
+    int64_t relevance     = 0;
+    const size_t n_suffix = sl_number_parse_i64(end - pos, text + pos, &relevance);
+    if (n_suffix == 0 || rcv1_skip_blank(end, text, pos + n_suffix) != end) {
+      SL_LOG_ERROR(
+          "RCV1 file '%s' lineno %zu: expected a number after document ID %zu",
+          path,
+          lineno,
+          (size_t)id
+      );
+      goto done;
+    }
+
+    metadata[id].is_ccat_class
+        = category_len == 4 && memcmp(text + category_begin, "CCAT", category_len) == 0;
+  }
+
+  all_ok = true;
+done:
+  sl_fs_unmap_file(&content);
+  return all_ok;
+}
+
 bool rcv1(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
   if (sl_args_count_positional(args) != 3) {
     SL_ERROR(ctx, "too few arguments to RCV1 extractor");
@@ -364,8 +614,9 @@ bool rcv1(struct sl_context ctx[static 1], const struct sl_args args[const stati
   // TODO way too much code
   bool all_ok = false;
 
-  const char* const dataset_dir = sl_args_get_positional(args, 1);
-  const char* const output_dir  = sl_args_get_positional(args, 2);
+  const char* const dataset_dir    = sl_args_get_positional(args, 1);
+  const char* const output_dir     = sl_args_get_positional(args, 2);
+  const char* const samples_layout = sl_args_parse_flag(args, "--blocked") ? "blocked" : "sparse";
 
   SL_LOG_INFO(
       "reading RCV1 dataset with dimensions %d x %d from '%s', writing "
@@ -376,21 +627,11 @@ bool rcv1(struct sl_context ctx[static 1], const struct sl_args args[const stati
       output_dir
   );
 
-  struct sl_rcv1_metadata {
-    size_t index;
-    bool in_trainset;
-    bool is_ccat_class;
-    bool has_value;
-  };
-
   const size_t max_document_id = 2 * SL_DATASET_RCV1_SAMPLES;
 
-  FILE* fp = nullptr;
-
   struct sl_rcv1_metadata* metadata
       = sl_alloc(ctx, max_document_id + 1, sizeof(struct sl_rcv1_metadata));
-
-  struct sl_vector_f32 batch = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES);
+  float* minmax_data = nullptr;
 
   struct sl_record train_record           = {0};
   struct sl_file train_record_file        = {0};
@@ -408,31 +649,47 @@ bool rcv1(struct sl_context ctx[static 1], const struct sl_args args[const stati
       goto done;
     }
 
-    fp = fopen(path, "r");
-    if (!fp) {
+    struct sl_span ids = {0};
+    if (!sl_fs_map_file(ctx, path, &ids)) {
       SL_LOG_ERROR("cannot open file '%s' for reading", path);
       goto done;
     }
 
     SL_LOG_INFO("reading RCV1 document IDs from '%s'", path);
 
-    for (size_t id = 0, idx = 0; 1 == fscanf(fp, "%zu ", &id); ++idx) {
-      if (id >= max_document_id) {
-        SL_LOG_ERROR("unexpectedly large RCV1 document ID %zu at index %zu", id, idx);
-        goto done;
+    const char* const text = (const char*)ids.data;
+    bool ids_ok            = true;
+    for (size_t pos = 0, idx = 0; ids_ok; ++idx) {
+      while (pos < ids.size && isspace((unsigned char)text[pos])) {
+        ++pos;
       }
-      if (metadata[id].has_value) {
-        SL_LOG_ERROR("duplicate RCV1 document ID %zu at index %zu", id, idx);
-        goto done;
+      if (pos == ids.size) {
+        break;
+      }
+      uint64_t id         = 0;
+      const size_t n_read = sl_number_parse_u64(ids.size - pos, text + pos, &id);
+      if (n_read == 0) {
+        SL_LOG_ERROR("cannot parse RCV1 document ID at index %zu", idx);
+        ids_ok = false;
+      } else if (id >= max_document_id) {
+        SL_LOG_ERROR("unexpectedly large RCV1 document ID %zu at index %zu", (size_t)id, idx);
+        ids_ok = false;
+      } else if (metadata[id].has_value) {
+        SL_LOG_ERROR("duplicate RCV1 document ID %zu at index %zu", (size_t)id, idx);
+        ids_ok = false;
+      } else {
+        metadata[id] = (struct sl_rcv1_metadata){
+            .index     = idx,
+            .has_value = true,
+        };
       }
-      metadata[id] = (struct sl_rcv1_metadata){
-          .index     = idx,
-          .has_value = true,
-      };
+      pos += n_read;
     }
 
-    fclose(fp);
-    fp = nullptr;
+    sl_fs_unmap_file(&ids);
+    if (!ids_ok) {
+      goto done;
+    }
   }
 
   {
@@ -443,220 +700,113 @@ bool rcv1(struct sl_context ctx[static 1], const struct sl_args args[const stati
       goto done;
     }
 
-    fp = fopen(path, "r");
-    if (!fp) {
-      SL_LOG_ERROR("cannot open file '%s' for reading", path);
+    if (!rcv1_read_topics(ctx, path, max_document_id, metadata)) {
       goto done;
     }
-
-    SL_LOG_INFO("reading RCV1 topics from '%s'", path);
-
-    {
-      char category[16] = {0};
-      size_t id         = 0;
-      while (EOF != fscanf(fp, "%15s %zu %*d ", category, &id)) {
-        if (id >= max_document_id) {
-          SL_LOG_ERROR(
-              "unexpectedly large RCV1 document ID %zu while parsing topic "
-              "category",
-              id
-          );
-          goto done;
-        }
-        metadata[id].is_ccat_class = SL_STR_EQ(category, "CCAT");
-      }
-    }
-
-    fclose(fp);
-    fp = nullptr;
   }
 
   train_record = (struct sl_record){
-      .layout   = "sparse",
       .type     = "float32",
       .name     = "rcv1_train_samples",
       .n_dims   = 2,
       .dim_size = {0, SL_DATASET_RCV1_FEATURES},
   };
+  strncpy(train_record.layout, samples_layout, sizeof(train_record.layout) - 1);
   if (strlen(output_dir) >= sizeof(train_record.path)) {
     SL_LOG_ERROR("output_dir too long");
     goto done;
   }
   strncpy(train_record.path, output_dir, sizeof(train_record.path) - 1);
   train_record.path[sizeof(train_record.path) - 1] = '\0';
-  train_record_file                                = (struct sl_file){0};
-  trainset_writer                                  = (struct sl_record_writer){
-                                       .file   = &train_record_file,
-                                       .record = &train_record,
-  };
-
   test_record = (struct sl_record){
-      .layout   = "sparse",
       .type     = "float32",
       .name     = "rcv1_test_samples",
       .n_dims   = 2,
       .dim_size = {0, SL_DATASET_RCV1_FEATURES},
   };
+  strncpy(test_record.layout, samples_layout, sizeof(test_record.layout) - 1);
   if (strlen(output_dir) >= sizeof(test_record.path)) {
     SL_LOG_ERROR("output_dir too long");
     goto done;
   }
   strncpy(test_record.path, output_dir, sizeof(test_record.path) - 1);
   test_record.path[sizeof(test_record.path) - 1] = '\0';
-  test_record_file                               = (struct sl_file){0};
-  testset_writer                                 = (struct sl_record_writer){
-                                      .file   = &test_record_file,
-                                      .record = &test_record,
-  };
 
-  if (!sl_record_writer_open(ctx, &trainset_writer)) {
-    SL_LOG_ERROR("cannot open training set samples record writer");
-    goto done;
-  }
-  if (!sl_record_writer_open(ctx, &testset_writer)) {
-    SL_LOG_ERROR("cannot open test set samples record writer");
-    goto done;
-  }
-
-  const char* batch_names[] = {
+  const char* test_names[] = {
       "lyrl2004_vectors_test_pt0",
       "lyrl2004_vectors_test_pt1",
       "lyrl2004_vectors_test_pt2",
       "lyrl2004_vectors_test_pt3",
+  };
+  const char* train_names[] = {
       "lyrl2004_vectors_train",
   };
 
-  for (size_t batch_idx = 0; batch_idx < SL_ARRAY_LEN(batch_names); ++batch_idx) {
-    const char* batch_name = batch_names[batch_idx];
-    char path[1024]        = {0};
-    if (!sl_file_format_path(SL_ARRAY_LEN(path), path, dataset_dir, batch_name, ".dat")) {
-      SL_LOG_ERROR("failed formatting path '%s/%s.dat'", dataset_dir, batch_name);
-      goto done;
-    }
-
-    fp = fopen(path, "r");
-    if (!fp) {
-      SL_LOG_ERROR("cannot open file '%s' for reading", path);
-      goto done;
-    }
-
-    SL_LOG_INFO("reading RCV1 vectors from '%s'", path);
-
-    size_t lineno = 0;
-
-    for (char line[32768] = {0}, newline = 0; EOF != fscanf(fp, "%32767[^\n]%c", line, &newline);
-         ++lineno, newline               = 0) {
-      if (newline && newline != '\n') {
-        SL_LOG_ERROR(
-            "RCV1 file '%s' lineno %zu: too long line for line buffer of "
-            "length %zu",
-            path,
-            lineno,
-            SL_ARRAY_LEN(line)
-        );
-        goto done;
-      }
-
-      char* lhs = line;
-      char* rhs = nullptr;
-
-      unsigned long id = strtoul(lhs, &rhs, 10);
-      if (id >= max_document_id || !metadata[id].has_value) {
-        SL_LOG_ERROR("RCV1 file '%s' lineno %zu: unknown document with ID %zu", path, lineno, id);
-        goto done;
-      }
-
-      metadata[id].in_trainset = SL_STR_EQ(batch_name, "lyrl2004_vectors_train");
-
-      if (lineno % 10'000 == 0) {
-        SL_LOG_INFO(
-            "RCV1 file '%s' lineno %zu: document ID %zu sample index %zu",
-            path,
-            lineno,
-            id,
-            metadata[id].index
-        );
-      }
-
-      sl_la_vector_clear(&batch);
-
-      for (lhs = rhs; lhs && lhs[0];) {
-        unsigned long feature_id = strtoul(lhs, &rhs, 10);
-        if (lhs == rhs || errno == ERANGE || feature_id == 0
-            || feature_id > SL_DATASET_RCV1_FEATURES) {
-          SL_LOG_ERROR("RCV1 file '%s' lineno %zu: cannot parse invalid feature ID", path, lineno);
-          errno = 0;
-          goto done;
-        }
-
-        lhs = rhs;
-        if (lhs[0] != ':') {
-          SL_LOG_ERROR(
-              "RCV1 file '%s' lineno %zu: expected ':' after feature ID %lu",
-              path,
-              lineno,
-              feature_id
-          );
-          goto done;
-        }
-        ++lhs;
-
-        float value = strtof(lhs, &rhs);
-        if (lhs == rhs || errno == ERANGE) {
-          SL_LOG_ERROR(
-              "RCV1 file '%s' lineno %zu feature %lu: cannot parse float",
-              path,
-              lineno,
-              feature_id
-          );
-          errno = 0;
-          goto done;
-        }
-        if (value < 0 || value > 1) {
-          SL_LOG_ERROR(
-              "RCV1 file '%s' lineno %zu feature %lu value %g not in [0, 1]",
-              path,
-              lineno,
-              feature_id,
-              (double)value
-          );
-          errno = 0;
-          goto done;
-        }
-        batch.data[feature_id - 1] = value;
-
-        lhs = rhs;
-      }
-
-      struct sl_span write_buffer
-          = sl_span_view(sizeof(float) * sl_vector_f32_size(&batch), (void*)(batch.data));
-
-      if (metadata[id].in_trainset) {
-        // TODO len N buffer instead of len 1
-        train_record.dim_size[0] += 1;
-        if (!sl_record_writer_write(ctx, &trainset_writer, &write_buffer)) {
-          SL_LOG_ERROR(
-              "RCV1 file '%s' lineno %zu: failed training set writing sample",
-              path,
-              lineno
-          );
-          goto done;
-        }
-      } else {
-        test_record.dim_size[0] += 1;
-        if (!sl_record_writer_write(ctx, &testset_writer, &write_buffer)) {
-          SL_LOG_ERROR("RCV1 file '%s' lineno %zu: failed writing test set sample", path, lineno);
-          goto done;
-        }
-      }
-    }
+  // lo and hi of each shard, the test and training sets are converted one after the other
+  minmax_data
+      = sl_alloc(ctx, 2 * SL_ARRAY_LEN(test_names) * SL_DATASET_RCV1_FEATURES, sizeof(float));
+  if (!minmax_data) {
+    SL_LOG_ERROR("failed allocating RCV1 value ranges");
+    goto done;
+  }
+  struct sl_ml_minmax_scaler minmax[SL_ARRAY_LEN(test_names)] = {0};
+  for (size_t k = 0; k < SL_ARRAY_LEN(minmax); ++k) {
+    struct sl_vector_f32 lo = {
+        .length   = {SL_DATASET_RCV1_FEATURES},
+        .capacity = {SL_DATASET_RCV1_FEATURES},
+        .data     = minmax_data + (2 * k * SL_DATASET_RCV1_FEATURES),
+    };
+    struct sl_vector_f32 hi = lo;
+    hi.data += SL_DATASET_RCV1_FEATURES;
+    minmax[k] = (struct sl_ml_minmax_scaler){.lo = lo, .hi = hi};
+    sl_ml_minmax_reset(minmax + k);
+  }
 
-    fclose(fp);
-    fp = nullptr;
+  SL_LOG_INFO("converting %zu RCV1 test set files in parallel", SL_ARRAY_LEN(test_names));
+  if (!sl_record_write_shards(
+          ctx,
+          &test_record,
+          SL_ARRAY_LEN(test_names),
+          rcv1_write_vectors,
+          &((struct sl_rcv1_vectors){
+              .dataset_dir     = dataset_dir,
+              .names           = test_names,
+              .metadata        = metadata,
+              .max_document_id = max_document_id,
+              .minmax          = minmax,
+              .in_trainset     = false,
+          })
+      )) {
+    SL_LOG_ERROR("failed writing RCV1 test set samples");
+    goto done;
+  }
+  if (!rcv1_write_minmax(ctx, &test_record, SL_ARRAY_LEN(test_names), minmax)) {
+    goto done;
   }
 
-  train_record.size = trainset_writer.n_written;
-  test_record.size  = testset_writer.n_written;
+  for (size_t k = 0; k < SL_ARRAY_LEN(minmax); ++k) {
+    sl_ml_minmax_reset(minmax + k);
+  }
+  if (!sl_record_write_shards(
+          ctx,
+          &train_record,
+          SL_ARRAY_LEN(train_names),
+          rcv1_write_vectors,
+          &((struct sl_rcv1_vectors){
+              .dataset_dir     = dataset_dir,
+              .names           = train_names,
+              .metadata        = metadata,
+              .max_document_id = max_document_id,
+              .minmax          = minmax,
+              .in_trainset     = true,
+          })
+      )) {
+    SL_LOG_ERROR("failed writing RCV1 training set samples");
+    goto done;
+  }
+  if (!rcv1_write_minmax(ctx, &train_record, SL_ARRAY_LEN(train_names), minmax)) {
+    goto done;
+  }
 
   if (!sl_record_write_metadata(ctx, &train_record)) {
     SL_LOG_ERROR("failed writing RCV1 metadata for training set samples");
@@ -667,9 +817,6 @@ bool rcv1(struct sl_context ctx[static 1], const struct sl_args args[const stati
     goto done;
   }
 
-  sl_record_writer_close(&trainset_writer);
-  sl_record_writer_close(&testset_writer);
-
   train_record = (struct sl_record){
       .layout   = "dense",
       .type     = "uint8",
@@ -751,10 +898,8 @@ bool rcv1(struct sl_context ctx[static 1], const struct sl_args args[const stati
 
   all_ok = true;
 done:
-  if (fp) {
-    fclose(fp);
-  }
   sl_free(metadata);
+  sl_free(minmax_data);
   sl_record_writer_close(&trainset_writer);
   sl_record_writer_close(&testset_writer);
   return all_ok;
@@ -765,7 +910,7 @@ void print_usage(const struct sl_args args[const static 1]) {
       stderr,
       ("usage: %s cifar_to_png dataset_path output_path\n"
        "usage: %s spambase dataset_path output_path\n"
-       "usage: %s rcv1 dataset_path output_path\n"),
+       "usage: %s rcv1 dataset_path output_path [--blocked]\n"),
       args->argv[0],
       args->argv[0],
       args->argv[0]
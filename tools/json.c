@@ -1,24 +1,32 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <pthread.h>
 
 #include <stufflib/args/args.h>
 #include <stufflib/context/context.h>
 #include <stufflib/filesystem/filesystem.h>
 #include <stufflib/json/json.h>
 #include <stufflib/macros/macros.h>
+#include <stufflib/memory/memory.h>
 #include <stufflib/span/span.h>
 
+// NDJSON input is processed in rounds of one chunk per thread, each chunk ends at a newline
+#define SL_NDJSON_CHUNK_SIZE 8'388'608
+#define SL_NDJSON_MAX_THREADS 256
+
 void print_usage(const struct sl_args args[const static 1]) {
   fprintf(
       stderr,
       ("usage:"
        "\n"
-       "  %s check [-v] path"
+       "  %s check [-v] [--ndjson] [--threads=N] path"
        "\n"
-       "  %s count-nodes path"
+       "  %s count-nodes [--ndjson] [--threads=N] path"
        "\n"
-       "  %s get json_path path"
+       "  %s get [--ndjson] [--threads=N] json_path [json_path ...] path"
        "\n"),
       args->argv[0],
       args->argv[0],
@@ -26,6 +34,252 @@ void print_usage(const struct sl_args args[const static 1]) {
   );
 }
 
+enum sl_ndjson_command : unsigned char {
+  sl_ndjson_check,
+  sl_ndjson_count_nodes,
+  sl_ndjson_get,
+};
+
+struct sl_ndjson {
+  enum sl_ndjson_command command;
+  const char* path;
+  size_t n_threads;
+  // get only
+  char* const* json_paths;
+  const struct sl_json_path_trie* trie;
+};
+
+struct sl_ndjson_task {
+  struct sl_context ctx;
+  const struct sl_ndjson* ndjson;
+  size_t size;
+  const char* data;
+  struct sl_json_node* nodes;
+  // output of all lines of the chunk, written after all previous chunks
+  size_t output_size;
+  size_t output_capacity;
+  char* output;
+  // lines processed, including the failed line
+  size_t n_lines;
+  pthread_t thread;
+  bool is_started;
+  bool ok;
+};
+
+bool sl_ndjson_write(
+    struct sl_context ctx[static 1],
+    struct sl_ndjson_task task[const static 1],
+    const size_t size,
+    const char data[const static size]
+) {
+  if (task->output_capacity - task->output_size < size) {
+    size_t capacity = task->output_capacity ? task->output_capacity : 4096;
+    while (capacity - task->output_size < size) {
+      capacity *= 2;
+    }
+    char* output = sl_realloc(ctx, task->output, task->output_capacity, capacity, 1);
+    if (!output) {
+      SL_ERROR(ctx, "failed growing output buffer to %zu bytes", capacity);
+      return false;
+    }
+    task->output          = output;
+    task->output_capacity = capacity;
+  }
+  memcpy(task->output + task->output_size, data, size);
+  task->output_size += size;
+  return true;
+}
+
+bool sl_ndjson_process_line(
+    struct sl_context ctx[static 1],
+    struct sl_ndjson_task task[const static 1],
+    const size_t line_len,
+    const char line[const static line_len]
+) {
+  const struct sl_ndjson* ndjson = task->ndjson;
+
+  switch (ndjson->command) {
+    case sl_ndjson_check: {
+      return sl_json_is_valid(ctx, line_len, line);
+    }
+    case sl_ndjson_count_nodes: {
+      const size_t n = sl_json_count_nodes(ctx, line_len, line);
+      if (sl_context_error_occurred(ctx)) {
+        return false;
+      }
+      char count[32]   = {0};
+      const int length = snprintf(count, sizeof(count), "%zu\n", n);
+      return sl_ndjson_write(ctx, task, (size_t)length, count);
+    }
+    case sl_ndjson_get: {
+      const struct sl_json_path_trie* trie = ndjson->trie;
+      if (sl_json_find_paths(ctx, trie, line_len, line, task->nodes) != trie->n_paths) {
+        for (size_t i = 0; i < trie->n_paths && !sl_context_error_occurred(ctx); ++i) {
+          if (task->nodes[i].type == sl_json_type_NONE) {
+            SL_ERROR(ctx, "'%s' not found", ndjson->json_paths[i]);
+          }
+        }
+        return false;
+      }
+      for (size_t i = 0; i < trie->n_paths; ++i) {
+        const struct sl_json_node* node = task->nodes + i;
+        if (!sl_ndjson_write(ctx, task, node->value_len, line + node->value_begin)
+            || !sl_ndjson_write(ctx, task, 1, "\n")) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+void* sl_ndjson_run(void* arg) {
+  struct sl_ndjson_task* task = arg;
+  task->output_size           = 0;
+  task->n_lines               = 0;
+  task->ok                    = true;
+
+  for (size_t begin = 0; begin < task->size;) {
+    const char* line      = task->data + begin;
+    const char* newline   = memchr(line, '\n', task->size - begin);
+    const size_t line_len = newline ? (size_t)(newline - line) : task->size - begin;
+    begin += line_len + 1;
+    ++(task->n_lines);
+    // blank lines separate nothing
+    if (line_len == 0 || (line_len == 1 && line[0] == '\r')) {
+      continue;
+    }
+    if (!sl_ndjson_process_line(&(task->ctx), task, line_len, line)) {
+      task->ok = false;
+      break;
+    }
+  }
+  return nullptr;
+}
+
+bool sl_ndjson_run_all(
+    struct sl_context ctx[static 1],
+    const struct sl_ndjson ndjson[const static 1]
+) {
+  bool ok                      = false;
+  struct sl_span data          = {0};
+  struct sl_ndjson_task* tasks = nullptr;
+  const size_t n_threads       = ndjson->n_threads;
+  const size_t n_paths         = ndjson->trie ? ndjson->trie->n_paths : 0;
+
+  if (!sl_fs_map_file(ctx, ndjson->path, &data)) {
+    goto done;
+  }
+  if (data.size == 0) {
+    SL_ERROR(ctx, "%s is empty", ndjson->path);
+    goto done;
+  }
+  tasks = sl_alloc(ctx, n_threads, sizeof(*tasks));
+  if (!tasks) {
+    SL_ERROR(ctx, "failed allocating %zu NDJSON tasks", n_threads);
+    goto done;
+  }
+  for (size_t k = 0; k < n_threads; ++k) {
+    tasks[k].ndjson = ndjson;
+    if (n_paths > 0) {
+      tasks[k].nodes = sl_alloc(ctx, n_paths, sizeof(struct sl_json_node));
+      if (!tasks[k].nodes) {
+        SL_ERROR(ctx, "failed allocating %zu JSON nodes", n_paths);
+        goto done;
+      }
+    }
+  }
+
+  const char* json = (const char*)data.data;
+  size_t n_lines   = 0;
+  for (size_t pos = 0; pos < data.size;) {
+    size_t n_tasks = 0;
+    for (; n_tasks < n_threads && pos < data.size; ++n_tasks) {
+      size_t end = pos + SL_MIN(data.size - pos, (size_t)SL_NDJSON_CHUNK_SIZE);
+      if (end < data.size) {
+        const char* newline = memchr(json + end, '\n', data.size - end);
+        end                 = newline ? (size_t)(newline - json) + 1 : data.size;
+      }
+      tasks[n_tasks].data = json + pos;
+      tasks[n_tasks].size = end - pos;
+      pos                 = end;
+    }
+
+    for (size_t k = 0; k < n_tasks; ++k) {
+      const int err = pthread_create(&(tasks[k].thread), nullptr, sl_ndjson_run, tasks + k);
+      if (err != 0) {
+        SL_ERROR(ctx, "failed starting NDJSON thread %zu (%s)", k, strerror(err));
+        goto done;
+      }
+      tasks[k].is_started = true;
+    }
+    for (size_t k = 0; k < n_tasks; ++k) {
+      pthread_join(tasks[k].thread, nullptr);
+      tasks[k].is_started = false;
+    }
+
+    // write chunk outputs in input order up to the first failed line
+    for (size_t k = 0; k < n_tasks; ++k) {
+      struct sl_ndjson_task* task = tasks + k;
+      if (task->output_size > 0
+          && (fwrite(task->output, 1, task->output_size, stdout) != task->output_size
+              || ferror(stdout))) {
+        SL_ERROR(ctx, "failed writing output of %zu bytes", task->output_size);
+        goto done;
+      }
+      n_lines += task->n_lines;
+      if (!task->ok) {
+        sl_context_move_errors(ctx, &(task->ctx));
+        SL_ERROR(ctx, "failed processing line %zu of %s", n_lines, ndjson->path);
+        goto done;
+      }
+    }
+  }
+  if (fflush(stdout) != 0 || ferror(stdout)) {
+    SL_ERROR(ctx, "failed writing output");
+    goto done;
+  }
+
+  ok = true;
+done:
+  if (tasks) {
+    for (size_t k = 0; k < n_threads; ++k) {
+      if (tasks[k].is_started) {
+        pthread_join(tasks[k].thread, nullptr);
+      }
+      sl_free(tasks[k].nodes);
+      sl_free(tasks[k].output);
+    }
+  }
+  sl_free(tasks);
+  sl_fs_unmap_file(&data);
+  return ok;
+}
+
+// returns true if args ask for NDJSON input, one JSON document per line
+bool sl_ndjson_parse_args(
+    const struct sl_args args[const static 1],
+    const enum sl_ndjson_command command,
+    const char path[const static 1],
+    struct sl_ndjson ndjson[const static 1]
+) {
+  if (!sl_args_parse_flag(args, "--ndjson")) {
+    return false;
+  }
+  size_t n_threads = sl_args_parse_ull(args, "--threads", 10);
+  if (n_threads == 0) {
+    const long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n_threads         = n_cpus > 0 ? (size_t)n_cpus : 1;
+  }
+  *ndjson = (struct sl_ndjson){
+      .command   = command,
+      .path      = path,
+      .n_threads = SL_MIN(n_threads, (size_t)SL_NDJSON_MAX_THREADS),
+  };
+  return true;
+}
+
 bool sl_check(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
   {
     const int args_count     = sl_args_count_positional(args) - 1;
@@ -37,17 +291,26 @@ bool sl_check(struct sl_context ctx[static 1], const struct sl_args args[const s
   }
 
   const bool verbose    = sl_args_parse_flag(args, "-v");
+  const char* path      = sl_args_get_positional(args, 1);
+  struct sl_ndjson nd   = {0};
   struct sl_span buffer = {0};
   struct sl_span data   = {0};
   bool ok               = false;
 
+  if (sl_ndjson_parse_args(args, sl_ndjson_check, path, &nd)) {
+    ok = sl_ndjson_run_all(ctx, &nd);
+    if (!ok && !verbose) {
+      sl_error_clear(&ctx->errors);
+    }
+    return ok;
+  }
+
   if (!sl_span_create(ctx, 4096, &buffer)) {
     SL_ERROR(ctx, "failed allocating read buffer");
     goto done;
   }
 
-  const char* path = sl_args_get_positional(args, 1);
-  data             = sl_fs_read_file(ctx, path, &buffer);
+  data = sl_fs_read_file(ctx, path, &buffer);
   if (sl_context_error_occurred(ctx)) {
     SL_ERROR(ctx, "failed reading %s", path);
     goto done;
@@ -78,17 +341,22 @@ bool sl_count_nodes(struct sl_context ctx[static 1], const struct sl_args args[c
     }
   }
 
+  const char* path      = sl_args_get_positional(args, 1);
+  struct sl_ndjson nd   = {0};
   struct sl_span buffer = {0};
   struct sl_span data   = {0};
   bool ok               = false;
 
+  if (sl_ndjson_parse_args(args, sl_ndjson_count_nodes, path, &nd)) {
+    return sl_ndjson_run_all(ctx, &nd);
+  }
+
   if (!sl_span_create(ctx, 4096, &buffer)) {
     SL_ERROR(ctx, "failed allocating read buffer");
     goto done;
   }
 
-  const char* path = sl_args_get_positional(args, 1);
-  data             = sl_fs_read_file(ctx, path, &buffer);
+  data = sl_fs_read_file(ctx, path, &buffer);
   if (sl_context_error_occurred(ctx)) {
     SL_ERROR(ctx, "failed reading %s", path);
     goto done;
@@ -111,28 +379,74 @@ done:
   return ok;
 }
 
-bool sl_get(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
-  {
-    const int args_count     = sl_args_count_positional(args) - 1;
-    const int expected_count = 2;
-    if (args_count != expected_count) {
-      SL_ERROR(ctx, "get takes %d arguments, not %d", expected_count, args_count);
+// compiles all json_path arguments into one trie searched on each line
+bool sl_ndjson_get_all(
+    struct sl_context ctx[static 1],
+    const struct sl_args args[const static 1],
+    const int n_json_paths,
+    struct sl_ndjson ndjson[const static 1]
+) {
+  if (n_json_paths > SL_JSON_PATH_TRIE_MAX_PATHS) {
+    SL_ERROR(ctx, "get takes at most %d json paths", SL_JSON_PATH_TRIE_MAX_PATHS);
+    return false;
+  }
+  struct sl_json_path_step steps[SL_JSON_PATH_TRIE_MAX_SIZE];
+  struct sl_json_path paths[SL_JSON_PATH_TRIE_MAX_PATHS];
+  char* json_paths[SL_JSON_PATH_TRIE_MAX_PATHS];
+  size_t n_steps = 0;
+
+  for (int i = 0; i < n_json_paths; ++i) {
+    char* json_path     = sl_args_get_positional(args, i + 1);
+    const size_t n_path = sl_json_parse_path(
+        ctx,
+        strlen(json_path),
+        json_path,
+        SL_ARRAY_LEN(steps) - n_steps,
+        steps + n_steps
+    );
+    if (n_path == 0) {
+      SL_ERROR(ctx, "invalid json path '%s'", json_path);
       return false;
     }
+    json_paths[i] = json_path;
+    paths[i]      = (struct sl_json_path){.n_steps = n_path, .steps = steps + n_steps};
+    n_steps += n_path;
   }
 
-  struct sl_span buffer = {0};
-  struct sl_span data   = {0};
-  bool ok               = false;
+  struct sl_json_path_trie trie;
+  if (!sl_json_path_trie_compile(ctx, &trie, (size_t)n_json_paths, paths)) {
+    return false;
+  }
+  ndjson->json_paths = json_paths;
+  ndjson->trie       = &trie;
+  return sl_ndjson_run_all(ctx, ndjson);
+}
+
+bool sl_get(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
+  const int args_count = sl_args_count_positional(args) - 1;
+  if (args_count < 2) {
+    SL_ERROR(ctx, "get takes at least 2 arguments, not %d", args_count);
+    return false;
+  }
+  const int n_json_paths = args_count - 1;
+
+  const char* path         = sl_args_get_positional(args, args_count);
+  struct sl_ndjson nd      = {0};
+  struct sl_span buffer    = {0};
+  struct sl_span data      = {0};
+  struct sl_json_tape tape = {0};
+  bool ok                  = false;
+
+  if (sl_ndjson_parse_args(args, sl_ndjson_get, path, &nd)) {
+    return sl_ndjson_get_all(ctx, args, n_json_paths, &nd);
+  }
 
   if (!sl_span_create(ctx, 4096, &buffer)) {
     SL_ERROR(ctx, "failed allocating read buffer");
     goto done;
   }
 
-  const char* json_path = sl_args_get_positional(args, 1);
-  const char* path      = sl_args_get_positional(args, 2);
-  data                  = sl_fs_read_file(ctx, path, &buffer);
+  data = sl_fs_read_file(ctx, path, &buffer);
   if (sl_context_error_occurred(ctx)) {
     SL_ERROR(ctx, "failed reading %s", path);
     goto done;
@@ -142,22 +456,35 @@ bool sl_get(struct sl_context ctx[static 1], const struct sl_args args[const sta
     goto done;
   }
 
-  const char* json         = (const char*)data.data;
-  struct sl_json_node node = {0};
-  if (!sl_json_find(ctx, data.size, json, strlen(json_path), json_path, &node)) {
-    if (!sl_context_error_occurred(ctx)) {
-      SL_ERROR(ctx, "'%s' not found in %s", json_path, path);
-    }
+  const char* json = (const char*)data.data;
+  // parse once for many paths, a single path is searched without parsing the whole document
+  if (n_json_paths > 1 && !sl_json_tape_parse(ctx, &tape, data.size, json)) {
+    SL_ERROR(ctx, "failed parsing %s", path);
     goto done;
   }
 
-  if (printf("%.*s\n", (int)node.value_len, json + node.value_begin) < 0) {
-    goto done;
+  for (int i = 1; i <= n_json_paths; ++i) {
+    const char* json_path    = sl_args_get_positional(args, i);
+    struct sl_json_node node = {0};
+    const bool found
+        = n_json_paths > 1
+              ? sl_json_tape_find(ctx, &tape, json, strlen(json_path), json_path, &node)
+              : sl_json_find(ctx, data.size, json, strlen(json_path), json_path, &node);
+    if (!found) {
+      if (!sl_context_error_occurred(ctx)) {
+        SL_ERROR(ctx, "'%s' not found in %s", json_path, path);
+      }
+      goto done;
+    }
+    if (printf("%.*s\n", (int)node.value_len, json + node.value_begin) < 0) {
+      goto done;
+    }
   }
 
   ok = true;
 
 done:
+  sl_json_tape_destroy(&tape);
   sl_span_destroy(&data);
   sl_span_destroy(&buffer);
   return ok;
@@ -0,0 +1,423 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <stufflib/args/args.h>
+#include <stufflib/context/context.h>
+#include <stufflib/json/writer.h>
+#include <stufflib/linalg/simd.h>
+#include <stufflib/logging/logging.h>
+#include <stufflib/macros/macros.h>
+#include <stufflib/memory/memory.h>
+#include <stufflib/random/random.h>
+
+#ifdef __APPLE__
+  #define ACCELERATE_NEW_LAPACK
+  #include <Accelerate/Accelerate.h>
+#else
+  #include <cblas.h>
+#endif
+
+#define BENCH_DEFAULT_SIZE 4'096
+// default number of repeats is chosen such that each measurement covers this many items
+#define BENCH_DEFAULT_ITEMS 16'777'216
+// each measurement is the fastest of this many rounds, the first ones warm up caches and clocks
+#define BENCH_ROUNDS 3
+// relative tolerance of dot products, which are summed in a different order by each kernel
+#define BENCH_DOT_TOLERANCE 1e-4
+// relative tolerance of axpby items, which may be rounded once with fused multiply-add
+#define BENCH_AXPBY_TOLERANCE 1e-6
+
+void print_usage(const struct sl_args args[const static 1]) {
+  fprintf(stderr, "usage: %s bench [--size=N] [--repeat=R]\n", args->argv[0]);
+}
+
+enum bench_kernel : unsigned char {
+  bench_add,
+  bench_sub,
+  bench_mul,
+  bench_min,
+  bench_max,
+  bench_scale,
+  bench_axpby,
+  bench_dot,
+  bench_kernel_count,
+};
+
+static const char* const bench_kernel_names[bench_kernel_count] = {
+    [bench_add]   = "add",
+    [bench_sub]   = "sub",
+    [bench_mul]   = "mul",
+    [bench_min]   = "min",
+    [bench_max]   = "max",
+    [bench_scale] = "scale",
+    [bench_axpby] = "axpby",
+    [bench_dot]   = "dot",
+};
+
+// OpenBLAS or Accelerate has equivalents for only some of the kernels
+
+static bool blas_is_supported(void) {
+  return true;
+}
+
+static void blas_add(
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count]
+) {
+  cblas_saxpy((int)count, 1, rhs, 1, lhs, 1);
+}
+
+static void blas_sub(
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count]
+) {
+  cblas_saxpy((int)count, -1, rhs, 1, lhs, 1);
+}
+
+static void blas_scale(const size_t count, float x[count], const float alpha) {
+  cblas_sscal((int)count, alpha, x, 1);
+}
+
+static void blas_axpby(
+    const size_t count,
+    const float alpha,
+    const float x[restrict count],
+    const float beta,
+    float y[restrict count]
+) {
+#ifdef __APPLE__
+  catlas_saxpby((int)count, alpha, x, 1, beta, y, 1);
+#else
+  cblas_saxpby((int)count, alpha, x, 1, beta, y, 1);
+#endif
+}
+
+static float blas_dot(const size_t count, const float lhs[count], const float rhs[count]) {
+  return cblas_sdot((int)count, lhs, 1, rhs, 1);
+}
+
+static const struct sl_la_simd_kernels blas_kernels = {
+    .name         = "blas",
+    .is_supported = blas_is_supported,
+    .add          = blas_add,
+    .sub          = blas_sub,
+    .scale        = blas_scale,
+    .axpby        = blas_axpby,
+    .dot          = blas_dot,
+};
+
+static bool bench_has_kernel(
+    const struct sl_la_simd_kernels impl[const static 1],
+    const enum bench_kernel kernel
+) {
+  switch (kernel) {
+    case bench_add:
+      return impl->add;
+    case bench_sub:
+      return impl->sub;
+    case bench_mul:
+      return impl->mul;
+    case bench_min:
+      return impl->min;
+    case bench_max:
+      return impl->max;
+    case bench_scale:
+      return impl->scale;
+    case bench_axpby:
+      return impl->axpby;
+    case bench_dot:
+      return impl->dot;
+    case bench_kernel_count:
+      break;
+  }
+  return false;
+}
+
+// lhs := kernel(lhs, rhs), scale multiplies lhs by alpha, axpby sets lhs to alpha (rhs + lhs)
+// and dot returns the dot product
+static float bench_run(
+    const struct sl_la_simd_kernels impl[const static 1],
+    const enum bench_kernel kernel,
+    const size_t count,
+    float lhs[restrict count],
+    const float rhs[restrict count],
+    const float alpha
+) {
+  switch (kernel) {
+    case bench_add:
+      impl->add(count, lhs, rhs);
+      break;
+    case bench_sub:
+      impl->sub(count, lhs, rhs);
+      break;
+    case bench_mul:
+      impl->mul(count, lhs, rhs);
+      break;
+    case bench_min:
+      impl->min(count, lhs, rhs);
+      break;
+    case bench_max:
+      impl->max(count, lhs, rhs);
+      break;
+    case bench_scale:
+      impl->scale(count, lhs, alpha);
+      break;
+    case bench_axpby:
+      impl->axpby(count, alpha, rhs, alpha, lhs);
+      break;
+    case bench_dot:
+      return impl->dot(count, lhs, rhs);
+    case bench_kernel_count:
+      break;
+  }
+  return 0;
+}
+
+static double bench_now_ns(void) {
+  struct timespec now = {0};
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec * 1e9 + (double)now.tv_nsec;
+}
+
+struct bench_data {
+  size_t size;
+  // input of all kernels
+  float* lhs;
+  // random values for checking the results against the scalar kernels
+  float* rhs;
+  // random signs for timing, such that repeated products neither overflow nor underflow
+  float* signs;
+  float* expected;
+  float* actual;
+};
+
+// runs kernel of impl once on a copy of the inputs and compares the result to the scalar kernel
+static bool bench_check(
+    struct sl_context ctx[static 1],
+    const struct sl_la_simd_kernels impl[const static 1],
+    const enum bench_kernel kernel,
+    const struct bench_data data[const static 1]
+) {
+  const struct sl_la_simd_kernels* const scalar = sl_la_simd_get(0);
+  const size_t n                                = data->size;
+
+  memcpy(data->expected, data->lhs, n * sizeof(float));
+  memcpy(data->actual, data->lhs, n * sizeof(float));
+  const float expected = bench_run(scalar, kernel, n, data->expected, data->rhs, 0.5f);
+  const float actual   = bench_run(impl, kernel, n, data->actual, data->rhs, 0.5f);
+
+  if (kernel == bench_dot) {
+    const double error = fabs((double)actual - (double)expected);
+    if (error > BENCH_DOT_TOLERANCE * fmax(1, fabs((double)expected))) {
+      SL_ERROR(
+          ctx,
+          "%s %s of %zu items is %g, expected %g",
+          impl->name,
+          bench_kernel_names[kernel],
+          n,
+          (double)actual,
+          (double)expected
+      );
+      return false;
+    }
+    return true;
+  }
+  if (kernel == bench_axpby) {
+    for (size_t i = 0; i < n; ++i) {
+      const double error = fabs((double)data->actual[i] - (double)data->expected[i]);
+      if (error > BENCH_AXPBY_TOLERANCE * fmax(1, fabs((double)data->expected[i]))) {
+        SL_ERROR(
+            ctx,
+            "%s %s of %zu items is %g at %zu, expected %g",
+            impl->name,
+            bench_kernel_names[kernel],
+            n,
+            (double)data->actual[i],
+            i,
+            (double)data->expected[i]
+        );
+        return false;
+      }
+    }
+    return true;
+  }
+  if (memcmp(data->actual, data->expected, n * sizeof(float)) != 0) {
+    SL_ERROR(
+        ctx,
+        "%s %s of %zu items differs from scalar",
+        impl->name,
+        bench_kernel_names[kernel],
+        n
+    );
+    return false;
+  }
+  return true;
+}
+
+// average nanoseconds per item of running kernel of impl repeat times
+static double bench_time(
+    const struct sl_la_simd_kernels impl[const static 1],
+    const enum bench_kernel kernel,
+    const struct bench_data data[const static 1],
+    const size_t repeat
+) {
+  const size_t n = data->size;
+  memcpy(data->actual, data->lhs, n * sizeof(float));
+  volatile float sink = 0;
+  double fastest      = INFINITY;
+
+  for (size_t round = 0; round < BENCH_ROUNDS; ++round) {
+    const double begin = bench_now_ns();
+    for (size_t r = 0; r < repeat; ++r) {
+      sink = bench_run(impl, kernel, n, data->actual, data->signs, -1);
+    }
+    fastest = fmin(fastest, bench_now_ns() - begin);
+  }
+
+  (void)sink;
+  return fastest / (double)(repeat * n);
+}
+
+static bool bench_write(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const char implementation[const static 1],
+    const enum bench_kernel kernel,
+    const size_t size,
+    const size_t repeat,
+    const double ns_per_item,
+    const double scalar_ns_per_item
+) {
+  return (
+      sl_json_writer_object_begin(ctx, writer) && sl_json_writer_key(ctx, writer, "kernel")
+      && sl_json_writer_string(ctx, writer, bench_kernel_names[kernel])
+      && sl_json_writer_key(ctx, writer, "implementation")
+      && sl_json_writer_string(ctx, writer, implementation)
+      && sl_json_writer_key(ctx, writer, "size") && sl_json_writer_uint(ctx, writer, size)
+      && sl_json_writer_key(ctx, writer, "repeat") && sl_json_writer_uint(ctx, writer, repeat)
+      && sl_json_writer_key(ctx, writer, "ns_per_item")
+      && sl_json_writer_double(ctx, writer, ns_per_item)
+      && sl_json_writer_key(ctx, writer, "speedup")
+      && sl_json_writer_double(ctx, writer, scalar_ns_per_item / ns_per_item)
+      && sl_json_writer_object_end(ctx, writer)
+  );
+}
+
+// checks and times every kernel of every instruction set that the CPU supports and of BLAS,
+// writes one object per kernel and implementation to stdout
+bool bench(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
+  bool all_ok                  = false;
+  struct sl_json_writer writer = {0};
+  struct bench_data data       = {0};
+
+  size_t size   = sl_args_parse_ull(args, "--size", 10);
+  size_t repeat = sl_args_parse_ull(args, "--repeat", 10);
+  if (size == 0) {
+    size = BENCH_DEFAULT_SIZE;
+  }
+  if (repeat == 0) {
+    repeat = SL_MAX((size_t)1, BENCH_DEFAULT_ITEMS / size);
+  }
+  if (size > (size_t)INT32_MAX) {
+    SL_ERROR(ctx, "size %zu is too large for BLAS", size);
+    goto done;
+  }
+
+  SL_LOG_INFO(
+      "benchmarking vector kernels of %zu items, %zu repeats, best kernels are %s",
+      size,
+      repeat,
+      sl_la_simd_best()->name
+  );
+
+  data.size     = size;
+  data.lhs      = sl_alloc(ctx, size, sizeof(float));
+  data.rhs      = sl_alloc(ctx, size, sizeof(float));
+  data.signs    = sl_alloc(ctx, size, sizeof(float));
+  data.expected = sl_alloc(ctx, size, sizeof(float));
+  data.actual   = sl_alloc(ctx, size, sizeof(float));
+  if (!data.lhs || !data.rhs || !data.signs || !data.expected || !data.actual) {
+    SL_LOG_ERROR("failed allocating benchmark data");
+    goto done;
+  }
+
+  uint64_t prng = 0;
+  sl_random_pcg32_init(&prng, 1);
+  for (size_t i = 0; i < size; ++i) {
+    data.lhs[i]   = 2 * ((float)sl_random_pcg32(&prng) / (float)UINT32_MAX) - 1;
+    data.rhs[i]   = 2 * ((float)sl_random_pcg32(&prng) / (float)UINT32_MAX) - 1;
+    data.signs[i] = (sl_random_pcg32(&prng) & 1) ? 1 : -1;
+  }
+
+  if (!sl_json_writer_create(ctx, &writer, stdout, SL_JSON_WRITER_BUFFER_SIZE)) {
+    goto done;
+  }
+  for (enum bench_kernel kernel = bench_add; kernel < bench_kernel_count; ++kernel) {
+    // min and max ignore NaNs, which would propagate into the results of the other kernels
+    data.rhs[size / 2] = (kernel == bench_min || kernel == bench_max) ? NAN : 0;
+    double scalar_ns_per_item = 0;
+    for (size_t i = 0; i <= sl_la_simd_count(); ++i) {
+      const struct sl_la_simd_kernels* const impl
+          = i < sl_la_simd_count() ? sl_la_simd_get(i) : &blas_kernels;
+      if (!impl->is_supported() || !bench_has_kernel(impl, kernel)) {
+        continue;
+      }
+      if (!bench_check(ctx, impl, kernel, &data)) {
+        goto done;
+      }
+      const double ns_per_item = bench_time(impl, kernel, &data, repeat);
+      if (i == 0) {
+        scalar_ns_per_item = ns_per_item;
+      }
+      if (!bench_write(
+              ctx,
+              &writer,
+              impl->name,
+              kernel,
+              size,
+              repeat,
+              ns_per_item,
+              scalar_ns_per_item
+          )) {
+        goto done;
+      }
+    }
+  }
+  if (!sl_json_writer_flush(ctx, &writer)) {
+    goto done;
+  }
+
+  all_ok = true;
+done:
+  sl_json_writer_destroy(&writer);
+  sl_free(data.lhs);
+  sl_free(data.rhs);
+  sl_free(data.signs);
+  sl_free(data.expected);
+  sl_free(data.actual);
+  return all_ok;
+}
+
+int main(int argc, char* const argv[argc + 1]) {
+  struct sl_context ctx = {0};
+  bool ok               = false;
+  struct sl_args args   = {.argc = argc, .argv = argv};
+
+  const char* const command = sl_args_get_positional(&args, 0);
+  if (command && strcmp(command, "bench") == 0) {
+    ok = bench(&ctx, &args);
+  } else {
+    print_usage(&args);
+  }
+
+  if (!sl_context_unwind_errors(&ctx, stderr)) {
+    ok = false;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,7 +4,9 @@
 
 #include <stufflib/args/args.h>
 #include <stufflib/context/context.h>
+#include <stufflib/error/error.h>
 #include <stufflib/img/img.h>
+#include <stufflib/json/writer.h>
 #include <stufflib/logging/logging.h>
 #include <stufflib/png/png.h>
 
@@ -46,43 +48,103 @@ done:
   return is_done;
 }
 
-bool info(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
-  if (sl_args_count_positional(args) != 2) {
-    SL_ERROR(ctx, "too few arguments to PNG info");
-    return false;
-  }
-
-  bool is_done = false;
+// writes the info of the PNG at png_path as one JSON object on its own line
+// returns false if the PNG cannot be read, the object may then be left open
+static bool info_write(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1],
+    const char png_path[const static 1]
+) {
+  bool ok = false;
 
   struct sl_png_chunks chunks = {0};
   struct sl_png_image img     = {0};
 
-  const char* const png_path = sl_args_get_positional(args, 1);
-
-  printf("{");
   chunks = sl_png_read_chunks(ctx, png_path);
-  printf("\"chunks\":");
-  sl_png_dump_chunk_type_freq(stdout, chunks);
+  if (sl_context_error_occurred(ctx)
+      || !(sl_json_writer_object_begin(ctx, writer) && sl_json_writer_key(ctx, writer, "chunks")
+           && sl_png_dump_chunk_type_freq(ctx, writer, chunks))) {
+    goto done;
+  }
 
   struct sl_png_header header = sl_png_read_header(ctx, png_path);
-  printf(",\"header\":");
-  sl_png_dump_header(stdout, header);
+  if (sl_context_error_occurred(ctx)
+      || !(sl_json_writer_key(ctx, writer, "header") && sl_png_dump_header(ctx, writer, header))) {
+    goto done;
+  }
 
   if (!sl_png_is_supported(header)) {
     SL_LOG_ERROR("PNG contains unsupported features, not reading IDAT chunks");
-    is_done = true;
-    goto done;
+  } else {
+    img = sl_png_read_image(ctx, png_path);
+    if (sl_context_error_occurred(ctx)
+        || !(sl_json_writer_key(ctx, writer, "data")
+             && sl_png_dump_img_data_info(ctx, writer, img))) {
+      goto done;
+    }
   }
 
-  img = sl_png_read_image(ctx, png_path);
-  printf(",\"data\":");
-  sl_png_dump_img_data_info(stdout, img);
-  is_done = true;
+  ok = sl_json_writer_object_end(ctx, writer);
 
 done:
-  printf("}\n");
   sl_png_chunks_destroy(chunks);
   sl_png_image_destroy(img);
+  return ok;
+}
+
+// ends the object of a PNG that failed part-way with the latest error, such that it is valid JSON
+static bool info_write_error(
+    struct sl_context ctx[static 1],
+    struct sl_json_writer writer[static 1]
+) {
+  char msg[SL_ERROR_MSG_LEN]         = "failed reading PNG";
+  const struct sl_error_msg* const e = sl_error_peek(&(ctx->errors));
+  if (e) {
+    memcpy(msg, e->msg, sizeof(msg));
+  }
+  if (writer->depth == 0 && !sl_json_writer_object_begin(ctx, writer)) {
+    return false;
+  }
+  return sl_json_writer_end_to_depth(ctx, writer, 1) && sl_json_writer_key(ctx, writer, "error")
+         && sl_json_writer_string(ctx, writer, msg) && sl_json_writer_object_end(ctx, writer);
+}
+
+bool info(struct sl_context ctx[static 1], const struct sl_args args[const static 1]) {
+  if (sl_args_count_positional(args) < 2) {
+    SL_ERROR(ctx, "too few arguments to PNG info");
+    return false;
+  }
+
+  bool is_done = false;
+
+  struct sl_json_writer writer = {0};
+  if (!sl_json_writer_create(ctx, &writer, stdout, SL_JSON_WRITER_BUFFER_SIZE)) {
+    goto done;
+  }
+
+  for (int i_arg = 1;; ++i_arg) {
+    const char* const png_path = sl_args_get_positional(args, i_arg);
+    if (!png_path) {
+      break;
+    }
+    if (!info_write(ctx, &writer, png_path)) {
+      SL_LOG_ERROR("failed writing info of %s", png_path);
+      if (!info_write_error(ctx, &writer)) {
+        SL_LOG_ERROR("failed writing error of %s", png_path);
+      }
+      goto done;
+    }
+  }
+
+  is_done = true;
+
+done:
+  // a writer that cannot even end the object with an error is not flushed, such that
+  // the output is never left with half an object
+  if (writer.depth > 0 || !sl_json_writer_flush(ctx, &writer)) {
+    is_done = false;
+  }
+  sl_json_writer_destroy(&writer);
   return is_done;
 }
 
@@ -127,7 +189,7 @@ void print_usage(const struct sl_args args[const static 1]) {
       stderr,
       ("usage:"
        "\n"
-       "   %s info png_path"
+       "   %s info png_path [png_paths...]"
        "\n"
        "   %s dump_raw png_path block_type [block_types...]"
        "\n"
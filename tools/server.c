@@ -10,10 +10,14 @@
 #include <sys/socket.h>
 
 #include <stufflib/args/args.h>
+#include <stufflib/context/context.h>
+#include <stufflib/json/json.h>
 #include <stufflib/logging/logging.h>
 #include <stufflib/macros/macros.h>
 
 #define SL_SOCKET_BACKLOG_LEN 1024
+// largest JSON token (e.g. a string) in a request, requests of any size are parsed in this buffer
+#define SL_SERVER_JSON_BUFFER_SIZE 65'536
 
 static bool sl_server_running = false;
 
@@ -26,6 +30,96 @@ void print_usage(const struct sl_args args[const static 1]) {
   fprintf(stderr, "usage: %s [-h | --help] host port\n", args->argv[0]);
 }
 
+struct sl_server_json_request {
+  struct sl_json_stream stream;
+  size_t n_keys;
+  size_t n_values;
+  bool is_complete;
+};
+
+bool sl_server_is_json(const size_t msg_len, const char msg[const static msg_len]) {
+  for (size_t i = 0; i < msg_len; ++i) {
+    if (msg[i] != ' ' && msg[i] != '\t' && msg[i] != '\r' && msg[i] != '\n') {
+      return msg[i] == '{' || msg[i] == '[';
+    }
+  }
+  return false;
+}
+
+void sl_server_parse_json(
+    struct sl_context ctx[static 1],
+    struct sl_server_json_request req[static 1]
+) {
+  while (!req->is_complete && sl_json_stream_next(ctx, &(req->stream))) {
+    const struct sl_json_event* event = &(req->stream.parser.event);
+    const bool is_value = event->type == sl_json_value || event->type == sl_json_end_node;
+    req->n_keys += event->type == sl_json_key;
+    req->n_values += is_value;
+    req->is_complete = is_value && event->node_depth == 0;
+  }
+}
+
+// parses a JSON request while it is being received, msg_buffer holds the first msg_len bytes
+// the request ends when its top-level value is complete or when the client stops sending
+// replies with the amount of keys and values in the request or an error if it is not valid JSON
+bool sl_server_handle_json(
+    const int fd_conn,
+    const size_t msg_size,
+    char msg_buffer[const msg_size],
+    size_t msg_len
+) {
+  struct sl_context ctx             = {0};
+  struct sl_server_json_request req = {0};
+  bool ok                           = true;
+
+  if (sl_json_stream_create(&ctx, &(req.stream), SL_SERVER_JSON_BUFFER_SIZE)) {
+    for (size_t pos = 0; !req.is_complete && !sl_context_error_occurred(&ctx);) {
+      if (pos == msg_len) {
+        const ssize_t n_recv = recv(fd_conn, msg_buffer, msg_size, 0);
+        if (n_recv < 0) {
+          SL_LOG_ERROR("failed reading message on %d: %s", fd_conn, strerror(errno));
+          ok = false;
+          goto done;
+        }
+        if (n_recv == 0) {
+          sl_json_stream_finish(&(req.stream));
+          sl_server_parse_json(&ctx, &req);
+          break;
+        }
+        msg_len = (size_t)n_recv;
+        pos     = 0;
+      }
+      pos += sl_json_stream_feed(&ctx, &(req.stream), msg_len - pos, msg_buffer + pos);
+      sl_server_parse_json(&ctx, &req);
+    }
+  }
+
+  int reply_len = 0;
+  if (req.is_complete) {
+    SL_LOG_INFO("parsed JSON request with %zu values on %d", req.n_values, fd_conn);
+    reply_len = snprintf(
+        msg_buffer,
+        msg_size,
+        "{\"keys\": %zu, \"values\": %zu}\n",
+        req.n_keys,
+        req.n_values
+    );
+  } else {
+    SL_LOG_INFO("invalid JSON request on %d", fd_conn);
+    reply_len = snprintf(msg_buffer, msg_size, "{\"error\": \"invalid JSON\"}\n");
+  }
+
+  if (0 > send(fd_conn, msg_buffer, (size_t)reply_len, 0)) {
+    SL_LOG_ERROR("failed sending message on %d: %s", fd_conn, strerror(errno));
+    ok = false;
+  }
+
+done:
+  sl_error_clear(&(ctx.errors));
+  sl_json_stream_destroy(&(req.stream));
+  return ok;
+}
+
 int main(int argc, char* const argv[argc + 1]) {
   struct sockaddr_in serveraddr = {
       .sin_family = AF_INET,
@@ -139,6 +233,11 @@ int main(int argc, char* const argv[argc + 1]) {
         goto end_loop;
       }
 
+      if (sl_server_is_json((size_t)msg_len, msg_buffer)) {
+        ok = sl_server_handle_json(fd_conn, SL_ARRAY_LEN(msg_buffer), msg_buffer, (size_t)msg_len);
+        goto end_loop;
+      }
+
       if (msg_len >= (ssize_t)SL_ARRAY_LEN(msg_buffer)) {
         SL_LOG_ERROR(
             "message sent by client is too large (%zd), truncating to %zu",
@@ -2,38 +2,100 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <assert.h>
 
 #include <stufflib/args/args.h>
 #include <stufflib/context/context.h>
 #include <stufflib/dataset/dataset.h>
 #include <stufflib/io/io.h>
+#include <stufflib/json/writer.h>
 #include <stufflib/linalg/linalg.h>
 #include <stufflib/logging/logging.h>
 #include <stufflib/macros/macros.h>
+#include <stufflib/matrix/sl_csr_f32.h>
 #include <stufflib/matrix/sl_matrix_f32.h>
 #include <stufflib/memory/memory.h>
 #include <stufflib/ml/ml.h>
+#include <stufflib/ml/model.h>
 #include <stufflib/random/random.h>
+#include <stufflib/record/prefetch.h>
 #include <stufflib/record/reader.h>
 #include <stufflib/record/record.h>
 #include <stufflib/span/span.h>
 #include <stufflib/vector/sl_vector_f32.h>
 
+// reads all spambase samples into samples, which has already been allocated
+static bool spambase_read(
+    struct sl_context ctx[static 1],
+    const char dataset_dir[const static 1],
+    uint16_t classes[const static SL_DATASET_SPAMBASE_SAMPLES],
+    struct sl_matrix_f32 samples[const static 1]
+) {
+  struct sl_record classes_record;
+  struct sl_record samples_record;
+
+  if (!sl_record_read_metadata(ctx, &classes_record, dataset_dir, "spambase_classes")) {
+    SL_LOG_ERROR("failed reading metadata of spambase classes");
+    return false;
+  }
+
+  if (!sl_record_read_metadata(ctx, &samples_record, dataset_dir, "spambase_samples")) {
+    SL_LOG_ERROR("failed reading metadata of spambase samples");
+    return false;
+  }
+
+  if (!sl_record_read_all(
+          ctx,
+          &classes_record,
+          sizeof(uint16_t) * SL_DATASET_SPAMBASE_SAMPLES,
+          (void*)classes
+      )) {
+    SL_LOG_ERROR("failed reading spambase classes");
+    return false;
+  }
+
+  if (!sl_record_read_all(
+          ctx,
+          &samples_record,
+          sl_record_item_size(&samples_record) * sl_matrix_f32_size(samples),
+          (void*)(samples->data)
+      )) {
+    SL_LOG_ERROR("failed reading spambase samples");
+    return false;
+  }
+  return true;
+}
+
+// name of the model record written by --save-model and read by --load-model
+#define SL_SVM_SPAMBASE_MODEL "spambase_svm"
+
+// value of an optional argument prefix=value, or null if it was not given
+static const char* args_value(
+    const struct sl_args args[const static 1],
+    const char prefix[const static 1]
+) {
+  const char* const option = sl_args_find_optional(args, prefix);
+  return option ? option + strlen(prefix) : nullptr;
+}
+
 bool spambase(
     struct sl_context ctx[static 1],
     uint64_t prng[static 1],
     const struct sl_args args[const static 1]
 ) {
-  bool all_ok = false;
+  bool all_ok              = false;
+  struct sl_ml_model model = {0};
 
   const char* const dataset_dir = sl_args_get_positional(args, 1);
+  const char* const save_dir    = args_value(args, "--save-model=");
+  const char* const load_dir    = args_value(args, "--load-model=");
 
   SL_LOG_INFO("training linear SVM on spambase dataset from '%s'", dataset_dir);
 
-  struct sl_record classes_record;
   uint16_t classes[SL_DATASET_SPAMBASE_SAMPLES] = {0};
 
-  struct sl_record samples_record;
   struct sl_matrix_f32 samples = {0};
   if (!sl_la_matrix_create(
           ctx,
@@ -45,35 +107,13 @@ bool spambase(
     goto done;
   }
 
-  if (!sl_record_read_metadata(ctx, &classes_record, dataset_dir, "spambase_classes")) {
-    SL_LOG_ERROR("failed reading metadata of spambase classes");
-    goto done;
-  }
-
-  if (!sl_record_read_metadata(ctx, &samples_record, dataset_dir, "spambase_samples")) {
-    SL_LOG_ERROR("failed reading metadata of spambase samples");
-    goto done;
-  }
-
-  if (!sl_record_read_all(ctx, &classes_record, sizeof(classes), (void*)classes)) {
-    SL_LOG_ERROR("failed reading spambase classes");
-    goto done;
-  }
-
-  if (!sl_record_read_all(
-          ctx,
-          &samples_record,
-          sl_record_item_size(&samples_record) * sl_matrix_f32_size(&samples),
-          (void*)(samples.data)
-      )) {
-    SL_LOG_ERROR("failed reading spambase samples");
+  if (!spambase_read(ctx, dataset_dir, classes, &samples)) {
     goto done;
   }
 
   struct sl_ml_svm svm = {
       .w              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_SPAMBASE_FEATURES),
       .s              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_SPAMBASE_FEATURES),
-      .x              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_SPAMBASE_FEATURES),
       .shuffle_buffer = (size_t[SL_DATASET_SPAMBASE_SAMPLES]){0},
       .batch_size     = 1,
       .n_epochs       = 2,
@@ -109,38 +149,368 @@ bool spambase(
 
   struct sl_ml_minmax_scaler minmax_scaler
       = SL_ML_MINMAX_SCALER_CREATE_INLINE(SL_DATASET_SPAMBASE_FEATURES);
-  sl_ml_minmax_fit(&minmax_scaler, &train_data);
-  sl_ml_minmax_apply(&minmax_scaler, &train_data, -1, 1);
-  sl_ml_minmax_apply(&minmax_scaler, &test_data, -1, 1);
+  struct sl_ml_minmax_scaler* scaler = &minmax_scaler;
+  struct sl_ml_svm* classifier       = &svm;
 
-  sl_ml_svm_linear_fit(prng, &svm, &train_data, train_classes);
+  if (load_dir) {
+    SL_LOG_INFO("loading linear SVM and scaler from '%s' instead of training", load_dir);
+    if (!sl_ml_model_load(ctx, load_dir, SL_SVM_SPAMBASE_MODEL, &model)) {
+      goto done;
+    }
+    if (!model.has_minmax || sl_vector_f32_size(&(model.svm.w)) != SL_DATASET_SPAMBASE_FEATURES) {
+      SL_LOG_ERROR("model in '%s' is not a spambase SVM with a scaler", load_dir);
+      goto done;
+    }
+    scaler     = &(model.minmax);
+    classifier = &(model.svm);
+  } else {
+    sl_ml_minmax_fit(&minmax_scaler, &train_data);
+  }
+  sl_ml_minmax_apply(scaler, &train_data, -1, 1);
+  sl_ml_minmax_apply(scaler, &test_data, -1, 1);
+
+  if (!load_dir) {
+    sl_ml_svm_linear_fit(prng, &svm, &train_data, train_classes);
+  }
+  if (save_dir && !sl_ml_model_save(ctx, save_dir, SL_SVM_SPAMBASE_MODEL, classifier, scaler)) {
+    SL_LOG_ERROR("failed saving spambase model to '%s'", save_dir);
+    goto done;
+  }
 
   {
     struct sl_ml_classification report = {0};
-    for (size_t i = 0; i < sl_matrix_f32_num_rows(&train_data); ++i) {
-      struct sl_vector_f32 x = sl_la_matrix_row_view(&train_data, i);
-      sl_ml_classification_update(&report, train_classes[i], sl_ml_svm_binary_predict(&svm, &x));
-    }
+    struct sl_vector_f32 scores        = SL_LA_VECTOR_CREATE_INLINE(SL_ARRAY_LEN(train_classes));
+    sl_ml_svm_scores(classifier, &train_data, &scores);
+    sl_ml_classification_update_scores(
+        &report,
+        SL_ARRAY_LEN(train_classes),
+        scores.data,
+        train_classes
+    );
     SL_LOG_INFO("spambase dataset, random train set, linear SVM");
-    sl_ml_classification_print(stderr, &report);
+    if (!sl_ml_classification_print(ctx, stderr, &report)) {
+      goto done;
+    }
   }
   {
     struct sl_ml_classification report = {0};
-    for (size_t i = 0; i < sl_matrix_f32_num_rows(&test_data); ++i) {
-      struct sl_vector_f32 x = sl_la_matrix_row_view(&test_data, i);
-      sl_ml_classification_update(&report, test_classes[i], sl_ml_svm_binary_predict(&svm, &x));
-    }
+    struct sl_vector_f32 scores        = SL_LA_VECTOR_CREATE_INLINE(SL_ARRAY_LEN(test_classes));
+    sl_ml_svm_scores(classifier, &test_data, &scores);
+    sl_ml_classification_update_scores(
+        &report,
+        SL_ARRAY_LEN(test_classes),
+        scores.data,
+        test_classes
+    );
     SL_LOG_INFO("spambase dataset, random test set, linear SVM");
-    sl_ml_classification_print(stderr, &report);
+    if (!sl_ml_classification_print(ctx, stderr, &report)) {
+      goto done;
+    }
   }
 
   all_ok = true;
 done:
+  sl_ml_model_unload(&model);
   sl_la_matrix_destroy(&samples);
   return all_ok;
 }
 
-#define SL_SVM_RCV1_BUFFER_LEN 10'000
+// two batches are kept in memory while prefetching
+#define SL_SVM_RCV1_BUFFER_LEN 5'000
+// initial nonzero capacity per row of sparse batches, RCV1 rows have less on average
+#define SL_SVM_RCV1_ROW_NNZ 100
+
+// dense samples batch that is rescaled by the prefetcher right after reading it
+struct sl_rcv1_batch {
+  struct sl_matrix_f32 samples;
+  struct sl_ml_minmax_scaler* minmax;
+};
+
+static bool rcv1_read_samples_batch(
+    struct sl_context ctx[static 1],
+    struct sl_record_reader reader[const static 1],
+    void* batch
+) {
+  struct sl_rcv1_batch* samples_batch = batch;
+  struct sl_matrix_f32* samples       = &(samples_batch->samples);
+  struct sl_span read_buffer
+      = sl_span_view(sizeof(float) * sl_matrix_f32_size(samples), (void*)samples->data);
+  if (!sl_record_prefetch_read_span(ctx, reader, &read_buffer)) {
+    return false;
+  }
+  sl_ml_minmax_apply(samples_batch->minmax, samples, -1, 1);
+  return true;
+}
+
+// reads the value ranges written by the dataset tool next to the samples record
+static bool rcv1_read_minmax(
+    struct sl_context ctx[static 1],
+    const struct sl_record samples[const static 1],
+    struct sl_ml_minmax_scaler minmax[const static 1]
+) {
+  const size_t n_features = sl_vector_f32_size(&(minmax->lo));
+  assert(n_features == sl_vector_f32_size(&(minmax->hi)));
+  assert(minmax->hi.data == minmax->lo.data + n_features);
+
+  char name[sizeof(samples->name)] = {0};
+  const int name_len
+      = snprintf(name, sizeof(name), "%s" SL_DATASET_RCV1_MINMAX_SUFFIX, samples->name);
+  if (name_len < 0 || (size_t)name_len >= sizeof(name)) {
+    SL_LOG_ERROR("name of the value ranges record of '%s' is too long", samples->name);
+    return false;
+  }
+
+  struct sl_record record = {0};
+  if (!sl_record_read_metadata(ctx, &record, samples->path, name)) {
+    SL_LOG_ERROR("failed reading metadata of RCV1 value ranges '%s'", name);
+    return false;
+  }
+  if (sl_record_type_of(&record) != sl_record_type_float32 || record.n_dims != 2
+      || record.dim_size[0] != 2 || record.dim_size[1] != n_features) {
+    SL_LOG_ERROR("RCV1 value ranges '%s' are not 2 x %zu float32", name, n_features);
+    return false;
+  }
+  // lo and hi are adjacent, such that both rows are read at once
+  if (!sl_record_read_all(ctx, &record, 2 * n_features * sizeof(float), (void*)minmax->lo.data)) {
+    SL_LOG_ERROR("failed reading RCV1 value ranges '%s'", name);
+    return false;
+  }
+  for (size_t i = 0; i < n_features; ++i) {
+    const float lo = minmax->lo.data[i];
+    const float hi = minmax->hi.data[i];
+    if (!(0 <= lo && lo <= hi && hi <= 1)) {
+      SL_LOG_ERROR("invalid RCV1 value range [%g, %g] of feature %zu", (double)lo, (double)hi, i);
+      return false;
+    }
+  }
+  minmax->is_cached = false;
+  return true;
+}
+
+// parses the loss of the optional --loss=name, returns false if the name is unknown
+static bool rcv1_parse_loss(
+    const struct sl_args args[const static 1],
+    bool has_loss[static 1],
+    enum sl_ml_loss loss[static 1]
+) {
+  const char* const name = args_value(args, "--loss=");
+  *has_loss              = name != nullptr;
+  if (!name) {
+    return true;
+  }
+  if (strcmp(name, "hinge") == 0) {
+    *loss = sl_ml_loss_hinge;
+  } else if (strcmp(name, "logistic") == 0) {
+    *loss = sl_ml_loss_logistic;
+  } else if (strcmp(name, "squared_hinge") == 0) {
+    *loss = sl_ml_loss_squared_hinge;
+  } else {
+    SL_LOG_ERROR("unknown loss '%s', expected hinge, logistic or squared_hinge", name);
+    return false;
+  }
+  return true;
+}
+
+// fits on CSR batches without rescaling, RCV1 samples are already in [0, 1]
+// and rescaling them to [-1, 1] would make every zero a nonzero
+// if loss is not null, fits an ASGD linear model with that loss instead of the Pegasos SVM
+// and optionally writes the probabilities of class 1 for the test set to stdout, one per line
+static bool rcv1_sparse(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    struct sl_record_reader train_samples_reader[const static 1],
+    struct sl_record_reader test_samples_reader[const static 1],
+    const size_t n_train,
+    const uint8_t train_classes[const static n_train],
+    const size_t n_test,
+    const uint8_t test_classes[const static n_test],
+    const size_t n_threads,
+    const size_t sync_steps,
+    const enum sl_ml_loss* loss,
+    const bool write_probabilities
+) {
+  bool all_ok = false;
+
+  struct sl_csr_f32 samples_batches[2] = {0};
+
+  struct sl_record_prefetcher train_prefetcher = {
+      .reader  = train_samples_reader,
+      .read    = sl_record_prefetch_read_csr,
+      .batches = {samples_batches + 0, samples_batches + 1},
+  };
+  struct sl_record_prefetcher test_prefetcher = {
+      .reader  = test_samples_reader,
+      .read    = sl_record_prefetch_read_csr,
+      .batches = {samples_batches + 0, samples_batches + 1},
+  };
+
+  for (size_t i = 0; i < SL_ARRAY_LEN(samples_batches); ++i) {
+    if (!sl_la_csr_create(
+            ctx,
+            SL_SVM_RCV1_BUFFER_LEN,
+            SL_DATASET_RCV1_FEATURES,
+            SL_SVM_RCV1_BUFFER_LEN * SL_SVM_RCV1_ROW_NNZ,
+            samples_batches + i
+        )) {
+      SL_LOG_ERROR("failed allocating sparse samples batch");
+      goto done;
+    }
+  }
+
+  if (!sl_record_prefetcher_open(ctx, &train_prefetcher)) {
+    SL_LOG_ERROR("failed starting RCV1 training set samples prefetcher");
+    goto done;
+  }
+
+  SL_LOG_INFO("RCV1: fitting sparse linear %s on training set", loss ? "model" : "SVM");
+
+  struct sl_ml_svm svm = {
+      .w              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
+      .shuffle_buffer = (size_t[SL_SVM_RCV1_BUFFER_LEN]){0},
+      .batch_size     = 100,
+      .n_epochs       = 1,
+      // learning rate from Shalev-Shwartz et al. (2011)
+      .learning_rate  = 1e-4F,
+  };
+  struct sl_ml_linear linear = {
+      .w              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
+      .a              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
+      .shuffle_buffer = svm.shuffle_buffer,
+      .loss           = loss ? *loss : sl_ml_loss_hinge,
+      .n_epochs       = 1,
+      .learning_rate  = 1,
+      // regularization from Bottou (2012) for RCV1
+      .lambda         = 1e-5F,
+      // average from the second batch, when the weights are past the initial transient
+      .average_begin  = SL_SVM_RCV1_BUFFER_LEN,
+  };
+  struct sl_vector_f32* weights = loss ? &(linear.a) : &(svm.w);
+
+  uint16_t classes_buffer[SL_SVM_RCV1_BUFFER_LEN] = {0};
+  float scores_buffer[SL_SVM_RCV1_BUFFER_LEN]     = {0};
+  size_t row_offset                               = 0;
+  for (size_t batch_idx = 0;; ++batch_idx) {
+    SL_LOG_INFO("RCV1 train batch %zu: reading buffer", batch_idx);
+    struct sl_csr_f32* samples_batch = nullptr;
+    if (!sl_record_prefetcher_next(ctx, &train_prefetcher, (void**)&samples_batch)) {
+      SL_LOG_ERROR("failed reading RCV1 training set samples batch during svm fit");
+      goto done;
+    }
+    if (!samples_batch) {
+      break;
+    }
+
+    const size_t n_rows = sl_csr_f32_num_rows(samples_batch);
+    for (size_t i = 0; i < n_rows; ++i) {
+      const size_t class_idx = row_offset + i;
+      classes_buffer[i]      = class_idx < n_train ? train_classes[class_idx] : 0;
+    }
+    row_offset += n_rows;
+
+    SL_LOG_INFO("RCV1 train batch %zu: fit svm", batch_idx);
+    if (loss) {
+      sl_ml_linear_fit_csr(prng, &linear, samples_batch, classes_buffer);
+    } else if (n_threads == 0) {
+      sl_ml_svm_linear_fit_csr(prng, &svm, samples_batch, classes_buffer);
+    } else if (!sl_ml_svm_linear_fit_parallel(
+                   ctx,
+                   prng,
+                   &svm,
+                   samples_batch,
+                   classes_buffer,
+                   n_threads,
+                   sync_steps
+               )) {
+      SL_LOG_ERROR("RCV1 train batch %zu: failed fitting svm", batch_idx);
+      goto done;
+    }
+
+    if (!sl_la_vector_is_finite(weights)) {
+      SL_LOG_ERROR("RCV1 train batch %zu: SVM weights has NaNs", batch_idx);
+      goto done;
+    }
+
+    SL_LOG_INFO("RCV1 train batch %zu: results", batch_idx);
+    struct sl_vector_f32 scores = {
+        .length   = {n_rows},
+        .capacity = {n_rows},
+        .data     = scores_buffer,
+    };
+    if (loss) {
+      sl_ml_linear_scores_csr(&linear, samples_batch, &scores);
+    } else {
+      sl_ml_svm_scores_csr(&svm, samples_batch, &scores);
+    }
+    struct sl_ml_classification report = {0};
+    sl_ml_classification_update_scores(&report, n_rows, scores.data, classes_buffer);
+    if (!sl_ml_classification_print(ctx, stderr, &report)) {
+      goto done;
+    }
+  }
+
+  // both prefetchers share the samples batches
+  sl_record_prefetcher_close(&train_prefetcher);
+  if (!sl_record_prefetcher_open(ctx, &test_prefetcher)) {
+    SL_LOG_ERROR("failed starting RCV1 testing set samples prefetcher");
+    goto done;
+  }
+
+  row_offset = 0;
+  for (size_t batch_idx = 0;; ++batch_idx) {
+    SL_LOG_INFO("RCV1 test batch %zu: reading buffer", batch_idx);
+    struct sl_csr_f32* samples_batch = nullptr;
+    if (!sl_record_prefetcher_next(ctx, &test_prefetcher, (void**)&samples_batch)) {
+      SL_LOG_ERROR("failed reading RCV1 testing set samples batch during svm evaluation");
+      goto done;
+    }
+    if (!samples_batch) {
+      break;
+    }
+
+    const size_t n_rows = sl_csr_f32_num_rows(samples_batch);
+    for (size_t i = 0; i < n_rows; ++i) {
+      const size_t class_idx = row_offset + i;
+      classes_buffer[i]      = class_idx < n_test ? test_classes[class_idx] : 0;
+    }
+    row_offset += n_rows;
+
+    SL_LOG_INFO("RCV1 test batch %zu: results", batch_idx);
+    struct sl_vector_f32 scores = {
+        .length   = {n_rows},
+        .capacity = {n_rows},
+        .data     = scores_buffer,
+    };
+    if (loss) {
+      sl_ml_linear_scores_csr(&linear, samples_batch, &scores);
+    } else {
+      sl_ml_svm_scores_csr(&svm, samples_batch, &scores);
+    }
+    struct sl_ml_classification report = {0};
+    sl_ml_classification_update_scores(&report, n_rows, scores.data, classes_buffer);
+    if (!sl_ml_classification_print(ctx, stderr, &report)) {
+      goto done;
+    }
+
+    if (write_probabilities) {
+      sl_ml_sigmoid(n_rows, scores.data);
+      for (size_t i = 0; i < n_rows; ++i) {
+        if (printf("%.6g\n", (double)scores.data[i]) < 0) {
+          SL_LOG_ERROR("RCV1 test batch %zu: failed writing probabilities", batch_idx);
+          goto done;
+        }
+      }
+    }
+  }
+
+  all_ok = true;
+done:
+  sl_record_prefetcher_close(&train_prefetcher);
+  sl_record_prefetcher_close(&test_prefetcher);
+  for (size_t i = 0; i < SL_ARRAY_LEN(samples_batches); ++i) {
+    sl_la_csr_destroy(samples_batches + i);
+  }
+  return all_ok;
+}
 
 bool rcv1(
     struct sl_context ctx[static 1],
@@ -151,6 +521,7 @@ bool rcv1(
 
   const char* const dataset_dir = sl_args_get_positional(args, 1);
   const bool flip_train_test    = sl_args_parse_flag(args, "--flip-train-test");
+  const bool is_sparse          = sl_args_parse_flag(args, "--sparse");
 
   SL_LOG_INFO("RCV1: training linear SVM, reading dataset from '%s'", dataset_dir);
 
@@ -174,13 +545,49 @@ bool rcv1(
   struct sl_record test_classes_record = {0};
   uint8_t* test_classes                = nullptr;
 
-  struct sl_matrix_f32 samples_batch = {0};
-  if (!sl_la_matrix_create(ctx, SL_SVM_RCV1_BUFFER_LEN, SL_DATASET_RCV1_FEATURES, &samples_batch)) {
-    SL_LOG_ERROR("failed allocating samples batch matrix");
+  struct sl_ml_minmax_scaler minmax_scaler = {
+      .scale  = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
+      .offset = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
+  };
+  float* minmax_data = nullptr;
+
+  struct sl_rcv1_batch samples_batches[2] = {
+      {.minmax = &minmax_scaler},
+      {.minmax = &minmax_scaler},
+  };
+
+  struct sl_record_prefetcher train_prefetcher = {
+      .reader  = &train_samples_reader,
+      .read    = rcv1_read_samples_batch,
+      .batches = {samples_batches + 0, samples_batches + 1},
+  };
+  struct sl_record_prefetcher test_prefetcher = {
+      .reader  = &test_samples_reader,
+      .read    = rcv1_read_samples_batch,
+      .batches = {samples_batches + 0, samples_batches + 1},
+  };
+
+  bool has_loss        = false;
+  enum sl_ml_loss loss = sl_ml_loss_hinge;
+  if (!rcv1_parse_loss(args, &has_loss, &loss)) {
+    goto done;
+  }
+  if (has_loss && !is_sparse) {
+    SL_LOG_ERROR("--loss is supported only with --sparse");
     goto done;
   }
-  struct sl_span read_buffer
-      = sl_span_view(sizeof(float) * sl_matrix_f32_size(&samples_batch), (void*)samples_batch.data);
+
+  for (size_t i = 0; i < SL_ARRAY_LEN(samples_batches) && !is_sparse; ++i) {
+    if (!sl_la_matrix_create(
+            ctx,
+            SL_SVM_RCV1_BUFFER_LEN,
+            SL_DATASET_RCV1_FEATURES,
+            &(samples_batches[i].samples)
+        )) {
+      SL_LOG_ERROR("failed allocating samples batch matrix");
+      goto done;
+    }
+  }
 
   SL_LOG_INFO("RCV1: reading metadata records");
 
@@ -266,59 +673,60 @@ bool rcv1(
     goto done;
   }
 
-  SL_LOG_INFO("RCV1: fitting minmax scaler on training set");
-
-  struct sl_ml_minmax_scaler minmax_scaler
-      = SL_ML_MINMAX_SCALER_CREATE_INLINE(SL_DATASET_RCV1_FEATURES);
-
-  for (size_t batch_idx = 0; !sl_record_reader_is_done(ctx, &train_samples_reader); ++batch_idx) {
-    SL_LOG_INFO("RCV1 train batch %zu minmax: read batch", batch_idx);
-    sl_span_clear(&read_buffer);
-    if (!sl_record_reader_read(ctx, &train_samples_reader, &read_buffer)) {
-      SL_LOG_ERROR("RCV1 train batch %zu minmax: failed reading samples batch", batch_idx);
+  if (is_sparse) {
+    if (!sl_record_reader_open(ctx, &test_samples_reader)) {
+      SL_LOG_ERROR("failed opening RCV1 testing set samples record reader");
       goto done;
     }
-    for (size_t row = 0; row < sl_matrix_f32_num_rows(&samples_batch); ++row) {
-      for (size_t col = 0; col < sl_matrix_f32_num_cols(&samples_batch); ++col) {
-        const float value = *sl_matrix_f32_get(&samples_batch, row, col);
-        if (value < 0 || value > 1) {
-          SL_LOG_ERROR(
-              "invalid RCV1 training sample at (%zu, %zu): %g is not in [0, 1]",
-              row,
-              col,
-              (double)value
-          );
-          goto done;
-        }
-      }
-    }
-    SL_LOG_INFO("RCV1 train batch %zu minmax: fit", batch_idx);
-    sl_ml_minmax_fit(&minmax_scaler, &samples_batch);
+    all_ok = rcv1_sparse(
+        ctx,
+        prng,
+        &train_samples_reader,
+        &test_samples_reader,
+        train_classes_record.size,
+        train_classes,
+        test_classes_record.size,
+        test_classes,
+        sl_args_parse_ull(args, "--threads", 10),
+        sl_args_parse_ull(args, "--sync-steps", 10),
+        has_loss ? &loss : nullptr,
+        sl_args_parse_flag(args, "--probabilities")
+    );
+    goto done;
   }
 
-  sl_record_reader_close(&train_samples_reader);
+  SL_LOG_INFO("RCV1: reading value ranges of the training set");
 
-  train_record_file    = (struct sl_file){0};
-  train_samples_reader = (struct sl_record_reader){
-      .file   = &train_record_file,
-      .record = &train_samples_record,
+  minmax_data = sl_alloc(ctx, 2 * SL_DATASET_RCV1_FEATURES, sizeof(float));
+  if (!minmax_data) {
+    SL_LOG_ERROR("failed allocating RCV1 value ranges");
+    goto done;
+  }
+  minmax_scaler.lo = (struct sl_vector_f32){
+      .length   = {SL_DATASET_RCV1_FEATURES},
+      .capacity = {SL_DATASET_RCV1_FEATURES},
+      .data     = minmax_data,
   };
-
-  if (!sl_record_reader_open(ctx, &train_samples_reader)) {
-    SL_LOG_ERROR("failed opening RCV1 training set samples record reader");
+  minmax_scaler.hi = minmax_scaler.lo;
+  minmax_scaler.hi.data += SL_DATASET_RCV1_FEATURES;
+  if (!rcv1_read_minmax(ctx, &train_samples_record, &minmax_scaler)) {
     goto done;
   }
+
   if (!sl_record_reader_open(ctx, &test_samples_reader)) {
     SL_LOG_ERROR("failed opening RCV1 testing set samples record reader");
     goto done;
   }
+  if (!sl_record_prefetcher_open(ctx, &train_prefetcher)) {
+    SL_LOG_ERROR("failed starting RCV1 training set samples prefetcher");
+    goto done;
+  }
 
   SL_LOG_INFO("RCV1: fitting linear SVM on training set");
 
   struct sl_ml_svm svm = {
       .w              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
       .s              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
-      .x              = SL_LA_VECTOR_CREATE_INLINE(SL_DATASET_RCV1_FEATURES),
       .shuffle_buffer = (size_t[SL_SVM_RCV1_BUFFER_LEN]){0},
       .batch_size     = 100,
       .n_epochs       = 1,
@@ -326,26 +734,30 @@ bool rcv1(
       .learning_rate  = 1e-4F,
   };
 
+  struct sl_vector_f32 scores = SL_LA_VECTOR_CREATE_INLINE(SL_SVM_RCV1_BUFFER_LEN);
+
   uint16_t classes_buffer[SL_SVM_RCV1_BUFFER_LEN] = {0};
-  for (size_t batch_idx = 0; !sl_record_reader_is_done(ctx, &train_samples_reader); ++batch_idx) {
+  for (size_t batch_idx = 0;; ++batch_idx) {
     SL_LOG_INFO("RCV1 train batch %zu: reading buffer", batch_idx);
-    sl_span_clear(&read_buffer);
-    if (!sl_record_reader_read(ctx, &train_samples_reader, &read_buffer)) {
+    struct sl_rcv1_batch* batch = nullptr;
+    if (!sl_record_prefetcher_next(ctx, &train_prefetcher, (void**)&batch)) {
       SL_LOG_ERROR("failed reading RCV1 training set samples batch during svm fit");
       goto done;
     }
-
-    SL_LOG_INFO("RCV1 train batch %zu: apply minmax", batch_idx);
-    sl_ml_minmax_apply(&minmax_scaler, &samples_batch, -1, 1);
+    if (!batch) {
+      break;
+    }
+    // rescaled by the prefetcher
+    struct sl_matrix_f32* samples_batch = &(batch->samples);
 
     SL_LOG_INFO("RCV1 train batch %zu: copy classes", batch_idx);
     for (size_t i = 0; i < SL_SVM_RCV1_BUFFER_LEN; ++i) {
-      const size_t class_idx = (sl_matrix_f32_num_rows(&samples_batch) * batch_idx) + i;
+      const size_t class_idx = (sl_matrix_f32_num_rows(samples_batch) * batch_idx) + i;
       classes_buffer[i]      = class_idx < train_classes_record.size ? train_classes[class_idx] : 0;
     }
 
     SL_LOG_INFO("RCV1 train batch %zu: fit svm", batch_idx);
-    sl_ml_svm_linear_fit(prng, &svm, &samples_batch, classes_buffer);
+    sl_ml_svm_linear_fit(prng, &svm, samples_batch, classes_buffer);
 
     if (!sl_la_vector_is_finite(&(svm.w))) {
       SL_LOG_ERROR("RCV1 train batch %zu: SVM weights has NaNs", batch_idx);
@@ -353,55 +765,193 @@ bool rcv1(
     }
 
     SL_LOG_INFO("RCV1 train batch %zu: results", batch_idx);
+    sl_ml_svm_scores(&svm, samples_batch, &scores);
     struct sl_ml_classification report = {0};
-    for (size_t i = 0; i < SL_SVM_RCV1_BUFFER_LEN; ++i) {
-      struct sl_vector_f32 x = sl_la_matrix_row_view(&samples_batch, i);
-      sl_ml_classification_update(&report, classes_buffer[i], sl_ml_svm_binary_predict(&svm, &x));
+    sl_ml_classification_update_scores(
+        &report,
+        SL_SVM_RCV1_BUFFER_LEN,
+        scores.data,
+        classes_buffer
+    );
+    if (!sl_ml_classification_print(ctx, stderr, &report)) {
+      goto done;
     }
-    sl_ml_classification_print(stderr, &report);
   }
 
-  for (size_t batch_idx = 0; !sl_record_reader_is_done(ctx, &test_samples_reader); ++batch_idx) {
+  // both prefetchers share the samples batches
+  sl_record_prefetcher_close(&train_prefetcher);
+  if (!sl_record_prefetcher_open(ctx, &test_prefetcher)) {
+    SL_LOG_ERROR("failed starting RCV1 testing set samples prefetcher");
+    goto done;
+  }
+
+  for (size_t batch_idx = 0;; ++batch_idx) {
     SL_LOG_INFO("RCV1 test batch %zu: reading buffer", batch_idx);
-    sl_span_clear(&read_buffer);
-    if (!sl_record_reader_read(ctx, &test_samples_reader, &read_buffer)) {
+    struct sl_rcv1_batch* batch = nullptr;
+    if (!sl_record_prefetcher_next(ctx, &test_prefetcher, (void**)&batch)) {
       SL_LOG_ERROR(
           "failed reading RCV1 testing set samples batch during svm "
           "evaluation"
       );
       goto done;
     }
-
-    SL_LOG_INFO("RCV1 test batch %zu: apply minmax", batch_idx);
-    sl_ml_minmax_apply(&minmax_scaler, &samples_batch, -1, 1);
+    if (!batch) {
+      break;
+    }
+    // rescaled by the prefetcher
+    struct sl_matrix_f32* samples_batch = &(batch->samples);
 
     SL_LOG_INFO("RCV1 test batch %zu: copy classes", batch_idx);
     for (size_t i = 0; i < SL_SVM_RCV1_BUFFER_LEN; ++i) {
-      const size_t class_idx = (sl_matrix_f32_num_rows(&samples_batch) * batch_idx) + i;
+      const size_t class_idx = (sl_matrix_f32_num_rows(samples_batch) * batch_idx) + i;
       classes_buffer[i]      = class_idx < test_classes_record.size ? test_classes[class_idx] : 0;
     }
 
     SL_LOG_INFO("RCV1 test batch %zu: results", batch_idx);
+    sl_ml_svm_scores(&svm, samples_batch, &scores);
     struct sl_ml_classification report = {0};
-    for (size_t i = 0; i < SL_SVM_RCV1_BUFFER_LEN; ++i) {
-      struct sl_vector_f32 x = sl_la_matrix_row_view(&samples_batch, i);
-      sl_ml_classification_update(&report, classes_buffer[i], sl_ml_svm_binary_predict(&svm, &x));
+    sl_ml_classification_update_scores(
+        &report,
+        SL_SVM_RCV1_BUFFER_LEN,
+        scores.data,
+        classes_buffer
+    );
+    if (!sl_ml_classification_print(ctx, stderr, &report)) {
+      goto done;
     }
-    sl_ml_classification_print(stderr, &report);
   }
 
   all_ok = true;
 done:
   sl_free(train_classes);
   sl_free(test_classes);
+  sl_record_prefetcher_close(&train_prefetcher);
+  sl_record_prefetcher_close(&test_prefetcher);
   sl_record_reader_close(&train_samples_reader);
   sl_record_reader_close(&test_samples_reader);
-  sl_la_matrix_destroy(&samples_batch);
+  for (size_t i = 0; i < SL_ARRAY_LEN(samples_batches); ++i) {
+    sl_la_matrix_destroy(&(samples_batches[i].samples));
+  }
+  sl_free(minmax_data);
+  return all_ok;
+}
+
+// values of the spambase hyperparameter grid, learning_rate is the regularization of pegasos
+static const float tune_learning_rates[] = {1e-9F, 1e-7F, 1e-5F, 1e-3F};
+static const int tune_batch_sizes[]      = {1, 10, 100};
+static const int tune_epoch_counts[]     = {1, 2, 5};
+
+// cross-validates every configuration of the grid on spambase and writes one object per
+// configuration to stdout
+bool tune(
+    struct sl_context ctx[static 1],
+    uint64_t prng[static 1],
+    const struct sl_args args[const static 1]
+) {
+  bool all_ok                          = false;
+  struct sl_matrix_f32 samples         = {0};
+  struct sl_ml_kfold kfold             = {0};
+  struct sl_ml_classification* results = nullptr;
+  struct sl_json_writer writer         = {0};
+
+  const char* const dataset_dir = sl_args_get_positional(args, 1);
+  size_t n_folds                = sl_args_parse_ull(args, "--folds", 10);
+  size_t n_threads              = sl_args_parse_ull(args, "--threads", 10);
+  if (n_folds == 0) {
+    n_folds = 5;
+  }
+  if (n_threads == 0) {
+    const long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n_threads         = n_cpus > 0 ? (size_t)n_cpus : 1;
+  }
+
+  const struct sl_ml_svm_grid grid = {
+      .n_learning_rates = SL_ARRAY_LEN(tune_learning_rates),
+      .learning_rates   = tune_learning_rates,
+      .n_batch_sizes    = SL_ARRAY_LEN(tune_batch_sizes),
+      .batch_sizes      = tune_batch_sizes,
+      .n_epoch_counts   = SL_ARRAY_LEN(tune_epoch_counts),
+      .epoch_counts     = tune_epoch_counts,
+  };
+  const size_t n_configurations = sl_ml_svm_grid_size(&grid);
+
+  SL_LOG_INFO(
+      "tuning linear SVM on spambase dataset from '%s', %zu configurations, %zu folds, %zu threads",
+      dataset_dir,
+      n_configurations,
+      n_folds,
+      n_threads
+  );
+
+  uint16_t classes[SL_DATASET_SPAMBASE_SAMPLES] = {0};
+  if (!sl_la_matrix_create(
+          ctx,
+          SL_DATASET_SPAMBASE_SAMPLES,
+          SL_DATASET_SPAMBASE_FEATURES,
+          &samples
+      )) {
+    SL_LOG_ERROR("failed allocating samples matrix");
+    goto done;
+  }
+  if (!spambase_read(ctx, dataset_dir, classes, &samples)) {
+    goto done;
+  }
+  // all folds share the samples, which are rescaled once with the ranges of the whole dataset
+  SL_ML_MINMAX_RESCALE(SL_DATASET_SPAMBASE_FEATURES, &samples, -1, 1);
+
+  if (!sl_ml_kfold_create(ctx, prng, SL_DATASET_SPAMBASE_SAMPLES, n_folds, &kfold)) {
+    goto done;
+  }
+  results = sl_alloc(ctx, n_configurations * n_folds, sizeof(*results));
+  if (!results) {
+    SL_LOG_ERROR("failed allocating cross-validation results");
+    goto done;
+  }
+  if (!sl_ml_svm_cross_validate(ctx, prng, &grid, &kfold, &samples, classes, n_threads, results)) {
+    SL_LOG_ERROR("failed cross-validating linear SVM");
+    goto done;
+  }
+
+  if (!sl_json_writer_create(ctx, &writer, stdout, SL_JSON_WRITER_BUFFER_SIZE)) {
+    goto done;
+  }
+  for (size_t c = 0; c < n_configurations; ++c) {
+    if (!sl_ml_svm_cross_validation_write(ctx, &writer, &grid, c, n_folds, results)) {
+      goto done;
+    }
+  }
+  if (!sl_json_writer_flush(ctx, &writer)) {
+    goto done;
+  }
+
+  all_ok = true;
+done:
+  sl_json_writer_destroy(&writer);
+  sl_free(results);
+  sl_ml_kfold_destroy(&kfold);
+  sl_la_matrix_destroy(&samples);
   return all_ok;
 }
 
 void print_usage(const struct sl_args args[const static 1]) {
-  SL_LOG_ERROR("usage: %s experiment dataset_dir", args->argv[0]);
+  fprintf(
+      stderr,
+      ("usage:"
+       "\n"
+       "  %s spambase dataset_dir [--save-model=dir] [--load-model=dir]"
+       "\n"
+       "  %s rcv1 dataset_dir [--flip-train-test]"
+       "\n"
+       "  %s rcv1 dataset_dir --sparse [--flip-train-test] [--threads=N] [--sync-steps=K]"
+       " [--loss=hinge|logistic|squared_hinge] [--probabilities]"
+       "\n"
+       "  %s tune dataset_dir [--folds=K] [--threads=N]"
+       "\n"),
+      args->argv[0],
+      args->argv[0],
+      args->argv[0],
+      args->argv[0]
+  );
 }
 
 int main(int argc, char* const argv[argc + 1]) {
@@ -427,6 +977,8 @@ int main(int argc, char* const argv[argc + 1]) {
         ok = spambase(&ctx, &prng, &args);
       } else if (strcmp(experiment, "rcv1") == 0) {
         ok = rcv1(&ctx, &prng, &args);
+      } else if (strcmp(experiment, "tune") == 0) {
+        ok = tune(&ctx, &prng, &args);
       } else {
         SL_ERROR(&ctx, "unknown experiment %s", experiment);
       }